@@ -32,10 +32,17 @@
 NIMBLE_BEGIN
 
     //! Allocates objects of type T from an array and returns their indices.
-    template<typename T>
+    /*!
+        Objects are stored inside an Array by default, pass a PagedArray as a container type
+        to grow without copying objects and to keep their addresses stable.
+    */
+    template<typename T, typename TContainer = Array<T> >
     class IndexAllocator {
     public:
 
+        //! Alias the container type.
+        typedef TContainer  Container;
+
                             //! Constructs IndexAllocator instance
                             IndexAllocator( s32 size, f32 growth = 0.1f );
 
@@ -44,8 +51,8 @@ NIMBLE_BEGIN
         T&                  operator[] ( s32 index );
 
         //! Returns allocated items.
-        const Array<T>&     items( void ) const;
-        Array<T>&           items( void );
+        const Container&    items( void ) const;
+        Container&          items( void );
 
         //! Clears an array of allocated objects.
         void                reset( void );
@@ -64,15 +71,15 @@ NIMBLE_BEGIN
 
     private:
 
-        Array<T>            m_array;            //!< An array of allocated objects.
+        Container           m_array;            //!< An array of allocated objects.
         f32                 m_growth;           //!< When an array is full it's size will be increased by this factor.
         s32                 m_capacity;         //!< The maximum number of objects that can be allocated.
         s32                 m_allocatedCount;    //!< The total number of allocated objects.
     };
 
     // ** IndexAllocator::IndexAllocator
-    template<typename T>
-    IndexAllocator<T>::IndexAllocator( s32 size, f32 growth )
+    template<typename T, typename TContainer>
+    IndexAllocator<T, TContainer>::IndexAllocator( s32 size, f32 growth )
         : m_growth( growth )
         , m_capacity( size )
         , m_allocatedCount( 0 )
@@ -81,22 +88,22 @@ NIMBLE_BEGIN
     }
 
     // ** IndexAllocator::items
-    template<typename T>
-    const Array<T>& IndexAllocator<T>::items( void ) const
+    template<typename T, typename TContainer>
+    const TContainer& IndexAllocator<T, TContainer>::items( void ) const
     {
         return m_array;
     }
 
     // ** IndexAllocator::items
-    template<typename T>
-    Array<T>& IndexAllocator<T>::items( void )
+    template<typename T, typename TContainer>
+    TContainer& IndexAllocator<T, TContainer>::items( void )
     {
         return m_array;
     }
 
     // ** IndexAllocator::reset
-    template<typename T>
-    void IndexAllocator<T>::reset( void )
+    template<typename T, typename TContainer>
+    void IndexAllocator<T, TContainer>::reset( void )
     {
         for( s32 i = 0, n = allocatedCount(); i < n; i++ ) {
             m_array[i].~T();
@@ -106,28 +113,28 @@ NIMBLE_BEGIN
     }
 
     // ** IndexAllocator::operator[]
-    template<typename T>
-    const T& IndexAllocator<T>::operator[]( s32 index ) const
+    template<typename T, typename TContainer>
+    const T& IndexAllocator<T, TContainer>::operator[]( s32 index ) const
     {
         NIMBLE_ABORT_IF( index < 0 || index >= allocatedCount(), "index is out of range" );
         return m_array[index];
     }
 
     // ** IndexAllocator::operator[]
-    template<typename T>
-    T& IndexAllocator<T>::operator[]( s32 index )
+    template<typename T, typename TContainer>
+    T& IndexAllocator<T, TContainer>::operator[]( s32 index )
     {
         NIMBLE_ABORT_IF( index < 0 || index >= allocatedCount(), "index is out of range" );
         return m_array[index];
     }
 
     // ** IndexAllocator::allocate
-    template<typename T>
-    s32 IndexAllocator<T>::allocate( void )
+    template<typename T, typename TContainer>
+    s32 IndexAllocator<T, TContainer>::allocate( void )
     {
         // Resize an array when maximum capacity reached
         if( m_allocatedCount >= maximumCapacity() ) {
-            m_capacity = maximumCapacity() + min2( 1, static_cast<s32>( maximumCapacity() * m_growth ) );
+            m_capacity = maximumCapacity() + max2( 1, static_cast<s32>( maximumCapacity() * m_growth ) );
             m_array.resize( m_capacity );
         }
 
@@ -139,8 +146,8 @@ NIMBLE_BEGIN
     }
 
     // ** IndexAllocator::allocate
-    template<typename T>
-    s32 IndexAllocator<T>::allocate( const T& value )
+    template<typename T, typename TContainer>
+    s32 IndexAllocator<T, TContainer>::allocate( const T& value )
     {
        s32 idx = allocate();
        m_array[idx] = value;
@@ -148,15 +155,15 @@ NIMBLE_BEGIN
     }
 
     // ** IndexAllocator::allocatedCount
-    template<typename T>
-    s32 IndexAllocator<T>::allocatedCount( void ) const
+    template<typename T, typename TContainer>
+    s32 IndexAllocator<T, TContainer>::allocatedCount( void ) const
     {
         return m_allocatedCount;
     }
 
     // ** IndexAllocator::maximumCapacity
-    template<typename T>
-    s32 IndexAllocator<T>::maximumCapacity( void ) const
+    template<typename T, typename TContainer>
+    s32 IndexAllocator<T, TContainer>::maximumCapacity( void ) const
     {
         return m_capacity;
     }
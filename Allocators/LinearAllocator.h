@@ -86,7 +86,7 @@ NIMBLE_BEGIN
     // ** LinearAllocator::allocate
     inline u8* LinearAllocator::allocate( s32 size )
     {
-        if( (m_allocated + size) >= m_size ) {
+        if( (m_allocated + size) > m_size ) {
             return NULL;
         }
 
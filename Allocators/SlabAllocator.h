@@ -0,0 +1,159 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_SlabAllocator_H__
+#define __Nimble_SlabAllocator_H__
+
+#include "../Globals.h"
+
+NIMBLE_BEGIN
+
+    //! Allocates fixed size memory blocks from large slabs and recycles released blocks through an intrusive free list.
+    /*!
+        Blocks are never returned to the system until the allocator is destroyed, so a heavy
+        allocate/release traffic of small objects does not touch a general purpose heap.
+        The allocator is not synchronized.
+    */
+    template<s32 TBlockSize, s32 TBlocksPerSlab = 1024>
+    class SlabAllocator {
+    public:
+
+                            //! Constructs SlabAllocator instance.
+                            SlabAllocator( void );
+                            ~SlabAllocator( void );
+
+        //! Allocates a single memory block.
+        void*               allocate( void );
+
+        //! Returns a memory block back to an allocator.
+        void                deallocate( void* pointer );
+
+        //! Returns the total number of allocated blocks.
+        s32                 allocatedCount( void ) const;
+
+        //! Returns the total number of allocated slabs.
+        s32                 slabCount( void ) const;
+
+    private:
+
+                            SlabAllocator( const SlabAllocator& other );
+        SlabAllocator&      operator = ( const SlabAllocator& other );
+
+    private:
+
+        //! A single memory block that stores a pointer to a next free block when it is not allocated.
+        union Block {
+            Block*          next;               //!< Next free block.
+            u8              data[TBlockSize];   //!< Block memory.
+            f64             alignment;          //!< Aligns blocks to 8 bytes.
+        };
+
+        Array<Block*>       m_slabs;            //!< Allocated slabs.
+        Block*              m_free;             //!< Head of a free block list.
+        Block*              m_cursor;           //!< Next never allocated block inside the last slab.
+        Block*              m_end;              //!< End of the last slab.
+        s32                 m_allocatedCount;   //!< The total number of allocated blocks.
+    };
+
+    // ** SlabAllocator::SlabAllocator
+    template<s32 TBlockSize, s32 TBlocksPerSlab>
+    SlabAllocator<TBlockSize, TBlocksPerSlab>::SlabAllocator( void )
+        : m_free( NULL )
+        , m_cursor( NULL )
+        , m_end( NULL )
+        , m_allocatedCount( 0 )
+    {
+    }
+
+    // ** SlabAllocator::~SlabAllocator
+    template<s32 TBlockSize, s32 TBlocksPerSlab>
+    SlabAllocator<TBlockSize, TBlocksPerSlab>::~SlabAllocator( void )
+    {
+        NIMBLE_BREAK_IF( m_allocatedCount != 0, "destroying an allocator with allocated blocks" );
+
+        for( s32 i = 0, n = slabCount(); i < n; i++ ) {
+            free( m_slabs[i] );
+        }
+    }
+
+    // ** SlabAllocator::allocate
+    template<s32 TBlockSize, s32 TBlocksPerSlab>
+    void* SlabAllocator<TBlockSize, TBlocksPerSlab>::allocate( void )
+    {
+        Block* block = m_free;
+
+        if( block ) {
+            m_free = block->next;
+        } else {
+            // Start a new slab when the last one is exhausted
+            if( m_cursor == m_end ) {
+                Block* slab = reinterpret_cast<Block*>( malloc( sizeof( Block ) * TBlocksPerSlab ) );
+                NIMBLE_ABORT_IF( slab == NULL, "failed to allocate a slab" );
+                m_slabs.push_back( slab );
+                m_cursor = slab;
+                m_end    = slab + TBlocksPerSlab;
+            }
+
+            block = m_cursor++;
+        }
+
+        m_allocatedCount++;
+        return block;
+    }
+
+    // ** SlabAllocator::deallocate
+    template<s32 TBlockSize, s32 TBlocksPerSlab>
+    void SlabAllocator<TBlockSize, TBlocksPerSlab>::deallocate( void* pointer )
+    {
+        if( pointer == NULL ) {
+            return;
+        }
+
+        NIMBLE_ABORT_IF( m_allocatedCount == 0, "deallocating a block that was not allocated" );
+
+        Block* block = reinterpret_cast<Block*>( pointer );
+        block->next = m_free;
+        m_free = block;
+        m_allocatedCount--;
+    }
+
+    // ** SlabAllocator::allocatedCount
+    template<s32 TBlockSize, s32 TBlocksPerSlab>
+    s32 SlabAllocator<TBlockSize, TBlocksPerSlab>::allocatedCount( void ) const
+    {
+        return m_allocatedCount;
+    }
+
+    // ** SlabAllocator::slabCount
+    template<s32 TBlockSize, s32 TBlocksPerSlab>
+    s32 SlabAllocator<TBlockSize, TBlocksPerSlab>::slabCount( void ) const
+    {
+        return static_cast<s32>( m_slabs.size() );
+    }
+
+NIMBLE_END
+
+#endif    /*    !__Nimble_SlabAllocator_H__    */
@@ -0,0 +1,166 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_Benchmarks_Benchmark_H__
+#define __Nimble_Benchmarks_Benchmark_H__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <stdarg.h>
+
+#include <Preprocessor/Preprocessor.h>
+#include <Globals.h>
+
+#if defined( NIMBLE_PLATFORM_WINDOWS )
+    #include <intrin.h>
+    #define NIMBLE_BENCHMARK_RDTSC (1)
+#elif defined( __i386__ ) || defined( __x86_64__ )
+    #include <x86intrin.h>
+    #define NIMBLE_BENCHMARK_RDTSC (1)
+#endif
+
+#include <chrono>
+
+NIMBLE_BEGIN
+
+namespace Benchmark {
+
+    //! Returns the current value of a CPU timestamp counter or a nanosecond clock when it is not available.
+    inline u64 cycles( void )
+    {
+    #if NIMBLE_BENCHMARK_RDTSC
+        return __rdtsc();
+    #else
+        return static_cast<u64>( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::high_resolution_clock::now().time_since_epoch() ).count() );
+    #endif  /*  NIMBLE_BENCHMARK_RDTSC  */
+    }
+
+    //! Returns the current time in nanoseconds.
+    inline u64 nanoseconds( void )
+    {
+        return static_cast<u64>( std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+    }
+
+    //! Forces the compiler to assume the value is used, so the computation is not optimized away.
+    template<typename TValue>
+    inline void doNotOptimize( const TValue& value )
+    {
+    #if defined( __GNUC__ ) || defined( __clang__ )
+        // An empty asm block that reads the value through memory is opaque to the optimizer and emits no instructions
+        __asm__ __volatile__( "" : : "r,m"( value ) : "memory" );
+    #else
+        // Fall back to a volatile read of the value address, which the compiler has to keep
+        static const void* volatile sink;
+        sink = &value;
+    #endif  /*  __GNUC__ || __clang__   */
+    }
+
+    //! A small and fast splitmix64 generator that produces reproducible benchmark inputs.
+    class Generator {
+    public:
+
+                    //! Constructs a Generator instance.
+                    Generator( u64 seed = 0x9e3779b97f4a7c15ull )
+                        : m_state( seed ) {}
+
+        //! Returns a next 64-bit pseudo-random number.
+        u64         next( void )
+                    {
+                        u64 z = (m_state += 0x9e3779b97f4a7c15ull);
+                        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+                        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+                        return z ^ (z >> 31);
+                    }
+
+        //! Returns a next pseudo-random number in a [0, 1) range.
+        f64         unit( void ) { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+        //! Fills the buffer with pseudo-random bytes.
+        void        fill( void* buffer, u32 size )
+                    {
+                        u8* bytes = reinterpret_cast<u8*>( buffer );
+                        for( u32 i = 0; i < size; i++ ) {
+                            bytes[i] = static_cast<u8>( next() );
+                        }
+                    }
+
+    private:
+
+        u64         m_state;    //!< Generator state.
+    };
+
+    //! Runs the callback for a specified number of times and returns the best number of cycles per single run.
+    template<typename TCallback>
+    f64 measure( TCallback callback, u32 iterations, u32 repeats = 7 )
+    {
+        f64 best = DBL_MAX;
+
+        for( u32 r = 0; r < repeats; r++ ) {
+            u64 start = cycles();
+            for( u32 i = 0; i < iterations; i++ ) {
+                callback( i );
+            }
+            u64 end = cycles();
+            best = min2( best, static_cast<f64>( end - start ) / iterations );
+        }
+
+        return best;
+    }
+
+    //! Returns the name of a unit reported by the cycles function.
+    inline CString cyclesUnit( void )
+    {
+    #if NIMBLE_BENCHMARK_RDTSC
+        return "cycle";
+    #else
+        return "ns";
+    #endif  /*  NIMBLE_BENCHMARK_RDTSC  */
+    }
+
+} // namespace Benchmark
+
+namespace Internal {
+
+    // ** message
+    inline void message( int, CString function, CString, CString, CString prefix, CString format, ... )
+    {
+        // Benchmarks do not link the logger, so assertion messages go straight to stderr
+        va_list ap;
+        va_start( ap, format );
+        fprintf( stderr, "[%s] %s: ", prefix, function );
+        vfprintf( stderr, format, ap );
+        fprintf( stderr, "\n" );
+        va_end( ap );
+    }
+
+} // namespace Internal
+
+NIMBLE_END
+
+#endif  /*  !__Nimble_Benchmarks_Benchmark_H__  */
@@ -0,0 +1,199 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#include "Benchmark.h"
+
+#include <Containers/Pool.h>
+#include <Math/Random.h>
+#include <Math/Vector.h>
+#include <Math/Vec2.h>
+#include <Math/Vec3.h>
+#include <Math/Vec4.h>
+#include <Math/Quat.h>
+#include <Math/Matrix.h>
+#include <Math/Matrix4.h>
+#include <Bv/Bounds.h>
+#include <Math/Plane.h>
+#include <Bv/CullingFrustum.h>
+#include <Math/Ray.h>
+#include <Bv/Bvh.h>
+#include <Bv/LooseOctree.h>
+#include <Bv/HashedGrid.h>
+#include <Bv/SweepAndPrune.h>
+
+NIMBLE_IMPORT
+
+//! The number of simulated objects.
+static const s32 ObjectCount = 20000;
+
+//! A size of a cube that contains all objects.
+static const f32 WorldSize = 80.0f;
+
+//! Objects that move with a constant velocity and bounce off world bounds.
+struct Scene {
+    Array<Vec3>     positions;
+    Array<Vec3>     velocities;
+    Array<Vec3>     extents;
+    Array<Bounds>   bounds;
+
+    //! Generates objects with random positions, sizes and velocities.
+    Scene( void )
+    {
+        Benchmark::Generator random;
+
+        for( s32 i = 0; i < ObjectCount; i++ ) {
+            positions.push_back( Vec3( static_cast<f32>( random.unit() ) * WorldSize, static_cast<f32>( random.unit() ) * WorldSize, static_cast<f32>( random.unit() ) * WorldSize ) );
+            velocities.push_back( Vec3( static_cast<f32>( random.unit() - 0.5 ) * 0.2f, static_cast<f32>( random.unit() - 0.5 ) * 0.2f, static_cast<f32>( random.unit() - 0.5 ) * 0.2f ) );
+            extents.push_back( Vec3( static_cast<f32>( random.unit() ) + 0.1f, static_cast<f32>( random.unit() ) + 0.1f, static_cast<f32>( random.unit() ) + 0.1f ) );
+        }
+
+        bounds.resize( ObjectCount );
+        step();
+    }
+
+    //! Advances a simulation by one frame and updates object bounds.
+    void step( void )
+    {
+        for( s32 i = 0; i < ObjectCount; i++ ) {
+            Vec3& position = positions[i];
+            Vec3& velocity = velocities[i];
+
+            position += velocity;
+
+            for( s32 axis = 0; axis < 3; axis++ ) {
+                if( (position[axis] < 0.0f && velocity[axis] < 0.0f) || (position[axis] > WorldSize && velocity[axis] > 0.0f) ) {
+                    velocity[axis] = -velocity[axis];
+                }
+            }
+
+            bounds[i] = Bounds( position - extents[i], position + extents[i] );
+        }
+    }
+};
+
+int main( void )
+{
+    typedef OpaqueHandle<20, 12> Handle;
+
+    printf( "\nOverlapping pairs of %d moving objects, thousands of %ss/frame\n", ObjectCount, Benchmark::cyclesUnit() );
+
+    // All pairs are tested against each other
+    {
+        Scene scene;
+        f64 result = Benchmark::measure( [&]( u32 ) {
+            scene.step();
+            s32 pairs = 0;
+            for( s32 i = 0; i < ObjectCount; i++ ) {
+                for( s32 j = i + 1; j < ObjectCount; j++ ) {
+                    pairs += scene.bounds[i].overlaps( scene.bounds[j] );
+                }
+            }
+            Benchmark::doNotOptimize( pairs );
+        }, 1, 3 );
+        printf( "%-32s%12.0f\n", "Brute force", result / 1000.0 );
+    }
+
+    // Incremental sweep and prune along one and three axes
+    for( s32 axes = 1; axes <= 3; axes += 2 ) {
+        Scene                scene;
+        SweepAndPrune        sap( axes );
+        SweepAndPrune::Pairs added, removed;
+
+        sap.update( &scene.bounds[0], ObjectCount, added, removed );
+
+        f64 result = Benchmark::measure( [&]( u32 ) {
+            scene.step();
+            sap.update( &scene.bounds[0], ObjectCount, added, removed );
+            Benchmark::doNotOptimize( sap.pairs().size() );
+        }, 10 );
+        printf( "%-32s%12.0f\n", axes == 1 ? "Sweep and prune, one axis" : "Sweep and prune, three axes", result / 1000.0 );
+    }
+
+    // Hashed grid with a cell size close to an object size
+    {
+        Scene              scene;
+        HashedGrid<s32>    grid( 2.0f );
+        Array<Handle>      handles;
+
+        for( s32 i = 0; i < ObjectCount; i++ ) {
+            handles.push_back( grid.insert( scene.bounds[i], i ) );
+        }
+
+        f64 result = Benchmark::measure( [&]( u32 ) {
+            scene.step();
+            for( s32 i = 0; i < ObjectCount; i++ ) {
+                grid.move( handles[i], scene.bounds[i] );
+            }
+            s32 pairs = 0;
+            grid.pairs( [&]( const Handle&, const Handle& ) { pairs++; } );
+            Benchmark::doNotOptimize( pairs );
+        }, 10 );
+        printf( "%-32s%12.0f\n", "Hashed grid", result / 1000.0 );
+    }
+
+    // Loose octree that covers the world
+    {
+        Scene              scene;
+        LooseOctree<s32>   octree( Bounds( Vec3( -10.0f, -10.0f, -10.0f ), Vec3( WorldSize + 10.0f, WorldSize + 10.0f, WorldSize + 10.0f ) ) );
+        Array<Handle>      handles;
+
+        for( s32 i = 0; i < ObjectCount; i++ ) {
+            handles.push_back( octree.insert( scene.bounds[i], i ) );
+        }
+
+        f64 result = Benchmark::measure( [&]( u32 ) {
+            scene.step();
+            for( s32 i = 0; i < ObjectCount; i++ ) {
+                octree.move( handles[i], scene.bounds[i] );
+            }
+            s32 pairs = 0;
+            octree.pairs( [&]( const Handle&, const Handle& ) { pairs++; } );
+            Benchmark::doNotOptimize( pairs );
+        }, 10 );
+        printf( "%-32s%12.0f\n", "Loose octree", result / 1000.0 );
+    }
+
+    // Bounding volume hierarchy refit each frame and queried with each object
+    {
+        Scene scene;
+        Bvh   bvh;
+
+        bvh.build( &scene.bounds[0], ObjectCount );
+
+        f64 result = Benchmark::measure( [&]( u32 ) {
+            scene.step();
+            bvh.refit( &scene.bounds[0] );
+            s32 pairs = 0;
+            for( s32 i = 0; i < ObjectCount; i++ ) {
+                bvh.query( scene.bounds[i], [&]( s32 index ) { pairs += index > i; } );
+            }
+            Benchmark::doNotOptimize( pairs );
+        }, 10 );
+        printf( "%-32s%12.0f\n", "Bvh refit", result / 1000.0 );
+    }
+
+    return 0;
+}
@@ -0,0 +1,124 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#include "Benchmark.h"
+
+#include <Math/Random.h>
+#include <Math/Vector.h>
+#include <Math/Vec2.h>
+#include <Math/Vec3.h>
+#include <Math/Vec4.h>
+#include <Math/Quat.h>
+#include <Math/Matrix.h>
+#include <Math/Matrix4.h>
+#include <Bv/Bounds.h>
+#include <Math/Plane.h>
+#include <Bv/CullingFrustum.h>
+#include <Math/Ray.h>
+#include <Bv/Bvh.h>
+
+NIMBLE_IMPORT
+
+//! The number of rays cast per measurement.
+static const s32 RayCount = 256;
+
+//! Returns a random point inside a cube of a specified size.
+static Vec3 randomPoint( Benchmark::Generator& random, f64 size )
+{
+    return Vec3( static_cast<f32>( random.unit() * size ), static_cast<f32>( random.unit() * size ), static_cast<f32>( random.unit() * size ) );
+}
+
+//! Generates a scene with small objects scattered inside a cube which volume grows with an object count.
+static void generateScene( Array<Bounds>& bounds, Array<Ray>& rays, s32 count )
+{
+    Benchmark::Generator random;
+    f64                  size = pow( static_cast<f64>( count ), 1.0 / 3.0 ) * 4.0;
+
+    for( s32 i = 0; i < count; i++ ) {
+        Vec3 center = randomPoint( random, size );
+        Vec3 extent = randomPoint( random, 1.0 );
+        bounds.push_back( Bounds( center - extent, center + extent ) );
+    }
+
+    for( s32 i = 0; i < RayCount; i++ ) {
+        Vec3 direction = randomPoint( random, 2.0 ) - Vec3( 1.0f, 1.0f, 1.0f );
+        direction.normalize();
+        rays.push_back( Ray( randomPoint( random, size ), direction ) );
+    }
+}
+
+int main( void )
+{
+    s32 counts[] = { 10000, 100000, 500000 };
+
+    printf( "\nClosest hit raycast and box overlap queries, %s/query\n", Benchmark::cyclesUnit() );
+    printf( "%-12s%16s%16s%16s%16s\n", "objects", "build, ms", "brute force", "bvh raycast", "bvh overlap" );
+
+    for( u32 i = 0; i < sizeof( counts ) / sizeof( counts[0] ); i++ ) {
+        s32           count = counts[i];
+        Array<Bounds> bounds;
+        Array<Ray>    rays;
+        Bvh           bvh;
+
+        generateScene( bounds, rays, count );
+
+        u64 start = Benchmark::nanoseconds();
+        bvh.build( &bounds[0], count );
+        f64 build = (Benchmark::nanoseconds() - start) / 1000000.0;
+
+        f64 bruteForce = Benchmark::measure( [&]( u32 ) {
+            s32 hits = 0;
+            for( s32 j = 0; j < 16; j++ ) {
+                for( s32 k = 0; k < count; k++ ) {
+                    hits += rays[j].intersects( bounds[k] );
+                }
+            }
+            Benchmark::doNotOptimize( hits );
+        }, 1, 3 ) / 16;
+
+        f64 raycast = Benchmark::measure( [&]( u32 ) {
+            s32 hits = 0;
+            for( s32 j = 0; j < RayCount; j++ ) {
+                f32 time;
+                hits += bvh.raycast( rays[j], time );
+            }
+            Benchmark::doNotOptimize( hits );
+        }, 10 ) / RayCount;
+
+        f64 overlap = Benchmark::measure( [&]( u32 ) {
+            s32 hits = 0;
+            for( s32 j = 0; j < RayCount; j++ ) {
+                const Vec3& point = rays[j].origin();
+                bvh.query( Bounds( point - Vec3( 2.0f, 2.0f, 2.0f ), point + Vec3( 2.0f, 2.0f, 2.0f ) ), [&]( s32 ) { hits++; } );
+            }
+            Benchmark::doNotOptimize( hits );
+        }, 10 ) / RayCount;
+
+        printf( "%-12d%16.2f%16.0f%16.0f%16.0f\n", count, build, bruteForce, raycast, overlap );
+    }
+
+    return 0;
+}
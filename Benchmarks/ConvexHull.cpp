@@ -0,0 +1,232 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#include "Benchmark.h"
+
+#include <Math/Random.h>
+#include <Math/Vector.h>
+#include <Math/Vec2.h>
+#include <Math/Vec3.h>
+#include <Math/Vec4.h>
+#include <Math/Quat.h>
+#include <Math/Matrix.h>
+#include <Math/Matrix4.h>
+#include <Bv/Bounds.h>
+#include <Math/Plane.h>
+#include <Bv/ConvexHull.h>
+
+NIMBLE_IMPORT
+
+//! The number of hulls built from jittered cube corners per jitter size.
+static const s32 JitteredHullCount = 2000;
+
+//! The number of hulls built from tiny point clouds far from an origin.
+static const s32 DistantCloudCount = 300;
+
+//! The number of hulls built from thin slabs.
+static const s32 ThinSlabCount = 20000;
+
+//! Returns a random value in a [-1, 1) range.
+static f32 randomSigned( Benchmark::Generator& random )
+{
+    return static_cast<f32>( random.unit() * 2.0 - 1.0 );
+}
+
+//! Returns a random point inside a cube of a specified half size.
+static Vec3 randomPoint( Benchmark::Generator& random, f32 size )
+{
+    return Vec3( randomSigned( random ), randomSigned( random ), randomSigned( random ) ) * size;
+}
+
+//! Generates points on cube corners, each displaced by a small random offset.
+static void generateJitteredCorners( Benchmark::Generator& random, Array<Vec3>& points, s32 count, f32 jitter )
+{
+    points.clear();
+
+    for( s32 i = 0; i < count; i++ ) {
+        s32  corner = i < 8 ? i : static_cast<s32>( random.next() % 8 );
+        Vec3 point( (corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f );
+        points.push_back( point + randomPoint( random, jitter ) );
+    }
+}
+
+//! Generates points inside a cube of a specified half size around a center.
+static void generateCloud( Benchmark::Generator& random, Array<Vec3>& points, s32 count, const Vec3& center, f32 size )
+{
+    points.clear();
+
+    for( s32 i = 0; i < count; i++ ) {
+        points.push_back( center + randomPoint( random, size ) );
+    }
+}
+
+//! Generates points inside a 2x2 slab of a specified thickness.
+static void generateSlab( Benchmark::Generator& random, Array<Vec3>& points, s32 count, f32 thickness )
+{
+    points.clear();
+
+    for( s32 i = 0; i < count; i++ ) {
+        points.push_back( Vec3( randomSigned( random ), randomSigned( random ), randomSigned( random ) * thickness * 0.5f ) );
+    }
+}
+
+//! Returns the largest distance an input point lies above a hull face.
+static f32 measureViolation( const ConvexHull& hull, const Array<Vec3>& points )
+{
+    Array<Plane> planes;
+    hull.planes( planes );
+
+    f32 worst = 0.0f;
+
+    for( u32 i = 0; i < planes.size(); i++ ) {
+        for( u32 j = 0; j < points.size(); j++ ) {
+            worst = max2( worst, planes[i].normal() * points[j] + planes[i].distance() );
+        }
+    }
+
+    return worst;
+}
+
+//! Builds a hull and returns the largest distance an input point lies above it, a hull may be rejected, but a built hull should not be empty.
+static f32 validateHull( ConvexHull& hull, const Array<Vec3>& points )
+{
+    if( !hull.build( &points[0], static_cast<s32>( points.size() ) ) ) {
+        return 0.0f;
+    }
+
+    if( hull.triangleCount() < 4 || hull.vertices().size() < 4 ) {
+        return FLT_MAX;
+    }
+
+    return measureViolation( hull, points );
+}
+
+int main( void )
+{
+    // Nearly coplanar points on jittered cube corners used to produce hulls that leave input points outside
+    f32                  jitters[] = { 1e-6f, 1e-5f, 1e-4f };
+    s32                  failed    = 0;
+    Benchmark::Generator random;
+    ConvexHull           hull;
+    Array<Vec3>          points;
+
+    printf( "\nConvex hulls of nearly degenerate point sets\n" );
+    printf( "%-12s%16s%16s\n", "input", "failed", "worst" );
+
+    // A cloud of a few tolerance sizes used to produce empty hulls, and thin slabs used to leave points outside
+    {
+        Vec3 center( 5000.0f, -3000.0f, 100.0f );
+        f32  tolerance = 3.0f * FLT_EPSILON * (center.x - center.y + center.z);
+        s32  errors    = 0;
+        f32  worst     = 0.0f;
+
+        for( s32 i = 0; i < DistantCloudCount; i++ ) {
+            generateCloud( random, points, 8 + static_cast<s32>( random.next() % 200 ), center, 0.005f );
+
+            f32 violation = validateHull( hull, points );
+            worst = max2( worst, violation );
+
+            if( violation > 2.0f * tolerance ) {
+                errors++;
+            }
+        }
+
+        printf( "%-12s%16d%16g\n", "cloud", errors, worst );
+        failed += errors;
+    }
+
+    {
+        s32 errors = 0;
+        f32 worst  = 0.0f;
+
+        for( s32 i = 0; i < ThinSlabCount; i++ ) {
+            generateSlab( random, points, 8 + static_cast<s32>( random.next() % 200 ), 2e-5f );
+
+            f32 violation = validateHull( hull, points );
+            worst = max2( worst, violation );
+
+            if( violation > 1e-5f ) {
+                errors++;
+            }
+        }
+
+        printf( "%-12s%16d%16g\n", "slab", errors, worst );
+        failed += errors;
+    }
+
+    printf( "\nConvex hulls of jittered cube corners\n" );
+    printf( "%-12s%16s%16s\n", "jitter", "failed", "worst" );
+
+    for( u32 i = 0; i < sizeof( jitters ) / sizeof( jitters[0] ); i++ ) {
+        s32 errors = 0;
+        f32 worst  = 0.0f;
+
+        for( s32 j = 0; j < JitteredHullCount; j++ ) {
+            generateJitteredCorners( random, points, 8 + static_cast<s32>( random.next() % 200 ), jitters[i] );
+
+            f32 violation = hull.build( &points[0], static_cast<s32>( points.size() ) ) ? measureViolation( hull, points ) : FLT_MAX;
+            worst = max2( worst, violation );
+
+            if( violation > 1e-5f ) {
+                errors++;
+            }
+        }
+
+        printf( "%-12g%16d%16g\n", jitters[i], errors, worst );
+        failed += errors;
+    }
+
+    // Hull construction time for points inside a cube and on a sphere
+    s32 counts[] = { 1000, 10000, 100000 };
+
+    printf( "\nConvex hull construction, %s/point\n", Benchmark::cyclesUnit() );
+    printf( "%-12s%16s%16s%16s\n", "points", "cube", "sphere", "triangles" );
+
+    for( u32 i = 0; i < sizeof( counts ) / sizeof( counts[0] ); i++ ) {
+        s32         count = counts[i];
+        Array<Vec3> cube;
+        Array<Vec3> sphere;
+
+        for( s32 j = 0; j < count; j++ ) {
+            Vec3 point = randomPoint( random, 1.0f );
+            cube.push_back( point );
+            point.normalize();
+            sphere.push_back( point );
+        }
+
+        f64 cubeTime = Benchmark::measure( [&]( u32 ) {
+            Benchmark::doNotOptimize( hull.build( &cube[0], count ) );
+        }, 1, 3 ) / count;
+
+        f64 sphereTime = Benchmark::measure( [&]( u32 ) {
+            Benchmark::doNotOptimize( hull.build( &sphere[0], count ) );
+        }, 1, 3 ) / count;
+
+        printf( "%-12d%16.0f%16.0f%16d\n", count, cubeTime, sphereTime, hull.triangleCount() );
+    }
+
+    return failed ? 1 : 0;
+}
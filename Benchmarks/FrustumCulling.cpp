@@ -0,0 +1,122 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#include "Benchmark.h"
+
+#include <Math/Random.h>
+#include <Math/Vector.h>
+#include <Math/Vec2.h>
+#include <Math/Vec3.h>
+#include <Math/Vec4.h>
+#include <Math/Quat.h>
+#include <Math/Matrix.h>
+#include <Math/Matrix4.h>
+#include <Bv/Bounds.h>
+#include <Math/Plane.h>
+#include <Bv/CullingFrustum.h>
+
+NIMBLE_IMPORT
+
+//! The number of culled objects.
+static const s32 ObjectCount = 100000;
+
+//! Bounding volumes in both array of structures and structure of arrays layouts.
+struct Scene {
+    Array<Bounds>   bounds;
+    Array<Vec3>     centers;
+    Array<f32>      radius;
+    Array<f32>      x, y, z;
+    Array<f32>      extentX, extentY, extentZ;
+};
+
+//! Generates a scene with objects scattered around a camera.
+static void generateScene( Scene& scene )
+{
+    Benchmark::Generator random;
+
+    for( s32 i = 0; i < ObjectCount; i++ ) {
+        Vec3 center( static_cast<f32>( random.unit() * 200.0 - 100.0 ), static_cast<f32>( random.unit() * 200.0 - 100.0 ), static_cast<f32>( random.unit() * 200.0 - 100.0 ) );
+        Vec3 extent( static_cast<f32>( random.unit() * 4.0 ), static_cast<f32>( random.unit() * 4.0 ), static_cast<f32>( random.unit() * 4.0 ) );
+
+        scene.bounds.push_back( Bounds( center - extent, center + extent ) );
+        scene.centers.push_back( center );
+        scene.radius.push_back( extent.length() );
+        scene.x.push_back( center.x );
+        scene.y.push_back( center.y );
+        scene.z.push_back( center.z );
+        scene.extentX.push_back( extent.x );
+        scene.extentY.push_back( extent.y );
+        scene.extentZ.push_back( extent.z );
+    }
+}
+
+int main( void )
+{
+    Scene scene;
+    generateScene( scene );
+
+    CullingFrustum frustum( Matrix4::perspective( 60.0f, 1.5f, 0.5f, 100.0f ) * Matrix4::lookAt( Vec3( 0.0f, 0.0f, 0.0f ), Vec3( 10.0f, 0.0f, -20.0f ), Vec3( 0.0f, 1.0f, 0.0f ) ) );
+    SphereBatch    spheres( &scene.x[0], &scene.y[0], &scene.z[0], &scene.radius[0], ObjectCount );
+    BoxBatch       boxes( &scene.x[0], &scene.y[0], &scene.z[0], &scene.extentX[0], &scene.extentY[0], &scene.extentZ[0], ObjectCount );
+    Array<u32>     mask;
+    Array<s32>     indices;
+
+    mask.resize( (ObjectCount + 31) / 32 );
+    indices.resize( ObjectCount );
+
+    printf( "\nCulling %d objects, %s/object\n", ObjectCount, Benchmark::cyclesUnit() );
+    printf( "%-32s%12s%12s\n", "", "spheres", "boxes" );
+
+    f64 sphereScalar = Benchmark::measure( [&]( u32 ) {
+        s32 visible = 0;
+        for( s32 i = 0; i < ObjectCount; i++ ) {
+            visible += frustum.isVisible( scene.centers[i], scene.radius[i] );
+        }
+        Benchmark::doNotOptimize( visible );
+    }, 10 ) / ObjectCount;
+
+    f64 boxScalar = Benchmark::measure( [&]( u32 ) {
+        s32 visible = 0;
+        for( s32 i = 0; i < ObjectCount; i++ ) {
+            visible += frustum.isVisible( scene.bounds[i] );
+        }
+        Benchmark::doNotOptimize( visible );
+    }, 10 ) / ObjectCount;
+
+    printf( "%-32s%12.2f%12.2f\n", "Plane::isBehind per object", sphereScalar, boxScalar );
+
+    f64 sphereMask = Benchmark::measure( [&]( u32 ) { frustum.cull( spheres, &mask[0] ); Benchmark::doNotOptimize( mask[0] ); }, 10 ) / ObjectCount;
+    f64 boxMask    = Benchmark::measure( [&]( u32 ) { frustum.cull( boxes, &mask[0] ); Benchmark::doNotOptimize( mask[0] ); }, 10 ) / ObjectCount;
+
+    printf( "%-32s%12.2f%12.2f\n", "Batch, visibility mask", sphereMask, boxMask );
+
+    f64 sphereIndices = Benchmark::measure( [&]( u32 ) { Benchmark::doNotOptimize( frustum.collectVisible( spheres, &indices[0] ) ); }, 10 ) / ObjectCount;
+    f64 boxIndices    = Benchmark::measure( [&]( u32 ) { Benchmark::doNotOptimize( frustum.collectVisible( boxes, &indices[0] ) ); }, 10 ) / ObjectCount;
+
+    printf( "%-32s%12.2f%12.2f\n", "Batch, visible indices", sphereIndices, boxIndices );
+
+    return 0;
+}
@@ -0,0 +1,360 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#include "Benchmark.h"
+
+#include <Hash.h>
+
+NIMBLE_IMPORT
+
+//! Describes a single hash function under test.
+struct HashFunctionInfo {
+    CString         name;                                   //!< Hash function name.
+    u32             bits;                                   //!< Number of significant output bits.
+    u64             (*hash)( const void* input, u32 length );   //!< Hash function entry point.
+};
+
+//! A set of keys stored in a flat buffer.
+struct KeySet {
+    CString         name;       //!< Key set name.
+    ByteArray       data;       //!< Key bytes packed together.
+    Array<u32>      offsets;    //!< Key offsets inside a data buffer, has one extra item that marks the end of the last key.
+
+    //! Returns the total number of keys.
+    u32             size( void ) const { return static_cast<u32>( offsets.size() ) - 1; }
+
+    //! Returns the pointer to a key data.
+    const u8*       key( u32 index ) const { return &data[offsets[index]]; }
+
+    //! Returns the length of a key.
+    u32             length( u32 index ) const { return offsets[index + 1] - offsets[index]; }
+
+    //! Appends a new key to a set.
+    void            push( const void* key, u32 length )
+                    {
+                        const u8* bytes = reinterpret_cast<const u8*>( key );
+                        if( offsets.empty() ) {
+                            offsets.push_back( 0 );
+                        }
+                        data.insert( data.end(), bytes, bytes + length );
+                        offsets.push_back( static_cast<u32>( data.size() ) );
+                    }
+};
+
+static u64 murmur32( const void* input, u32 length ) { return HashFunction::murmur<u32>( input, length ); }
+static u64 murmur64( const void* input, u32 length ) { return HashFunction::murmur<u64>( input, length ); }
+static u64 djb2( const void* input, u32 length ) { return HashFunction::djb2( input, length ); }
+static u64 sdbm( const void* input, u32 length ) { return HashFunction::sdbm( input, length ); }
+static u64 loseLose( const void* input, u32 length ) { return HashFunction::hash( input, length ); }
+
+//! All hash functions from a HashFunction namespace.
+static const HashFunctionInfo HashFunctions[] = {
+      { "murmur<u32>", 32, murmur32 }
+    , { "murmur<u64>", 64, murmur64 }
+    , { "djb2",        64, djb2     }
+    , { "sdbm",        64, sdbm     }
+    , { "lose lose",   64, loseLose }
+};
+
+//! Total number of tested hash functions.
+static const u32 HashFunctionCount = sizeof( HashFunctions ) / sizeof( HashFunctions[0] );
+
+//! Number of keys in each of generated key sets.
+static const u32 KeyCount = 1 << 20;
+
+//! Number of buckets keys are distributed between.
+static const u32 BucketCount = 1 << 16;
+
+//! Generates sequential 32-bit integer keys.
+static KeySet generateSequentialKeys( void )
+{
+    KeySet keys;
+    keys.name = "sequential u32";
+
+    for( u32 i = 0; i < KeyCount; i++ ) {
+        keys.push( &i, sizeof( i ) );
+    }
+
+    return keys;
+}
+
+//! Generates identifier-like keys that share a common prefix, like the ones found in scene files.
+static KeySet generateIdentifierKeys( void )
+{
+    KeySet keys;
+    keys.name = "identifiers";
+
+    s8 buffer[64];
+    for( u32 i = 0; i < KeyCount; i++ ) {
+        s32 length = snprintf( buffer, sizeof( buffer ), "%s_%u", i & 1 ? "SceneNode" : "Transform", i );
+        keys.push( buffer, length );
+    }
+
+    return keys;
+}
+
+//! Generates random 16-byte keys.
+static KeySet generateRandomKeys( void )
+{
+    KeySet keys;
+    keys.name = "random 16 bytes";
+
+    Benchmark::Generator generator( 1 );
+    u8 buffer[16];
+    for( u32 i = 0; i < KeyCount; i++ ) {
+        generator.fill( buffer, sizeof( buffer ) );
+        keys.push( buffer, sizeof( buffer ) );
+    }
+
+    return keys;
+}
+
+//! Measures the throughput of each hash function for a set of key lengths.
+static void benchmarkThroughput( void )
+{
+    static const u32 KeyLengths[] = { 4, 7, 8, 16, 31, 64, 256, 4096, 65536 };
+    static const u32 BufferSize   = 1 << 20;
+
+    ByteArray buffer;
+    buffer.resize( BufferSize + 65536 + 64 );
+    Benchmark::Generator generator;
+    generator.fill( &buffer[0], static_cast<u32>( buffer.size() ) );
+
+    printf( "\nThroughput, bytes/%s (cycles/hash in parentheses)\n", Benchmark::cyclesUnit() );
+    printf( "%-12s", "length" );
+    for( u32 f = 0; f < HashFunctionCount; f++ ) {
+        printf( "%22s", HashFunctions[f].name );
+    }
+    printf( "\n" );
+
+    for( u32 l = 0; l < sizeof( KeyLengths ) / sizeof( KeyLengths[0] ); l++ ) {
+        u32 length     = KeyLengths[l];
+        u32 iterations = max2<u32>( 16, (1 << 22) / length );
+
+        printf( "%-12u", length );
+
+        for( u32 f = 0; f < HashFunctionCount; f++ ) {
+            const HashFunctionInfo& info = HashFunctions[f];
+            const u8*               data = &buffer[0];
+            u64                     accumulator = 0;
+
+            // Hash keys at varying offsets so that both aligned and unaligned reads are measured
+            f64 cyclesPerHash = Benchmark::measure( [&]( u32 i ) { accumulator += info.hash( data + ((i * 67) & (BufferSize - 1)), length ); }, iterations );
+            Benchmark::doNotOptimize( accumulator );
+
+            s8 cell[32];
+            snprintf( cell, sizeof( cell ), "%.3f (%.1f)", length / cyclesPerHash, cyclesPerHash );
+            printf( "%22s", cell );
+        }
+
+        printf( "\n" );
+    }
+}
+
+//! Measures how often each output bit flips when a single input bit is flipped and reports the worst and mean bias.
+static void testAvalanche( void )
+{
+    static const u32 KeyLengths[] = { 4, 8, 16 };
+    static const u32 Trials       = 10000;
+
+    printf( "\nAvalanche bias, worst / mean %% (ideal is ~%.1f / ~%.1f for %u trials)\n", 400.0 / sqrt( f64( Trials ) ), 56.0 / sqrt( f64( Trials ) ), Trials );
+    printf( "%-12s", "length" );
+    for( u32 f = 0; f < HashFunctionCount; f++ ) {
+        printf( "%22s", HashFunctions[f].name );
+    }
+    printf( "\n" );
+
+    for( u32 l = 0; l < sizeof( KeyLengths ) / sizeof( KeyLengths[0] ); l++ ) {
+        u32 length    = KeyLengths[l];
+        u32 inputBits = length * 8;
+
+        printf( "%-12u", length );
+
+        for( u32 f = 0; f < HashFunctionCount; f++ ) {
+            const HashFunctionInfo& info = HashFunctions[f];
+            Array<u32>              flips;
+            Benchmark::Generator    generator( 2 );
+            u8                      key[16];
+
+            flips.resize( inputBits * info.bits, 0 );
+
+            for( u32 t = 0; t < Trials; t++ ) {
+                generator.fill( key, length );
+                u64 original = info.hash( key, length );
+
+                for( u32 i = 0; i < inputBits; i++ ) {
+                    key[i >> 3] ^= 1 << (i & 7);
+                    u64 diff = original ^ info.hash( key, length );
+                    key[i >> 3] ^= 1 << (i & 7);
+
+                    u32* row = &flips[i * info.bits];
+                    for( u32 j = 0; j < info.bits; j++ ) {
+                        row[j] += (diff >> j) & 1;
+                    }
+                }
+            }
+
+            f64 worst = 0.0;
+            f64 mean  = 0.0;
+            for( u32 i = 0, n = static_cast<u32>( flips.size() ); i < n; i++ ) {
+                f64 bias = fabs( 2.0 * flips[i] / Trials - 1.0 );
+                worst = max2( worst, bias );
+                mean += bias;
+            }
+            mean /= flips.size();
+
+            s8 cell[32];
+            snprintf( cell, sizeof( cell ), "%.2f / %.2f", worst * 100.0, mean * 100.0 );
+            printf( "%22s", cell );
+        }
+
+        printf( "\n" );
+    }
+}
+
+//! Returns an expected maximum bucket load when keys are distributed between buckets uniformly at random.
+static f64 expectedMaxLoad( u32 keys, u32 buckets )
+{
+    // A bucket load follows a Poisson distribution, a maximum load of independent buckets exceeds k with a probability 1 - P(X <= k)^buckets
+    f64        mean = f64( keys ) / buckets;
+    Array<f64> probabilities;
+
+    for( f64 p = exp( -mean ); p > 0.0 || probabilities.size() < mean; p *= mean / probabilities.size() ) {
+        probabilities.push_back( p );
+    }
+
+    f64 result = 0.0;
+    f64 tail   = 0.0;
+
+    for( s32 k = static_cast<s32>( probabilities.size() ) - 1; k >= 0; k-- ) {
+        result += 1.0 - exp( buckets * log1p( -tail ) );
+        tail   += probabilities[k];
+    }
+
+    return result;
+}
+
+//! Hashes keys into a power-of-two number of buckets using the lowest bits and reports the normalized chi-square value and a maximum bucket load.
+static void testDistribution( const KeySet& keys )
+{
+    printf( "%-18s", keys.name );
+
+    for( u32 f = 0; f < HashFunctionCount; f++ ) {
+        const HashFunctionInfo& info = HashFunctions[f];
+        Array<u32>              counts;
+
+        counts.resize( BucketCount, 0 );
+
+        for( u32 i = 0, n = keys.size(); i < n; i++ ) {
+            counts[info.hash( keys.key( i ), keys.length( i ) ) & (BucketCount - 1)]++;
+        }
+
+        f64 expected = f64( keys.size() ) / BucketCount;
+        f64 chi2     = 0.0;
+        u32 maxLoad  = 0;
+        for( u32 i = 0; i < BucketCount; i++ ) {
+            f64 delta = counts[i] - expected;
+            chi2   += delta * delta / expected;
+            maxLoad = max2( maxLoad, counts[i] );
+        }
+
+        s8 cell[32];
+        snprintf( cell, sizeof( cell ), "%.2f (%u)", chi2 / (BucketCount - 1), maxLoad );
+        printf( "%22s", cell );
+    }
+
+    printf( "\n" );
+}
+
+//! Counts the number of colliding hash values for a full and a truncated to 32 bits output.
+static void testCollisions( const KeySet& keys )
+{
+    printf( "%-18s", keys.name );
+
+    for( u32 f = 0; f < HashFunctionCount; f++ ) {
+        const HashFunctionInfo& info = HashFunctions[f];
+        Array<u64>              full;
+        Array<u32>              truncated;
+
+        full.resize( keys.size() );
+        truncated.resize( keys.size() );
+
+        for( u32 i = 0, n = keys.size(); i < n; i++ ) {
+            full[i]      = info.hash( keys.key( i ), keys.length( i ) );
+            truncated[i] = static_cast<u32>( full[i] );
+        }
+
+        std::sort( full.begin(), full.end() );
+        std::sort( truncated.begin(), truncated.end() );
+
+        u32 fullCollisions      = 0;
+        u32 truncatedCollisions = 0;
+        for( u32 i = 1, n = keys.size(); i < n; i++ ) {
+            fullCollisions      += full[i] == full[i - 1];
+            truncatedCollisions += truncated[i] == truncated[i - 1];
+        }
+
+        s8 cell[32];
+        snprintf( cell, sizeof( cell ), "%u / %u", fullCollisions, truncatedCollisions );
+        printf( "%22s", cell );
+    }
+
+    printf( "\n" );
+}
+
+//! Prints a table header with hash function names.
+static void printHeader( CString title )
+{
+    printf( "%-18s", title );
+    for( u32 f = 0; f < HashFunctionCount; f++ ) {
+        printf( "%22s", HashFunctions[f].name );
+    }
+    printf( "\n" );
+}
+
+int main( void )
+{
+    KeySet keySets[] = { generateSequentialKeys(), generateIdentifierKeys(), generateRandomKeys() };
+    u32    keySetCount = sizeof( keySets ) / sizeof( keySets[0] );
+
+    benchmarkThroughput();
+    testAvalanche();
+
+    printf( "\nBucket distribution of %u keys over %u buckets, chi-square / degrees of freedom (max load), ideal is ~1.0 (~%.1f)\n", KeyCount, BucketCount, expectedMaxLoad( KeyCount, BucketCount ) );
+    printHeader( "keys" );
+    for( u32 i = 0; i < keySetCount; i++ ) {
+        testDistribution( keySets[i] );
+    }
+
+    f64 n = KeyCount;
+    printf( "\nCollisions of %u keys, full / truncated to 32 bits (expected ~0 / ~%.0f)\n", KeyCount, n * (n - 1) / 2.0 / 4294967296.0 );
+    printHeader( "keys" );
+    for( u32 i = 0; i < keySetCount; i++ ) {
+        testCollisions( keySets[i] );
+    }
+
+    return 0;
+}
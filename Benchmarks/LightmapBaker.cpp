@@ -0,0 +1,157 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#include "Benchmark.h"
+
+#include <Pointers/UniquePtr.h>
+#include <Color/Rgb.h>
+#include <Color/Rgba.h>
+#include <Math/Random.h>
+#include <Math/Vector.h>
+#include <Math/Vec2.h>
+#include <Math/Vec3.h>
+#include <Math/Vec4.h>
+#include <Math/Quat.h>
+#include <Math/Matrix.h>
+#include <Math/Matrix4.h>
+#include <Math/Samples.h>
+#include <Bv/Bounds.h>
+#include <RectanglePacker.h>
+#include <Math/Plane.h>
+#include <Bv/CullingFrustum.h>
+#include <Math/Ray.h>
+#include <Bv/Bvh.h>
+#include <Math/Mesh.h>
+#include <Bv/TriangleBvh.h>
+#include <Math/LightmapBaker.h>
+
+NIMBLE_IMPORT
+
+//! A mesh vertex with a single lightmap UV set.
+struct Vertex {
+    Vec3    position;   //!< A vertex position.
+    Vec2    uv[1];      //!< A lightmap texture coordinate.
+};
+
+//! A benchmark mesh type.
+typedef TriMesh<Vertex, u32> Mesh;
+
+//! A lightmap baker for a benchmark mesh.
+typedef LightmapBaker<Mesh> Baker;
+
+//! Generates a bumpy terrain made of a grid of quads with a lightmap UV set that covers a whole lightmap.
+static void generateTerrain( Mesh::Vertices& vertices, Mesh::Indices& indices, s32 size )
+{
+    for( s32 y = 0; y <= size; y++ ) {
+        for( s32 x = 0; x <= size; x++ ) {
+            Vertex vertex;
+            vertex.position = Vec3( static_cast<f32>( x ), sinf( x * 0.3f ) * cosf( y * 0.2f ) * 4.0f, static_cast<f32>( y ) );
+            vertex.uv[0]    = Vec2( static_cast<f32>( x ) / size, static_cast<f32>( y ) / size );
+            vertices.push_back( vertex );
+        }
+    }
+
+    for( s32 y = 0; y < size; y++ ) {
+        for( s32 x = 0; x < size; x++ ) {
+            u32 i = y * (size + 1) + x;
+            u32 j = i + size + 1;
+
+            indices.push_back( i ); indices.push_back( j );     indices.push_back( i + 1 );
+            indices.push_back( j ); indices.push_back( j + 1 ); indices.push_back( i + 1 );
+        }
+    }
+}
+
+//! Returns the number of texels which ambient occlusion is out of range or differs between two bakes.
+static s32 validate( const Array<f32>& serial, const Array<f32>& parallel )
+{
+    s32 mismatches = 0;
+
+    for( u32 i = 0; i < serial.size(); i++ ) {
+        if( serial[i] < 0.0f || serial[i] > 1.0f || serial[i] != parallel[i] ) {
+            mismatches++;
+        }
+    }
+
+    return mismatches;
+}
+
+int main( void )
+{
+    s32       sizes[] = { 64, 128, 256 };
+    s32       samples = 32;
+    s32       failed  = 0;
+    JobSystem jobs;
+
+    Array<Baker::Light> lights;
+    lights.push_back( Baker::Light::directional( Vec3( 1.0f, -1.0f, 0.5f ), Rgb( 1.0f, 1.0f, 1.0f ) ) );
+    lights.push_back( Baker::Light::point( Vec3( 32.0f, 16.0f, 32.0f ), Rgb( 256.0f, 128.0f, 64.0f ) ) );
+
+    printf( "\nLightmap bakes of a terrain, %d ambient occlusion samples, ms\n", samples );
+    printf( "%-12s%16s%16s%16s%16s\n", "texels", "setup", "occlusion", "parallel", "direct light" );
+
+    for( u32 i = 0; i < sizeof( sizes ) / sizeof( sizes[0] ); i++ ) {
+        s32            size = sizes[i];
+        Mesh::Vertices vertices;
+        Mesh::Indices  indices;
+
+        generateTerrain( vertices, indices, size / 2 );
+
+        Mesh mesh( vertices, indices );
+
+        u64   start = Benchmark::nanoseconds();
+        Baker baker( mesh, 0, size, size );
+        f64   setup = (Benchmark::nanoseconds() - start) / 1000000.0;
+
+        Array<f32> serial;
+        Array<f32> parallel;
+        Array<Rgb> direct;
+
+        start = Benchmark::nanoseconds();
+        baker.bakeAmbientOcclusion( serial, samples, 8.0f );
+        f64 occlusion = (Benchmark::nanoseconds() - start) / 1000000.0;
+
+        start = Benchmark::nanoseconds();
+        baker.bakeAmbientOcclusion( jobs, parallel, samples, 8.0f );
+        f64 parallelOcclusion = (Benchmark::nanoseconds() - start) / 1000000.0;
+
+        start = Benchmark::nanoseconds();
+        baker.bakeDirectLight( jobs, direct, lights );
+        baker.dilate( direct, 2 );
+        f64 light = (Benchmark::nanoseconds() - start) / 1000000.0;
+
+        failed += validate( serial, parallel );
+        failed += baker.coveredCount() == size * size ? 0 : 1;
+
+        printf( "%-12d%16.2f%16.2f%16.2f%16.2f\n", baker.coveredCount(), setup, occlusion, parallelOcclusion, light );
+    }
+
+    if( failed ) {
+        printf( "\n%d texels were not covered or baked differently by serial and parallel bakes\n", failed );
+    }
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,170 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#include "Benchmark.h"
+
+#include <Allocators/LinearAllocator.h>
+#include <Containers/SpscRingBuffer.h>
+#include <Containers/MpmcQueue.h>
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+NIMBLE_IMPORT
+
+//! A mutex protected deque, the baseline queue.
+class MutexQueue {
+public:
+
+    //! Pushes up to a specified number of items to a queue.
+    s32 push( const u64* items, s32 count )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_items.insert( m_items.end(), items, items + count );
+        return count;
+    }
+
+    //! Pops up to a specified number of items from a queue.
+    s32 pop( u64* items, s32 count )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        s32 popped = min2( count, static_cast<s32>( m_items.size() ) );
+        std::copy( m_items.begin(), m_items.begin() + popped, items );
+        m_items.erase( m_items.begin(), m_items.begin() + popped );
+        return popped;
+    }
+
+private:
+
+    std::mutex      m_mutex;
+    std::deque<u64> m_items;
+};
+
+//! The queue capacity used by a benchmark.
+static const s32 Capacity = 4096;
+
+//! The number of items pushed by a single producer thread.
+static const u64 Iterations = 1 << 22;
+
+//! Measures the throughput of a queue with a number of producer and consumer threads, returns millions of items per second.
+template<typename TQueue>
+static f64 benchmarkQueue( TQueue& queue, s32 producers, s32 consumers, s32 batch )
+{
+    std::vector<std::thread> threads;
+    std::atomic<u64>         consumed( 0 );
+    std::atomic<u64>         checksum( 0 );
+    u64                      total = Iterations * producers;
+    u64                      start = Benchmark::nanoseconds();
+
+    for( s32 p = 0; p < producers; p++ ) {
+        threads.push_back( std::thread( [&]() {
+            Array<u64> items;
+            items.resize( batch );
+
+            for( u64 i = 0; i < Iterations; ) {
+                s32 count = static_cast<s32>( min2<u64>( batch, Iterations - i ) );
+
+                for( s32 j = 0; j < count; j++ ) {
+                    items[j] = i + j;
+                }
+
+                s32 pushed = queue.push( &items[0], count );
+
+                if( pushed == 0 ) {
+                    std::this_thread::yield();
+                }
+
+                i += pushed;
+            }
+        } ) );
+    }
+
+    for( s32 c = 0; c < consumers; c++ ) {
+        threads.push_back( std::thread( [&]() {
+            Array<u64> items;
+            items.resize( batch );
+            u64 sum = 0;
+
+            while( consumed.load( std::memory_order_relaxed ) < total ) {
+                s32 popped = queue.pop( &items[0], batch );
+
+                if( popped == 0 ) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                for( s32 j = 0; j < popped; j++ ) {
+                    sum += items[j];
+                }
+
+                consumed.fetch_add( popped, std::memory_order_relaxed );
+            }
+
+            checksum.fetch_add( sum );
+        } ) );
+    }
+
+    for( size_t i = 0; i < threads.size(); i++ ) {
+        threads[i].join();
+    }
+
+    u64 elapsed = Benchmark::nanoseconds() - start;
+    Benchmark::doNotOptimize( checksum.load() );
+
+    return static_cast<f64>( total ) * 1000.0 / elapsed;
+}
+
+int main( void )
+{
+    s32 batches[] = { 1, 16 };
+
+    printf( "\nSingle producer, single consumer, millions of items/s\n" );
+    printf( "%-12s%16s%16s%16s\n", "batch", "mutex", "SpscRingBuffer", "MpmcQueue" );
+
+    for( s32 i = 0; i < 2; i++ ) {
+        MutexQueue            mutex;
+        SpscRingBuffer<u64>   spsc( Capacity );
+        MpmcQueue<u64>        mpmc( Capacity );
+        printf( "%-12d%16.2f%16.2f%16.2f\n", batches[i], benchmarkQueue( mutex, 1, 1, batches[i] ), benchmarkQueue( spsc, 1, 1, batches[i] ), benchmarkQueue( mpmc, 1, 1, batches[i] ) );
+    }
+
+    s32 maxThreads = max2<s32>( 2, std::thread::hardware_concurrency() );
+
+    printf( "\nMultiple producers and consumers, millions of items/s\n" );
+    printf( "%-12s%-12s%16s%16s\n", "threads", "batch", "mutex", "MpmcQueue" );
+
+    for( s32 threads = 2; threads <= maxThreads; threads *= 2 ) {
+        for( s32 i = 0; i < 2; i++ ) {
+            MutexQueue      mutex;
+            MpmcQueue<u64>  mpmc( Capacity );
+            printf( "%-12d%-12d%16.2f%16.2f\n", threads, batches[i], benchmarkQueue( mutex, threads / 2, threads / 2, batches[i] ), benchmarkQueue( mpmc, threads / 2, threads / 2, batches[i] ) );
+        }
+    }
+
+    return 0;
+}
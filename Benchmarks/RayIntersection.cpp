@@ -0,0 +1,206 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#include "Benchmark.h"
+
+#include <Math/Random.h>
+#include <Math/Vector.h>
+#include <Math/Vec2.h>
+#include <Math/Vec3.h>
+#include <Math/Vec4.h>
+#include <Math/Quat.h>
+#include <Math/Matrix.h>
+#include <Math/Matrix4.h>
+#include <Bv/Bounds.h>
+#include <Math/Plane.h>
+#include <Math/Ray.h>
+#include <Math/RayPacket.h>
+
+NIMBLE_IMPORT
+
+//! The number of rays tested against each primitive.
+static const s32 RayCount = 4096;
+
+//! The number of tested primitives.
+static const s32 PrimitiveCount = 256;
+
+//! Returns a random point inside a cube centered at origin.
+static Vec3 randomPoint( Benchmark::Generator& random, f64 size )
+{
+    return Vec3( static_cast<f32>( (random.unit() - 0.5) * size ), static_cast<f32>( (random.unit() - 0.5) * size ), static_cast<f32>( (random.unit() - 0.5) * size ) );
+}
+
+//! An axis parallel ray tested against a unit box.
+struct AxisParallelRay {
+    Vec3        origin;     //!< A ray origin.
+    Vec3        direction;  //!< A ray direction.
+    bool        hit;        //!< Indicates that a ray should hit a box.
+};
+
+//! Returns the number of axis parallel rays a single ray test or a packet test classifies wrong.
+static s32 validateAxisParallelRays( void )
+{
+    // Rays parallel to a slab that start on it's plane produce a NaN distance, which used to turn misses into hits
+    AxisParallelRay cases[] = {
+          { Vec3( -5.0f, 10.0f, 1.0f ), Vec3( 1.0f, 0.0f,  0.0f ), false }
+        , { Vec3( -5.0f, 10.0f, 0.0f ), Vec3( 1.0f, 0.0f, -0.0f ), false }
+        , { Vec3( -5.0f,  0.5f, 1.0f ), Vec3( 1.0f, 0.0f,  0.0f ), true  }
+        , { Vec3( -5.0f,  0.5f, 0.0f ), Vec3( 1.0f, 0.0f, -0.0f ), true  }
+        , { Vec3(  0.5f,  1.0f, 5.0f ), Vec3( 0.0f, 0.0f, -1.0f ), true  }
+        , { Vec3(  0.5f,  1.0f, 5.0f ), Vec3( 0.0f, 0.0f,  1.0f ), false }
+    };
+
+    Bounds box( Vec3( 0.0f, 0.0f, 0.0f ), Vec3( 1.0f, 1.0f, 1.0f ) );
+    s32    errors = 0;
+
+    for( u32 i = 0; i < sizeof( cases ) / sizeof( cases[0] ); i++ ) {
+        Ray       ray( cases[i].origin, cases[i].direction );
+        RayPacket packet( &ray, 1 );
+        f32       times[RayPacket::MaxRays];
+
+        bool single = ray.intersects( box, reinterpret_cast<f32*>( NULL ), times );
+        bool packed = (packet.intersects( box, times ) & 1) != 0;
+
+        if( single != cases[i].hit || packed != cases[i].hit ) {
+            printf( "Axis parallel ray %d: expected %d, single ray %d, ray packet %d\n", i, cases[i].hit, single, packed );
+            errors++;
+        }
+    }
+
+    return errors;
+}
+
+//! Returns the number of maximum hit times a single ray triangle test and a packet triangle test disagree on.
+static s32 validateTriangleMaxTime( void )
+{
+    // A triangle lies exactly at a time of 4, a maximum time is inclusive for both tests
+    Vec3 v0( -1.0f, -1.0f, 0.0f );
+    Vec3 v1(  1.0f, -1.0f, 0.0f );
+    Vec3 v2(  0.0f,  1.0f, 0.0f );
+    Ray  ray( Vec3( 0.0f, 0.0f, 4.0f ), Vec3( 0.0f, 0.0f, -1.0f ) );
+
+    f32  maxTimes[] = { 3.5f, 4.0f, 4.5f };
+    s32  errors     = 0;
+
+    for( u32 i = 0; i < sizeof( maxTimes ) / sizeof( maxTimes[0] ); i++ ) {
+        RayPacket packet( &ray, 1, maxTimes[i] );
+        f32       times[RayPacket::MaxRays];
+
+        bool expected = maxTimes[i] >= 4.0f;
+        bool single   = ray.intersectsTriangle( v0, v1 - v0, v2 - v0, maxTimes[i] );
+        bool packed   = (packet.intersects( v0, v1, v2, times ) & 1) != 0;
+
+        if( single != expected || packed != expected ) {
+            printf( "Triangle at a maximum time %g: expected %d, single ray %d, ray packet %d\n", maxTimes[i], expected, single, packed );
+            errors++;
+        }
+    }
+
+    return errors;
+}
+
+int main( void )
+{
+    s32 failed = validateAxisParallelRays() + validateTriangleMaxTime();
+
+    Benchmark::Generator random;
+    Array<Ray>           rays;
+    Array<RayPacket>     packets;
+    Array<Bounds>        boxes;
+    Array<Vec3>          triangles;
+
+    for( s32 i = 0; i < RayCount; i++ ) {
+        Vec3 origin = randomPoint( random, 20.0 );
+        rays.push_back( Ray( origin, randomPoint( random, 4.0 ) - origin ) );
+    }
+
+    for( s32 i = 0; i < RayCount; i += RayPacket::MaxRays ) {
+        packets.push_back( RayPacket( &rays[i], RayPacket::MaxRays ) );
+    }
+
+    for( s32 i = 0; i < PrimitiveCount; i++ ) {
+        Vec3 center = randomPoint( random, 4.0 );
+        boxes.push_back( Bounds( center - Vec3( 0.5f, 0.5f, 0.5f ), center + Vec3( 0.5f, 0.5f, 0.5f ) ) );
+        triangles.push_back( center + randomPoint( random, 2.0 ) );
+        triangles.push_back( center + randomPoint( random, 2.0 ) );
+        triangles.push_back( center + randomPoint( random, 2.0 ) );
+    }
+
+    s32 tests = RayCount * PrimitiveCount;
+
+    printf( "\nRay intersection tests, %s/test\n", Benchmark::cyclesUnit() );
+    printf( "%-32s%12s%12s\n", "", "boxes", "triangles" );
+
+    f64 boxScalar = Benchmark::measure( [&]( u32 ) {
+        s32 hits = 0;
+        for( s32 j = 0; j < PrimitiveCount; j++ ) {
+            for( s32 i = 0; i < RayCount; i++ ) {
+                f32 time;
+                hits += rays[i].intersects( boxes[j], reinterpret_cast<f32*>( NULL ), &time );
+            }
+        }
+        Benchmark::doNotOptimize( hits );
+    }, 1 ) / tests;
+
+    f64 triangleScalar = Benchmark::measure( [&]( u32 ) {
+        s32 hits = 0;
+        for( s32 j = 0; j < PrimitiveCount; j++ ) {
+            for( s32 i = 0; i < RayCount; i++ ) {
+                f32 time;
+                hits += rays[i].intersects( triangles[j * 3 + 0], triangles[j * 3 + 1], triangles[j * 3 + 2], &time );
+            }
+        }
+        Benchmark::doNotOptimize( hits );
+    }, 1 ) / tests;
+
+    printf( "%-32s%12.2f%12.2f\n", "Single ray", boxScalar, triangleScalar );
+
+    f64 boxPacket = Benchmark::measure( [&]( u32 ) {
+        u32 hits = 0;
+        f32 times[RayPacket::MaxRays];
+        for( s32 j = 0; j < PrimitiveCount; j++ ) {
+            for( s32 i = 0, n = static_cast<s32>( packets.size() ); i < n; i++ ) {
+                hits ^= packets[i].intersects( boxes[j], times );
+            }
+        }
+        Benchmark::doNotOptimize( hits );
+    }, 1 ) / tests;
+
+    f64 trianglePacket = Benchmark::measure( [&]( u32 ) {
+        u32 hits = 0;
+        f32 times[RayPacket::MaxRays];
+        for( s32 j = 0; j < PrimitiveCount; j++ ) {
+            for( s32 i = 0, n = static_cast<s32>( packets.size() ); i < n; i++ ) {
+                hits ^= packets[i].intersects( triangles[j * 3 + 0], triangles[j * 3 + 1], triangles[j * 3 + 2], times );
+            }
+        }
+        Benchmark::doNotOptimize( hits );
+    }, 1 ) / tests;
+
+    printf( "%-32s%12.2f%12.2f\n", "Ray packet", boxPacket, trianglePacket );
+
+    return failed ? 1 : 0;
+}
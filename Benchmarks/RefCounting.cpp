@@ -0,0 +1,130 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#include "Benchmark.h"
+
+#include <Pointers/Ptr.h>
+
+#include <thread>
+#include <vector>
+
+NIMBLE_IMPORT
+
+//! An object with a virtual reference counting.
+class VirtualObject : public RefCounted {
+public:
+    u32     value;
+};
+
+//! An object with a non-virtual single threaded reference counting.
+class UnsafeObject : public UnsafeRefCounted {
+public:
+    u32     value;
+};
+
+//! An object with a non-virtual atomic reference counting.
+class AtomicObject : public AtomicRefCounted {
+public:
+    u32     value;
+};
+
+//! The number of objects referenced by a benchmark.
+static const u32 ObjectCount = 64;
+
+//! The number of pointer slots that are overwritten by a benchmark.
+static const u32 SlotCount = 1024;
+
+//! The number of pointer assignments made by a single thread.
+static const u32 Iterations = 1 << 22;
+
+//! Measures the cost of a pointer assignment that releases one object and retains another one.
+template<typename TObject>
+static f64 benchmarkAssignment( void )
+{
+    Array< Ptr<TObject> > objects;
+    Array< Ptr<TObject> > slots;
+    slots.resize( SlotCount );
+
+    for( u32 i = 0; i < ObjectCount; i++ ) {
+        objects.push_back( new TObject );
+    }
+
+    f64 cycles = Benchmark::measure( [&]( u32 i ) { slots[(i * 7) & (SlotCount - 1)] = objects[i & (ObjectCount - 1)]; }, Iterations );
+    Benchmark::doNotOptimize( slots[0].get() );
+
+    return cycles;
+}
+
+//! Measures the time of pointer copies made by a number of threads, all threads reference the same objects if shared is true.
+template<typename TObject>
+static f64 benchmarkThreads( u32 threadCount, bool shared )
+{
+    Array< Ptr<TObject> > objects;
+
+    for( u32 i = 0; i < ObjectCount * threadCount; i++ ) {
+        objects.push_back( new TObject );
+    }
+
+    std::vector<std::thread> threads;
+    u64 start = Benchmark::nanoseconds();
+
+    for( u32 t = 0; t < threadCount; t++ ) {
+        threads.push_back( std::thread( [&, t]() {
+            Array< Ptr<TObject> > slots;
+            slots.resize( SlotCount );
+            u32 offset = shared ? 0 : t * ObjectCount;
+
+            for( u32 i = 0; i < Iterations; i++ ) {
+                slots[(i * 7) & (SlotCount - 1)] = objects[offset + (i & (ObjectCount - 1))];
+            }
+        } ) );
+    }
+
+    for( u32 t = 0; t < threadCount; t++ ) {
+        threads[t].join();
+    }
+
+    return static_cast<f64>( Benchmark::nanoseconds() - start ) / Iterations;
+}
+
+int main( void )
+{
+    printf( "\nSingle threaded Ptr assignment, %s/assignment\n", Benchmark::cyclesUnit() );
+    printf( "%-24s%12.2f\n", "RefCounted (virtual)", benchmarkAssignment<VirtualObject>() );
+    printf( "%-24s%12.2f\n", "UnsafeRefCounted", benchmarkAssignment<UnsafeObject>() );
+    printf( "%-24s%12.2f\n", "AtomicRefCounted", benchmarkAssignment<AtomicObject>() );
+
+    u32 maxThreads = max2<u32>( 1, std::thread::hardware_concurrency() );
+
+    printf( "\nAtomicRefCounted Ptr assignment from multiple threads, wall ns/assignment per thread\n" );
+    printf( "%-12s%16s%16s\n", "threads", "private", "shared" );
+
+    for( u32 threads = 1; threads <= maxThreads; threads *= 2 ) {
+        printf( "%-12u%16.2f%16.2f\n", threads, benchmarkThreads<AtomicObject>( threads, false ), benchmarkThreads<AtomicObject>( threads, true ) );
+    }
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#include "Benchmark.h"
+
+#include <Pointers/UniquePtr.h>
+#include <Math/Random.h>
+#include <Math/Vector.h>
+#include <Math/Vec2.h>
+#include <Math/Vec3.h>
+#include <Math/Vec4.h>
+#include <Math/Quat.h>
+#include <Math/Matrix.h>
+#include <Math/Matrix4.h>
+#include <Math/Samples.h>
+#include <Bv/Bounds.h>
+#include <RectanglePacker.h>
+#include <Math/Plane.h>
+#include <Bv/CullingFrustum.h>
+#include <Math/Ray.h>
+#include <Bv/Bvh.h>
+#include <Math/Mesh.h>
+#include <Bv/TriangleBvh.h>
+
+NIMBLE_IMPORT
+
+//! The number of rays cast per measurement.
+static const s32 RayCount = 4096;
+
+//! The number of rays validated against a brute force search.
+static const s32 ValidatedRayCount = 64;
+
+//! A mesh vertex used by a benchmark.
+struct Vertex {
+    Vec3    position;   //!< A vertex position.
+};
+
+//! A benchmark mesh type.
+typedef TriMesh<Vertex, u32> Mesh;
+
+//! Generates a bumpy terrain made of a grid of quads, each split into two triangles.
+static void generateTerrain( Mesh::Vertices& vertices, Mesh::Indices& indices, s32 size )
+{
+    for( s32 y = 0; y <= size; y++ ) {
+        for( s32 x = 0; x <= size; x++ ) {
+            Vertex vertex;
+            vertex.position = Vec3( static_cast<f32>( x ), sinf( x * 0.3f ) * cosf( y * 0.2f ) * 4.0f, static_cast<f32>( y ) );
+            vertices.push_back( vertex );
+        }
+    }
+
+    for( s32 y = 0; y < size; y++ ) {
+        for( s32 x = 0; x < size; x++ ) {
+            u32 i = y * (size + 1) + x;
+            u32 j = i + size + 1;
+
+            indices.push_back( i ); indices.push_back( j );     indices.push_back( i + 1 );
+            indices.push_back( j ); indices.push_back( j + 1 ); indices.push_back( i + 1 );
+        }
+    }
+}
+
+//! Generates rays cast from above a terrain in random downward directions.
+static void generateRays( Array<Ray>& rays, s32 size )
+{
+    Benchmark::Generator random;
+
+    for( s32 i = 0; i < RayCount; i++ ) {
+        Vec3 origin( static_cast<f32>( random.unit() * size ), 8.0f, static_cast<f32>( random.unit() * size ) );
+        Vec3 direction( static_cast<f32>( random.unit() * 2.0 - 1.0 ), -1.0f, static_cast<f32>( random.unit() * 2.0 - 1.0 ) );
+        direction.normalize();
+        rays.push_back( Ray( origin, direction ) );
+    }
+}
+
+//! Returns the number of rays which closest hit found by a tree differs from a brute force search.
+static s32 validate( const Mesh& mesh, const TriangleBvh& bvh, const Array<Ray>& rays )
+{
+    const Mesh::Vertices& vertices   = mesh.vertices();
+    const Mesh::Indices&  indices    = mesh.indices();
+    s32                   mismatches = 0;
+
+    for( s32 i = 0; i < ValidatedRayCount; i++ ) {
+        f32 closest = FLT_MAX;
+
+        for( s32 j = 0, n = mesh.faceCount(); j < n; j++ ) {
+            f32 time;
+
+            if( rays[i].intersects( vertices[indices[j * 3 + 0]].position, vertices[indices[j * 3 + 1]].position, vertices[indices[j * 3 + 2]].position, &time ) ) {
+                closest = min2( closest, time );
+            }
+        }
+
+        TriangleBvh::Hit hit;
+        bool             found = bvh.raycast( rays[i], hit );
+
+        if( found != (closest != FLT_MAX) || (found && fabsf( hit.time - closest ) > 1e-4f * closest) ) {
+            mismatches++;
+        }
+    }
+
+    return mismatches;
+}
+
+int main( void )
+{
+    s32       sizes[] = { 64, 256, 512 };
+    s32       failed  = 0;
+    JobSystem jobs;
+
+    printf( "\nTriangle mesh raycasts, %s/ray\n", Benchmark::cyclesUnit() );
+    printf( "%-12s%16s%16s%16s%16s\n", "triangles", "build, ms", "closest hit", "occluded", "parallel batch" );
+
+    for( u32 i = 0; i < sizeof( sizes ) / sizeof( sizes[0] ); i++ ) {
+        s32            size = sizes[i];
+        Mesh::Vertices vertices;
+        Mesh::Indices  indices;
+        Array<Ray>     rays;
+        TriangleBvh    bvh;
+
+        generateTerrain( vertices, indices, size );
+        generateRays( rays, size );
+
+        Mesh mesh( vertices, indices );
+
+        u64 start = Benchmark::nanoseconds();
+        bvh.build( mesh );
+        f64 build = (Benchmark::nanoseconds() - start) / 1000000.0;
+
+        failed += validate( mesh, bvh, rays );
+
+        Array<TriangleBvh::Hit> hits;
+        Array<u8>               occluded;
+        hits.resize( RayCount );
+        occluded.resize( RayCount );
+
+        f64 closest = Benchmark::measure( [&]( u32 ) {
+            bvh.raycast( &rays[0], RayCount, &hits[0] );
+            Benchmark::doNotOptimize( hits[0].face );
+        }, 1 ) / RayCount;
+
+        f64 shadow = Benchmark::measure( [&]( u32 ) {
+            bvh.occluded( &rays[0], RayCount, &occluded[0] );
+            Benchmark::doNotOptimize( occluded[0] );
+        }, 1 ) / RayCount;
+
+        f64 parallel = Benchmark::measure( [&]( u32 ) {
+            bvh.raycast( jobs, &rays[0], RayCount, &hits[0] );
+            Benchmark::doNotOptimize( hits[0].face );
+        }, 1 ) / RayCount;
+
+        printf( "%-12d%16.2f%16.0f%16.0f%16.0f\n", bvh.triangleCount(), build, closest, shadow, parallel );
+    }
+
+    if( failed ) {
+        printf( "\n%d rays hit a different triangle than a brute force search\n", failed );
+    }
+
+    return failed ? 1 : 0;
+}
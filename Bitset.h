@@ -28,15 +28,175 @@
 #define    __Nimble_Bitset_H__
 
 #include "Globals.h"
+#include "Preprocessor/Simd.h"
 
 NIMBLE_BEGIN
 
+    namespace Private {
+
+        //! Performs a bitwise operation over two arrays of 64-bit words, four or two words at a time when SIMD is available.
+        template<typename TOperation>
+        void combineBitWords( u64* target, const u64* source, s32 count, TOperation operation )
+        {
+            s32 i = 0;
+
+        #if defined( NIMBLE_SIMD_AVX2 )
+            for( ; i + 4 <= count; i += 4 ) {
+                __m256i a = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( target + i ) );
+                __m256i b = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( source + i ) );
+                _mm256_storeu_si256( reinterpret_cast<__m256i*>( target + i ), operation( a, b ) );
+            }
+        #endif  /*  NIMBLE_SIMD_AVX2    */
+
+        #if defined( NIMBLE_SIMD_SSE2 )
+            for( ; i + 2 <= count; i += 2 ) {
+                __m128i a = _mm_loadu_si128( reinterpret_cast<const __m128i*>( target + i ) );
+                __m128i b = _mm_loadu_si128( reinterpret_cast<const __m128i*>( source + i ) );
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( target + i ), operation( a, b ) );
+            }
+        #endif  /*  NIMBLE_SIMD_SSE2    */
+
+            for( ; i < count; i++ ) {
+                target[i] = operation( target[i], source[i] );
+            }
+        }
+
+        //! Bitwise operations on scalar and vector words.
+        struct BitAnd {
+            u64     operator()( u64 a, u64 b ) const { return a & b; }
+        #if defined( NIMBLE_SIMD_SSE2 )
+            __m128i operator()( __m128i a, __m128i b ) const { return _mm_and_si128( a, b ); }
+        #endif  /*  NIMBLE_SIMD_SSE2    */
+        #if defined( NIMBLE_SIMD_AVX2 )
+            __m256i operator()( __m256i a, __m256i b ) const { return _mm256_and_si256( a, b ); }
+        #endif  /*  NIMBLE_SIMD_AVX2    */
+        };
+
+        struct BitOr {
+            u64     operator()( u64 a, u64 b ) const { return a | b; }
+        #if defined( NIMBLE_SIMD_SSE2 )
+            __m128i operator()( __m128i a, __m128i b ) const { return _mm_or_si128( a, b ); }
+        #endif  /*  NIMBLE_SIMD_SSE2    */
+        #if defined( NIMBLE_SIMD_AVX2 )
+            __m256i operator()( __m256i a, __m256i b ) const { return _mm256_or_si256( a, b ); }
+        #endif  /*  NIMBLE_SIMD_AVX2    */
+        };
+
+        struct BitXor {
+            u64     operator()( u64 a, u64 b ) const { return a ^ b; }
+        #if defined( NIMBLE_SIMD_SSE2 )
+            __m128i operator()( __m128i a, __m128i b ) const { return _mm_xor_si128( a, b ); }
+        #endif  /*  NIMBLE_SIMD_SSE2    */
+        #if defined( NIMBLE_SIMD_AVX2 )
+            __m256i operator()( __m256i a, __m256i b ) const { return _mm256_xor_si256( a, b ); }
+        #endif  /*  NIMBLE_SIMD_AVX2    */
+        };
+
+        struct BitAndNot {
+            u64     operator()( u64 a, u64 b ) const { return a & ~b; }
+        #if defined( NIMBLE_SIMD_SSE2 )
+            __m128i operator()( __m128i a, __m128i b ) const { return _mm_andnot_si128( b, a ); }
+        #endif  /*  NIMBLE_SIMD_SSE2    */
+        #if defined( NIMBLE_SIMD_AVX2 )
+            __m256i operator()( __m256i a, __m256i b ) const { return _mm256_andnot_si256( b, a ); }
+        #endif  /*  NIMBLE_SIMD_AVX2    */
+        };
+
+        //! Returns true if two arrays of 64-bit words have any common bits.
+        inline bool intersectBitWords( const u64* a, const u64* b, s32 count )
+        {
+            s32 i = 0;
+
+        #if defined( NIMBLE_SIMD_SSE2 )
+            for( ; i + 2 <= count; i += 2 ) {
+                __m128i common = _mm_and_si128( _mm_loadu_si128( reinterpret_cast<const __m128i*>( a + i ) ), _mm_loadu_si128( reinterpret_cast<const __m128i*>( b + i ) ) );
+
+                if( _mm_movemask_epi8( _mm_cmpeq_epi8( common, _mm_setzero_si128() ) ) != 0xFFFF ) {
+                    return true;
+                }
+            }
+        #endif  /*  NIMBLE_SIMD_SSE2    */
+
+            for( ; i < count; i++ ) {
+                if( a[i] & b[i] ) {
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        //! Returns the total number of set bits in an array of 64-bit words.
+        inline u32 countBitWords( const u64* words, s32 count )
+        {
+            u32 result = 0;
+
+            for( s32 i = 0; i < count; i++ ) {
+                result += countSetBits( words[i] );
+            }
+
+            return result;
+        }
+
+        //! Returns the index of a first set bit that is greater or equal to a specified one, or -1 if there is no such bit.
+        inline s32 findBitWords( const u64* words, s32 count, u32 bit )
+        {
+            s32 word = static_cast<s32>( bit >> 6 );
+
+            if( word >= count ) {
+                return -1;
+            }
+
+            // Mask out bits below the start one
+            u64 bits = words[word] & (~static_cast<u64>( 0 ) << (bit & 63));
+
+            while( !bits ) {
+                if( ++word >= count ) {
+                    return -1;
+                }
+
+                bits = words[word];
+            }
+
+            return word * 64 + countTrailingZeros( bits );
+        }
+
+        //! Invokes a callback for each set bit in an array of 64-bit words in an ascending order.
+        template<typename TCallback>
+        void forEachBitWord( const u64* words, s32 count, const TCallback& callback )
+        {
+            for( s32 i = 0; i < count; i++ ) {
+                // Visit set bits from the lowest one, clearing each visited bit
+                for( u64 bits = words[i]; bits; bits &= bits - 1 ) {
+                    callback( static_cast<u32>( i * 64 + countTrailingZeros( bits ) ) );
+                }
+            }
+        }
+
+        //! Compares two arrays of 64-bit words as big integers, missing high words are treated as zeros.
+        inline s32 compareBitWords( const u64* a, s32 countA, const u64* b, s32 countB )
+        {
+            for( s32 i = max2( countA, countB ) - 1; i >= 0; i-- ) {
+                u64 wordA = i < countA ? a[i] : 0;
+                u64 wordB = i < countB ? b[i] : 0;
+
+                if( wordA != wordB ) {
+                    return wordA < wordB ? -1 : 1;
+                }
+            }
+
+            return 0;
+        }
+
+    } // namespace Private
+
     // ** class Bitset
+    //! A bitset that grows when a bit outside its size is set, bits are stored in 64-bit words.
     class Bitset {
     public:
 
                                     //! Constructs an empty bitset.
-                                    Bitset( void ) : m_bits( 1 ) { clear(); }
+                                    Bitset( void ) : m_words( 1 ) { clear(); }
 
         //! Returns true if a bitset has at least one bit set.
                                     operator bool( void ) const;
@@ -44,6 +204,9 @@ NIMBLE_BEGIN
         //! Compares two bitsets.
         bool                        operator < ( const Bitset& other ) const;
 
+        //! Returns true if two bitsets are equal.
+        bool                        operator == ( const Bitset& other ) const;
+
         //! Returns true if two bitsets are not equal.
         bool                        operator != ( const Bitset& other ) const;
 
@@ -56,9 +219,34 @@ NIMBLE_BEGIN
         //! Returns true if two bitsets have an intersection.
         bool                        operator * ( const Bitset& other ) const;
 
+        //! Intersects this bitset with another one.
+        Bitset&                     operator &= ( const Bitset& other );
+
+        //! Adds all bits of another bitset to this one.
+        Bitset&                     operator |= ( const Bitset& other );
+
+        //! Toggles all bits that are set in another bitset.
+        Bitset&                     operator ^= ( const Bitset& other );
+
+        //! Clears all bits that are set in another bitset.
+        Bitset&                     andNot( const Bitset& other );
+
         //! Returns a bitset size.
         unsigned int                size( void ) const;
 
+        //! Returns the total number of set bits.
+        u32                         count( void ) const;
+
+        //! Returns the index of a first set bit, or -1 if a bitset is empty.
+        s32                         findFirst( void ) const;
+
+        //! Returns the index of a first set bit after a specified one, or -1 if there are no such bits.
+        s32                         findNext( unsigned int bit ) const;
+
+        //! Invokes a callback for each set bit in an ascending order.
+        template<typename TCallback>
+        void                        forEachSetBit( const TCallback& callback ) const;
+
         //! Turns on a given bit.
         void                        set( unsigned int bit );
 
@@ -76,8 +264,13 @@ NIMBLE_BEGIN
 
     private:
 
-        //! Bitset buffer.
-        std::vector<unsigned char>    m_bits;
+        //! Returns the number of words.
+        s32                         wordCount( void ) const;
+
+    private:
+
+        //! Bitset words.
+        std::vector<u64>            m_words;
     };
 
     // ** Bitset::withSingleBit
@@ -87,11 +280,17 @@ NIMBLE_BEGIN
         return bitset;
     }
 
+    // ** Bitset::wordCount
+    inline s32 Bitset::wordCount( void ) const
+    {
+        return static_cast<s32>( m_words.size() );
+    }
+
     // ** Bitset::operator bool
     inline Bitset::operator bool( void ) const
     {
-        for( size_t i = 0, n = m_bits.size(); i < n; i++ ) {
-            if( m_bits[i] ) return true;
+        for( size_t i = 0, n = m_words.size(); i < n; i++ ) {
+            if( m_words[i] ) return true;
         }
 
         return false;
@@ -100,95 +299,385 @@ NIMBLE_BEGIN
     // ** Bitset::operator <
     inline bool Bitset::operator < ( const Bitset& other ) const
     {
-        u32 bit = max2( size(), other.size() );
-
-        while( bit-- ) {
-            bool a = is( bit );
-            bool b = other.is( bit );
-
-            if( a != b ) {
-                return a ? false : true;
-            }
-        }
+        return Private::compareBitWords( &m_words[0], wordCount(), &other.m_words[0], other.wordCount() ) < 0;
+    }
 
-        return false;
+    // ** Bitset::operator ==
+    inline bool Bitset::operator == ( const Bitset& other ) const
+    {
+        return Private::compareBitWords( &m_words[0], wordCount(), &other.m_words[0], other.wordCount() ) == 0;
     }
 
     // ** Bitset::operator !=
     inline bool Bitset::operator != ( const Bitset& other ) const
     {
-        u32 bit = max2( size(), other.size() );
-
-        while( bit-- ) {
-            if( is( bit ) != other.is( bit ) ) {
-                return true;
-            }
-        }
-
-        return false;
+        return !(*this == other);
     }
 
     // ** Bitset::operator *
     inline bool Bitset::operator * ( const Bitset& other ) const {
-        size_t size = std::min( m_bits.size(), other.m_bits.size() );
-
-        for( size_t i = 0; i < size; i++ ) {
-            if( m_bits[i] & other.m_bits[i] ) {
-                return true;
-            }
-        }
-
-        return false;
+        return Private::intersectBitWords( &m_words[0], &other.m_words[0], min2( wordCount(), other.wordCount() ) );
     }
 
     // ** Bitset::size
     inline unsigned int Bitset::size( void ) const
     {
-        return static_cast<unsigned int>(m_bits.size()) * 8;
+        return static_cast<unsigned int>(m_words.size()) * 64;
+    }
+
+    // ** Bitset::count
+    inline u32 Bitset::count( void ) const
+    {
+        return Private::countBitWords( &m_words[0], wordCount() );
+    }
+
+    // ** Bitset::findFirst
+    inline s32 Bitset::findFirst( void ) const
+    {
+        return Private::findBitWords( &m_words[0], wordCount(), 0 );
+    }
+
+    // ** Bitset::findNext
+    inline s32 Bitset::findNext( unsigned int bit ) const
+    {
+        return Private::findBitWords( &m_words[0], wordCount(), bit + 1 );
+    }
+
+    // ** Bitset::forEachSetBit
+    template<typename TCallback>
+    void Bitset::forEachSetBit( const TCallback& callback ) const
+    {
+        Private::forEachBitWord( &m_words[0], wordCount(), callback );
+    }
+
+    // ** Bitset::operator &
+    inline Bitset Bitset::operator & ( const Bitset& other ) const {
+        Bitset result = *this;
+        result &= other;
+        return result;
     }
 
     // ** Bitset::operator |
     inline Bitset Bitset::operator | ( const Bitset& other ) const {
-        Bitset result;
+        Bitset result = *this;
+        result |= other;
+        return result;
+    }
 
-        int nBits = std::max( size(), other.size() );
+    // ** Bitset::operator &=
+    inline Bitset& Bitset::operator &= ( const Bitset& other ) {
+        s32 common = min2( wordCount(), other.wordCount() );
+        Private::combineBitWords( &m_words[0], &other.m_words[0], common, Private::BitAnd() );
 
-        for( int i = 0; i < nBits; i++ ) {
-            if( is( i ) || other.is( i ) ) result.set( i );
+        // Words missing in another bitset are zeros
+        for( s32 i = common, n = wordCount(); i < n; i++ ) {
+            m_words[i] = 0;
         }
 
-        return result;
+        return *this;
+    }
+
+    // ** Bitset::operator |=
+    inline Bitset& Bitset::operator |= ( const Bitset& other ) {
+        if( other.wordCount() > wordCount() ) {
+            m_words.resize( other.m_words.size(), 0 );
+        }
+
+        Private::combineBitWords( &m_words[0], &other.m_words[0], other.wordCount(), Private::BitOr() );
+        return *this;
+    }
+
+    // ** Bitset::operator ^=
+    inline Bitset& Bitset::operator ^= ( const Bitset& other ) {
+        if( other.wordCount() > wordCount() ) {
+            m_words.resize( other.m_words.size(), 0 );
+        }
+
+        Private::combineBitWords( &m_words[0], &other.m_words[0], other.wordCount(), Private::BitXor() );
+        return *this;
+    }
+
+    // ** Bitset::andNot
+    inline Bitset& Bitset::andNot( const Bitset& other ) {
+        Private::combineBitWords( &m_words[0], &other.m_words[0], min2( wordCount(), other.wordCount() ), Private::BitAndNot() );
+        return *this;
     }
 
     // ** Bitset::set
     inline void Bitset::set( unsigned int bit ) {
-        unsigned int idx = bit >> 3;
+        unsigned int idx = bit >> 6;
 
-        if( idx >= m_bits.size() ) {
-            m_bits.resize( idx + 1 );
+        if( idx >= m_words.size() ) {
+            m_words.resize( idx + 1, 0 );
         }
 
-        m_bits[idx] |= (1 << (bit & 7));
+        m_words[idx] |= static_cast<u64>( 1 ) << (bit & 63);
     }
 
     // ** Bitset::is
     inline bool Bitset::is( unsigned int bit ) const {
-        unsigned int idx = bit >> 3;
-        return ( idx < m_bits.size() && m_bits[idx] & (1 << (bit & 7 )) ) ? true : false;
+        unsigned int idx = bit >> 6;
+        return ( idx < m_words.size() && m_words[idx] & (static_cast<u64>( 1 ) << (bit & 63)) ) ? true : false;
     }
 
     // ** Bitset::clear
     inline void Bitset::clear( unsigned int bit ) {
-        unsigned int idx = bit >> 3;
+        unsigned int idx = bit >> 6;
 
-        if( idx < m_bits.size() ) {
-            m_bits[idx] &= ~(1 << (bit & 7));
+        if( idx < m_words.size() ) {
+            m_words[idx] &= ~(static_cast<u64>( 1 ) << (bit & 63));
         }
     }
 
     // ** Bitset::clear
     inline void Bitset::clear( void ) {
-        memset( &m_bits[0], 0, m_bits.size() );
+        memset( &m_words[0], 0, m_words.size() * sizeof( u64 ) );
+    }
+
+    //! A bitset with a fixed number of bits, that are stored inline in 64-bit words.
+    template<u32 TBits>
+    class FixedBitset {
+    public:
+
+        //! The number of words used to store bits.
+        enum { WordCount = (TBits + 63) / 64 };
+
+                                    //! Constructs an empty bitset.
+                                    FixedBitset( void ) { clear(); }
+
+        //! Returns true if a bitset has at least one bit set.
+                                    operator bool( void ) const;
+
+        //! Compares two bitsets.
+        bool                        operator < ( const FixedBitset& other ) const;
+
+        //! Returns true if two bitsets are equal.
+        bool                        operator == ( const FixedBitset& other ) const;
+
+        //! Returns true if two bitsets are not equal.
+        bool                        operator != ( const FixedBitset& other ) const;
+
+        //! Returns an intersection of bitsets.
+        FixedBitset                 operator & ( const FixedBitset& other ) const;
+
+        //! Returns a union of bitsets.
+        FixedBitset                 operator | ( const FixedBitset& other ) const;
+
+        //! Returns true if two bitsets have an intersection.
+        bool                        operator * ( const FixedBitset& other ) const;
+
+        //! Intersects this bitset with another one.
+        FixedBitset&                operator &= ( const FixedBitset& other );
+
+        //! Adds all bits of another bitset to this one.
+        FixedBitset&                operator |= ( const FixedBitset& other );
+
+        //! Toggles all bits that are set in another bitset.
+        FixedBitset&                operator ^= ( const FixedBitset& other );
+
+        //! Clears all bits that are set in another bitset.
+        FixedBitset&                andNot( const FixedBitset& other );
+
+        //! Returns a bitset size.
+        unsigned int                size( void ) const;
+
+        //! Returns the total number of set bits.
+        u32                         count( void ) const;
+
+        //! Returns the index of a first set bit, or -1 if a bitset is empty.
+        s32                         findFirst( void ) const;
+
+        //! Returns the index of a first set bit after a specified one, or -1 if there are no such bits.
+        s32                         findNext( unsigned int bit ) const;
+
+        //! Invokes a callback for each set bit in an ascending order.
+        template<typename TCallback>
+        void                        forEachSetBit( const TCallback& callback ) const;
+
+        //! Turns on a given bit.
+        void                        set( unsigned int bit );
+
+        //! Checks a given bit
+        bool                        is( unsigned int bit ) const;
+
+        //! Clears a given bit
+        void                        clear( unsigned int bit );
+
+        //! Clears a bitset.
+        void                        clear( void );
+
+        //! Creates a bitset with just a single bit set.
+        static FixedBitset          withSingleBit( unsigned int bit );
+
+    private:
+
+        //! Bitset words.
+        u64                         m_words[WordCount];
+    };
+
+    // ** FixedBitset::withSingleBit
+    template<u32 TBits>
+    FixedBitset<TBits> FixedBitset<TBits>::withSingleBit( unsigned int bit )
+    {
+        FixedBitset bitset;
+        bitset.set( bit );
+        return bitset;
+    }
+
+    // ** FixedBitset::operator bool
+    template<u32 TBits>
+    FixedBitset<TBits>::operator bool( void ) const
+    {
+        for( s32 i = 0; i < WordCount; i++ ) {
+            if( m_words[i] ) return true;
+        }
+
+        return false;
+    }
+
+    // ** FixedBitset::operator <
+    template<u32 TBits>
+    bool FixedBitset<TBits>::operator < ( const FixedBitset& other ) const
+    {
+        return Private::compareBitWords( m_words, WordCount, other.m_words, WordCount ) < 0;
+    }
+
+    // ** FixedBitset::operator ==
+    template<u32 TBits>
+    bool FixedBitset<TBits>::operator == ( const FixedBitset& other ) const
+    {
+        return memcmp( m_words, other.m_words, sizeof( m_words ) ) == 0;
+    }
+
+    // ** FixedBitset::operator !=
+    template<u32 TBits>
+    bool FixedBitset<TBits>::operator != ( const FixedBitset& other ) const
+    {
+        return !(*this == other);
+    }
+
+    // ** FixedBitset::operator &
+    template<u32 TBits>
+    FixedBitset<TBits> FixedBitset<TBits>::operator & ( const FixedBitset& other ) const
+    {
+        FixedBitset result = *this;
+        result &= other;
+        return result;
+    }
+
+    // ** FixedBitset::operator |
+    template<u32 TBits>
+    FixedBitset<TBits> FixedBitset<TBits>::operator | ( const FixedBitset& other ) const
+    {
+        FixedBitset result = *this;
+        result |= other;
+        return result;
+    }
+
+    // ** FixedBitset::operator *
+    template<u32 TBits>
+    bool FixedBitset<TBits>::operator * ( const FixedBitset& other ) const
+    {
+        return Private::intersectBitWords( m_words, other.m_words, WordCount );
+    }
+
+    // ** FixedBitset::operator &=
+    template<u32 TBits>
+    FixedBitset<TBits>& FixedBitset<TBits>::operator &= ( const FixedBitset& other )
+    {
+        Private::combineBitWords( m_words, other.m_words, WordCount, Private::BitAnd() );
+        return *this;
+    }
+
+    // ** FixedBitset::operator |=
+    template<u32 TBits>
+    FixedBitset<TBits>& FixedBitset<TBits>::operator |= ( const FixedBitset& other )
+    {
+        Private::combineBitWords( m_words, other.m_words, WordCount, Private::BitOr() );
+        return *this;
+    }
+
+    // ** FixedBitset::operator ^=
+    template<u32 TBits>
+    FixedBitset<TBits>& FixedBitset<TBits>::operator ^= ( const FixedBitset& other )
+    {
+        Private::combineBitWords( m_words, other.m_words, WordCount, Private::BitXor() );
+        return *this;
+    }
+
+    // ** FixedBitset::andNot
+    template<u32 TBits>
+    FixedBitset<TBits>& FixedBitset<TBits>::andNot( const FixedBitset& other )
+    {
+        Private::combineBitWords( m_words, other.m_words, WordCount, Private::BitAndNot() );
+        return *this;
+    }
+
+    // ** FixedBitset::size
+    template<u32 TBits>
+    unsigned int FixedBitset<TBits>::size( void ) const
+    {
+        return TBits;
+    }
+
+    // ** FixedBitset::count
+    template<u32 TBits>
+    u32 FixedBitset<TBits>::count( void ) const
+    {
+        return Private::countBitWords( m_words, WordCount );
+    }
+
+    // ** FixedBitset::findFirst
+    template<u32 TBits>
+    s32 FixedBitset<TBits>::findFirst( void ) const
+    {
+        return Private::findBitWords( m_words, WordCount, 0 );
+    }
+
+    // ** FixedBitset::findNext
+    template<u32 TBits>
+    s32 FixedBitset<TBits>::findNext( unsigned int bit ) const
+    {
+        return Private::findBitWords( m_words, WordCount, bit + 1 );
+    }
+
+    // ** FixedBitset::forEachSetBit
+    template<u32 TBits>
+    template<typename TCallback>
+    void FixedBitset<TBits>::forEachSetBit( const TCallback& callback ) const
+    {
+        Private::forEachBitWord( m_words, WordCount, callback );
+    }
+
+    // ** FixedBitset::set
+    template<u32 TBits>
+    void FixedBitset<TBits>::set( unsigned int bit )
+    {
+        NIMBLE_BREAK_IF( bit >= TBits, "bit index is out of range" );
+        m_words[bit >> 6] |= static_cast<u64>( 1 ) << (bit & 63);
+    }
+
+    // ** FixedBitset::is
+    template<u32 TBits>
+    bool FixedBitset<TBits>::is( unsigned int bit ) const
+    {
+        return bit < TBits && (m_words[bit >> 6] & (static_cast<u64>( 1 ) << (bit & 63))) != 0;
+    }
+
+    // ** FixedBitset::clear
+    template<u32 TBits>
+    void FixedBitset<TBits>::clear( unsigned int bit )
+    {
+        if( bit < TBits ) {
+            m_words[bit >> 6] &= ~(static_cast<u64>( 1 ) << (bit & 63));
+        }
+    }
+
+    // ** FixedBitset::clear
+    template<u32 TBits>
+    void FixedBitset<TBits>::clear( void )
+    {
+        memset( m_words, 0, sizeof( m_words ) );
     }
 
 NIMBLE_END
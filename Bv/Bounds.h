@@ -28,6 +28,13 @@
 #define __Nimble_Bounds_H__
 
 #include "../Globals.h"
+#include "../Math/Samples.h"
+
+#include <float.h>
+
+#if NIMBLE_CPP11_ENABLED
+    #include "../Threading/ParallelAlgorithms.h"
+#endif  /*  NIMBLE_CPP11_ENABLED    */
 
 NIMBLE_BEGIN
 
@@ -104,12 +111,20 @@ NIMBLE_BEGIN
         //! Returns true if the point is inside the bounding box.
         bool            contains( const Vec3& point ) const;
 
+        //! Returns true if two bounding boxes overlap, touching boxes are considered overlapping.
+        bool            overlaps( const Bounds& other ) const;
+
         //! Returns a random point in bounding box.
         Vec3            randomPointInside( void ) const;
 
         //! Constructs bounding box from an array of points.
         static Bounds   fromPoints( const Vec3* points, s32 count );
 
+    #if NIMBLE_CPP11_ENABLED
+        //! Constructs bounding box from an array of points in parallel.
+        static Bounds   fromPoints( JobSystem& jobs, const Vec3* points, s32 count );
+    #endif  /*  NIMBLE_CPP11_ENABLED    */
+
         //! Constructs a bounding cube from a inscribed sphere radius and a center point.
         static Bounds   fromSphere( const Vec3& center, f32 radius );
 
@@ -228,6 +243,16 @@ NIMBLE_BEGIN
         return true;
     }
 
+    // ** Bounds::overlaps
+    inline bool Bounds::overlaps( const Bounds& other ) const
+    {
+        if( m_min.x > other.m_max.x || m_max.x < other.m_min.x ) return false;
+        if( m_min.y > other.m_max.y || m_max.y < other.m_min.y ) return false;
+        if( m_min.z > other.m_max.z || m_max.z < other.m_min.z ) return false;
+
+        return true;
+    }
+
     // ** Bounds::operator <<
     inline Bounds& Bounds::operator << ( const Vec3& point ) {
         for( int i = 0; i < 3; i++ ) {
@@ -284,6 +309,16 @@ NIMBLE_BEGIN
         return result;
     }
 
+#if NIMBLE_CPP11_ENABLED
+    // ** Bounds::fromPoints
+    inline Bounds Bounds::fromPoints( JobSystem& jobs, const Vec3* points, s32 count )
+    {
+        return parallelReduce( jobs, count, Bounds()
+                             , [points]( s32 begin, s32 end ) { return fromPoints( points + begin, end - begin ); }
+                             , []( Bounds a, const Bounds& b ) { return a += b; } );
+    }
+#endif  /*  NIMBLE_CPP11_ENABLED    */
+
     // ** Bounds::fromSphere
     inline Bounds Bounds::fromSphere( const Vec3& center, f32 radius )
     {
@@ -441,6 +476,25 @@ NIMBLE_BEGIN
         //! Constructs a bounding sphere from an array of points.
         static Sphere   fromPoints( const Vec3* points, s32 count );
 
+    #if NIMBLE_CPP11_ENABLED
+        //! Constructs a bounding sphere from an array of points in parallel.
+        static Sphere   fromPoints( JobSystem& jobs, const Vec3* points, s32 count );
+    #endif  /*  NIMBLE_CPP11_ENABLED    */
+
+        //! Constructs a bounding sphere from an array of points with a Ritter's algorithm, a result is usually a few percents larger than a minimal sphere.
+        static Sphere   ritterFromPoints( const Vec3* points, s32 count );
+
+        //! Constructs a minimal bounding sphere from an array of points with a Welzl's algorithm using a move-to-front heuristic.
+        static Sphere   minimalFromPoints( const Vec3* points, s32 count );
+
+    private:
+
+        //! Constructs a smallest sphere that passes through up to four support points.
+        static Sphere   circumscribed( const Vec3* support, s32 count );
+
+        //! Constructs a minimal sphere that encloses list items preceding an end item and passes through support points.
+        static Sphere   moveToFront( const Vec3* points, s32* next, s32* prev, s32& head, s32 end, Vec3* support, s32 supportCount );
+
     private:
 
         Vec3            m_center;    //!< The center point of a sphere.
@@ -503,6 +557,429 @@ NIMBLE_BEGIN
         return result;
     }
 
+#if NIMBLE_CPP11_ENABLED
+    // ** Sphere::fromPoints
+    inline Sphere Sphere::fromPoints( JobSystem& jobs, const Vec3* points, s32 count )
+    {
+        NIMBLE_ABORT_IF( count == 0, "no points to construct a bounding sphere" );
+
+        Sphere result;
+        result.m_center = parallelReduce( jobs, count, Vec3( 0.0f, 0.0f, 0.0f )
+                                        , [points]( s32 begin, s32 end ) { Vec3 sum( 0.0f, 0.0f, 0.0f ); for( s32 i = begin; i < end; i++ ) sum += points[i]; return sum; }
+                                        , []( const Vec3& a, const Vec3& b ) { return a + b; } );
+        result.m_center /= static_cast<f32>( count );
+
+        const Vec3& center = result.m_center;
+        result.m_radius = parallelReduce( jobs, count, 0.0f
+                                        , [points, &center]( s32 begin, s32 end ) { f32 radius = 0.0f; for( s32 i = begin; i < end; i++ ) radius = max2( radius, (center - points[i]).length() ); return radius; }
+                                        , []( f32 a, f32 b ) { return max2( a, b ); } );
+
+        return result;
+    }
+#endif  /*  NIMBLE_CPP11_ENABLED    */
+
+    // ** Sphere::ritterFromPoints
+    inline Sphere Sphere::ritterFromPoints( const Vec3* points, s32 count )
+    {
+        NIMBLE_ABORT_IF( count == 0, "no points to construct a bounding sphere" );
+
+        // Find an approximately most distant pair of points
+        s32 a = 0;
+        s32 b = 0;
+
+        for( s32 i = 1; i < count; i++ ) {
+            if( (points[i] - points[0]).lengthSqr() > (points[a] - points[0]).lengthSqr() ) {
+                a = i;
+            }
+        }
+
+        for( s32 i = 1; i < count; i++ ) {
+            if( (points[i] - points[a]).lengthSqr() > (points[b] - points[a]).lengthSqr() ) {
+                b = i;
+            }
+        }
+
+        Sphere result( (points[a] + points[b]) * 0.5f, (points[b] - points[a]).length() * 0.5f );
+
+        // Grow a sphere to include points that lie outside
+        for( s32 i = 0; i < count; i++ ) {
+            f32 distance = (points[i] - result.m_center).length();
+
+            if( distance <= result.m_radius ) {
+                continue;
+            }
+
+            f32 radius = (result.m_radius + distance) * 0.5f;
+            result.m_center += (points[i] - result.m_center) * ((radius - result.m_radius) / distance);
+            result.m_radius  = radius;
+        }
+
+        // A moved center is rounded, so a radius is padded by a distance round-off error
+        result.m_radius += 4.0f * FLT_EPSILON * (fabsf( result.m_center.x ) + fabsf( result.m_center.y ) + fabsf( result.m_center.z ) + result.m_radius);
+
+        return result;
+    }
+
+    // ** Sphere::minimalFromPoints
+    inline Sphere Sphere::minimalFromPoints( const Vec3* points, s32 count )
+    {
+        NIMBLE_ABORT_IF( count == 0, "no points to construct a bounding sphere" );
+
+        // Points are shuffled to get an expected linear running time on sorted inputs and
+        // are moved to an origin to reduce a round-off error of circumscribed spheres
+        Array<Vec3> local;
+        local.resize( count );
+
+        for( s32 i = 0; i < count; i++ ) {
+            local[i] = points[i] - points[0];
+        }
+
+        u32 state = 0x9E3779B9u;
+
+        for( s32 i = count - 1; i > 0; i-- ) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+
+            s32  j    = static_cast<s32>( state % static_cast<u32>( i + 1 ) );
+            Vec3 temp = local[i];
+            local[i]  = local[j];
+            local[j]  = temp;
+        }
+
+        // A doubly linked list of points, so a point can be moved to front while preceding points are reordered
+        Array<s32> next;
+        Array<s32> prev;
+        next.resize( count );
+        prev.resize( count );
+
+        for( s32 i = 0; i < count; i++ ) {
+            next[i] = i + 1 < count ? i + 1 : -1;
+            prev[i] = i - 1;
+        }
+
+        s32  head = 0;
+        Vec3 support[4];
+
+        Sphere result = moveToFront( &local[0], &next[0], &prev[0], head, -1, support, 0 );
+
+        // A radius is recomputed from input points around a translated center and is padded by a distance round-off error,
+        // so neither a translation nor a local solution error leaves a point outside
+        result.m_center += points[0];
+        result.m_radius  = 0.0f;
+
+        for( s32 i = 0; i < count; i++ ) {
+            result.m_radius = max2( result.m_radius, (points[i] - result.m_center).length() );
+        }
+
+        result.m_radius += 4.0f * FLT_EPSILON * (fabsf( result.m_center.x ) + fabsf( result.m_center.y ) + fabsf( result.m_center.z ) + result.m_radius);
+
+        return result;
+    }
+
+    // ** Sphere::moveToFront
+    inline Sphere Sphere::moveToFront( const Vec3* points, s32* next, s32* prev, s32& head, s32 end, Vec3* support, s32 supportCount )
+    {
+        Sphere result = circumscribed( support, supportCount );
+
+        if( supportCount == 4 ) {
+            return result;
+        }
+
+        for( s32 i = head; i != end; ) {
+            s32 following = next[i];
+
+            if( result.m_radius < 0.0f || (points[i] - result.m_center).lengthSqr() > result.m_radius * result.m_radius * 1.00001f + 1e-12f ) {
+                support[supportCount] = points[i];
+                result = moveToFront( points, next, prev, head, i, support, supportCount + 1 );
+
+                // Move a point to the list front
+                if( i != head ) {
+                    next[prev[i]] = following;
+                    if( following != -1 ) prev[following] = prev[i];
+                    prev[i]    = -1;
+                    next[i]    = head;
+                    prev[head] = i;
+                    head       = i;
+                }
+            }
+
+            i = following;
+        }
+
+        return result;
+    }
+
+    // ** Sphere::circumscribed
+    inline Sphere Sphere::circumscribed( const Vec3* support, s32 count )
+    {
+        switch( count ) {
+        case 0: return Sphere( Vec3( 0.0f, 0.0f, 0.0f ), -1.0f );
+        case 1: return Sphere( support[0], 0.0f );
+        case 2: return Sphere( (support[0] + support[1]) * 0.5f, (support[1] - support[0]).length() * 0.5f );
+        }
+
+        Vec3 a = support[1] - support[0];
+        Vec3 b = support[2] - support[0];
+        Vec3 n = a % b;
+        f32  d = n * n;
+
+        // Nearly degenerate support sets are replaced by a largest sphere over a smaller subset
+        if( count == 3 ) {
+            if( d > 1e-10f * (a * a) * (b * b) ) {
+                Vec3 offset = ((n % a) * (b * b) + (b % n) * (a * a)) / (2.0f * d);
+                return Sphere( support[0] + offset, offset.length() );
+            }
+        } else {
+            Vec3 c   = support[3] - support[0];
+            f32  det = a * (b % c);
+
+            if( fabsf( det ) > 1e-6f * a.length() * b.length() * c.length() ) {
+                Vec3 offset = ((b % c) * (a * a) + (c % a) * (b * b) + (a % b) * (c * c)) / (2.0f * det);
+                return Sphere( support[0] + offset, offset.length() );
+            }
+        }
+
+        Sphere result = circumscribed( support + 1, count - 1 );
+
+        for( s32 i = 0; i < count - 1; i++ ) {
+            Vec3 subset[3];
+            for( s32 j = 0, k = 0; j < count; j++ ) {
+                if( j != i ) subset[k++] = support[j];
+            }
+
+            Sphere sphere = circumscribed( subset, count - 1 );
+            if( sphere.m_radius > result.m_radius ) {
+                result = sphere;
+            }
+        }
+
+        return result;
+    }
+
+    //! A bounding box with arbitrary orthonormal axes.
+    class OrientedBounds {
+    public:
+
+                        //! Constructs an empty OrientedBounds instance.
+                        OrientedBounds( void );
+
+                        //! Constructs an OrientedBounds instance from a center point, orthonormal axes and half sizes along them.
+                        OrientedBounds( const Vec3& center, const Vec3& axisX, const Vec3& axisY, const Vec3& axisZ, const Vec3& extents );
+
+        //! Returns a box center point.
+        const Vec3&     center( void ) const;
+
+        //! Returns a box axis by an index.
+        const Vec3&     axis( s32 index ) const;
+
+        //! Returns half sizes of a box along it's axes.
+        const Vec3&     extents( void ) const;
+
+        //! Returns a box volume.
+        f32             volume( void ) const;
+
+        //! Returns true if a point is inside a box.
+        bool            contains( const Vec3& point ) const;
+
+        //! Returns an axis aligned box that encloses this one.
+        Bounds          bounds( void ) const;
+
+        //! Constructs an oriented bounding box from an array of points with axes along principal components of a point set.
+        /*!
+            A principal components analysis can produce a box larger than an axis aligned one for
+            point sets with no dominant direction, so callers may compare volumes of both boxes.
+        */
+        static OrientedBounds fromPoints( const Vec3* points, s32 count );
+
+    private:
+
+        //! Returns a normalized dominant eigenvector of a covariance matrix found with a power iteration.
+        static Vec3     dominantAxis( const CovMatrix<f32>& covariance, const Vec3& fallback );
+
+    private:
+
+        Vec3            m_center;       //!< A box center point.
+        Vec3            m_axes[3];      //!< Orthonormal box axes.
+        Vec3            m_extents;      //!< Half sizes of a box along it's axes.
+    };
+
+    // ** OrientedBounds::OrientedBounds
+    inline OrientedBounds::OrientedBounds( void )
+    {
+        m_axes[0] = Vec3::axisX();
+        m_axes[1] = Vec3::axisY();
+        m_axes[2] = Vec3::axisZ();
+    }
+
+    // ** OrientedBounds::OrientedBounds
+    inline OrientedBounds::OrientedBounds( const Vec3& center, const Vec3& axisX, const Vec3& axisY, const Vec3& axisZ, const Vec3& extents )
+        : m_center( center ), m_extents( extents )
+    {
+        m_axes[0] = axisX;
+        m_axes[1] = axisY;
+        m_axes[2] = axisZ;
+    }
+
+    // ** OrientedBounds::center
+    inline const Vec3& OrientedBounds::center( void ) const
+    {
+        return m_center;
+    }
+
+    // ** OrientedBounds::axis
+    inline const Vec3& OrientedBounds::axis( s32 index ) const
+    {
+        NIMBLE_BREAK_IF( index < 0 || index >= 3 );
+        return m_axes[index];
+    }
+
+    // ** OrientedBounds::extents
+    inline const Vec3& OrientedBounds::extents( void ) const
+    {
+        return m_extents;
+    }
+
+    // ** OrientedBounds::volume
+    inline f32 OrientedBounds::volume( void ) const
+    {
+        return 8.0f * m_extents.x * m_extents.y * m_extents.z;
+    }
+
+    // ** OrientedBounds::contains
+    inline bool OrientedBounds::contains( const Vec3& point ) const
+    {
+        Vec3 offset = point - m_center;
+
+        for( s32 i = 0; i < 3; i++ ) {
+            if( fabsf( offset * m_axes[i] ) > m_extents[i] ) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // ** OrientedBounds::bounds
+    inline Bounds OrientedBounds::bounds( void ) const
+    {
+        Vec3 half;
+
+        for( s32 i = 0; i < 3; i++ ) {
+            half[i] = fabsf( m_axes[0][i] ) * m_extents.x + fabsf( m_axes[1][i] ) * m_extents.y + fabsf( m_axes[2][i] ) * m_extents.z;
+        }
+
+        return Bounds( m_center - half, m_center + half );
+    }
+
+    // ** OrientedBounds::dominantAxis
+    inline Vec3 OrientedBounds::dominantAxis( const CovMatrix<f32>& covariance, const Vec3& fallback )
+    {
+        // A start vector is the largest covariance column, so it is never orthogonal to a dominant eigenvector
+        Vector<f32> axis( 3 );
+        f32         largest = 0.0f;
+
+        for( s32 col = 0; col < 3; col++ ) {
+            f32 length = 0.0f;
+            for( s32 row = 0; row < 3; row++ ) {
+                length += covariance( col, row ) * covariance( col, row );
+            }
+
+            if( length > largest ) {
+                largest = length;
+                for( s32 row = 0; row < 3; row++ ) {
+                    axis[row] = covariance( col, row );
+                }
+            }
+        }
+
+        if( largest <= 1e-24f ) {
+            return fallback;
+        }
+
+        // A vector is normalized after each step, so large coordinates do not overflow
+        axis.normalize();
+
+        for( s32 i = 0; i < 32; i++ ) {
+            axis = covariance.converge( axis, 1 );
+            if( axis.normalize() == 0.0f ) {
+                return fallback;
+            }
+        }
+
+        return Vec3( axis[0], axis[1], axis[2] );
+    }
+
+    // ** OrientedBounds::fromPoints
+    inline OrientedBounds OrientedBounds::fromPoints( const Vec3* points, s32 count )
+    {
+        NIMBLE_ABORT_IF( count == 0, "no points to construct an oriented bounding box" );
+
+        Array<Vec3> samples;
+        samples.insert( samples.end(), points, points + count );
+        CovMatrix<f32> covariance = covarianceMatrix<f32>( Samples<Vec3>( samples ), 3 );
+
+        // Find a principal axis, then deflate a covariance matrix to find a second one
+        Vec3 axisX = dominantAxis( covariance, Vec3::axisX() );
+        f32  value = 0.0f;
+
+        for( s32 col = 0; col < 3; col++ ) {
+            for( s32 row = 0; row < 3; row++ ) {
+                value += axisX[col] * covariance( col, row ) * axisX[row];
+            }
+        }
+
+        for( s32 col = 0; col < 3; col++ ) {
+            for( s32 row = 0; row < 3; row++ ) {
+                covariance( col, row ) -= value * axisX[col] * axisX[row];
+            }
+        }
+
+        Vec3 axisY = dominantAxis( covariance, axisX.ordinal() % axisX );
+
+        // Orthonormalize axes to remove an error left by a power iteration
+        axisY = axisY - axisX * (axisY * axisX);
+
+        if( axisY.normalize() < 1e-6f ) {
+            axisY = (fabsf( axisX.x ) > 0.9f ? Vec3::axisY() : Vec3::axisX()) % axisX;
+            axisY.normalize();
+        }
+
+        Vec3 axisZ = axisX % axisY;
+
+        // Project points to axes to find box extents
+        Vec3 min( FLT_MAX, FLT_MAX, FLT_MAX );
+        Vec3 max( -FLT_MAX, -FLT_MAX, -FLT_MAX );
+
+        for( s32 i = 0; i < count; i++ ) {
+            Vec3 projected( points[i] * axisX, points[i] * axisY, points[i] * axisZ );
+
+            for( s32 j = 0; j < 3; j++ ) {
+                min[j] = min2( min[j], projected[j] );
+                max[j] = max2( max[j], projected[j] );
+            }
+        }
+
+        Vec3 middle = (min + max) * 0.5f;
+        Vec3 center = axisX * middle.x + axisY * middle.y + axisZ * middle.z;
+
+        // Extents are measured about a rebuilt center exactly as contains() does and padded
+        // by a relative epsilon, so a round-off error never leaves an input point outside
+        Vec3 axes[3] = { axisX, axisY, axisZ };
+        Vec3 extents( 0.0f, 0.0f, 0.0f );
+
+        for( s32 i = 0; i < count; i++ ) {
+            Vec3 offset = points[i] - center;
+
+            for( s32 j = 0; j < 3; j++ ) {
+                extents[j] = max2( extents[j], fabsf( offset * axes[j] ) );
+            }
+        }
+
+        f32 padding = 4.0f * FLT_EPSILON * (fabsf( center.x ) + fabsf( center.y ) + fabsf( center.z ) + extents.x + extents.y + extents.z);
+        return OrientedBounds( center, axisX, axisY, axisZ, extents + padding );
+    }
+
     //! Circle class.
     class Circle {
     public:
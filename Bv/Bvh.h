@@ -0,0 +1,623 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_Bvh_H__
+#define __Nimble_Bvh_H__
+
+#include "../Globals.h"
+
+NIMBLE_BEGIN
+
+    //! A bounding volume hierarchy over an array of object bounding boxes.
+    /*!
+        A tree is built top-down with a binned surface area heuristic and stored as a flat array
+        of 32-byte nodes, where both children of an inner node are adjacent. Leaves reference a range
+        of an object index array, so an object is identified by its index in a source array. When
+        objects move, a tree can be refit in place instead of being rebuilt, which keeps a topology
+        and only updates node bounds. All queries use an explicit stack and visit nodes front to back.
+    */
+    class Bvh {
+    public:
+
+        //! The number of bins used to evaluate split candidates along each axis.
+        enum { BinCount = 16 };
+
+        //! The maximum tree depth supported by queries.
+        enum { MaxDepth = 64 };
+
+                            //! Constructs an empty Bvh instance.
+                            Bvh( void );
+
+        //! Builds a tree over an array of object bounding boxes.
+        void                build( const Bounds* bounds, s32 count, s32 maxLeafSize = 4 );
+
+        //! Updates node bounds after objects have moved, an array should have the same number of objects as a one passed to build.
+        void                refit( const Bounds* bounds );
+
+        //! Renumbers objects in a leaf order, so objects of each leaf have consecutive indices, and outputs an original index of each object.
+        /*!
+            This lets callers store object data contiguously for each leaf. Bounds passed to a refit
+            should be ordered in the same way.
+        */
+        void                reorder( Array<s32>& order );
+
+        //! Returns a bounding box of all objects.
+        Bounds              bounds( void ) const;
+
+        //! Returns the total number of tree nodes.
+        s32                 nodeCount( void ) const;
+
+        //! Returns the total number of objects.
+        s32                 objectCount( void ) const;
+
+        //! Finds the closest object hit by a ray and returns its index, or -1 if nothing was hit.
+        /*!
+            The intersect callback is called as intersect( index, time ) for objects whose bounding boxes
+            are hit closer than the current hit time, it should return true and update time if an object
+            is hit closer. Times are measured in ray direction lengths.
+        */
+        template<typename TIntersect>
+        s32                 raycast( const Ray& ray, const TIntersect& intersect, f32& time, f32 maxTime = FLT_MAX ) const;
+
+        //! Finds the closest object bounding box hit by a ray and returns an object index, or -1 if nothing was hit.
+        s32                 raycast( const Ray& ray, f32& time, f32 maxTime = FLT_MAX ) const;
+
+        //! Returns true if any object is hit by a ray closer than a max time, traversal stops at the first hit.
+        /*!
+            The intersect callback is called as intersect( index, maxTime ) and returns true if an object is hit.
+        */
+        template<typename TIntersect>
+        bool                raycastAny( const Ray& ray, const TIntersect& intersect, f32 maxTime = FLT_MAX ) const;
+
+        //! Returns true if any object bounding box is hit by a ray closer than a max time.
+        bool                raycastAny( const Ray& ray, f32 maxTime = FLT_MAX ) const;
+
+        //! Invokes a callback with an index of each object whose bounding box is visible inside a frustum.
+        template<typename TCallback>
+        void                query( const CullingFrustum& frustum, const TCallback& callback ) const;
+
+        //! Invokes a callback with an index of each object whose bounding box overlaps a specified one.
+        template<typename TCallback>
+        void                query( const Bounds& bounds, const TCallback& callback ) const;
+
+    private:
+
+        //! A tree node, an inner node stores the index of a left child and a leaf stores the first object index.
+        struct Node {
+            Bounds          bounds;     //!< A node bounding box.
+            u32             first;      //!< A left child node index for inner nodes or a first object for leaves.
+            u32             count;      //!< The number of objects in a leaf, zero for inner nodes.
+        };
+
+        //! A split candidate bin.
+        struct Bin {
+            Bounds          bounds;     //!< Bounds of objects inside a bin.
+            s32             count;      //!< The number of objects inside a bin.
+        };
+
+        //! A precomputed ray used by a slab test.
+        struct RayData {
+            Vec3            origin;     //!< A ray origin.
+            Vec3            inverse;    //!< An inverse ray direction.
+        };
+
+        //! Intersects a ray with object bounding boxes.
+        struct BoundsIntersect {
+                            //! Constructs a BoundsIntersect instance.
+                            BoundsIntersect( const RayData& ray, const Array<Bounds>& bounds )
+                                : ray( ray ), bounds( bounds ) {}
+
+            //! Returns true and updates a hit time if a ray hits an object bounding box closer than a current hit.
+            bool            operator () ( s32 index, f32& time ) const;
+
+            RayData         ray;        //!< A ray to be tested.
+            const Array<Bounds>& bounds; //!< Object bounding boxes.
+        };
+
+        //! Splits a node if this reduces a surface area heuristic cost.
+        void                subdivide( u32 index, const Bounds* bounds, s32 maxLeafSize, s32 depth );
+
+        //! Returns a surface area of a bounding box.
+        static f32          area( const Bounds& bounds );
+
+        //! Returns an entry time of a ray into a bounding box, or FLT_MAX if a ray misses it.
+        static f32          slab( const RayData& ray, const Bounds& bounds, f32 maxTime );
+
+        //! Precomputes ray data for slab tests.
+        static RayData      prepare( const Ray& ray );
+
+    private:
+
+        Array<Node>         m_nodes;        //!< Tree nodes, the first one is a root.
+        Array<s32>          m_indices;      //!< Object indices referenced by leaves.
+        Array<Bounds>       m_bounds;       //!< Object bounding boxes, used to test individual objects inside leaves.
+        Array<Vec3>         m_centroids;    //!< Object centroids used during a build.
+    };
+
+    // ** Bvh::Bvh
+    inline Bvh::Bvh( void )
+    {
+    }
+
+    // ** Bvh::nodeCount
+    inline s32 Bvh::nodeCount( void ) const
+    {
+        return static_cast<s32>( m_nodes.size() );
+    }
+
+    // ** Bvh::objectCount
+    inline s32 Bvh::objectCount( void ) const
+    {
+        return static_cast<s32>( m_indices.size() );
+    }
+
+    // ** Bvh::bounds
+    inline Bounds Bvh::bounds( void ) const
+    {
+        return m_nodes.empty() ? Bounds() : m_nodes[0].bounds;
+    }
+
+    // ** Bvh::area
+    inline f32 Bvh::area( const Bounds& bounds )
+    {
+        Vec3 e = bounds.max() - bounds.min();
+        return e.x * e.y + e.y * e.z + e.z * e.x;
+    }
+
+    // ** Bvh::prepare
+    inline Bvh::RayData Bvh::prepare( const Ray& ray )
+    {
+        RayData data;
+        data.origin  = ray.origin();
+        data.inverse = ray.inverseDirection();
+
+        return data;
+    }
+
+    // ** Bvh::slab
+    inline f32 Bvh::slab( const RayData& ray, const Bounds& bounds, f32 maxTime )
+    {
+        const Vec3& min = bounds.min();
+        const Vec3& max = bounds.max();
+
+        const Vec3& inv = ray.inverse;
+
+        // Entry and exit planes are selected by a direction sign, so a NaN distance of a ray parallel to a slab
+        // and starting on its plane is always passed first to max2 and min2, which return a second argument then
+        f32 tx1 = ((inv.x < 0.0f ? max.x : min.x) - ray.origin.x) * inv.x, tx2 = ((inv.x < 0.0f ? min.x : max.x) - ray.origin.x) * inv.x;
+        f32 ty1 = ((inv.y < 0.0f ? max.y : min.y) - ray.origin.y) * inv.y, ty2 = ((inv.y < 0.0f ? min.y : max.y) - ray.origin.y) * inv.y;
+        f32 tz1 = ((inv.z < 0.0f ? max.z : min.z) - ray.origin.z) * inv.z, tz2 = ((inv.z < 0.0f ? min.z : max.z) - ray.origin.z) * inv.z;
+
+        f32 tmin = max2( tx1, max2( ty1, max2( tz1, 0.0f ) ) );
+        f32 tmax = min2( tx2, min2( ty2, min2( tz2, maxTime ) ) );
+
+        return tmin <= tmax ? tmin : FLT_MAX;
+    }
+
+    // ** Bvh::build
+    inline void Bvh::build( const Bounds* bounds, s32 count, s32 maxLeafSize )
+    {
+        m_nodes.clear();
+        m_indices.resize( count );
+        m_centroids.resize( count );
+        m_bounds.assign( bounds, bounds + count );
+
+        if( count == 0 ) {
+            return;
+        }
+
+        // Initialize a root node that contains all objects
+        Node root;
+        root.first = 0;
+        root.count = count;
+
+        for( s32 i = 0; i < count; i++ ) {
+            m_indices[i]   = i;
+            m_centroids[i] = bounds[i].center();
+            root.bounds   += bounds[i];
+        }
+
+        // A binary tree with N leaves has 2N - 1 nodes
+        m_nodes.reserve( count * 2 );
+        m_nodes.push_back( root );
+
+        subdivide( 0, bounds, max2( 1, maxLeafSize ), 0 );
+
+        // Centroids are only needed during a build
+        Array<Vec3>().swap( m_centroids );
+    }
+
+    // ** Bvh::subdivide
+    inline void Bvh::subdivide( u32 index, const Bounds* bounds, s32 maxLeafSize, s32 depth )
+    {
+        Node node = m_nodes[index];
+
+        // Stop at a depth that still fits a traversal stack
+        if( depth >= MaxDepth - 2 ) {
+            return;
+        }
+
+        // Calculate bounds of object centroids to place bins
+        Bounds centroids;
+
+        for( u32 i = node.first; i < node.first + node.count; i++ ) {
+            centroids << m_centroids[m_indices[i]];
+        }
+
+        // Find the split with a lowest cost
+        f32 bestCost  = FLT_MAX;
+        s32 bestAxis  = -1;
+        s32 bestSplit = 0;
+
+        for( s32 axis = 0; axis < 3; axis++ ) {
+            f32 lower  = centroids.min()[axis];
+            f32 extent = centroids.max()[axis] - lower;
+
+            if( extent <= 0.0f ) {
+                continue;
+            }
+
+            // Distribute objects to bins
+            Bin bins[BinCount];
+            f32 scale = BinCount / extent;
+
+            for( s32 i = 0; i < BinCount; i++ ) {
+                bins[i].count = 0;
+            }
+
+            for( u32 i = node.first; i < node.first + node.count; i++ ) {
+                s32 object = m_indices[i];
+                s32 bin    = min2( BinCount - 1, static_cast<s32>( (m_centroids[object][axis] - lower) * scale ) );
+                bins[bin].count++;
+                bins[bin].bounds += bounds[object];
+            }
+
+            // Sweep from both sides to get an area and a count of each split side
+            f32    leftArea[BinCount - 1], rightArea[BinCount - 1];
+            s32    leftCount[BinCount - 1], rightCount[BinCount - 1];
+            Bounds left, right;
+            s32    leftSum = 0, rightSum = 0;
+
+            for( s32 i = 0; i < BinCount - 1; i++ ) {
+                leftSum += bins[i].count;
+                left    += bins[i].bounds;
+                leftCount[i] = leftSum;
+                leftArea[i]  = leftSum ? area( left ) : 0.0f;
+
+                rightSum += bins[BinCount - 1 - i].count;
+                right    += bins[BinCount - 1 - i].bounds;
+                rightCount[BinCount - 2 - i] = rightSum;
+                rightArea[BinCount - 2 - i]  = rightSum ? area( right ) : 0.0f;
+            }
+
+            for( s32 i = 0; i < BinCount - 1; i++ ) {
+                f32 cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+
+                if( cost < bestCost ) {
+                    bestCost  = cost;
+                    bestAxis  = axis;
+                    bestSplit = i;
+                }
+            }
+        }
+
+        // Keep a leaf if all centroids coincide or a split is more expensive than a leaf, unless a leaf is too large
+        f32 leafCost = node.count * area( node.bounds );
+
+        if( bestAxis < 0 || (bestCost >= leafCost && static_cast<s32>( node.count ) <= maxLeafSize) ) {
+            return;
+        }
+
+        // Partition object indices by a split plane
+        f32 lower = centroids.min()[bestAxis];
+        f32 scale = BinCount / (centroids.max()[bestAxis] - lower);
+        s32 i     = node.first;
+        s32 j     = node.first + node.count - 1;
+
+        while( i <= j ) {
+            s32 bin = min2( BinCount - 1, static_cast<s32>( (m_centroids[m_indices[i]][bestAxis] - lower) * scale ) );
+
+            if( bin <= bestSplit ) {
+                i++;
+            } else {
+                std::swap( m_indices[i], m_indices[j--] );
+            }
+        }
+
+        s32 leftCount = i - node.first;
+
+        if( leftCount == 0 || leftCount == static_cast<s32>( node.count ) ) {
+            return;
+        }
+
+        // Create child nodes next to each other
+        u32  leftIndex = static_cast<u32>( m_nodes.size() );
+        Node left, right;
+
+        left.first  = node.first;
+        left.count  = leftCount;
+        right.first = i;
+        right.count = node.count - leftCount;
+
+        for( u32 k = left.first; k < left.first + left.count; k++ ) {
+            left.bounds += bounds[m_indices[k]];
+        }
+
+        for( u32 k = right.first; k < right.first + right.count; k++ ) {
+            right.bounds += bounds[m_indices[k]];
+        }
+
+        m_nodes.push_back( left );
+        m_nodes.push_back( right );
+
+        m_nodes[index].first = leftIndex;
+        m_nodes[index].count = 0;
+
+        subdivide( leftIndex, bounds, maxLeafSize, depth + 1 );
+        subdivide( leftIndex + 1, bounds, maxLeafSize, depth + 1 );
+    }
+
+    // ** Bvh::refit
+    inline void Bvh::refit( const Bounds* bounds )
+    {
+        m_bounds.assign( bounds, bounds + objectCount() );
+
+        // Children are always stored after their parent, so a reverse pass visits them first
+        for( s32 i = nodeCount() - 1; i >= 0; i-- ) {
+            Node& node = m_nodes[i];
+            node.bounds = Bounds();
+
+            if( node.count ) {
+                for( u32 k = node.first; k < node.first + node.count; k++ ) {
+                    node.bounds += bounds[m_indices[k]];
+                }
+            } else {
+                node.bounds += m_nodes[node.first].bounds;
+                node.bounds += m_nodes[node.first + 1].bounds;
+            }
+        }
+    }
+
+    // ** Bvh::raycast
+    template<typename TIntersect>
+    s32 Bvh::raycast( const Ray& ray, const TIntersect& intersect, f32& time, f32 maxTime ) const
+    {
+        if( m_nodes.empty() ) {
+            return -1;
+        }
+
+        RayData data  = prepare( ray );
+        s32     hit   = -1;
+        u32     stack[MaxDepth];
+        f32     entry[MaxDepth];
+        s32     depth = 0;
+
+        time = maxTime;
+
+        if( (entry[0] = slab( data, m_nodes[0].bounds, time )) == FLT_MAX ) {
+            return -1;
+        }
+
+        stack[depth++] = 0;
+
+        while( depth ) {
+            // Skip a node if a closer hit was found after it was pushed
+            if( entry[--depth] > time ) {
+                continue;
+            }
+
+            const Node& node = m_nodes[stack[depth]];
+
+            if( node.count ) {
+                for( u32 k = node.first; k < node.first + node.count; k++ ) {
+                    if( intersect( m_indices[k], time ) ) {
+                        hit = m_indices[k];
+                    }
+                }
+                continue;
+            }
+
+            // Visit a closer child first, a farther one is pushed below it
+            f32 near = slab( data, m_nodes[node.first].bounds, time );
+            f32 far  = slab( data, m_nodes[node.first + 1].bounds, time );
+            u32 nearIndex = node.first, farIndex = node.first + 1;
+
+            if( near > far ) {
+                std::swap( near, far );
+                std::swap( nearIndex, farIndex );
+            }
+
+            NIMBLE_ABORT_IF( depth + 2 > MaxDepth, "bounding volume hierarchy is too deep" );
+
+            if( far != FLT_MAX ) {
+                entry[depth]   = far;
+                stack[depth++] = farIndex;
+            }
+            if( near != FLT_MAX ) {
+                entry[depth]   = near;
+                stack[depth++] = nearIndex;
+            }
+        }
+
+        return hit;
+    }
+
+    // ** Bvh::reorder
+    inline void Bvh::reorder( Array<s32>& order )
+    {
+        Array<Bounds> bounds;
+        bounds.resize( m_indices.size() );
+
+        for( s32 i = 0, n = objectCount(); i < n; i++ ) {
+            bounds[i] = m_bounds[m_indices[i]];
+        }
+
+        order = m_indices;
+        m_bounds.swap( bounds );
+
+        for( s32 i = 0, n = objectCount(); i < n; i++ ) {
+            m_indices[i] = i;
+        }
+    }
+
+    // ** Bvh::BoundsIntersect::operator ()
+    inline bool Bvh::BoundsIntersect::operator () ( s32 index, f32& time ) const
+    {
+        f32 hit = slab( ray, bounds[index], time );
+
+        if( hit == FLT_MAX ) {
+            return false;
+        }
+
+        time = hit;
+        return true;
+    }
+
+    // ** Bvh::raycast
+    inline s32 Bvh::raycast( const Ray& ray, f32& time, f32 maxTime ) const
+    {
+        return raycast( ray, BoundsIntersect( prepare( ray ), m_bounds ), time, maxTime );
+    }
+
+    // ** Bvh::raycastAny
+    template<typename TIntersect>
+    bool Bvh::raycastAny( const Ray& ray, const TIntersect& intersect, f32 maxTime ) const
+    {
+        if( m_nodes.empty() ) {
+            return false;
+        }
+
+        RayData data  = prepare( ray );
+        u32     stack[MaxDepth];
+        s32     depth = 0;
+
+        stack[depth++] = 0;
+
+        while( depth ) {
+            const Node& node = m_nodes[stack[--depth]];
+
+            if( slab( data, node.bounds, maxTime ) == FLT_MAX ) {
+                continue;
+            }
+
+            if( node.count ) {
+                for( u32 k = node.first; k < node.first + node.count; k++ ) {
+                    f32 time = maxTime;
+
+                    if( intersect( m_indices[k], time ) ) {
+                        return true;
+                    }
+                }
+                continue;
+            }
+
+            NIMBLE_ABORT_IF( depth + 2 > MaxDepth, "bounding volume hierarchy is too deep" );
+            stack[depth++] = node.first + 1;
+            stack[depth++] = node.first;
+        }
+
+        return false;
+    }
+
+    // ** Bvh::raycastAny
+    inline bool Bvh::raycastAny( const Ray& ray, f32 maxTime ) const
+    {
+        return raycastAny( ray, BoundsIntersect( prepare( ray ), m_bounds ), maxTime );
+    }
+
+    // ** Bvh::query
+    template<typename TCallback>
+    void Bvh::query( const CullingFrustum& frustum, const TCallback& callback ) const
+    {
+        if( m_nodes.empty() ) {
+            return;
+        }
+
+        u32 stack[MaxDepth];
+        s32 depth = 0;
+
+        stack[depth++] = 0;
+
+        while( depth ) {
+            const Node& node = m_nodes[stack[--depth]];
+
+            if( !frustum.isVisible( node.bounds ) ) {
+                continue;
+            }
+
+            if( node.count ) {
+                for( u32 k = node.first; k < node.first + node.count; k++ ) {
+                    if( node.count == 1 || frustum.isVisible( m_bounds[m_indices[k]] ) ) {
+                        callback( m_indices[k] );
+                    }
+                }
+                continue;
+            }
+
+            NIMBLE_ABORT_IF( depth + 2 > MaxDepth, "bounding volume hierarchy is too deep" );
+            stack[depth++] = node.first + 1;
+            stack[depth++] = node.first;
+        }
+    }
+
+    // ** Bvh::query
+    template<typename TCallback>
+    void Bvh::query( const Bounds& bounds, const TCallback& callback ) const
+    {
+        if( m_nodes.empty() ) {
+            return;
+        }
+
+        u32 stack[MaxDepth];
+        s32 depth = 0;
+
+        stack[depth++] = 0;
+
+        while( depth ) {
+            const Node& node = m_nodes[stack[--depth]];
+
+            if( !node.bounds.overlaps( bounds ) ) {
+                continue;
+            }
+
+            if( node.count ) {
+                for( u32 k = node.first; k < node.first + node.count; k++ ) {
+                    if( m_bounds[m_indices[k]].overlaps( bounds ) ) {
+                        callback( m_indices[k] );
+                    }
+                }
+                continue;
+            }
+
+            NIMBLE_ABORT_IF( depth + 2 > MaxDepth, "bounding volume hierarchy is too deep" );
+            stack[depth++] = node.first + 1;
+            stack[depth++] = node.first;
+        }
+    }
+
+NIMBLE_END
+
+#endif  /*  !__Nimble_Bvh_H__  */
@@ -0,0 +1,852 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_ConvexHull_H__
+#define __Nimble_ConvexHull_H__
+
+#include "../Globals.h"
+
+#include <float.h>
+
+NIMBLE_BEGIN
+
+    //! Computes a convex hull of a 3D point set with a quickhull algorithm.
+    /*!
+        A hull starts from a tetrahedron of extreme points and each point outside of it is stored in a
+        conflict list of a face it lies furthest above. A furthest conflict point is repeatedly added to a
+        hull: faces visible from it are removed, a horizon is connected to a point with new faces and
+        conflict points of removed faces are reassigned. Faces and conflict list nodes are allocated from
+        arenas that keep their capacity between builds, so a single instance can process many point sets
+        without heap allocations once warmed up. A distance tolerance is derived from point coordinates,
+        points closer than a tolerance to a hull do not extend it, so nearly coplanar points do not produce
+        sliver faces.
+    */
+    class ConvexHull {
+    public:
+
+                                //! Constructs an empty ConvexHull instance.
+                                ConvexHull( void );
+
+        //! Computes a hull of a point set, returns false if there are less than four points, all points are coplanar or a point set is too degenerate for a distance tolerance.
+        bool                    build( const Vec3* points, s32 count );
+
+        //! Returns the total number of hull triangles.
+        s32                     triangleCount( void ) const;
+
+        //! Returns hull vertices as indices of input points, this is a fast path when no topology is needed.
+        const Array<s32>&       vertices( void ) const;
+
+        //! Outputs hull triangles as triples of input point indices with a counter clockwise order seen from outside.
+        void                    triangles( Array<s32>& indices ) const;
+
+        //! Outputs a plane of each hull triangle with a normal pointing outside.
+        void                    planes( Array<Plane>& planes ) const;
+
+    private:
+
+        //! A hull triangle.
+        struct Face {
+            s32                 vertex[3];      //!< Point indices in a counter clockwise order.
+            s32                 neighbour[3];   //!< A face adjacent across an edge that starts at a vertex with the same index.
+            f64                 normal[3];      //!< A unit face normal pointing outside.
+            f64                 offset;         //!< A face plane offset along a normal.
+            s32                 conflicts;      //!< A first conflict list node, or -1 if there are no points above a face.
+            s32                 visited;        //!< An iteration a face was last found visible.
+            s32                 traversed;      //!< A horizon search a face was last traversed by.
+            bool                alive;          //!< Indicates that a face is a part of a hull, dead faces are linked to a free list through a first neighbour.
+        };
+
+        //! A node of a face conflict list.
+        struct Conflict {
+            s32                 point;          //!< A point index.
+            f64                 distance;       //!< A point distance above a face.
+            s32                 next;           //!< A next node, or -1.
+        };
+
+        //! A horizon edge recorded by a visible face traversal.
+        struct HorizonEdge {
+            s32                 face;           //!< A visible face.
+            s32                 edge;           //!< An edge index inside a visible face.
+        };
+
+        //! A visible face traversal stack entry.
+        struct Visit {
+            s32                 face;           //!< A visible face.
+            s32                 first;          //!< An edge a traversal entered a face through.
+            s32                 step;           //!< A next edge offset from an entry edge.
+        };
+
+        //! Allocates a face from an arena and computes it's plane.
+        s32                     allocateFace( s32 a, s32 b, s32 c );
+
+        //! Returns a face to an arena.
+        void                    releaseFace( s32 index );
+
+        //! Adds a point to a conflict list of a face it lies furthest above, returns false if a point is below all faces.
+        bool                    assign( s32 point, const s32* faces, s32 count );
+
+        //! Returns a signed distance from a point to a face plane.
+        f64                     distance( const Face& face, s32 point ) const;
+
+        //! Returns a signed distance from a point to a plane.
+        f64                     distance( const f64* normal, f64 offset, s32 point ) const;
+
+        //! Computes a plane through three points, returns false if points are collinear.
+        static bool             calculatePlane( const Vec3& a, const Vec3& b, const Vec3& c, f64* normal, f64& offset );
+
+        //! Records horizon edges of visible faces in a counter clockwise order, returns false if more faces had to be marked visible.
+        bool                    findHorizon( s32 start, s32 eye );
+
+        //! Returns true if horizon edges form a single closed loop that passes each vertex once.
+        bool                    isSimpleHorizon( void );
+
+        //! Moves conflict points to neighbouring faces they lie further above, returns true if any point was moved.
+        bool                    redistributeConflicts( void );
+
+        //! Collects indices of points referenced by alive faces.
+        void                    collectVertices( void );
+
+        //! Finds a tetrahedron of extreme points, returns false if a point set is degenerate.
+        bool                    buildSimplex( void );
+
+        //! Adds a furthest conflict point of a face to a hull unless it lies within a tolerance of a face.
+        void                    addPoint( s32 face );
+
+        //! Removes an eye point from a conflict list of a face, so a hull is built without it.
+        void                    skipPoint( s32 face, s32 eye );
+
+    private:
+
+        const Vec3*             m_points;       //!< Input points.
+        s32                     m_count;        //!< The total number of input points.
+        f32                     m_epsilon;      //!< A distance tolerance.
+        Vec3                    m_interior;     //!< A point strictly inside a hull.
+        s32                     m_iteration;    //!< A current hull expansion iteration.
+        s32                     m_traversal;    //!< A current horizon search.
+        Array<Face>             m_faces;        //!< A face arena.
+        s32                     m_freeFaces;    //!< A first free face, or -1.
+        s32                     m_faceCount;    //!< The total number of alive faces.
+        Array<Conflict>         m_conflicts;    //!< A conflict list node arena.
+        s32                     m_freeConflicts;//!< A first free conflict node, or -1.
+        Array<s32>              m_pending;      //!< Faces that may have points above them.
+        Array<Visit>            m_stack;        //!< A visible face traversal stack.
+        Array<s32>              m_visible;      //!< Faces visible from a current point.
+        Array<HorizonEdge>      m_horizon;      //!< Horizon edges in a counter clockwise order.
+        Array<s32>              m_created;      //!< Faces created by a current iteration.
+        Array<u8>               m_marks;        //!< Points already collected as hull vertices or visited by a horizon check.
+        Array<s32>              m_skipped;      //!< Eye points that could not be added without breaking a hull topology.
+        Array<s32>              m_vertices;     //!< Hull vertices collected after a build.
+    };
+
+    // ** ConvexHull::ConvexHull
+    inline ConvexHull::ConvexHull( void )
+        : m_points( NULL ), m_count( 0 ), m_epsilon( 0.0f ), m_iteration( 0 ), m_traversal( 0 ), m_freeFaces( -1 ), m_faceCount( 0 ), m_freeConflicts( -1 )
+    {
+    }
+
+    // ** ConvexHull::triangleCount
+    inline s32 ConvexHull::triangleCount( void ) const
+    {
+        return m_faceCount;
+    }
+
+    // ** ConvexHull::vertices
+    inline const Array<s32>& ConvexHull::vertices( void ) const
+    {
+        return m_vertices;
+    }
+
+    // ** ConvexHull::triangles
+    inline void ConvexHull::triangles( Array<s32>& indices ) const
+    {
+        indices.clear();
+        indices.reserve( m_faceCount * 3 );
+
+        for( s32 i = 0, n = static_cast<s32>( m_faces.size() ); i < n; i++ ) {
+            const Face& face = m_faces[i];
+
+            if( face.alive ) {
+                indices.push_back( face.vertex[0] );
+                indices.push_back( face.vertex[1] );
+                indices.push_back( face.vertex[2] );
+            }
+        }
+    }
+
+    // ** ConvexHull::planes
+    inline void ConvexHull::planes( Array<Plane>& planes ) const
+    {
+        planes.clear();
+        planes.reserve( m_faceCount );
+
+        for( s32 i = 0, n = static_cast<s32>( m_faces.size() ); i < n; i++ ) {
+            const Face& face = m_faces[i];
+
+            if( face.alive ) {
+                planes.push_back( Plane( Vec3( static_cast<f32>( face.normal[0] ), static_cast<f32>( face.normal[1] ), static_cast<f32>( face.normal[2] ) ), static_cast<f32>( -face.offset ) ) );
+            }
+        }
+    }
+
+    // ** ConvexHull::distance
+    inline f64 ConvexHull::distance( const Face& face, s32 point ) const
+    {
+        const Vec3& p = m_points[point];
+        return face.normal[0] * p.x + face.normal[1] * p.y + face.normal[2] * p.z - face.offset;
+    }
+
+    // ** ConvexHull::distance
+    inline f64 ConvexHull::distance( const f64* normal, f64 offset, s32 point ) const
+    {
+        const Vec3& p = m_points[point];
+        return normal[0] * p.x + normal[1] * p.y + normal[2] * p.z - offset;
+    }
+
+    // ** ConvexHull::calculatePlane
+    inline bool ConvexHull::calculatePlane( const Vec3& a, const Vec3& b, const Vec3& c, f64* normal, f64& offset )
+    {
+        // Planes are computed in double precision from face vertices, so normals of sliver faces near
+        // a corner stay accurate, and a cross product of two shortest edges is used to lose even less
+        f64 p[3][3] = { { a.x, a.y, a.z }, { b.x, b.y, b.z }, { c.x, c.y, c.z } };
+        f64 edges[3][3];
+        f64 lengths[3];
+
+        for( s32 i = 0; i < 3; i++ ) {
+            const f64* from = p[i];
+            const f64* to   = p[(i + 1) % 3];
+
+            lengths[i] = 0.0;
+            for( s32 j = 0; j < 3; j++ ) {
+                edges[i][j] = to[j] - from[j];
+                lengths[i] += edges[i][j] * edges[i][j];
+            }
+        }
+
+        s32 longest = 0;
+        if( lengths[1] > lengths[longest] ) longest = 1;
+        if( lengths[2] > lengths[longest] ) longest = 2;
+
+        const f64* u = edges[(longest + 1) % 3];
+        const f64* v = edges[(longest + 2) % 3];
+
+        normal[0] = u[1] * v[2] - u[2] * v[1];
+        normal[1] = u[2] * v[0] - u[0] * v[2];
+        normal[2] = u[0] * v[1] - u[1] * v[0];
+
+        f64 length = sqrt( normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2] );
+
+        if( length == 0.0 ) {
+            normal[0] = normal[1] = normal[2] = offset = 0.0;
+            return false;
+        }
+
+        offset = 0.0;
+        for( s32 j = 0; j < 3; j++ ) {
+            normal[j] /= length;
+            offset    += normal[j] * (p[0][j] + p[1][j] + p[2][j]) / 3.0;
+        }
+
+        return true;
+    }
+
+    // ** ConvexHull::allocateFace
+    inline s32 ConvexHull::allocateFace( s32 a, s32 b, s32 c )
+    {
+        s32 index;
+
+        if( m_freeFaces != -1 ) {
+            index       = m_freeFaces;
+            m_freeFaces = m_faces[index].neighbour[0];
+        } else {
+            index = static_cast<s32>( m_faces.size() );
+            m_faces.push_back( Face() );
+        }
+
+        Face& face = m_faces[index];
+        face.vertex[0]    = a;
+        face.vertex[1]    = b;
+        face.vertex[2]    = c;
+        face.neighbour[0] = face.neighbour[1] = face.neighbour[2] = -1;
+        face.conflicts    = -1;
+        face.visited      = -1;
+        face.traversed    = -1;
+        face.alive        = true;
+
+        // A zero normal of a degenerate face leaves all points below it
+        calculatePlane( m_points[a], m_points[b], m_points[c], face.normal, face.offset );
+
+        m_faceCount++;
+
+        return index;
+    }
+
+    // ** ConvexHull::releaseFace
+    inline void ConvexHull::releaseFace( s32 index )
+    {
+        Face& face = m_faces[index];
+        face.alive        = false;
+        face.neighbour[0] = m_freeFaces;
+        m_freeFaces       = index;
+        m_faceCount--;
+    }
+
+    // ** ConvexHull::assign
+    inline bool ConvexHull::assign( s32 point, const s32* faces, s32 count )
+    {
+        // A point goes to a face it lies furthest above, points slightly above a face are kept, so they are
+        // reassigned if a face is removed later and do not end up outside of a tilted replacement face
+        s32 furthest = -1;
+        f64 best     = 0.0;
+
+        for( s32 i = 0; i < count; i++ ) {
+            f64 d = distance( m_faces[faces[i]], point );
+
+            if( d > best ) {
+                best     = d;
+                furthest = faces[i];
+            }
+        }
+
+        if( furthest == -1 ) {
+            return false;
+        }
+
+        s32 node;
+
+        if( m_freeConflicts != -1 ) {
+            node            = m_freeConflicts;
+            m_freeConflicts = m_conflicts[node].next;
+        } else {
+            node = static_cast<s32>( m_conflicts.size() );
+            m_conflicts.push_back( Conflict() );
+        }
+
+        // A face becomes pending when it's conflict list stops being empty
+        Face& face = m_faces[furthest];
+
+        if( face.conflicts == -1 ) {
+            m_pending.push_back( furthest );
+        }
+
+        Conflict& conflict = m_conflicts[node];
+        conflict.point    = point;
+        conflict.distance = best;
+        conflict.next     = face.conflicts;
+        face.conflicts    = node;
+
+        return true;
+    }
+
+    // ** ConvexHull::build
+    inline bool ConvexHull::build( const Vec3* points, s32 count )
+    {
+        m_points        = points;
+        m_count         = count;
+        m_iteration     = 0;
+        m_freeFaces     = -1;
+        m_faceCount     = 0;
+        m_freeConflicts = -1;
+        m_faces.clear();
+        m_conflicts.clear();
+        m_pending.clear();
+        m_vertices.clear();
+        m_skipped.clear();
+        m_marks.clear();
+        m_marks.resize( count, 0 );
+
+        if( count < 4 || !buildSimplex() ) {
+            m_faces.clear();
+            m_faceCount = 0;
+            return false;
+        }
+
+        do {
+            while( !m_pending.empty() ) {
+                s32 face = m_pending.back();
+                m_pending.pop_back();
+
+                if( m_faces[face].alive && m_faces[face].conflicts != -1 ) {
+                    addPoint( face );
+                }
+            }
+        } while( redistributeConflicts() );
+
+        // A skipped point is fine if a hull grew around it later, otherwise a point set is too degenerate for a tolerance
+        for( s32 i = 0, n = static_cast<s32>( m_skipped.size() ); i < n; i++ ) {
+            for( s32 j = 0, k = static_cast<s32>( m_faces.size() ); j < k; j++ ) {
+                if( m_faces[j].alive && distance( m_faces[j], m_skipped[i] ) > m_epsilon ) {
+                    m_faces.clear();
+                    m_faceCount = 0;
+                    return false;
+                }
+            }
+        }
+
+        collectVertices();
+
+        return true;
+    }
+
+    // ** ConvexHull::redistributeConflicts
+    inline bool ConvexHull::redistributeConflicts( void )
+    {
+        bool moved = false;
+
+        // Points left within a tolerance above a face may lie further above a face created next to it later,
+        // they are moved to a neighbour, so a hull is extended by them instead of leaving them outside
+        for( s32 i = 0, n = static_cast<s32>( m_faces.size() ); i < n; i++ ) {
+            if( !m_faces[i].alive ) {
+                continue;
+            }
+
+            s32* link = &m_faces[i].conflicts;
+
+            while( *link != -1 ) {
+                s32       node     = *link;
+                Conflict& conflict = m_conflicts[node];
+                s32       target   = -1;
+                f64       best     = max2( conflict.distance, static_cast<f64>( m_epsilon ) );
+
+                for( s32 edge = 0; edge < 3; edge++ ) {
+                    s32 neighbour = m_faces[i].neighbour[edge];
+                    f64 d         = distance( m_faces[neighbour], conflict.point );
+
+                    if( d > best ) {
+                        best   = d;
+                        target = neighbour;
+                    }
+                }
+
+                if( target == -1 ) {
+                    link = &conflict.next;
+                    continue;
+                }
+
+                Face& face = m_faces[target];
+
+                if( face.conflicts == -1 ) {
+                    m_pending.push_back( target );
+                }
+
+                *link             = conflict.next;
+                conflict.distance = best;
+                conflict.next     = face.conflicts;
+                face.conflicts    = node;
+                moved             = true;
+            }
+        }
+
+        return moved;
+    }
+
+    // ** ConvexHull::collectVertices
+    inline void ConvexHull::collectVertices( void )
+    {
+        // Mark points referenced by alive faces, so each hull vertex is reported once
+
+        for( s32 i = 0, n = static_cast<s32>( m_faces.size() ); i < n; i++ ) {
+            const Face& face = m_faces[i];
+
+            if( !face.alive ) {
+                continue;
+            }
+
+            for( s32 j = 0; j < 3; j++ ) {
+                if( !m_marks[face.vertex[j]] ) {
+                    m_marks[face.vertex[j]] = 1;
+                    m_vertices.push_back( face.vertex[j] );
+                }
+            }
+        }
+    }
+
+    // ** ConvexHull::buildSimplex
+    inline bool ConvexHull::buildSimplex( void )
+    {
+        // Find extreme points along each axis and derive a tolerance from coordinate magnitudes
+        s32  extremes[6] = { 0, 0, 0, 0, 0, 0 };
+        Vec3 magnitude( 0.0f, 0.0f, 0.0f );
+
+        for( s32 i = 0; i < m_count; i++ ) {
+            const Vec3& point = m_points[i];
+
+            for( s32 axis = 0; axis < 3; axis++ ) {
+                if( point[axis] < m_points[extremes[axis * 2 + 0]][axis] ) extremes[axis * 2 + 0] = i;
+                if( point[axis] > m_points[extremes[axis * 2 + 1]][axis] ) extremes[axis * 2 + 1] = i;
+                magnitude[axis] = max2( magnitude[axis], fabsf( point[axis] ) );
+            }
+        }
+
+        m_epsilon = 3.0f * FLT_EPSILON * (magnitude.x + magnitude.y + magnitude.z);
+
+        // A first edge connects the most distant pair of extreme points
+        s32 v0 = extremes[0];
+        s32 v1 = extremes[1];
+
+        for( s32 axis = 1; axis < 3; axis++ ) {
+            s32 a = extremes[axis * 2 + 0];
+            s32 b = extremes[axis * 2 + 1];
+
+            if( (m_points[b] - m_points[a]).lengthSqr() > (m_points[v1] - m_points[v0]).lengthSqr() ) {
+                v0 = a;
+                v1 = b;
+            }
+        }
+
+        if( (m_points[v1] - m_points[v0]).length() <= m_epsilon ) {
+            return false;
+        }
+
+        // A third point is the most distant from a line
+        Vec3 direction = m_points[v1] - m_points[v0];
+        direction.normalize();
+
+        s32 v2 = -1;
+        f32 best = m_epsilon;
+
+        for( s32 i = 0; i < m_count; i++ ) {
+            Vec3 offset = m_points[i] - m_points[v0];
+            f32  d      = (offset - direction * (offset * direction)).length();
+
+            if( d > best ) {
+                best = d;
+                v2   = i;
+            }
+        }
+
+        if( v2 == -1 ) {
+            return false;
+        }
+
+        // A fourth point is the most distant from a plane
+        Vec3 normal = (m_points[v1] - m_points[v0]) % (m_points[v2] - m_points[v0]);
+        normal.normalize();
+
+        s32 v3 = -1;
+        best   = m_epsilon;
+
+        for( s32 i = 0; i < m_count; i++ ) {
+            f32 d = fabsf( normal * (m_points[i] - m_points[v0]) );
+
+            if( d > best ) {
+                best = d;
+                v3   = i;
+            }
+        }
+
+        if( v3 == -1 ) {
+            return false;
+        }
+
+        // Orient a base, so a fourth point lies below it
+        if( normal * (m_points[v3] - m_points[v0]) > 0.0f ) {
+            s32 temp = v1;
+            v1 = v2;
+            v2 = temp;
+        }
+
+        m_interior = (m_points[v0] + m_points[v1] + m_points[v2] + m_points[v3]) * 0.25f;
+
+        s32 faces[4];
+        faces[0] = allocateFace( v0, v1, v2 );
+        faces[1] = allocateFace( v0, v3, v1 );
+        faces[2] = allocateFace( v1, v3, v2 );
+        faces[3] = allocateFace( v2, v3, v0 );
+
+        // Link faces through shared edges
+        for( s32 i = 0; i < 4; i++ ) {
+            Face& face = m_faces[faces[i]];
+
+            for( s32 edge = 0; edge < 3; edge++ ) {
+                s32 a = face.vertex[edge];
+                s32 b = face.vertex[(edge + 1) % 3];
+
+                for( s32 j = 0; j < 4; j++ ) {
+                    const Face& other = m_faces[faces[j]];
+
+                    for( s32 k = 0; k < 3; k++ ) {
+                        if( other.vertex[k] == b && other.vertex[(k + 1) % 3] == a ) {
+                            face.neighbour[edge] = faces[j];
+                        }
+                    }
+                }
+            }
+        }
+
+        // Distribute remaining points between conflict lists
+        for( s32 i = 0; i < m_count; i++ ) {
+            if( i != v0 && i != v1 && i != v2 && i != v3 ) {
+                assign( i, faces, 4 );
+            }
+        }
+
+        return true;
+    }
+
+    // ** ConvexHull::findHorizon
+    inline bool ConvexHull::findHorizon( s32 start, s32 eye )
+    {
+        m_traversal++;
+        m_horizon.clear();
+        m_stack.clear();
+
+        // A depth first traversal of visible faces records horizon edges in a counter clockwise order
+        Visit root = { start, 0, 0 };
+        m_stack.push_back( root );
+        m_faces[start].traversed = m_traversal;
+
+        while( !m_stack.empty() ) {
+            Visit& top = m_stack.back();
+
+            if( top.step > 2 ) {
+                m_stack.pop_back();
+                continue;
+            }
+
+            s32 face      = top.face;
+            s32 edge      = (top.first + top.step) % 3;
+            s32 neighbour = m_faces[face].neighbour[edge];
+            top.step++;
+
+            Face& other = m_faces[neighbour];
+
+            if( other.visited != m_iteration ) {
+                HorizonEdge horizon = { face, edge };
+                m_horizon.push_back( horizon );
+                continue;
+            }
+
+            if( other.traversed == m_traversal ) {
+                continue;
+            }
+
+            // Continue from an edge after the one a traversal came through
+            other.traversed = m_traversal;
+
+            s32 entry = 0;
+            while( other.neighbour[entry] != face ) {
+                entry++;
+            }
+
+            Visit visit = { neighbour, entry, 1 };
+            m_stack.push_back( visit );
+        }
+
+        // A face outside of a horizon is removed as well if a new face over a shared edge would be degenerate,
+        // would bend inwards over that edge, or would not face away from a hull interior
+        bool convex = true;
+
+        for( s32 i = 0, n = static_cast<s32>( m_horizon.size() ); i < n; i++ ) {
+            const Face& face    = m_faces[m_horizon[i].face];
+            s32         edge    = m_horizon[i].edge;
+            s32         a       = face.vertex[edge];
+            s32         b       = face.vertex[(edge + 1) % 3];
+            s32         outside = face.neighbour[edge];
+            Face&       other   = m_faces[outside];
+
+            if( other.visited == m_iteration ) {
+                continue;
+            }
+
+            s32 opposite = other.vertex[0];
+            for( s32 k = 1; k < 3 && (opposite == a || opposite == b); k++ ) {
+                opposite = other.vertex[k];
+            }
+
+            f64  normal[3];
+            f64  offset;
+            bool valid = calculatePlane( m_points[a], m_points[b], m_points[eye], normal, offset );
+
+            const Vec3& q = m_interior;
+
+            bool concave  = distance( normal, offset, opposite ) > 0.0;
+            bool inverted = normal[0] * q.x + normal[1] * q.y + normal[2] * q.z - offset > -m_epsilon;
+
+            if( !valid || concave || inverted ) {
+                other.visited = m_iteration;
+                m_visible.push_back( outside );
+                convex = false;
+            }
+        }
+
+        return convex;
+    }
+
+    // ** ConvexHull::isSimpleHorizon
+    inline bool ConvexHull::isSimpleHorizon( void )
+    {
+        s32  count  = static_cast<s32>( m_horizon.size() );
+        bool simple = count >= 3;
+
+        // Each edge should start where a previous one ends and no vertex should be passed twice
+        for( s32 i = 0; i < count && simple; i++ ) {
+            const HorizonEdge& edge = m_horizon[i];
+            const HorizonEdge& next = m_horizon[(i + 1) % count];
+            const Face&        face = m_faces[edge.face];
+            s32                a    = face.vertex[edge.edge];
+
+            simple = face.vertex[(edge.edge + 1) % 3] == m_faces[next.face].vertex[next.edge] && !m_marks[a];
+            m_marks[a] = 1;
+        }
+
+        for( s32 i = 0; i < count; i++ ) {
+            m_marks[m_faces[m_horizon[i].face].vertex[m_horizon[i].edge]] = 0;
+        }
+
+        return simple;
+    }
+
+    // ** ConvexHull::skipPoint
+    inline void ConvexHull::skipPoint( s32 face, s32 eye )
+    {
+        s32* link = &m_faces[face].conflicts;
+
+        while( m_conflicts[*link].point != eye ) {
+            link = &m_conflicts[*link].next;
+        }
+
+        s32 node = *link;
+        *link = m_conflicts[node].next;
+        m_conflicts[node].next = m_freeConflicts;
+        m_freeConflicts        = node;
+
+        m_skipped.push_back( eye );
+
+        // Remaining conflict points of a face are still processed
+        if( m_faces[face].conflicts != -1 ) {
+            m_pending.push_back( face );
+        }
+    }
+
+    // ** ConvexHull::addPoint
+    inline void ConvexHull::addPoint( s32 start )
+    {
+        // Pick the furthest conflict point of a face
+        s32 eye  = -1;
+        f64 best = -DBL_MAX;
+
+        for( s32 node = m_faces[start].conflicts; node != -1; node = m_conflicts[node].next ) {
+            if( m_conflicts[node].distance > best ) {
+                best = m_conflicts[node].distance;
+                eye  = m_conflicts[node].point;
+            }
+        }
+
+        // Points within a tolerance of a face do not extend a hull
+        if( best <= m_epsilon ) {
+            return;
+        }
+
+        m_iteration++;
+
+        // Collect faces an eye point lies above by more than a tolerance
+        m_visible.clear();
+        m_visible.push_back( start );
+        m_faces[start].visited = m_iteration;
+
+        for( s32 i = 0; i < static_cast<s32>( m_visible.size() ); i++ ) {
+            for( s32 edge = 0; edge < 3; edge++ ) {
+                s32   neighbour = m_faces[m_visible[i]].neighbour[edge];
+                Face& other     = m_faces[neighbour];
+
+                if( other.visited != m_iteration && distance( other, eye ) > m_epsilon ) {
+                    other.visited = m_iteration;
+                    m_visible.push_back( neighbour );
+                }
+            }
+        }
+
+        // Grow a visible region until every new face forms a convex edge with a face outside of it
+        while( !findHorizon( start, eye ) ) {
+        }
+
+        // An eye point is skipped if it would remove a whole hull or a horizon is not a single loop
+        if( static_cast<s32>( m_visible.size() ) >= m_faceCount || !isSimpleHorizon() ) {
+            skipPoint( start, eye );
+            return;
+        }
+
+        // Connect horizon edges to an eye point
+        s32 count = static_cast<s32>( m_horizon.size() );
+        m_created.resize( count );
+
+        for( s32 i = 0; i < count; i++ ) {
+            const HorizonEdge& horizon = m_horizon[i];
+            const Face&        face    = m_faces[horizon.face];
+            s32                a       = face.vertex[horizon.edge];
+            s32                b       = face.vertex[(horizon.edge + 1) % 3];
+            s32                outside = face.neighbour[horizon.edge];
+
+            s32 created = allocateFace( a, b, eye );
+            m_created[i] = created;
+
+            Face& other = m_faces[outside];
+            for( s32 k = 0; k < 3; k++ ) {
+                if( other.neighbour[k] == horizon.face ) {
+                    other.neighbour[k] = created;
+                    break;
+                }
+            }
+
+            m_faces[created].neighbour[0] = outside;
+        }
+
+        for( s32 i = 0; i < count; i++ ) {
+            Face& face = m_faces[m_created[i]];
+            face.neighbour[1] = m_created[(i + 1) % count];
+            face.neighbour[2] = m_created[(i + count - 1) % count];
+            NIMBLE_BREAK_IF( face.vertex[1] != m_faces[face.neighbour[1]].vertex[0] );
+        }
+
+        // Reassign conflict points of visible faces and release them
+        const s32* created = count ? &m_created[0] : NULL;
+
+        for( s32 i = 0, n = static_cast<s32>( m_visible.size() ); i < n; i++ ) {
+            s32 index = m_visible[i];
+            s32 node  = m_faces[index].conflicts;
+
+            while( node != -1 ) {
+                s32 next  = m_conflicts[node].next;
+                s32 point = m_conflicts[node].point;
+
+                m_conflicts[node].next = m_freeConflicts;
+                m_freeConflicts        = node;
+
+                if( point != eye ) {
+                    assign( point, created, count );
+                }
+
+                node = next;
+            }
+
+            m_faces[index].conflicts = -1;
+            releaseFace( index );
+        }
+    }
+
+NIMBLE_END
+
+#endif  /*  !__Nimble_ConvexHull_H__  */
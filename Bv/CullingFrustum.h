@@ -0,0 +1,394 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_CullingFrustum_H__
+#define __Nimble_CullingFrustum_H__
+
+#include "../Globals.h"
+
+NIMBLE_BEGIN
+
+    //! Bounding spheres stored as a structure of arrays.
+    struct SphereBatch {
+                        //! Constructs a SphereBatch instance.
+                        SphereBatch( const f32* x = NULL, const f32* y = NULL, const f32* z = NULL, const f32* radius = NULL, s32 count = 0 )
+                            : x( x ), y( y ), z( z ), radius( radius ), count( count ) {}
+
+        const f32*      x;          //!< Sphere center X coordinates.
+        const f32*      y;          //!< Sphere center Y coordinates.
+        const f32*      z;          //!< Sphere center Z coordinates.
+        const f32*      radius;     //!< Sphere radii.
+        s32             count;      //!< The total number of spheres.
+    };
+
+    //! Axis-aligned bounding boxes stored as a structure of arrays of centers and half extents.
+    struct BoxBatch {
+                        //! Constructs a BoxBatch instance.
+                        BoxBatch( const f32* x = NULL, const f32* y = NULL, const f32* z = NULL, const f32* extentX = NULL, const f32* extentY = NULL, const f32* extentZ = NULL, s32 count = 0 )
+                            : x( x ), y( y ), z( z ), extentX( extentX ), extentY( extentY ), extentZ( extentZ ), count( count ) {}
+
+        const f32*      x;          //!< Box center X coordinates.
+        const f32*      y;          //!< Box center Y coordinates.
+        const f32*      z;          //!< Box center Z coordinates.
+        const f32*      extentX;    //!< Box half extents along the X axis.
+        const f32*      extentY;    //!< Box half extents along the Y axis.
+        const f32*      extentZ;    //!< Box half extents along the Z axis.
+        s32             count;      //!< The total number of boxes.
+    };
+
+    //! A view frustum represented by six inward facing planes, that culls bounding volumes.
+    /*!
+        Planes are extracted from a view-projection matrix with the Gribb-Hartmann method. Batch
+        culling kernels test 8 objects per iteration with AVX2, 4 objects with SSE2 and fall back
+        to a scalar loop otherwise. A result is either a visibility mask, where bit i % 32 of word
+        i / 32 is set for a visible object i, or a compacted list of visible object indices.
+    */
+    class CullingFrustum {
+    public:
+
+        //! The number of frustum planes.
+        enum { PlaneCount = 6 };
+
+        //! A clip space depth range of a projection matrix.
+        enum DepthRange {
+              DepthZeroToOne        //!< A clip space depth is in [0, w] range, as produced by Matrix4::perspective.
+            , DepthMinusOneToOne    //!< A clip space depth is in [-w, w] range.
+        };
+
+                        //! Constructs an empty CullingFrustum instance, that does not cull anything.
+                        CullingFrustum( void );
+
+                        //! Constructs a CullingFrustum instance from a view-projection matrix.
+        explicit        CullingFrustum( const Matrix4& viewProjection, DepthRange depthRange = DepthZeroToOne );
+
+        //! Returns a frustum plane with specified index, planes are left, right, bottom, top, near and far.
+        const Plane&    plane( s32 index ) const;
+
+        //! Returns true if a bounding box intersects or is inside a frustum.
+        bool            isVisible( const Bounds& bounds ) const;
+
+        //! Returns true if a sphere intersects or is inside a frustum.
+        bool            isVisible( const Vec3& center, f32 radius ) const;
+
+        //! Writes a visibility mask of a sphere batch, a mask should have (count + 31) / 32 words.
+        void            cull( const SphereBatch& spheres, u32* visibility ) const;
+
+        //! Writes a visibility mask of a box batch, a mask should have (count + 31) / 32 words.
+        void            cull( const BoxBatch& boxes, u32* visibility ) const;
+
+        //! Writes indices of visible spheres and returns their number.
+        s32             collectVisible( const SphereBatch& spheres, s32* indices ) const;
+
+        //! Writes indices of visible boxes and returns their number.
+        s32             collectVisible( const BoxBatch& boxes, s32* indices ) const;
+
+    private:
+
+        //! Returns a visibility bit mask of up to 32 spheres starting from specified index.
+        u32             test( const SphereBatch& spheres, s32 first, s32 count ) const;
+
+        //! Returns a visibility bit mask of up to 32 boxes starting from specified index.
+        u32             test( const BoxBatch& boxes, s32 first, s32 count ) const;
+
+        //! Writes a visibility mask of a batch.
+        template<typename TBatch>
+        void            cullBatch( const TBatch& batch, u32* visibility ) const;
+
+        //! Writes indices of visible objects of a batch and returns their number.
+        template<typename TBatch>
+        s32             collectBatch( const TBatch& batch, s32* indices ) const;
+
+    private:
+
+        Plane           m_planes[PlaneCount];       //!< Frustum planes.
+        f32             m_normalX[PlaneCount];      //!< Plane normal X coordinates.
+        f32             m_normalY[PlaneCount];      //!< Plane normal Y coordinates.
+        f32             m_normalZ[PlaneCount];      //!< Plane normal Z coordinates.
+        f32             m_distance[PlaneCount];     //!< Plane distances.
+        f32             m_absNormalX[PlaneCount];   //!< Absolute values of plane normal X coordinates.
+        f32             m_absNormalY[PlaneCount];   //!< Absolute values of plane normal Y coordinates.
+        f32             m_absNormalZ[PlaneCount];   //!< Absolute values of plane normal Z coordinates.
+    };
+
+    // ** CullingFrustum::CullingFrustum
+    inline CullingFrustum::CullingFrustum( void )
+    {
+        // Degenerate planes are offset to infinity, so every point, including a zero radius sphere, is in front of them
+        for( s32 i = 0; i < PlaneCount; i++ ) {
+            m_planes[i]  = Plane( 0.0f, 0.0f, 0.0f, FLT_MAX );
+            m_normalX[i] = m_normalY[i] = m_normalZ[i] = 0.0f;
+            m_distance[i] = FLT_MAX;
+            m_absNormalX[i] = m_absNormalY[i] = m_absNormalZ[i] = 0.0f;
+        }
+    }
+
+    // ** CullingFrustum::CullingFrustum
+    inline CullingFrustum::CullingFrustum( const Matrix4& viewProjection, DepthRange depthRange )
+    {
+        // Matrix rows, a clip space point is inside when -w <= x, y <= w and a depth is inside a depth range
+        f32 rows[4][4];
+
+        for( s32 i = 0; i < 4; i++ ) {
+            for( s32 j = 0; j < 4; j++ ) {
+                rows[i][j] = viewProjection[j * 4 + i];
+            }
+        }
+
+        // Each plane is a sum of the W row and a signed X, Y or Z row, except a near plane for a [0, w] depth range, that is the Z row itself
+        s32 axes[PlaneCount]    = { 0, 0, 1, 1, 2, 2 };
+        f32 signs[PlaneCount]   = { 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f };
+        f32 weights[PlaneCount] = { 1.0f, 1.0f, 1.0f, 1.0f, depthRange == DepthZeroToOne ? 0.0f : 1.0f, 1.0f };
+        f32 planes[PlaneCount][4];
+
+        for( s32 i = 0; i < PlaneCount; i++ ) {
+            for( s32 j = 0; j < 4; j++ ) {
+                planes[i][j] = rows[3][j] * weights[i] + rows[axes[i]][j] * signs[i];
+            }
+        }
+
+        for( s32 i = 0; i < PlaneCount; i++ ) {
+            m_planes[i] = Plane( planes[i][0], planes[i][1], planes[i][2], planes[i][3] );
+            m_planes[i].normalize();
+
+            m_normalX[i]  = m_planes[i].normal().x;
+            m_normalY[i]  = m_planes[i].normal().y;
+            m_normalZ[i]  = m_planes[i].normal().z;
+            m_distance[i] = m_planes[i].distance();
+
+            m_absNormalX[i] = fabsf( m_normalX[i] );
+            m_absNormalY[i] = fabsf( m_normalY[i] );
+            m_absNormalZ[i] = fabsf( m_normalZ[i] );
+        }
+    }
+
+    // ** CullingFrustum::plane
+    inline const Plane& CullingFrustum::plane( s32 index ) const
+    {
+        NIMBLE_ABORT_IF( index < 0 || index >= PlaneCount, "index is out of range" );
+        return m_planes[index];
+    }
+
+    // ** CullingFrustum::isVisible
+    inline bool CullingFrustum::isVisible( const Bounds& bounds ) const
+    {
+        for( s32 i = 0; i < PlaneCount; i++ ) {
+            if( m_planes[i].isBehind( bounds ) ) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // ** CullingFrustum::isVisible
+    inline bool CullingFrustum::isVisible( const Vec3& center, f32 radius ) const
+    {
+        for( s32 i = 0; i < PlaneCount; i++ ) {
+            if( m_planes[i].isBehind( center, radius ) ) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // ** CullingFrustum::cull
+    inline void CullingFrustum::cull( const SphereBatch& spheres, u32* visibility ) const
+    {
+        cullBatch( spheres, visibility );
+    }
+
+    // ** CullingFrustum::cull
+    inline void CullingFrustum::cull( const BoxBatch& boxes, u32* visibility ) const
+    {
+        cullBatch( boxes, visibility );
+    }
+
+    // ** CullingFrustum::collectVisible
+    inline s32 CullingFrustum::collectVisible( const SphereBatch& spheres, s32* indices ) const
+    {
+        return collectBatch( spheres, indices );
+    }
+
+    // ** CullingFrustum::collectVisible
+    inline s32 CullingFrustum::collectVisible( const BoxBatch& boxes, s32* indices ) const
+    {
+        return collectBatch( boxes, indices );
+    }
+
+    // ** CullingFrustum::cullBatch
+    template<typename TBatch>
+    void CullingFrustum::cullBatch( const TBatch& batch, u32* visibility ) const
+    {
+        for( s32 i = 0; i < batch.count; i += 32 ) {
+            visibility[i / 32] = test( batch, i, min2( 32, batch.count - i ) );
+        }
+    }
+
+    // ** CullingFrustum::collectBatch
+    template<typename TBatch>
+    s32 CullingFrustum::collectBatch( const TBatch& batch, s32* indices ) const
+    {
+        s32 visible = 0;
+
+        for( s32 i = 0; i < batch.count; i += 32 ) {
+            // Append visible indices from the lowest bit, clearing each visited bit
+            for( u32 mask = test( batch, i, min2( 32, batch.count - i ) ); mask; mask &= mask - 1 ) {
+                indices[visible++] = i + countTrailingZeros( mask );
+            }
+        }
+
+        return visible;
+    }
+
+    // ** CullingFrustum::test
+    inline u32 CullingFrustum::test( const SphereBatch& spheres, s32 first, s32 count ) const
+    {
+        u32 mask = 0;
+        s32 i    = 0;
+
+    #if defined( NIMBLE_SIMD_AVX2 )
+        for( ; i + 8 <= count; i += 8 ) {
+            s32    k       = first + i;
+            __m256 x       = _mm256_loadu_ps( spheres.x + k );
+            __m256 y       = _mm256_loadu_ps( spheres.y + k );
+            __m256 z       = _mm256_loadu_ps( spheres.z + k );
+            __m256 radius  = _mm256_sub_ps( _mm256_setzero_ps(), _mm256_loadu_ps( spheres.radius + k ) );
+            __m256 visible = _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) );
+
+            // A sphere is visible if it is not behind any of planes
+            for( s32 j = 0; j < PlaneCount; j++ ) {
+                __m256 distance = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( x, _mm256_set1_ps( m_normalX[j] ) ), _mm256_mul_ps( y, _mm256_set1_ps( m_normalY[j] ) ) ), _mm256_mul_ps( z, _mm256_set1_ps( m_normalZ[j] ) ) ), _mm256_set1_ps( m_distance[j] ) );
+                visible = _mm256_and_ps( visible, _mm256_cmp_ps( distance, radius, _CMP_GT_OQ ) );
+            }
+
+            mask |= static_cast<u32>( _mm256_movemask_ps( visible ) ) << i;
+        }
+    #endif  /*  NIMBLE_SIMD_AVX2    */
+
+    #if defined( NIMBLE_SIMD_SSE2 )
+        for( ; i + 4 <= count; i += 4 ) {
+            s32    k       = first + i;
+            __m128 x       = _mm_loadu_ps( spheres.x + k );
+            __m128 y       = _mm_loadu_ps( spheres.y + k );
+            __m128 z       = _mm_loadu_ps( spheres.z + k );
+            __m128 radius  = _mm_sub_ps( _mm_setzero_ps(), _mm_loadu_ps( spheres.radius + k ) );
+            __m128 visible = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+
+            // A sphere is visible if it is not behind any of planes
+            for( s32 j = 0; j < PlaneCount; j++ ) {
+                __m128 distance = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, _mm_set1_ps( m_normalX[j] ) ), _mm_mul_ps( y, _mm_set1_ps( m_normalY[j] ) ) ), _mm_mul_ps( z, _mm_set1_ps( m_normalZ[j] ) ) ), _mm_set1_ps( m_distance[j] ) );
+                visible = _mm_and_ps( visible, _mm_cmpgt_ps( distance, radius ) );
+            }
+
+            mask |= static_cast<u32>( _mm_movemask_ps( visible ) ) << i;
+        }
+    #endif  /*  NIMBLE_SIMD_SSE2    */
+
+        for( ; i < count; i++ ) {
+            s32  k       = first + i;
+            bool visible = true;
+
+            for( s32 j = 0; j < PlaneCount && visible; j++ ) {
+                f32 distance = spheres.x[k] * m_normalX[j] + spheres.y[k] * m_normalY[j] + spheres.z[k] * m_normalZ[j] + m_distance[j];
+                visible = distance > -spheres.radius[k];
+            }
+
+            mask |= static_cast<u32>( visible ) << i;
+        }
+
+        return mask;
+    }
+
+    // ** CullingFrustum::test
+    inline u32 CullingFrustum::test( const BoxBatch& boxes, s32 first, s32 count ) const
+    {
+        u32 mask = 0;
+        s32 i    = 0;
+
+    #if defined( NIMBLE_SIMD_AVX2 )
+        for( ; i + 8 <= count; i += 8 ) {
+            s32    k       = first + i;
+            __m256 x       = _mm256_loadu_ps( boxes.x + k );
+            __m256 y       = _mm256_loadu_ps( boxes.y + k );
+            __m256 z       = _mm256_loadu_ps( boxes.z + k );
+            __m256 ex      = _mm256_loadu_ps( boxes.extentX + k );
+            __m256 ey      = _mm256_loadu_ps( boxes.extentY + k );
+            __m256 ez      = _mm256_loadu_ps( boxes.extentZ + k );
+            __m256 visible = _mm256_castsi256_ps( _mm256_set1_epi32( -1 ) );
+
+            // A box is behind a plane if its center is farther than a box projected radius
+            for( s32 j = 0; j < PlaneCount; j++ ) {
+                __m256 distance = _mm256_add_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( x, _mm256_set1_ps( m_normalX[j] ) ), _mm256_mul_ps( y, _mm256_set1_ps( m_normalY[j] ) ) ), _mm256_mul_ps( z, _mm256_set1_ps( m_normalZ[j] ) ) ), _mm256_set1_ps( m_distance[j] ) );
+                __m256 radius   = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( ex, _mm256_set1_ps( m_absNormalX[j] ) ), _mm256_mul_ps( ey, _mm256_set1_ps( m_absNormalY[j] ) ) ), _mm256_mul_ps( ez, _mm256_set1_ps( m_absNormalZ[j] ) ) );
+                visible = _mm256_and_ps( visible, _mm256_cmp_ps( _mm256_add_ps( distance, radius ), _mm256_setzero_ps(), _CMP_GE_OQ ) );
+            }
+
+            mask |= static_cast<u32>( _mm256_movemask_ps( visible ) ) << i;
+        }
+    #endif  /*  NIMBLE_SIMD_AVX2    */
+
+    #if defined( NIMBLE_SIMD_SSE2 )
+        for( ; i + 4 <= count; i += 4 ) {
+            s32    k       = first + i;
+            __m128 x       = _mm_loadu_ps( boxes.x + k );
+            __m128 y       = _mm_loadu_ps( boxes.y + k );
+            __m128 z       = _mm_loadu_ps( boxes.z + k );
+            __m128 ex      = _mm_loadu_ps( boxes.extentX + k );
+            __m128 ey      = _mm_loadu_ps( boxes.extentY + k );
+            __m128 ez      = _mm_loadu_ps( boxes.extentZ + k );
+            __m128 visible = _mm_castsi128_ps( _mm_set1_epi32( -1 ) );
+
+            // A box is behind a plane if its center is farther than a box projected radius
+            for( s32 j = 0; j < PlaneCount; j++ ) {
+                __m128 distance = _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, _mm_set1_ps( m_normalX[j] ) ), _mm_mul_ps( y, _mm_set1_ps( m_normalY[j] ) ) ), _mm_mul_ps( z, _mm_set1_ps( m_normalZ[j] ) ) ), _mm_set1_ps( m_distance[j] ) );
+                __m128 radius   = _mm_add_ps( _mm_add_ps( _mm_mul_ps( ex, _mm_set1_ps( m_absNormalX[j] ) ), _mm_mul_ps( ey, _mm_set1_ps( m_absNormalY[j] ) ) ), _mm_mul_ps( ez, _mm_set1_ps( m_absNormalZ[j] ) ) );
+                visible = _mm_and_ps( visible, _mm_cmpge_ps( _mm_add_ps( distance, radius ), _mm_setzero_ps() ) );
+            }
+
+            mask |= static_cast<u32>( _mm_movemask_ps( visible ) ) << i;
+        }
+    #endif  /*  NIMBLE_SIMD_SSE2    */
+
+        for( ; i < count; i++ ) {
+            s32  k       = first + i;
+            bool visible = true;
+
+            for( s32 j = 0; j < PlaneCount && visible; j++ ) {
+                f32 distance = boxes.x[k] * m_normalX[j] + boxes.y[k] * m_normalY[j] + boxes.z[k] * m_normalZ[j] + m_distance[j];
+                f32 radius   = boxes.extentX[k] * m_absNormalX[j] + boxes.extentY[k] * m_absNormalY[j] + boxes.extentZ[k] * m_absNormalZ[j];
+                visible = distance + radius >= 0.0f;
+            }
+
+            mask |= static_cast<u32>( visible ) << i;
+        }
+
+        return mask;
+    }
+
+NIMBLE_END
+
+#endif  /*  !__Nimble_CullingFrustum_H__  */
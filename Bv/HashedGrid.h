@@ -0,0 +1,455 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_HashedGrid_H__
+#define __Nimble_HashedGrid_H__
+
+#include "../Globals.h"
+
+NIMBLE_BEGIN
+
+    //! A uniform grid of an unbounded size, where cells are hashed into a fixed number of buckets.
+    /*!
+        An object is registered in each cell its bounding box overlaps, so a cell size should be
+        close to a typical object size. Moving an object inside the same range of cells only updates
+        its bounds, otherwise it is unregistered from old cells and registered in new ones. Each
+        bucket entry keeps a copy of object bounds and a cell coordinate, so range and pair queries
+        only touch bucket memory and cells that share a bucket are told apart. A bucket table grows
+        when the number of entries exceeds the number of buckets.
+    */
+    template<typename TValue, typename THandle = OpaqueHandle<20, 12> >
+    class HashedGrid {
+    public:
+
+        typedef TValue          Value;  //!< Store the value type.
+        typedef THandle         Handle; //!< Store the handle type.
+
+                                //! Constructs a HashedGrid instance with a specified cell size.
+        explicit                HashedGrid( f32 cellSize = 1.0f, s32 bucketCount = 1024 );
+
+        //! Inserts an object with specified bounds and returns its handle.
+        Handle                  insert( const Bounds& bounds, const Value& value = Value() );
+
+        //! Updates bounds of an object.
+        void                    move( const Handle& handle, const Bounds& bounds );
+
+        //! Removes an object from a grid. Returns true if the removal succeed, otherwise returns false.
+        bool                    remove( const Handle& handle );
+
+        //! Returns true if the specified handle is valid.
+        bool                    has( const Handle& handle ) const;
+
+        //! Returns the value of an object referenced by a specified handle.
+        const Value&            get( const Handle& handle ) const;
+        Value&                  get( const Handle& handle );
+
+        //! Returns bounds of an object referenced by a specified handle.
+        const Bounds&           bounds( const Handle& handle ) const;
+
+        //! Returns the total number of objects.
+        s32                     size( void ) const;
+
+        //! Returns the cell size.
+        f32                     cellSize( void ) const;
+
+        //! Invokes a callback once for each object which bounds overlap a specified bounding box.
+        template<typename TCallback>
+        void                    query( const Bounds& bounds, const TCallback& callback ) const;
+
+        //! Invokes a callback once for each pair of objects with overlapping bounds.
+        template<typename TCallback>
+        void                    pairs( const TCallback& callback ) const;
+
+    private:
+
+        //! A cell coordinate.
+        struct Cell {
+            s32                 x;          //!< A cell X coordinate.
+            s32                 y;          //!< A cell Y coordinate.
+            s32                 z;          //!< A cell Z coordinate.
+
+            //! Compares two cell coordinates.
+            bool                operator == ( const Cell& other ) const { return x == other.x && y == other.y && z == other.z; }
+        };
+
+        //! An object registered in a cell.
+        struct Entry {
+            Bounds              bounds;     //!< Object bounds.
+            Cell                cell;       //!< A cell coordinate.
+            Handle              handle;     //!< An object handle.
+        };
+
+        //! A grid object.
+        struct Object {
+            Value               value;      //!< A user value.
+            Bounds              bounds;     //!< Object bounds.
+            Cell                min;        //!< The first cell overlapped by an object.
+            Cell                max;        //!< The last cell overlapped by an object.
+        };
+
+        //! A bucket of entries from all cells that share a hash value.
+        typedef Array<Entry>    Bucket;
+
+        //! Returns a cell that contains a point.
+        Cell                    cellAt( const Vec3& point ) const;
+
+        //! Returns a bucket index for a cell.
+        u32                     bucketAt( const Cell& cell ) const;
+
+        //! Registers an object in each cell of its range.
+        void                    link( const Handle& handle, const Object& object );
+
+        //! Unregisters an object from each cell of its range.
+        void                    unlink( const Handle& handle, const Object& object );
+
+        //! Updates bounds copies stored in each cell of an object range.
+        void                    update( const Handle& handle, const Object& object );
+
+        //! Finds an entry of an object inside a bucket.
+        s32                     find( const Bucket& bucket, const Handle& handle, const Cell& cell ) const;
+
+        //! Returns true if an entry overlaps a query and lies in the first cell shared by an object and a query range, so each object is reported once.
+        bool                    reports( const Entry& entry, const Bounds& bounds, const Cell& min ) const;
+
+        //! Resizes a bucket table and redistributes entries.
+        void                    rehash( s32 bucketCount );
+
+    private:
+
+        Pool<Object, Handle>    m_objects;      //!< Grid objects.
+        Array<Bucket>           m_buckets;      //!< Hashed grid cells.
+        f32                     m_cellSize;     //!< A cell size.
+        f32                     m_invCellSize;  //!< An inverse cell size.
+        s32                     m_entryCount;   //!< The total number of entries in all buckets.
+    };
+
+    // ** HashedGrid::HashedGrid
+    template<typename TValue, typename THandle>
+    HashedGrid<TValue, THandle>::HashedGrid( f32 cellSize, s32 bucketCount )
+        : m_cellSize( cellSize )
+        , m_invCellSize( 1.0f / cellSize )
+        , m_entryCount( 0 )
+    {
+        NIMBLE_ABORT_IF( cellSize <= 0.0f, "cell size should be positive" );
+        m_buckets.resize( nextPowerOf2( max2( bucketCount, 1 ) ) );
+    }
+
+    // ** HashedGrid::size
+    template<typename TValue, typename THandle>
+    s32 HashedGrid<TValue, THandle>::size( void ) const
+    {
+        return m_objects.size();
+    }
+
+    // ** HashedGrid::cellSize
+    template<typename TValue, typename THandle>
+    f32 HashedGrid<TValue, THandle>::cellSize( void ) const
+    {
+        return m_cellSize;
+    }
+
+    // ** HashedGrid::has
+    template<typename TValue, typename THandle>
+    bool HashedGrid<TValue, THandle>::has( const Handle& handle ) const
+    {
+        return m_objects.has( handle );
+    }
+
+    // ** HashedGrid::get
+    template<typename TValue, typename THandle>
+    const TValue& HashedGrid<TValue, THandle>::get( const Handle& handle ) const
+    {
+        return m_objects.get( handle ).value;
+    }
+
+    // ** HashedGrid::get
+    template<typename TValue, typename THandle>
+    TValue& HashedGrid<TValue, THandle>::get( const Handle& handle )
+    {
+        return m_objects.get( handle ).value;
+    }
+
+    // ** HashedGrid::bounds
+    template<typename TValue, typename THandle>
+    const Bounds& HashedGrid<TValue, THandle>::bounds( const Handle& handle ) const
+    {
+        return m_objects.get( handle ).bounds;
+    }
+
+    // ** HashedGrid::cellAt
+    template<typename TValue, typename THandle>
+    typename HashedGrid<TValue, THandle>::Cell HashedGrid<TValue, THandle>::cellAt( const Vec3& point ) const
+    {
+        Cell cell;
+        cell.x = static_cast<s32>( floorf( point.x * m_invCellSize ) );
+        cell.y = static_cast<s32>( floorf( point.y * m_invCellSize ) );
+        cell.z = static_cast<s32>( floorf( point.z * m_invCellSize ) );
+        return cell;
+    }
+
+    // ** HashedGrid::bucketAt
+    template<typename TValue, typename THandle>
+    u32 HashedGrid<TValue, THandle>::bucketAt( const Cell& cell ) const
+    {
+        u32 hash = (static_cast<u32>( cell.x ) * 73856093u) ^ (static_cast<u32>( cell.y ) * 19349663u) ^ (static_cast<u32>( cell.z ) * 83492791u);
+        return hash & (static_cast<u32>( m_buckets.size() ) - 1);
+    }
+
+    // ** HashedGrid::find
+    template<typename TValue, typename THandle>
+    s32 HashedGrid<TValue, THandle>::find( const Bucket& bucket, const Handle& handle, const Cell& cell ) const
+    {
+        for( s32 i = 0, n = static_cast<s32>( bucket.size() ); i < n; i++ ) {
+            if( bucket[i].handle == handle && bucket[i].cell == cell ) {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    // ** HashedGrid::link
+    template<typename TValue, typename THandle>
+    void HashedGrid<TValue, THandle>::link( const Handle& handle, const Object& object )
+    {
+        Entry entry;
+        entry.bounds = object.bounds;
+        entry.handle = handle;
+
+        for( entry.cell.z = object.min.z; entry.cell.z <= object.max.z; entry.cell.z++ ) {
+            for( entry.cell.y = object.min.y; entry.cell.y <= object.max.y; entry.cell.y++ ) {
+                for( entry.cell.x = object.min.x; entry.cell.x <= object.max.x; entry.cell.x++ ) {
+                    m_buckets[bucketAt( entry.cell )].push_back( entry );
+                    m_entryCount++;
+                }
+            }
+        }
+    }
+
+    // ** HashedGrid::unlink
+    template<typename TValue, typename THandle>
+    void HashedGrid<TValue, THandle>::unlink( const Handle& handle, const Object& object )
+    {
+        Cell cell;
+
+        for( cell.z = object.min.z; cell.z <= object.max.z; cell.z++ ) {
+            for( cell.y = object.min.y; cell.y <= object.max.y; cell.y++ ) {
+                for( cell.x = object.min.x; cell.x <= object.max.x; cell.x++ ) {
+                    Bucket& bucket = m_buckets[bucketAt( cell )];
+                    s32     index  = find( bucket, handle, cell );
+                    NIMBLE_BREAK_IF( index < 0, "object is not registered in a cell" );
+
+                    bucket[index] = bucket.back();
+                    bucket.pop_back();
+                    m_entryCount--;
+                }
+            }
+        }
+    }
+
+    // ** HashedGrid::update
+    template<typename TValue, typename THandle>
+    void HashedGrid<TValue, THandle>::update( const Handle& handle, const Object& object )
+    {
+        Cell cell;
+
+        for( cell.z = object.min.z; cell.z <= object.max.z; cell.z++ ) {
+            for( cell.y = object.min.y; cell.y <= object.max.y; cell.y++ ) {
+                for( cell.x = object.min.x; cell.x <= object.max.x; cell.x++ ) {
+                    Bucket& bucket = m_buckets[bucketAt( cell )];
+                    s32     index  = find( bucket, handle, cell );
+                    NIMBLE_BREAK_IF( index < 0, "object is not registered in a cell" );
+                    bucket[index].bounds = object.bounds;
+                }
+            }
+        }
+    }
+
+    // ** HashedGrid::reports
+    template<typename TValue, typename THandle>
+    bool HashedGrid<TValue, THandle>::reports( const Entry& entry, const Bounds& bounds, const Cell& min ) const
+    {
+        if( !entry.bounds.overlaps( bounds ) ) {
+            return false;
+        }
+
+        Cell first = cellAt( entry.bounds.min() );
+        return max2( first.x, min.x ) == entry.cell.x && max2( first.y, min.y ) == entry.cell.y && max2( first.z, min.z ) == entry.cell.z;
+    }
+
+    // ** HashedGrid::rehash
+    template<typename TValue, typename THandle>
+    void HashedGrid<TValue, THandle>::rehash( s32 bucketCount )
+    {
+        Array<Bucket> buckets;
+        buckets.resize( bucketCount );
+        m_buckets.swap( buckets );
+
+        for( s32 i = 0, n = static_cast<s32>( buckets.size() ); i < n; i++ ) {
+            const Bucket& bucket = buckets[i];
+
+            for( s32 j = 0, m = static_cast<s32>( bucket.size() ); j < m; j++ ) {
+                m_buckets[bucketAt( bucket[j].cell )].push_back( bucket[j] );
+            }
+        }
+    }
+
+    // ** HashedGrid::insert
+    template<typename TValue, typename THandle>
+    THandle HashedGrid<TValue, THandle>::insert( const Bounds& bounds, const Value& value )
+    {
+        Object object;
+        object.value  = value;
+        object.bounds = bounds;
+        object.min    = cellAt( bounds.min() );
+        object.max    = cellAt( bounds.max() );
+
+        Handle handle = m_objects.add( object );
+        link( handle, object );
+
+        // Keep the average bucket size below one entry
+        if( m_entryCount > static_cast<s32>( m_buckets.size() ) ) {
+            rehash( static_cast<s32>( m_buckets.size() ) * 2 );
+        }
+
+        return handle;
+    }
+
+    // ** HashedGrid::move
+    template<typename TValue, typename THandle>
+    void HashedGrid<TValue, THandle>::move( const Handle& handle, const Bounds& bounds )
+    {
+        Object& object = m_objects.get( handle );
+        Cell    min    = cellAt( bounds.min() );
+        Cell    max    = cellAt( bounds.max() );
+
+        object.bounds = bounds;
+
+        // An object stays in the same cells, so only bounds copies should be updated
+        if( min == object.min && max == object.max ) {
+            update( handle, object );
+            return;
+        }
+
+        unlink( handle, object );
+        object.min = min;
+        object.max = max;
+        link( handle, object );
+
+        if( m_entryCount > static_cast<s32>( m_buckets.size() ) ) {
+            rehash( static_cast<s32>( m_buckets.size() ) * 2 );
+        }
+    }
+
+    // ** HashedGrid::remove
+    template<typename TValue, typename THandle>
+    bool HashedGrid<TValue, THandle>::remove( const Handle& handle )
+    {
+        if( !m_objects.has( handle ) ) {
+            return false;
+        }
+
+        unlink( handle, m_objects.get( handle ) );
+        return m_objects.remove( handle );
+    }
+
+    // ** HashedGrid::query
+    template<typename TValue, typename THandle>
+    template<typename TCallback>
+    void HashedGrid<TValue, THandle>::query( const Bounds& bounds, const TCallback& callback ) const
+    {
+        Cell min = cellAt( bounds.min() );
+        Cell max = cellAt( bounds.max() );
+
+        f64 cellCount = (f64( max.x ) - min.x + 1) * (f64( max.y ) - min.y + 1) * (f64( max.z ) - min.z + 1);
+
+        // A large query range is cheaper to process by scanning all buckets
+        if( cellCount > m_buckets.size() ) {
+            for( s32 i = 0, n = static_cast<s32>( m_buckets.size() ); i < n; i++ ) {
+                const Bucket& bucket = m_buckets[i];
+
+                for( s32 j = 0, m = static_cast<s32>( bucket.size() ); j < m; j++ ) {
+                    const Entry& entry = bucket[j];
+                    const Cell&  cell  = entry.cell;
+
+                    if( cell.x >= min.x && cell.x <= max.x && cell.y >= min.y && cell.y <= max.y && cell.z >= min.z && cell.z <= max.z && reports( entry, bounds, min ) ) {
+                        callback( entry.handle );
+                    }
+                }
+            }
+            return;
+        }
+
+        Cell cell;
+
+        for( cell.z = min.z; cell.z <= max.z; cell.z++ ) {
+            for( cell.y = min.y; cell.y <= max.y; cell.y++ ) {
+                for( cell.x = min.x; cell.x <= max.x; cell.x++ ) {
+                    const Bucket& bucket = m_buckets[bucketAt( cell )];
+
+                    for( s32 i = 0, n = static_cast<s32>( bucket.size() ); i < n; i++ ) {
+                        if( bucket[i].cell == cell && reports( bucket[i], bounds, min ) ) {
+                            callback( bucket[i].handle );
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // ** HashedGrid::pairs
+    template<typename TValue, typename THandle>
+    template<typename TCallback>
+    void HashedGrid<TValue, THandle>::pairs( const TCallback& callback ) const
+    {
+        for( s32 i = 0, n = static_cast<s32>( m_buckets.size() ); i < n; i++ ) {
+            const Bucket& bucket = m_buckets[i];
+
+            for( s32 j = 0, m = static_cast<s32>( bucket.size() ); j < m; j++ ) {
+                const Entry& a = bucket[j];
+
+                for( s32 k = j + 1; k < m; k++ ) {
+                    const Entry& b = bucket[k];
+
+                    if( !(a.cell == b.cell) || !a.bounds.overlaps( b.bounds ) ) {
+                        continue;
+                    }
+
+                    // Two objects may share several cells, a pair is reported from a cell that contains a lower corner of their intersection
+                    const Vec3& minA = a.bounds.min();
+                    const Vec3& minB = b.bounds.min();
+
+                    if( cellAt( Vec3( max2( minA.x, minB.x ), max2( minA.y, minB.y ), max2( minA.z, minB.z ) ) ) == a.cell ) {
+                        callback( a.handle, b.handle );
+                    }
+                }
+            }
+        }
+    }
+
+NIMBLE_END
+
+#endif  /*  !__Nimble_HashedGrid_H__  */
@@ -0,0 +1,488 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_KdTree_H__
+#define __Nimble_KdTree_H__
+
+#include "../Globals.h"
+
+NIMBLE_BEGIN
+
+    //! A static k-d tree over a point set used for nearest neighbour and radius queries.
+    /*!
+        A tree has an implicit layout: points are reordered so a node of a [begin, end) range is a median
+        point stored at a middle of a range, points of a left subtree precede it and points of a right subtree
+        follow it. A split axis is an axis of the largest range extent and a median is found with a linear
+        selection, so a build takes O(n log n) time and a tree stores no child links. Queries keep a traversal
+        stack on a call stack and never allocate, so they can run from several threads at once.
+    */
+    template<typename TPoint, s32 TDimensions>
+    class KdTree {
+    public:
+
+        //! A max depth of a tree traversal stack, a balanced tree over 2^31 points is 32 levels deep.
+        enum { MaxDepth = 64 };
+
+                                //! Constructs an empty KdTree instance.
+                                KdTree( void );
+
+        //! Builds a tree over an array of points.
+        void                    build( const TPoint* points, s32 count );
+
+    #if NIMBLE_CPP11_ENABLED
+        //! Builds a tree over an array of points in parallel, top levels are split breadth first and resulting subtrees are built by separate jobs.
+        void                    build( JobSystem& jobs, const TPoint* points, s32 count );
+    #endif  /*  NIMBLE_CPP11_ENABLED    */
+
+        //! Returns the total number of points.
+        s32                     size( void ) const;
+
+        //! Returns an index of a nearest point closer than a max distance, or -1 if there is no such point.
+        s32                     nearest( const TPoint& point, f32 maxDistance = FLT_MAX, f32* distanceSqr = NULL ) const;
+
+        //! Finds up to a specified number of nearest points closer than a max distance, outputs them sorted by a distance and returns the number of points found.
+        s32                     nearest( const TPoint& point, s32 count, s32* indices, f32* distancesSqr, f32 maxDistance = FLT_MAX ) const;
+
+        //! Invokes a callback as callback( index, distanceSqr ) for each point inside a sphere.
+        template<typename TCallback>
+        void                    radius( const TPoint& point, f32 radius, const TCallback& callback ) const;
+
+    private:
+
+        //! A point stored in a tree order.
+        struct Item {
+            TPoint              point;      //!< A point position.
+            s32                 index;      //!< An index of a point in an input array.
+        };
+
+        //! A subtree range.
+        struct Range {
+            s32                 begin;      //!< A first point of a range.
+            s32                 end;        //!< A point after the last one of a range.
+        };
+
+        //! A traversal stack entry.
+        struct Visit {
+            s32                 begin;      //!< A first point of a subtree.
+            s32                 end;        //!< A point after the last one of a subtree.
+            f32                 bound;      //!< A lower bound of a squared distance to any point of a subtree.
+        };
+
+        //! Orders items by a coordinate along a split axis.
+        struct CompareAxis {
+                                //! Constructs a CompareAxis instance.
+                                CompareAxis( s32 axis )
+                                    : axis( axis ) {}
+
+            //! Returns true if a first item precedes a second one along an axis.
+            bool                operator () ( const Item& a, const Item& b ) const { return a.point[axis] < b.point[axis]; }
+
+            s32                 axis;       //!< A split axis.
+        };
+
+        //! Copies input points to items.
+        void                    initialize( const TPoint* points, s32 count );
+
+        //! Selects a median of a range along an axis of the largest extent and outputs child ranges.
+        void                    split( const Range& range, Range& left, Range& right );
+
+        //! Recursively builds a subtree of a range.
+        void                    buildRange( const Range& range );
+
+        //! Returns a squared distance between two points.
+        static f32              distanceSqr( const TPoint& a, const TPoint& b );
+
+        //! Moves a last heap item up to restore a max heap order.
+        static void             siftUp( s32* indices, f32* distances, s32 item );
+
+        //! Moves a first heap item down to restore a max heap order.
+        static void             siftDown( s32* indices, f32* distances, s32 count );
+
+    private:
+
+        Array<Item>             m_items;    //!< Points in a tree order.
+        Array<u8>               m_axes;     //!< A split axis of each node.
+    };
+
+    // ** KdTree::KdTree
+    template<typename TPoint, s32 TDimensions>
+    KdTree<TPoint, TDimensions>::KdTree( void )
+    {
+    }
+
+    // ** KdTree::size
+    template<typename TPoint, s32 TDimensions>
+    s32 KdTree<TPoint, TDimensions>::size( void ) const
+    {
+        return static_cast<s32>( m_items.size() );
+    }
+
+    // ** KdTree::distanceSqr
+    template<typename TPoint, s32 TDimensions>
+    f32 KdTree<TPoint, TDimensions>::distanceSqr( const TPoint& a, const TPoint& b )
+    {
+        f32 result = 0.0f;
+
+        for( s32 i = 0; i < TDimensions; i++ ) {
+            f32 d = a[i] - b[i];
+            result += d * d;
+        }
+
+        return result;
+    }
+
+    // ** KdTree::initialize
+    template<typename TPoint, s32 TDimensions>
+    void KdTree<TPoint, TDimensions>::initialize( const TPoint* points, s32 count )
+    {
+        m_items.resize( count );
+        m_axes.resize( count );
+
+        for( s32 i = 0; i < count; i++ ) {
+            m_items[i].point = points[i];
+            m_items[i].index = i;
+        }
+    }
+
+    // ** KdTree::split
+    template<typename TPoint, s32 TDimensions>
+    void KdTree<TPoint, TDimensions>::split( const Range& range, Range& left, Range& right )
+    {
+        s32 middle = (range.begin + range.end) / 2;
+
+        // Find an axis of the largest extent
+        TPoint min = m_items[range.begin].point;
+        TPoint max = m_items[range.begin].point;
+
+        for( s32 i = range.begin + 1; i < range.end; i++ ) {
+            const TPoint& point = m_items[i].point;
+
+            for( s32 j = 0; j < TDimensions; j++ ) {
+                min[j] = min2( min[j], point[j] );
+                max[j] = max2( max[j], point[j] );
+            }
+        }
+
+        s32 axis = 0;
+
+        for( s32 j = 1; j < TDimensions; j++ ) {
+            if( max[j] - min[j] > max[axis] - min[axis] ) {
+                axis = j;
+            }
+        }
+
+        // Place a median to a middle of a range with smaller coordinates before it
+        std::nth_element( m_items.begin() + range.begin, m_items.begin() + middle, m_items.begin() + range.end, CompareAxis( axis ) );
+        m_axes[middle] = static_cast<u8>( axis );
+
+        left.begin  = range.begin;
+        left.end    = middle;
+        right.begin = middle + 1;
+        right.end   = range.end;
+    }
+
+    // ** KdTree::buildRange
+    template<typename TPoint, s32 TDimensions>
+    void KdTree<TPoint, TDimensions>::buildRange( const Range& range )
+    {
+        if( range.end - range.begin <= 1 ) {
+            return;
+        }
+
+        Range left, right;
+        split( range, left, right );
+        buildRange( left );
+        buildRange( right );
+    }
+
+    // ** KdTree::build
+    template<typename TPoint, s32 TDimensions>
+    void KdTree<TPoint, TDimensions>::build( const TPoint* points, s32 count )
+    {
+        initialize( points, count );
+
+        Range range = { 0, count };
+        buildRange( range );
+    }
+
+#if NIMBLE_CPP11_ENABLED
+    // ** KdTree::build
+    template<typename TPoint, s32 TDimensions>
+    void KdTree<TPoint, TDimensions>::build( JobSystem& jobs, const TPoint* points, s32 count )
+    {
+        // Ranges smaller than this are not split breadth first, because scheduling would cost more than a split
+        const s32 SplitGrainSize = 4096;
+
+        initialize( points, count );
+
+        Array<Range> ranges;
+        Array<Range> children;
+        Range        root = { 0, count };
+        ranges.push_back( root );
+
+        // Split top levels until there are enough independent subtrees to keep all threads busy
+        s32 subtrees = (jobs.workerCount() + 1) * 4;
+
+        while( static_cast<s32>( ranges.size() ) < subtrees && count / static_cast<s32>( ranges.size() ) > SplitGrainSize ) {
+            children.resize( ranges.size() * 2 );
+
+            parallelFor( jobs, static_cast<s32>( ranges.size() ), [&]( s32 begin, s32 end ) {
+                for( s32 i = begin; i < end; i++ ) {
+                    split( ranges[i], children[i * 2 + 0], children[i * 2 + 1] );
+                }
+            }, 1 );
+
+            ranges.swap( children );
+        }
+
+        parallelFor( jobs, static_cast<s32>( ranges.size() ), [&]( s32 begin, s32 end ) {
+            for( s32 i = begin; i < end; i++ ) {
+                buildRange( ranges[i] );
+            }
+        }, 1 );
+    }
+#endif  /*  NIMBLE_CPP11_ENABLED    */
+
+    // ** KdTree::nearest
+    template<typename TPoint, s32 TDimensions>
+    s32 KdTree<TPoint, TDimensions>::nearest( const TPoint& point, f32 maxDistance, f32* distanceSqr ) const
+    {
+        s32 result = -1;
+        f32 best   = maxDistance < sqrtf( FLT_MAX ) ? maxDistance * maxDistance : FLT_MAX;
+        f32 found  = best;
+
+        Visit stack[MaxDepth];
+        s32   top = 0;
+
+        Visit root = { 0, size(), 0.0f };
+        stack[top++] = root;
+
+        while( top ) {
+            Visit visit = stack[--top];
+
+            if( visit.begin >= visit.end || visit.bound >= best ) {
+                continue;
+            }
+
+            s32         middle = (visit.begin + visit.end) / 2;
+            const Item& item   = m_items[middle];
+            f32         d      = KdTree::distanceSqr( item.point, point );
+
+            if( d < best ) {
+                best   = d;
+                found  = d;
+                result = item.index;
+            }
+
+            // Visit a child on a query point side first, a far child is skipped once a closer point is found
+            s32 axis  = m_axes[middle];
+            f32 delta = point[axis] - item.point[axis];
+            Visit nearChild = { visit.begin, middle, visit.bound };
+            Visit farChild  = { middle + 1, visit.end, max2( visit.bound, delta * delta ) };
+
+            if( delta > 0.0f ) {
+                nearChild.begin = middle + 1;
+                nearChild.end   = visit.end;
+                farChild.begin  = visit.begin;
+                farChild.end    = middle;
+            }
+
+            NIMBLE_BREAK_IF( top + 2 > MaxDepth, "traversal stack overflow" );
+            stack[top++] = farChild;
+            stack[top++] = nearChild;
+        }
+
+        if( distanceSqr && result != -1 ) {
+            *distanceSqr = found;
+        }
+
+        return result;
+    }
+
+    // ** KdTree::nearest
+    template<typename TPoint, s32 TDimensions>
+    s32 KdTree<TPoint, TDimensions>::nearest( const TPoint& point, s32 count, s32* indices, f32* distancesSqr, f32 maxDistance ) const
+    {
+        if( count <= 0 ) {
+            return 0;
+        }
+
+        // Output arrays hold a max heap of found points while a tree is traversed
+        f32 limit = maxDistance < sqrtf( FLT_MAX ) ? maxDistance * maxDistance : FLT_MAX;
+        s32 found = 0;
+
+        Visit stack[MaxDepth];
+        s32   top = 0;
+
+        Visit root = { 0, size(), 0.0f };
+        stack[top++] = root;
+
+        while( top ) {
+            Visit visit = stack[--top];
+            f32   best  = found == count ? distancesSqr[0] : limit;
+
+            if( visit.begin >= visit.end || visit.bound >= best ) {
+                continue;
+            }
+
+            s32         middle = (visit.begin + visit.end) / 2;
+            const Item& item   = m_items[middle];
+            f32         d      = KdTree::distanceSqr( item.point, point );
+
+            if( d < best ) {
+                if( found < count ) {
+                    indices[found]      = item.index;
+                    distancesSqr[found] = d;
+                    siftUp( indices, distancesSqr, found++ );
+                } else {
+                    indices[0]      = item.index;
+                    distancesSqr[0] = d;
+                    siftDown( indices, distancesSqr, found );
+                }
+            }
+
+            s32 axis  = m_axes[middle];
+            f32 delta = point[axis] - item.point[axis];
+            Visit nearChild = { visit.begin, middle, visit.bound };
+            Visit farChild  = { middle + 1, visit.end, max2( visit.bound, delta * delta ) };
+
+            if( delta > 0.0f ) {
+                nearChild.begin = middle + 1;
+                nearChild.end   = visit.end;
+                farChild.begin  = visit.begin;
+                farChild.end    = middle;
+            }
+
+            NIMBLE_BREAK_IF( top + 2 > MaxDepth, "traversal stack overflow" );
+            stack[top++] = farChild;
+            stack[top++] = nearChild;
+        }
+
+        // Sort a heap in place, so points are ordered by an increasing distance
+        for( s32 i = found - 1; i > 0; i-- ) {
+            std::swap( indices[0], indices[i] );
+            std::swap( distancesSqr[0], distancesSqr[i] );
+            siftDown( indices, distancesSqr, i );
+        }
+
+        return found;
+    }
+
+    // ** KdTree::radius
+    template<typename TPoint, s32 TDimensions>
+    template<typename TCallback>
+    void KdTree<TPoint, TDimensions>::radius( const TPoint& point, f32 radius, const TCallback& callback ) const
+    {
+        f32 radiusSqr = radius * radius;
+
+        Range stack[MaxDepth];
+        s32   top = 0;
+
+        Range root = { 0, size() };
+        stack[top++] = root;
+
+        while( top ) {
+            Range range = stack[--top];
+
+            if( range.begin >= range.end ) {
+                continue;
+            }
+
+            s32         middle = (range.begin + range.end) / 2;
+            const Item& item   = m_items[middle];
+            f32         d      = KdTree::distanceSqr( item.point, point );
+
+            if( d <= radiusSqr ) {
+                callback( item.index, d );
+            }
+
+            // A child is visited only if a sphere reaches a side of a split plane it lies on
+            s32 axis  = m_axes[middle];
+            f32 delta = point[axis] - item.point[axis];
+
+            NIMBLE_BREAK_IF( top + 2 > MaxDepth, "traversal stack overflow" );
+
+            if( delta <= radius ) {
+                Range left = { range.begin, middle };
+                stack[top++] = left;
+            }
+            if( delta >= -radius ) {
+                Range right = { middle + 1, range.end };
+                stack[top++] = right;
+            }
+        }
+    }
+
+    // ** KdTree::siftUp
+    template<typename TPoint, s32 TDimensions>
+    void KdTree<TPoint, TDimensions>::siftUp( s32* indices, f32* distances, s32 item )
+    {
+        while( item > 0 ) {
+            s32 parent = (item - 1) / 2;
+
+            if( distances[parent] >= distances[item] ) {
+                break;
+            }
+
+            std::swap( indices[parent], indices[item] );
+            std::swap( distances[parent], distances[item] );
+            item = parent;
+        }
+    }
+
+    // ** KdTree::siftDown
+    template<typename TPoint, s32 TDimensions>
+    void KdTree<TPoint, TDimensions>::siftDown( s32* indices, f32* distances, s32 count )
+    {
+        s32 item = 0;
+
+        while( true ) {
+            s32 largest = item;
+            s32 left    = item * 2 + 1;
+            s32 right   = item * 2 + 2;
+
+            if( left  < count && distances[left]  > distances[largest] ) largest = left;
+            if( right < count && distances[right] > distances[largest] ) largest = right;
+
+            if( largest == item ) {
+                break;
+            }
+
+            std::swap( indices[largest], indices[item] );
+            std::swap( distances[largest], distances[item] );
+            item = largest;
+        }
+    }
+
+    //! A k-d tree over 2D points.
+    typedef KdTree<Vec2, 2> KdTree2;
+
+    //! A k-d tree over 3D points.
+    typedef KdTree<Vec3, 3> KdTree3;
+
+NIMBLE_END
+
+#endif  /*  !__Nimble_KdTree_H__  */
@@ -0,0 +1,410 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_LooseOctree_H__
+#define __Nimble_LooseOctree_H__
+
+#include "../Globals.h"
+
+NIMBLE_BEGIN
+
+    //! A loose octree of dynamic objects.
+    /*!
+        Each node bounds are expanded twice around a node center, so an object whose half size does
+        not exceed a node half size fits into a node that contains an object center. This allows a
+        target node to be picked directly from object size and position without testing node bounds.
+        Nodes are created lazily and keep the number of objects in their subtrees, so empty branches
+        are skipped by queries. Objects outside of world bounds are stored in a root node.
+    */
+    template<typename TValue, typename THandle = OpaqueHandle<20, 12> >
+    class LooseOctree {
+    public:
+
+        typedef TValue          Value;  //!< Store the value type.
+        typedef THandle         Handle; //!< Store the handle type.
+
+                                //! Constructs a LooseOctree instance that covers specified world bounds.
+        explicit                LooseOctree( const Bounds& world, s32 maxDepth = 8 );
+
+        //! Inserts an object with specified bounds and returns its handle.
+        Handle                  insert( const Bounds& bounds, const Value& value = Value() );
+
+        //! Updates bounds of an object.
+        void                    move( const Handle& handle, const Bounds& bounds );
+
+        //! Removes an object from a tree. Returns true if the removal succeed, otherwise returns false.
+        bool                    remove( const Handle& handle );
+
+        //! Returns true if the specified handle is valid.
+        bool                    has( const Handle& handle ) const;
+
+        //! Returns the value of an object referenced by a specified handle.
+        const Value&            get( const Handle& handle ) const;
+        Value&                  get( const Handle& handle );
+
+        //! Returns bounds of an object referenced by a specified handle.
+        const Bounds&           bounds( const Handle& handle ) const;
+
+        //! Returns the total number of objects.
+        s32                     size( void ) const;
+
+        //! Returns the total number of allocated nodes.
+        s32                     nodeCount( void ) const;
+
+        //! Invokes a callback once for each object which bounds overlap a specified bounding box.
+        template<typename TCallback>
+        void                    query( const Bounds& bounds, const TCallback& callback ) const;
+
+        //! Invokes a callback once for each pair of objects with overlapping bounds.
+        template<typename TCallback>
+        void                    pairs( const TCallback& callback ) const;
+
+    private:
+
+        //! An object stored inside a node.
+        struct Item {
+            Bounds              bounds;     //!< Object bounds.
+            Handle              handle;     //!< An object handle.
+        };
+
+        //! A tree node.
+        struct Node {
+            Vec3                center;     //!< A node center.
+            f32                 halfSize;   //!< A node half size, loose bounds are twice as large.
+            s32                 parent;     //!< A parent node index.
+            s32                 octant;     //!< An octant of a parent node occupied by this node.
+            s32                 children[8];//!< Child node indices, -1 for missing children.
+            s32                 count;      //!< The total number of objects in this subtree.
+            u32                 occupied;   //!< A bit mask of children with a non-empty subtree.
+            Array<Item>         items;      //!< Objects stored in this node.
+        };
+
+        //! A tree object.
+        struct Object {
+            Value               value;      //!< A user value.
+            s32                 node;       //!< A node that contains an object.
+            s32                 slot;       //!< An item index inside a node.
+        };
+
+        //! Returns a node that should contain an object with specified bounds, missing nodes are created.
+        s32                     findNode( const Bounds& bounds );
+
+        //! Adds an object to a node.
+        void                    link( const Handle& handle, Object& object, s32 node, const Bounds& bounds );
+
+        //! Removes an object from its node.
+        void                    unlink( const Object& object );
+
+        //! Returns true if loose bounds of a node overlap a box with a specified center and half size.
+        static bool             overlaps( const Vec3& nodeCenter, f32 nodeHalfSize, const Vec3& center, const Vec3& halfSize );
+
+        //! Reports a pair of an object and an overlapping one, each pair is found twice but reported once.
+        template<typename TCallback>
+        struct PairCallback {
+                                //! Constructs a PairCallback instance.
+                                PairCallback( const Handle& handle, const TCallback& callback )
+                                    : handle( handle ), callback( callback ) {}
+
+            //! Reports a pair if an overlapping object has a greater index.
+            void                operator () ( const Handle& other ) const { if( static_cast<u32>( handle ) < static_cast<u32>( other ) ) callback( handle, other ); }
+
+            Handle              handle;     //!< An object being tested.
+            const TCallback&    callback;   //!< A pair callback.
+        };
+
+    private:
+
+        Pool<Object, Handle>    m_objects;  //!< Tree objects.
+        Array<Node>             m_nodes;    //!< Tree nodes, the first one is a root.
+        s32                     m_maxDepth; //!< The maximum tree depth.
+    };
+
+    // ** LooseOctree::LooseOctree
+    template<typename TValue, typename THandle>
+    LooseOctree<TValue, THandle>::LooseOctree( const Bounds& world, s32 maxDepth )
+        : m_maxDepth( maxDepth )
+    {
+        NIMBLE_ABORT_IF( maxDepth < 0 || maxDepth > 32, "maximum octree depth is out of range" );
+
+        Node root;
+        root.center   = world.center();
+        root.halfSize = max3( world.width(), world.height(), world.depth() ) * 0.5f;
+        root.parent   = -1;
+        root.octant   = 0;
+        root.count    = 0;
+        root.occupied = 0;
+
+        for( s32 i = 0; i < 8; i++ ) {
+            root.children[i] = -1;
+        }
+
+        m_nodes.push_back( root );
+    }
+
+    // ** LooseOctree::size
+    template<typename TValue, typename THandle>
+    s32 LooseOctree<TValue, THandle>::size( void ) const
+    {
+        return m_objects.size();
+    }
+
+    // ** LooseOctree::nodeCount
+    template<typename TValue, typename THandle>
+    s32 LooseOctree<TValue, THandle>::nodeCount( void ) const
+    {
+        return static_cast<s32>( m_nodes.size() );
+    }
+
+    // ** LooseOctree::has
+    template<typename TValue, typename THandle>
+    bool LooseOctree<TValue, THandle>::has( const Handle& handle ) const
+    {
+        return m_objects.has( handle );
+    }
+
+    // ** LooseOctree::get
+    template<typename TValue, typename THandle>
+    const TValue& LooseOctree<TValue, THandle>::get( const Handle& handle ) const
+    {
+        return m_objects.get( handle ).value;
+    }
+
+    // ** LooseOctree::get
+    template<typename TValue, typename THandle>
+    TValue& LooseOctree<TValue, THandle>::get( const Handle& handle )
+    {
+        return m_objects.get( handle ).value;
+    }
+
+    // ** LooseOctree::bounds
+    template<typename TValue, typename THandle>
+    const Bounds& LooseOctree<TValue, THandle>::bounds( const Handle& handle ) const
+    {
+        const Object& object = m_objects.get( handle );
+        return m_nodes[object.node].items[object.slot].bounds;
+    }
+
+    // ** LooseOctree::overlaps
+    template<typename TValue, typename THandle>
+    bool LooseOctree<TValue, THandle>::overlaps( const Vec3& nodeCenter, f32 nodeHalfSize, const Vec3& center, const Vec3& halfSize )
+    {
+        f32 size = nodeHalfSize * 2.0f;
+
+        return fabsf( nodeCenter.x - center.x ) <= size + halfSize.x
+            && fabsf( nodeCenter.y - center.y ) <= size + halfSize.y
+            && fabsf( nodeCenter.z - center.z ) <= size + halfSize.z;
+    }
+
+    // ** LooseOctree::findNode
+    template<typename TValue, typename THandle>
+    s32 LooseOctree<TValue, THandle>::findNode( const Bounds& bounds )
+    {
+        Vec3 center   = bounds.center();
+        f32  halfSize = max3( bounds.width(), bounds.height(), bounds.depth() ) * 0.5f;
+        s32  index    = 0;
+
+        // Objects with a center outside of a root node are kept in a root
+        const Node& root = m_nodes[0];
+
+        if( fabsf( center.x - root.center.x ) > root.halfSize || fabsf( center.y - root.center.y ) > root.halfSize || fabsf( center.z - root.center.z ) > root.halfSize ) {
+            return 0;
+        }
+
+        // Descend while an object fits into a child node
+        for( s32 depth = 0; depth < m_maxDepth; depth++ ) {
+            const Node& node = m_nodes[index];
+            f32 childHalfSize = node.halfSize * 0.5f;
+
+            if( halfSize > childHalfSize ) {
+                break;
+            }
+
+            s32 octant = (center.x >= node.center.x ? 1 : 0) | (center.y >= node.center.y ? 2 : 0) | (center.z >= node.center.z ? 4 : 0);
+
+            if( node.children[octant] < 0 ) {
+                Node child;
+                child.center   = node.center + Vec3( octant & 1 ? childHalfSize : -childHalfSize, octant & 2 ? childHalfSize : -childHalfSize, octant & 4 ? childHalfSize : -childHalfSize );
+                child.halfSize = childHalfSize;
+                child.parent   = index;
+                child.octant   = octant;
+                child.count    = 0;
+                child.occupied = 0;
+
+                for( s32 i = 0; i < 8; i++ ) {
+                    child.children[i] = -1;
+                }
+
+                m_nodes[index].children[octant] = static_cast<s32>( m_nodes.size() );
+                m_nodes.push_back( child );
+            }
+
+            index = m_nodes[index].children[octant];
+        }
+
+        return index;
+    }
+
+    // ** LooseOctree::link
+    template<typename TValue, typename THandle>
+    void LooseOctree<TValue, THandle>::link( const Handle& handle, Object& object, s32 node, const Bounds& bounds )
+    {
+        Item item;
+        item.bounds = bounds;
+        item.handle = handle;
+
+        object.node = node;
+        object.slot = static_cast<s32>( m_nodes[node].items.size() );
+        m_nodes[node].items.push_back( item );
+
+        // Update subtree counters and mark non-empty subtrees in parent nodes
+        for( s32 i = node; i >= 0; i = m_nodes[i].parent ) {
+            if( m_nodes[i].count++ == 0 && m_nodes[i].parent >= 0 ) {
+                m_nodes[m_nodes[i].parent].occupied |= BIT( m_nodes[i].octant );
+            }
+        }
+    }
+
+    // ** LooseOctree::unlink
+    template<typename TValue, typename THandle>
+    void LooseOctree<TValue, THandle>::unlink( const Object& object )
+    {
+        Array<Item>& items = m_nodes[object.node].items;
+
+        // Move the last item to a removed slot
+        if( object.slot != static_cast<s32>( items.size() ) - 1 ) {
+            items[object.slot] = items.back();
+            m_objects.get( items[object.slot].handle ).slot = object.slot;
+        }
+
+        items.pop_back();
+
+        for( s32 i = object.node; i >= 0; i = m_nodes[i].parent ) {
+            if( --m_nodes[i].count == 0 && m_nodes[i].parent >= 0 ) {
+                m_nodes[m_nodes[i].parent].occupied &= ~BIT( m_nodes[i].octant );
+            }
+        }
+    }
+
+    // ** LooseOctree::insert
+    template<typename TValue, typename THandle>
+    THandle LooseOctree<TValue, THandle>::insert( const Bounds& bounds, const Value& value )
+    {
+        s32    node   = findNode( bounds );
+        Handle handle = m_objects.reserve();
+        Object& object = m_objects.get( handle );
+
+        object.value = value;
+        link( handle, object, node, bounds );
+
+        return handle;
+    }
+
+    // ** LooseOctree::move
+    template<typename TValue, typename THandle>
+    void LooseOctree<TValue, THandle>::move( const Handle& handle, const Bounds& bounds )
+    {
+        s32     node   = findNode( bounds );
+        Object& object = m_objects.get( handle );
+
+        // An object stays in the same node, so only its bounds should be updated
+        if( node == object.node ) {
+            m_nodes[node].items[object.slot].bounds = bounds;
+            return;
+        }
+
+        unlink( object );
+        link( handle, object, node, bounds );
+    }
+
+    // ** LooseOctree::remove
+    template<typename TValue, typename THandle>
+    bool LooseOctree<TValue, THandle>::remove( const Handle& handle )
+    {
+        if( !m_objects.has( handle ) ) {
+            return false;
+        }
+
+        unlink( m_objects.get( handle ) );
+        return m_objects.remove( handle );
+    }
+
+    // ** LooseOctree::query
+    template<typename TValue, typename THandle>
+    template<typename TCallback>
+    void LooseOctree<TValue, THandle>::query( const Bounds& bounds, const TCallback& callback ) const
+    {
+        Vec3 center   = bounds.center();
+        Vec3 halfSize = (bounds.max() - bounds.min()) * 0.5f;
+        s32  stack[8 * 32 + 1];
+        s32  depth    = 0;
+
+        // A root node is always visited, because it also contains objects outside of its bounds
+        stack[depth++] = 0;
+
+        while( depth ) {
+            const Node& node = m_nodes[stack[--depth]];
+
+            for( s32 i = 0, n = static_cast<s32>( node.items.size() ); i < n; i++ ) {
+                if( node.items[i].bounds.overlaps( bounds ) ) {
+                    callback( node.items[i].handle );
+                }
+            }
+
+            // Only push non-empty children that overlap a query, child bounds are derived from a parent to avoid touching child nodes
+            f32 childHalfSize = node.halfSize * 0.5f;
+
+            for( u32 mask = node.occupied; mask; mask &= mask - 1 ) {
+                s32  octant = countTrailingZeros( mask );
+                Vec3 childCenter( node.center.x + (octant & 1 ? childHalfSize : -childHalfSize)
+                                , node.center.y + (octant & 2 ? childHalfSize : -childHalfSize)
+                                , node.center.z + (octant & 4 ? childHalfSize : -childHalfSize) );
+
+                if( overlaps( childCenter, childHalfSize, center, halfSize ) ) {
+                    stack[depth++] = node.children[octant];
+                }
+            }
+        }
+    }
+
+    // ** LooseOctree::pairs
+    template<typename TValue, typename THandle>
+    template<typename TCallback>
+    void LooseOctree<TValue, THandle>::pairs( const TCallback& callback ) const
+    {
+        // Loose bounds of sibling nodes overlap, so each object is queried against a whole tree
+        for( s32 i = 0, n = static_cast<s32>( m_nodes.size() ); i < n; i++ ) {
+            const Array<Item>& items = m_nodes[i].items;
+
+            for( s32 j = 0, m = static_cast<s32>( items.size() ); j < m; j++ ) {
+                PairCallback<TCallback> visitor( items[j].handle, callback );
+                query( items[j].bounds, visitor );
+            }
+        }
+    }
+
+NIMBLE_END
+
+#endif  /*  !__Nimble_LooseOctree_H__  */
@@ -0,0 +1,356 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_SweepAndPrune_H__
+#define __Nimble_SweepAndPrune_H__
+
+#include "../Globals.h"
+
+NIMBLE_BEGIN
+
+    //! An incremental sort-based broadphase that tracks overlapping pairs of bounding boxes.
+    /*!
+        Object bounds are projected to one or three axes as sorted lists of interval endpoints.
+        On each update endpoint lists are resorted with an insertion sort, which takes a linear time
+        for coherent motion. With three axes new and separated pairs are detected from endpoint swaps
+        alone, while a single axis list is swept to find all pairs and compared against a previous set.
+        A single axis is cheaper to maintain when objects are spread along one direction.
+        Objects are identified by their indices in a bounds array, when the number of objects changes
+        endpoint lists are rebuilt from scratch.
+    */
+    class SweepAndPrune {
+    public:
+
+        //! An overlapping pair of object indices, a first index is always less than a second one.
+        struct Pair {
+            s32                 first;      //!< A first object index.
+            s32                 second;     //!< A second object index.
+        };
+
+        //! A container type to store pairs.
+        typedef Array<Pair>     Pairs;
+
+                                //! Constructs a SweepAndPrune instance that sorts endpoints along a specified number of axes.
+        explicit                SweepAndPrune( s32 axisCount = 3 );
+
+        //! Updates object bounds and outputs pairs that started and stopped overlapping since the last update.
+        void                    update( const Bounds* bounds, s32 count, Pairs& added, Pairs& removed );
+
+        //! Returns all overlapping pairs.
+        const Pairs&            pairs( void ) const;
+
+        //! Returns the total number of objects.
+        s32                     objectCount( void ) const;
+
+        //! Returns the number of sorted axes.
+        s32                     axisCount( void ) const;
+
+    private:
+
+        //! An interval endpoint projected to an axis.
+        struct Endpoint {
+            f32                 value;      //!< An endpoint coordinate.
+            u32                 data;       //!< An object index shifted left by one bit, the lowest bit is set for upper endpoints.
+
+            //! Compares two endpoints, lower endpoints go first for equal coordinates so touching boxes are considered overlapping.
+            bool                operator < ( const Endpoint& other ) const { return value < other.value || (value == other.value && (data & 1) < (other.data & 1)); }
+        };
+
+        //! Returns a hash key of a pair.
+        static u64              key( s32 a, s32 b );
+
+        //! Rebuilds all endpoint lists and a pair set.
+        void                    rebuild( Pairs& added, Pairs& removed );
+
+        //! Sorts an axis with an insertion sort, swaps of lower and upper endpoints are tracked when requested.
+        void                    sort( s32 axis, bool trackSwaps, Pairs& added, Pairs& removed );
+
+        //! Sweeps the first axis and collects all overlapping pairs.
+        void                    sweep( Pairs& overlapping );
+
+        //! Registers a new pair and appends it to an output array.
+        void                    addPair( s32 a, s32 b, Pairs& added );
+
+        //! Unregisters an existing pair and appends it to an output array.
+        void                    removePair( s32 a, s32 b, Pairs& removed );
+
+        //! Replaces a pair set with a new one and outputs a difference.
+        void                    replacePairs( const Pairs& overlapping, Pairs& added, Pairs& removed );
+
+    private:
+
+        s32                     m_axisCount;    //!< The number of sorted axes.
+        Array<Endpoint>         m_axes[3];      //!< Sorted endpoint lists.
+        Array<Bounds>           m_bounds;       //!< Object bounds from the last update.
+        Pairs                   m_pairs;        //!< Overlapping pairs.
+        HashMap<u64, s32>       m_pairIndices;  //!< Maps from a pair key to an index inside the pair array.
+        Array<u32>              m_seen;         //!< The last update stamp when each pair was found by a sweep.
+        Array<s32>              m_active;       //!< Objects with an open interval during a sweep.
+        Array<s32>              m_activeIndices;//!< Object positions inside an active list.
+        Pairs                   m_overlapping;  //!< Pairs found by the last sweep.
+        u32                     m_stamp;        //!< The current update stamp.
+    };
+
+    // ** SweepAndPrune::SweepAndPrune
+    inline SweepAndPrune::SweepAndPrune( s32 axisCount )
+        : m_axisCount( axisCount )
+        , m_stamp( 0 )
+    {
+        NIMBLE_ABORT_IF( axisCount != 1 && axisCount != 3, "sweep and prune supports either one or three axes" );
+    }
+
+    // ** SweepAndPrune::pairs
+    inline const SweepAndPrune::Pairs& SweepAndPrune::pairs( void ) const
+    {
+        return m_pairs;
+    }
+
+    // ** SweepAndPrune::objectCount
+    inline s32 SweepAndPrune::objectCount( void ) const
+    {
+        return static_cast<s32>( m_bounds.size() );
+    }
+
+    // ** SweepAndPrune::axisCount
+    inline s32 SweepAndPrune::axisCount( void ) const
+    {
+        return m_axisCount;
+    }
+
+    // ** SweepAndPrune::key
+    inline u64 SweepAndPrune::key( s32 a, s32 b )
+    {
+        return (static_cast<u64>( a ) << 32) | static_cast<u32>( b );
+    }
+
+    // ** SweepAndPrune::update
+    inline void SweepAndPrune::update( const Bounds* bounds, s32 count, Pairs& added, Pairs& removed )
+    {
+        added.clear();
+        removed.clear();
+
+        bool resized = count != objectCount();
+        m_bounds.assign( bounds, bounds + count );
+
+        if( resized ) {
+            rebuild( added, removed );
+            return;
+        }
+
+        // Refresh endpoint coordinates, lists stay nearly sorted for coherent motion
+        for( s32 axis = 0; axis < m_axisCount; axis++ ) {
+            Array<Endpoint>& endpoints = m_axes[axis];
+
+            for( s32 i = 0, n = static_cast<s32>( endpoints.size() ); i < n; i++ ) {
+                const Bounds& box = m_bounds[endpoints[i].data >> 1];
+                endpoints[i].value = (endpoints[i].data & 1) ? box.max()[axis] : box.min()[axis];
+            }
+
+            sort( axis, m_axisCount == 3, added, removed );
+        }
+
+        if( m_axisCount == 1 ) {
+            sweep( m_overlapping );
+            replacePairs( m_overlapping, added, removed );
+        }
+    }
+
+    // ** SweepAndPrune::rebuild
+    inline void SweepAndPrune::rebuild( Pairs& added, Pairs& removed )
+    {
+        s32 count = objectCount();
+
+        for( s32 axis = 0; axis < m_axisCount; axis++ ) {
+            Array<Endpoint>& endpoints = m_axes[axis];
+            endpoints.resize( count * 2 );
+
+            for( s32 i = 0; i < count; i++ ) {
+                endpoints[i * 2 + 0].value = m_bounds[i].min()[axis];
+                endpoints[i * 2 + 0].data  = i << 1;
+                endpoints[i * 2 + 1].value = m_bounds[i].max()[axis];
+                endpoints[i * 2 + 1].data  = (i << 1) | 1;
+            }
+
+            std::sort( endpoints.begin(), endpoints.end() );
+        }
+
+        // Pairs of removed objects can't be compared against new bounds, so they are dropped first
+        for( s32 i = static_cast<s32>( m_pairs.size() ) - 1; i >= 0; i-- ) {
+            Pair pair = m_pairs[i];
+
+            if( pair.second >= count ) {
+                removePair( pair.first, pair.second, removed );
+            }
+        }
+
+        sweep( m_overlapping );
+        replacePairs( m_overlapping, added, removed );
+    }
+
+    // ** SweepAndPrune::sort
+    inline void SweepAndPrune::sort( s32 axis, bool trackSwaps, Pairs& added, Pairs& removed )
+    {
+        Array<Endpoint>& endpoints = m_axes[axis];
+
+        for( s32 i = 1, n = static_cast<s32>( endpoints.size() ); i < n; i++ ) {
+            Endpoint endpoint = endpoints[i];
+            s32      j        = i - 1;
+
+            while( j >= 0 && endpoint < endpoints[j] ) {
+                const Endpoint& other = endpoints[j];
+
+                // Only swaps of lower and upper endpoints change an overlap along this axis
+                if( trackSwaps && ((endpoint.data ^ other.data) & 1) ) {
+                    s32 a = endpoint.data >> 1;
+                    s32 b = other.data >> 1;
+
+                    if( (endpoint.data & 1) == 0 ) {
+                        // A lower endpoint moved below an upper one, so intervals started overlapping
+                        if( a != b && m_bounds[a].overlaps( m_bounds[b] ) ) {
+                            addPair( a, b, added );
+                        }
+                    } else {
+                        // An upper endpoint moved below a lower one, so intervals are separated
+                        removePair( a, b, removed );
+                    }
+                }
+
+                endpoints[j + 1] = other;
+                j--;
+            }
+
+            endpoints[j + 1] = endpoint;
+        }
+    }
+
+    // ** SweepAndPrune::sweep
+    inline void SweepAndPrune::sweep( Pairs& overlapping )
+    {
+        const Array<Endpoint>& endpoints = m_axes[0];
+
+        overlapping.clear();
+        m_active.clear();
+        m_activeIndices.resize( objectCount() );
+
+        for( s32 i = 0, n = static_cast<s32>( endpoints.size() ); i < n; i++ ) {
+            s32 object = endpoints[i].data >> 1;
+
+            // An interval is closed, remove an object from an active list
+            if( endpoints[i].data & 1 ) {
+                s32 index = m_activeIndices[object];
+                m_active[index] = m_active.back();
+                m_activeIndices[m_active[index]] = index;
+                m_active.pop_back();
+                continue;
+            }
+
+            // An interval is opened, test an object against all active ones
+            const Bounds& bounds = m_bounds[object];
+
+            for( s32 j = 0, m = static_cast<s32>( m_active.size() ); j < m; j++ ) {
+                s32 other = m_active[j];
+
+                if( bounds.overlaps( m_bounds[other] ) ) {
+                    Pair pair;
+                    pair.first  = min2( object, other );
+                    pair.second = max2( object, other );
+                    overlapping.push_back( pair );
+                }
+            }
+
+            m_activeIndices[object] = static_cast<s32>( m_active.size() );
+            m_active.push_back( object );
+        }
+    }
+
+    // ** SweepAndPrune::addPair
+    inline void SweepAndPrune::addPair( s32 a, s32 b, Pairs& added )
+    {
+        Pair pair;
+        pair.first  = min2( a, b );
+        pair.second = max2( a, b );
+
+        if( !m_pairIndices.insert( std::make_pair( key( pair.first, pair.second ), static_cast<s32>( m_pairs.size() ) ) ).second ) {
+            return;
+        }
+
+        m_pairs.push_back( pair );
+        m_seen.push_back( m_stamp );
+        added.push_back( pair );
+    }
+
+    // ** SweepAndPrune::removePair
+    inline void SweepAndPrune::removePair( s32 a, s32 b, Pairs& removed )
+    {
+        HashMap<u64, s32>::iterator i = m_pairIndices.find( key( min2( a, b ), max2( a, b ) ) );
+
+        if( i == m_pairIndices.end() ) {
+            return;
+        }
+
+        s32 index = i->second;
+        removed.push_back( m_pairs[index] );
+        m_pairIndices.erase( i );
+
+        // Move the last pair to a removed slot
+        if( index != static_cast<s32>( m_pairs.size() ) - 1 ) {
+            m_pairs[index] = m_pairs.back();
+            m_seen[index]  = m_seen.back();
+            m_pairIndices[key( m_pairs[index].first, m_pairs[index].second )] = index;
+        }
+
+        m_pairs.pop_back();
+        m_seen.pop_back();
+    }
+
+    // ** SweepAndPrune::replacePairs
+    inline void SweepAndPrune::replacePairs( const Pairs& overlapping, Pairs& added, Pairs& removed )
+    {
+        u32 stamp = ++m_stamp;
+
+        // Mark pairs that still overlap and register new ones
+        for( s32 i = 0, n = static_cast<s32>( overlapping.size() ); i < n; i++ ) {
+            const Pair& pair = overlapping[i];
+            HashMap<u64, s32>::const_iterator j = m_pairIndices.find( key( pair.first, pair.second ) );
+
+            if( j != m_pairIndices.end() ) {
+                m_seen[j->second] = stamp;
+            } else {
+                addPair( pair.first, pair.second, added );
+            }
+        }
+
+        // Remove pairs that were not found, new pairs were stamped on insertion
+        for( s32 i = static_cast<s32>( m_pairs.size() ) - 1; i >= 0; i-- ) {
+            if( m_seen[i] != stamp ) {
+                removePair( m_pairs[i].first, m_pairs[i].second, removed );
+            }
+        }
+    }
+
+NIMBLE_END
+
+#endif  /*  !__Nimble_SweepAndPrune_H__  */
@@ -0,0 +1,265 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_TriangleBvh_H__
+#define __Nimble_TriangleBvh_H__
+
+#include "../Globals.h"
+
+NIMBLE_BEGIN
+
+    //! A bounding volume hierarchy over triangles of a TriMesh used to cast rays against a mesh.
+    /*!
+        A tree is built over triangle bounding boxes with a binned surface area heuristic, then triangles
+        are stored in a leaf order as a vertex and two edges, so triangles of each leaf are contiguous in
+        memory and are tested without touching mesh buffers. Ray batches can be cast from several threads,
+        because queries never modify a tree.
+    */
+    class TriangleBvh {
+    public:
+
+        //! The number of rays cast by a single job of a parallel batch.
+        enum { RayGrainSize = 64 };
+
+        //! A ray cast result.
+        struct Hit {
+            f32                 time;       //!< A hit time measured in ray direction lengths.
+            s32                 face;       //!< A hit mesh face index, or -1 if nothing was hit.
+            f32                 u;          //!< A barycentric coordinate of a hit point along a second face vertex.
+            f32                 v;          //!< A barycentric coordinate of a hit point along a third face vertex.
+        };
+
+                                //! Constructs an empty TriangleBvh instance.
+                                TriangleBvh( void );
+
+        //! Builds a tree over mesh faces.
+        template<typename TMesh>
+        void                    build( const TMesh& mesh, s32 maxLeafSize = 4 );
+
+        //! Returns the total number of triangles.
+        s32                     triangleCount( void ) const;
+
+        //! Returns a bounding box of a mesh.
+        Bounds                  bounds( void ) const;
+
+        //! Finds the closest triangle hit by a ray, returns false if nothing was hit.
+        bool                    raycast( const Ray& ray, Hit& hit, f32 maxTime = FLT_MAX ) const;
+
+        //! Returns true if any triangle is hit by a ray closer than a max time.
+        bool                    occluded( const Ray& ray, f32 maxTime = FLT_MAX ) const;
+
+        //! Casts a batch of rays and outputs the closest hit of each one.
+        void                    raycast( const Ray* rays, s32 count, Hit* hits, f32 maxTime = FLT_MAX ) const;
+
+        //! Tests a batch of rays for occlusion, a result is set to one for occluded rays and to zero otherwise.
+        void                    occluded( const Ray* rays, s32 count, u8* results, f32 maxTime = FLT_MAX ) const;
+
+    #if NIMBLE_CPP11_ENABLED
+        //! Casts a batch of rays in parallel and outputs the closest hit of each one.
+        void                    raycast( JobSystem& jobs, const Ray* rays, s32 count, Hit* hits, f32 maxTime = FLT_MAX ) const;
+
+        //! Tests a batch of rays for occlusion in parallel.
+        void                    occluded( JobSystem& jobs, const Ray* rays, s32 count, u8* results, f32 maxTime = FLT_MAX ) const;
+    #endif  /*  NIMBLE_CPP11_ENABLED    */
+
+    private:
+
+        //! A triangle stored as a vertex and two edges.
+        struct Triangle {
+            Vec3                v0;         //!< A first triangle vertex.
+            Vec3                e1;         //!< An edge from a first to a second vertex.
+            Vec3                e2;         //!< An edge from a first to a third vertex.
+        };
+
+        //! Intersects a ray with a triangle using a Moller-Trumbore test.
+        static bool             intersect( const Triangle& triangle, const Ray& ray, f32 maxTime, f32& time, f32& u, f32& v );
+
+        //! Records the closest triangle hit for a Bvh traversal.
+        struct ClosestHit {
+                                //! Constructs a ClosestHit instance.
+                                ClosestHit( const TriangleBvh& bvh, const Ray& ray, Hit& hit )
+                                    : bvh( bvh ), ray( ray ), hit( hit ) {}
+
+            //! Returns true and updates a hit time if a triangle is hit closer than a current hit.
+            bool                operator () ( s32 index, f32& time ) const;
+
+            const TriangleBvh&  bvh;        //!< A parent triangle tree.
+            const Ray&          ray;        //!< A ray being cast.
+            Hit&                hit;        //!< The closest hit.
+        };
+
+        //! Tests whether a triangle is hit by a ray during an any hit Bvh traversal.
+        struct AnyHit {
+                                //! Constructs an AnyHit instance.
+                                AnyHit( const TriangleBvh& bvh, const Ray& ray )
+                                    : bvh( bvh ), ray( ray ) {}
+
+            //! Returns true if a triangle is hit closer than a max time.
+            bool                operator () ( s32 index, f32& time ) const;
+
+            const TriangleBvh&  bvh;        //!< A parent triangle tree.
+            const Ray&          ray;        //!< A ray being cast.
+        };
+
+    private:
+
+        Bvh                     m_bvh;          //!< A tree over triangle bounding boxes.
+        Array<Triangle>         m_triangles;    //!< Triangles in a leaf order.
+        Array<s32>              m_faces;        //!< A mesh face index of each triangle.
+    };
+
+    // ** TriangleBvh::TriangleBvh
+    inline TriangleBvh::TriangleBvh( void )
+    {
+    }
+
+    // ** TriangleBvh::triangleCount
+    inline s32 TriangleBvh::triangleCount( void ) const
+    {
+        return static_cast<s32>( m_triangles.size() );
+    }
+
+    // ** TriangleBvh::bounds
+    inline Bounds TriangleBvh::bounds( void ) const
+    {
+        return m_bvh.bounds();
+    }
+
+    // ** TriangleBvh::build
+    template<typename TMesh>
+    void TriangleBvh::build( const TMesh& mesh, s32 maxLeafSize )
+    {
+        const typename TMesh::Vertices& vertices = mesh.vertices();
+        const typename TMesh::Indices&  indices  = mesh.indices();
+        s32                             count    = mesh.faceCount();
+
+        // Build a tree over face bounding boxes
+        Array<Bounds> bounds;
+        bounds.resize( count );
+
+        for( s32 i = 0; i < count; i++ ) {
+            bounds[i] << vertices[indices[i * 3 + 0]].position << vertices[indices[i * 3 + 1]].position << vertices[indices[i * 3 + 2]].position;
+        }
+
+        m_bvh.build( count ? &bounds[0] : NULL, count, maxLeafSize );
+
+        // Store triangles in a leaf order
+        m_bvh.reorder( m_faces );
+        m_triangles.resize( count );
+
+        for( s32 i = 0; i < count; i++ ) {
+            s32         face = m_faces[i];
+            const Vec3& v0   = vertices[indices[face * 3 + 0]].position;
+
+            m_triangles[i].v0 = v0;
+            m_triangles[i].e1 = vertices[indices[face * 3 + 1]].position - v0;
+            m_triangles[i].e2 = vertices[indices[face * 3 + 2]].position - v0;
+        }
+    }
+
+    // ** TriangleBvh::intersect
+    inline bool TriangleBvh::intersect( const Triangle& triangle, const Ray& ray, f32 maxTime, f32& time, f32& u, f32& v )
+    {
+        return ray.intersectsTriangle( triangle.v0, triangle.e1, triangle.e2, maxTime, &time, &u, &v );
+    }
+
+    // ** TriangleBvh::ClosestHit::operator ()
+    inline bool TriangleBvh::ClosestHit::operator () ( s32 index, f32& time ) const
+    {
+        if( !intersect( bvh.m_triangles[index], ray, time, time, hit.u, hit.v ) ) {
+            return false;
+        }
+
+        hit.time = time;
+        hit.face = bvh.m_faces[index];
+
+        return true;
+    }
+
+    // ** TriangleBvh::AnyHit::operator ()
+    inline bool TriangleBvh::AnyHit::operator () ( s32 index, f32& time ) const
+    {
+        f32 t, u, v;
+        return intersect( bvh.m_triangles[index], ray, time, t, u, v );
+    }
+
+    // ** TriangleBvh::raycast
+    inline bool TriangleBvh::raycast( const Ray& ray, Hit& hit, f32 maxTime ) const
+    {
+        f32 time;
+
+        hit.time = maxTime;
+        hit.face = -1;
+        hit.u    = 0.0f;
+        hit.v    = 0.0f;
+
+        return m_bvh.raycast( ray, ClosestHit( *this, ray, hit ), time, maxTime ) >= 0;
+    }
+
+    // ** TriangleBvh::occluded
+    inline bool TriangleBvh::occluded( const Ray& ray, f32 maxTime ) const
+    {
+        return m_bvh.raycastAny( ray, AnyHit( *this, ray ), maxTime );
+    }
+
+    // ** TriangleBvh::raycast
+    inline void TriangleBvh::raycast( const Ray* rays, s32 count, Hit* hits, f32 maxTime ) const
+    {
+        for( s32 i = 0; i < count; i++ ) {
+            raycast( rays[i], hits[i], maxTime );
+        }
+    }
+
+    // ** TriangleBvh::occluded
+    inline void TriangleBvh::occluded( const Ray* rays, s32 count, u8* results, f32 maxTime ) const
+    {
+        for( s32 i = 0; i < count; i++ ) {
+            results[i] = occluded( rays[i], maxTime ) ? 1 : 0;
+        }
+    }
+
+#if NIMBLE_CPP11_ENABLED
+    // ** TriangleBvh::raycast
+    inline void TriangleBvh::raycast( JobSystem& jobs, const Ray* rays, s32 count, Hit* hits, f32 maxTime ) const
+    {
+        // Each ray is an expensive traversal, so chunks are kept small for a better load balance
+        parallelFor( jobs, count, [=]( s32 begin, s32 end ) {
+            raycast( rays + begin, end - begin, hits + begin, maxTime );
+        }, RayGrainSize );
+    }
+
+    // ** TriangleBvh::occluded
+    inline void TriangleBvh::occluded( JobSystem& jobs, const Ray* rays, s32 count, u8* results, f32 maxTime ) const
+    {
+        parallelFor( jobs, count, [=]( s32 begin, s32 end ) {
+            occluded( rays + begin, end - begin, results + begin, maxTime );
+        }, RayGrainSize );
+    }
+#endif  /*  NIMBLE_CPP11_ENABLED    */
+
+NIMBLE_END
+
+#endif  /*  !__Nimble_TriangleBvh_H__  */
@@ -0,0 +1,361 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_Containers_BitmapIndexManager_H__
+#define __Nimble_Containers_BitmapIndexManager_H__
+
+#include "../Globals.h"
+
+NIMBLE_BEGIN
+
+    //! Manages unique integer identifiers with a two-level bitmap, allocating the lowest free index first.
+    /*!
+        Each index is a single bit in an array of 64-bit words, set while an index is free. A summary
+        level keeps a bit per word that has any free index, so the lowest free index is found with two
+        count trailing zeros instructions after skipping fully allocated regions of 4096 indices. Unlike
+        an IndexManager, it can acquire and release contiguous ranges of indices and iterate allocated
+        indices in an ascending order.
+    */
+    template<typename TValue>
+    class BitmapIndexManager {
+    public:
+
+                        //! Constructs a BitmapIndexManager instance.
+                        BitmapIndexManager( void );
+
+        //! Grows an index manager capacity, all new indices are free.
+        void            resize( s32 capacity );
+
+        //! Returns a lowest free index.
+        TValue          acquire( void );
+
+        //! Acquires a contiguous range of free indices and returns the first one.
+        TValue          acquire( s32 count );
+
+        //! Releases a used index.
+        void            release( TValue index );
+
+        //! Releases a contiguous range of used indices.
+        void            release( TValue first, s32 count );
+
+        //! Returns true if an index is allocated.
+        bool            isAllocated( TValue index ) const;
+
+        //! Returns a first allocated index that is greater or equal to a specified one, or -1 if there are no such indices.
+        s32             nextAllocated( s32 index ) const;
+
+        //! Invokes a callback for each allocated index in an ascending order.
+        template<typename TCallback>
+        void            forEach( const TCallback& callback ) const;
+
+        //! Returns a maximum capacity.
+        s32             maximumCapacity( void ) const;
+
+        //! Returns a total number of allocated indices.
+        s32             allocatedCount( void ) const;
+
+        //! Returns true if there are any free indices left.
+        bool            hasFreeIndices( void ) const;
+
+    private:
+
+        //! Marks a single index as free or allocated.
+        void            setFree( s32 index, bool free );
+
+        //! Returns a first index of a free range of a specified length, or -1 if there are no such ranges.
+        s32             findFreeRange( s32 count ) const;
+
+        //! Returns a mask of valid bits inside a word.
+        u64             validBits( s32 word ) const;
+
+    private:
+
+        Array<u64>      m_free;             //!< Free index bits.
+        Array<u64>      m_summary;          //!< A bit per free index word that is set if a word has any free indices.
+        s32             m_maximumCapacity;  //!< A maximum number of indices that can be allocated.
+        s32             m_allocatedCount;   //!< A total number of allocated indices.
+    };
+
+    // ** BitmapIndexManager::BitmapIndexManager
+    template<typename TValue>
+    BitmapIndexManager<TValue>::BitmapIndexManager( void )
+        : m_maximumCapacity( 0 )
+        , m_allocatedCount( 0 )
+    {
+    }
+
+    // ** BitmapIndexManager::resize
+    template<typename TValue>
+    void BitmapIndexManager<TValue>::resize( s32 capacity )
+    {
+        NIMBLE_ABORT_IF( capacity < m_maximumCapacity, "an index manager can not be shrinked" );
+
+        s32 oldCapacity = m_maximumCapacity;
+
+        m_free.resize( (capacity + 63) / 64, 0 );
+        m_summary.resize( (m_free.size() + 63) / 64, 0 );
+        m_maximumCapacity = capacity;
+
+        for( s32 i = oldCapacity; i < capacity; i++ ) {
+            setFree( i, true );
+        }
+    }
+
+    // ** BitmapIndexManager::acquire
+    template<typename TValue>
+    TValue BitmapIndexManager<TValue>::acquire( void )
+    {
+        // Grow twice if no more indices left
+        if( !hasFreeIndices() ) {
+            resize( max2( 64, maximumCapacity() * 2 ) );
+        }
+
+        for( s32 i = 0, n = static_cast<s32>( m_summary.size() ); i < n; i++ ) {
+            if( m_summary[i] == 0 ) {
+                continue;
+            }
+
+            s32 word  = i * 64 + countTrailingZeros( m_summary[i] );
+            s32 index = word * 64 + countTrailingZeros( m_free[word] );
+
+            setFree( index, false );
+            m_allocatedCount++;
+
+            return static_cast<TValue>( index );
+        }
+
+        NIMBLE_ABORT_IF( true, "index manager summary is inconsistent" );
+        return 0;
+    }
+
+    // ** BitmapIndexManager::acquire
+    template<typename TValue>
+    TValue BitmapIndexManager<TValue>::acquire( s32 count )
+    {
+        NIMBLE_ABORT_IF( count <= 0, "invalid number of indices to acquire" );
+
+        s32 first = findFreeRange( count );
+
+        // Grow enough to append a range to the end
+        if( first < 0 ) {
+            resize( max2( maximumCapacity() * 2, maximumCapacity() + count ) );
+            first = findFreeRange( count );
+        }
+
+        for( s32 i = first; i < first + count; i++ ) {
+            setFree( i, false );
+        }
+
+        m_allocatedCount += count;
+
+        return static_cast<TValue>( first );
+    }
+
+    // ** BitmapIndexManager::release
+    template<typename TValue>
+    void BitmapIndexManager<TValue>::release( TValue index )
+    {
+        NIMBLE_ABORT_IF( !isAllocated( index ), "index is not allocated" );
+        setFree( static_cast<s32>( index ), true );
+        m_allocatedCount--;
+    }
+
+    // ** BitmapIndexManager::release
+    template<typename TValue>
+    void BitmapIndexManager<TValue>::release( TValue first, s32 count )
+    {
+        for( s32 i = 0; i < count; i++ ) {
+            release( static_cast<TValue>( first + i ) );
+        }
+    }
+
+    // ** BitmapIndexManager::isAllocated
+    template<typename TValue>
+    bool BitmapIndexManager<TValue>::isAllocated( TValue index ) const
+    {
+        s32 i = static_cast<s32>( index );
+
+        if( i < 0 || i >= m_maximumCapacity ) {
+            return false;
+        }
+
+        return (m_free[i / 64] & (static_cast<u64>( 1 ) << (i % 64))) == 0;
+    }
+
+    // ** BitmapIndexManager::nextAllocated
+    template<typename TValue>
+    s32 BitmapIndexManager<TValue>::nextAllocated( s32 index ) const
+    {
+        if( index < 0 ) {
+            index = 0;
+        }
+
+        if( index >= m_maximumCapacity ) {
+            return -1;
+        }
+
+        // Mask out allocated bits below the start index
+        s32 word = index / 64;
+        u64 bits = ~m_free[word] & validBits( word ) & (~static_cast<u64>( 0 ) << (index % 64));
+
+        for( s32 n = static_cast<s32>( m_free.size() ); ; ) {
+            if( bits ) {
+                return word * 64 + countTrailingZeros( bits );
+            }
+
+            if( ++word >= n ) {
+                return -1;
+            }
+
+            bits = ~m_free[word] & validBits( word );
+        }
+    }
+
+    // ** BitmapIndexManager::forEach
+    template<typename TValue>
+    template<typename TCallback>
+    void BitmapIndexManager<TValue>::forEach( const TCallback& callback ) const
+    {
+        for( s32 word = 0, n = static_cast<s32>( m_free.size() ); word < n; word++ ) {
+            u64 bits = ~m_free[word] & validBits( word );
+
+            // Visit set bits from the lowest one, clearing each visited bit
+            while( bits ) {
+                callback( static_cast<TValue>( word * 64 + countTrailingZeros( bits ) ) );
+                bits &= bits - 1;
+            }
+        }
+    }
+
+    // ** BitmapIndexManager::hasFreeIndices
+    template<typename TValue>
+    bool BitmapIndexManager<TValue>::hasFreeIndices( void ) const
+    {
+        return allocatedCount() < maximumCapacity();
+    }
+
+    // ** BitmapIndexManager::maximumCapacity
+    template<typename TValue>
+    s32 BitmapIndexManager<TValue>::maximumCapacity( void ) const
+    {
+        return m_maximumCapacity;
+    }
+
+    // ** BitmapIndexManager::allocatedCount
+    template<typename TValue>
+    s32 BitmapIndexManager<TValue>::allocatedCount( void ) const
+    {
+        return m_allocatedCount;
+    }
+
+    // ** BitmapIndexManager::setFree
+    template<typename TValue>
+    void BitmapIndexManager<TValue>::setFree( s32 index, bool free )
+    {
+        s32 word = index / 64;
+        u64 bit  = static_cast<u64>( 1 ) << (index % 64);
+
+        if( free ) {
+            m_free[word] |= bit;
+        } else {
+            m_free[word] &= ~bit;
+        }
+
+        // Keep the summary bit in sync with a word
+        u64 summaryBit = static_cast<u64>( 1 ) << (word % 64);
+
+        if( m_free[word] ) {
+            m_summary[word / 64] |= summaryBit;
+        } else {
+            m_summary[word / 64] &= ~summaryBit;
+        }
+    }
+
+    // ** BitmapIndexManager::findFreeRange
+    template<typename TValue>
+    s32 BitmapIndexManager<TValue>::findFreeRange( s32 count ) const
+    {
+        s32 start  = 0;     // The first index of a current free run
+        s32 length = 0;     // The length of a current free run
+
+        for( s32 word = 0, n = static_cast<s32>( m_free.size() ); word < n; word++ ) {
+            u64 bits = m_free[word];
+
+            // Skip fully allocated words
+            if( bits == 0 ) {
+                length = 0;
+                continue;
+            }
+
+            s32 bit = 0;
+
+            while( bit < 64 ) {
+                u64 rest = bits >> bit;
+
+                if( rest == 0 ) {
+                    length = 0;
+                    break;
+                }
+
+                // Skip allocated bits, which breaks a current run
+                s32 allocated = countTrailingZeros( rest );
+
+                if( allocated ) {
+                    length = 0;
+                    bit   += allocated;
+                    rest >>= allocated;
+                }
+
+                // Count free bits, that extend a current run
+                s32 free = ~rest ? countTrailingZeros( ~rest ) : 64 - bit;
+
+                if( length == 0 ) {
+                    start = word * 64 + bit;
+                }
+
+                length += free;
+                bit    += free;
+
+                if( length >= count ) {
+                    return start;
+                }
+            }
+        }
+
+        return -1;
+    }
+
+    // ** BitmapIndexManager::validBits
+    template<typename TValue>
+    u64 BitmapIndexManager<TValue>::validBits( s32 word ) const
+    {
+        s32 count = m_maximumCapacity - word * 64;
+        return count >= 64 ? ~static_cast<u64>( 0 ) : (static_cast<u64>( 1 ) << count) - 1;
+    }
+
+NIMBLE_END
+
+#endif    /*    !__Nimble_Containers_BitmapIndexManager_H__    */
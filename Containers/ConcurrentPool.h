@@ -0,0 +1,318 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_Containers_ConcurrentPool_H__
+#define __Nimble_Containers_ConcurrentPool_H__
+
+#include "Pool.h"
+
+#if NIMBLE_CPP11_ENABLED
+
+#include <atomic>
+#include <mutex>
+
+NIMBLE_BEGIN
+
+    //! A thread-safe container that issues opaque handles to its slots, slot addresses are stable for the pool lifetime.
+    /*!
+        Slots are stored in fixed-size pages that are never moved or freed until the pool is destroyed,
+        so a reference returned by get() stays valid while other threads add or remove values.
+        Free slots form a lock-free list whose head is tagged with a counter to avoid the ABA problem,
+        a new page is allocated under a mutex only when the free list is exhausted. Removing a value
+        increments a slot generation, invalidating all handles to it, but the value itself is kept
+        until the slot is reused.
+    */
+    template<typename TValue, typename THandle, s32 TPageSize = 1024, s32 TMaxPages = 4096>
+    class ConcurrentPool {
+    public:
+
+        typedef TValue          Value;  //!< Store the value type.
+        typedef THandle         Handle; //!< Store the handle type.
+
+                                //! Constructs ConcurrentPool instance.
+                                ConcurrentPool( void );
+                                ~ConcurrentPool( void );
+
+        //! Adds the value to a container and returns it's handle.
+        Handle                  add( const Value& value );
+
+        //! Reserves the slot inside a container.
+        Handle                  reserve( void );
+
+        //! Removes item from a container with specified handle. Returns true if the removal succeed, otherwise returns false.
+        bool                    remove( const Handle& handle );
+
+        //! Returns true if the specified handle is valid.
+        bool                    has( const Handle& handle ) const;
+
+        //! Returns the value referenced by specified handle.
+        NIMBLE_INLINE const Value&  get( const Handle& handle ) const;
+        NIMBLE_INLINE Value&        get( const Handle& handle );
+
+        //! Returns the total number of used slots.
+        s32                     size( void ) const;
+
+        //! Returns the total number of allocated slots.
+        s32                     capacity( void ) const;
+
+    private:
+
+                                ConcurrentPool( const ConcurrentPool& other );
+        ConcurrentPool&         operator = ( const ConcurrentPool& other );
+
+        //! A single pool slot.
+        struct Slot {
+            std::atomic<u32>    generation; //!< The slot generation, incremented each time a value is removed.
+            std::atomic<u32>    next;       //!< The next free slot index.
+            Value               value;      //!< The stored value.
+        };
+
+        //! A fixed-size block of slots.
+        struct Page {
+            Slot                slots[TPageSize];   //!< Page slots.
+        };
+
+        //! An empty free list marker.
+        static const u32        Invalid = ~0u;
+
+        //! Returns a slot with specified index.
+        NIMBLE_INLINE Slot&     slotAt( u32 index ) const;
+
+        //! Pops a slot index from a free list, returns Invalid if the list is empty.
+        u32                     pop( void );
+
+        //! Pushes a chain of linked slots to a free list.
+        void                    push( u32 first, u32 last );
+
+        //! Allocates a new page and returns one of its slots.
+        u32                     grow( void );
+
+    private:
+
+        std::atomic<Page*>      m_pages[TMaxPages]; //!< Allocated pages.
+        std::atomic<s32>        m_pageCount;        //!< The total number of allocated pages.
+        std::atomic<u64>        m_head;             //!< Free list head, a slot index in lower 32 bits tagged by a modification counter in upper 32 bits.
+        std::atomic<s32>        m_count;            //!< The total number of used slots.
+        std::mutex              m_mutex;            //!< Serializes page allocations.
+    };
+
+    // ** ConcurrentPool::ConcurrentPool
+    template<typename TValue, typename THandle, s32 TPageSize, s32 TMaxPages>
+    ConcurrentPool<TValue, THandle, TPageSize, TMaxPages>::ConcurrentPool( void )
+        : m_pageCount( 0 )
+        , m_head( Invalid )
+        , m_count( 0 )
+    {
+        NIMBLE_STATIC_ASSERT( static_cast<u64>( TPageSize ) * TMaxPages < (static_cast<u64>( 1 ) << THandle::Bits), "pool slot indices do not fit a handle" );
+
+        for( s32 i = 0; i < TMaxPages; i++ ) {
+            m_pages[i].store( NULL, std::memory_order_relaxed );
+        }
+    }
+
+    // ** ConcurrentPool::~ConcurrentPool
+    template<typename TValue, typename THandle, s32 TPageSize, s32 TMaxPages>
+    ConcurrentPool<TValue, THandle, TPageSize, TMaxPages>::~ConcurrentPool( void )
+    {
+        for( s32 i = 0, n = m_pageCount.load(); i < n; i++ ) {
+            delete m_pages[i].load();
+        }
+    }
+
+    // ** ConcurrentPool::size
+    template<typename TValue, typename THandle, s32 TPageSize, s32 TMaxPages>
+    s32 ConcurrentPool<TValue, THandle, TPageSize, TMaxPages>::size( void ) const
+    {
+        return m_count.load( std::memory_order_relaxed );
+    }
+
+    // ** ConcurrentPool::capacity
+    template<typename TValue, typename THandle, s32 TPageSize, s32 TMaxPages>
+    s32 ConcurrentPool<TValue, THandle, TPageSize, TMaxPages>::capacity( void ) const
+    {
+        return m_pageCount.load( std::memory_order_acquire ) * TPageSize;
+    }
+
+    // ** ConcurrentPool::slotAt
+    template<typename TValue, typename THandle, s32 TPageSize, s32 TMaxPages>
+    NIMBLE_INLINE typename ConcurrentPool<TValue, THandle, TPageSize, TMaxPages>::Slot& ConcurrentPool<TValue, THandle, TPageSize, TMaxPages>::slotAt( u32 index ) const
+    {
+        return m_pages[index / TPageSize].load( std::memory_order_acquire )->slots[index % TPageSize];
+    }
+
+    // ** ConcurrentPool::add
+    template<typename TValue, typename THandle, s32 TPageSize, s32 TMaxPages>
+    THandle ConcurrentPool<TValue, THandle, TPageSize, TMaxPages>::add( const TValue& value )
+    {
+        Handle handle = reserve();
+        slotAt( handle ).value = value;
+        return handle;
+    }
+
+    // ** ConcurrentPool::reserve
+    template<typename TValue, typename THandle, s32 TPageSize, s32 TMaxPages>
+    THandle ConcurrentPool<TValue, THandle, TPageSize, TMaxPages>::reserve( void )
+    {
+        u32 index = pop();
+
+        // The free list is exhausted - allocate a new page
+        if( index == Invalid ) {
+            index = grow();
+        }
+
+        m_count.fetch_add( 1, std::memory_order_relaxed );
+
+        return THandle( index, slotAt( index ).generation.load( std::memory_order_relaxed ) );
+    }
+
+    // ** ConcurrentPool::has
+    template<typename TValue, typename THandle, s32 TPageSize, s32 TMaxPages>
+    bool ConcurrentPool<TValue, THandle, TPageSize, TMaxPages>::has( const THandle& handle ) const
+    {
+        if( !handle.isValid() ) {
+            return false;
+        }
+
+        NIMBLE_ABORT_IF( handle >= static_cast<u32>( capacity() ), "handle index is out of range" );
+        return handle.generation() == THandle( handle, slotAt( handle ).generation.load( std::memory_order_acquire ) ).generation();
+    }
+
+    // ** ConcurrentPool::get
+    template<typename TValue, typename THandle, s32 TPageSize, s32 TMaxPages>
+    NIMBLE_INLINE const TValue& ConcurrentPool<TValue, THandle, TPageSize, TMaxPages>::get( const THandle& handle ) const
+    {
+        NIMBLE_ABORT_IF( !has( handle ), "Handle is not valid" );
+        return slotAt( handle ).value;
+    }
+
+    // ** ConcurrentPool::get
+    template<typename TValue, typename THandle, s32 TPageSize, s32 TMaxPages>
+    NIMBLE_INLINE TValue& ConcurrentPool<TValue, THandle, TPageSize, TMaxPages>::get( const THandle& handle )
+    {
+        NIMBLE_ABORT_IF( !has( handle ), "Handle is not valid" );
+        return slotAt( handle ).value;
+    }
+
+    // ** ConcurrentPool::remove
+    template<typename TValue, typename THandle, s32 TPageSize, s32 TMaxPages>
+    bool ConcurrentPool<TValue, THandle, TPageSize, TMaxPages>::remove( const THandle& handle )
+    {
+        if( !handle.isValid() || handle >= static_cast<u32>( capacity() ) ) {
+            return false;
+        }
+
+        u32   index      = handle;
+        Slot& slot       = slotAt( index );
+        u32   generation = slot.generation.load( std::memory_order_relaxed );
+
+        // Increase the generation counter to invalidate all living handles, only a single thread can win the removal
+        do {
+            if( THandle( index, generation ).generation() != handle.generation() ) {
+                return false;
+            }
+        } while( !slot.generation.compare_exchange_weak( generation, generation + 1, std::memory_order_acq_rel, std::memory_order_relaxed ) );
+
+        m_count.fetch_sub( 1, std::memory_order_relaxed );
+        push( index, index );
+
+        return true;
+    }
+
+    // ** ConcurrentPool::pop
+    template<typename TValue, typename THandle, s32 TPageSize, s32 TMaxPages>
+    u32 ConcurrentPool<TValue, THandle, TPageSize, TMaxPages>::pop( void )
+    {
+        u64 head = m_head.load( std::memory_order_acquire );
+
+        for( ;; ) {
+            u32 index = static_cast<u32>( head );
+
+            if( index == Invalid ) {
+                return Invalid;
+            }
+
+            // The slot may be popped by another thread meanwhile, but its memory stays valid and the tag makes the CAS fail
+            u32 next = slotAt( index ).next.load( std::memory_order_relaxed );
+            u64 tag  = (head >> 32) + 1;
+
+            if( m_head.compare_exchange_weak( head, (tag << 32) | next, std::memory_order_acquire, std::memory_order_acquire ) ) {
+                return index;
+            }
+        }
+    }
+
+    // ** ConcurrentPool::push
+    template<typename TValue, typename THandle, s32 TPageSize, s32 TMaxPages>
+    void ConcurrentPool<TValue, THandle, TPageSize, TMaxPages>::push( u32 first, u32 last )
+    {
+        Slot& tail = slotAt( last );
+        u64   head = m_head.load( std::memory_order_relaxed );
+
+        do {
+            tail.next.store( static_cast<u32>( head ), std::memory_order_relaxed );
+        } while( !m_head.compare_exchange_weak( head, (((head >> 32) + 1) << 32) | first, std::memory_order_release, std::memory_order_relaxed ) );
+    }
+
+    // ** ConcurrentPool::grow
+    template<typename TValue, typename THandle, s32 TPageSize, s32 TMaxPages>
+    u32 ConcurrentPool<TValue, THandle, TPageSize, TMaxPages>::grow( void )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        // Another thread may have added a page or released slots while this one was waiting for a lock
+        u32 index = pop();
+
+        if( index != Invalid ) {
+            return index;
+        }
+
+        s32 pageIndex = m_pageCount.load( std::memory_order_relaxed );
+        NIMBLE_ABORT_IF( pageIndex >= TMaxPages, "maximum pool capacity reached" );
+
+        // Chain all page slots except the first one, that is returned to a caller
+        Page* page  = new Page;
+        u32   first = pageIndex * TPageSize;
+
+        for( s32 i = 0; i < TPageSize; i++ ) {
+            page->slots[i].generation.store( 0, std::memory_order_relaxed );
+            page->slots[i].next.store( first + i + 1, std::memory_order_relaxed );
+        }
+
+        m_pages[pageIndex].store( page, std::memory_order_release );
+        m_pageCount.store( pageIndex + 1, std::memory_order_release );
+
+        if( TPageSize > 1 ) {
+            push( first + 1, first + TPageSize - 1 );
+        }
+
+        return first;
+    }
+
+NIMBLE_END
+
+#endif  /*  NIMBLE_CPP11_ENABLED    */
+
+#endif  /*  !__Nimble_Containers_ConcurrentPool_H__    */
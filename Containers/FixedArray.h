@@ -32,12 +32,16 @@
 NIMBLE_BEGIN
 
     //! This container type wraps an Array class and implements the swap-on-remove behaviour.
-    template<typename T>
+    /*!
+        Items are stored inside an Array by default, pass a PagedArray as a container type
+        to keep item addresses stable when an array grows.
+    */
+    template<typename T, typename TContainer = Array<T> >
     class FixedArray {
     public:
 
         //! Alias the container type.
-        typedef Array<T>    Container;
+        typedef TContainer  Container;
 
                             //! Constructs the FixedArray of specified size.
                             FixedArray( s32 size = 0 );
@@ -71,46 +75,46 @@ NIMBLE_BEGIN
     };
 
     // ** FixedArray::FixedArray
-    template<typename T>
-    FixedArray<T>::FixedArray( s32 size )
+    template<typename T, typename TContainer>
+    FixedArray<T, TContainer>::FixedArray( s32 size )
         : m_count( 0 )
     {
         resize( size );
     }
 
     // ** FixedArray::operator []
-    template<typename T>
-    NIMBLE_INLINE const T& FixedArray<T>::operator []( s32 index ) const
+    template<typename T, typename TContainer>
+    NIMBLE_INLINE const T& FixedArray<T, TContainer>::operator []( s32 index ) const
     {
         NIMBLE_BREAK_IF( index < 0 || index >= count(), "index is out of range" );
         return m_items[index];
     }
 
     // ** FixedArray::operator []
-    template<typename T>
-    NIMBLE_INLINE T& FixedArray<T>::operator []( s32 index )
+    template<typename T, typename TContainer>
+    NIMBLE_INLINE T& FixedArray<T, TContainer>::operator []( s32 index )
     {
         NIMBLE_BREAK_IF( index < 0 || index >= count(), "index is out of range" );
         return m_items[index];
     }
 
     // ** FixedArray::count
-    template<typename T>
-    NIMBLE_INLINE s32 FixedArray<T>::count( void ) const
+    template<typename T, typename TContainer>
+    NIMBLE_INLINE s32 FixedArray<T, TContainer>::count( void ) const
     {
         return m_count;
     }
 
     // ** FixedArray::maximumCapacity
-    template<typename T>
-    s32 FixedArray<T>::maximumCapacity( void ) const
+    template<typename T, typename TContainer>
+    s32 FixedArray<T, TContainer>::maximumCapacity( void ) const
     {
         return static_cast<s32>( m_items.size() );
     }
 
     // ** FixedArray::remove
-    template<typename T>
-    void FixedArray<T>::remove( s32 index )
+    template<typename T, typename TContainer>
+    void FixedArray<T, TContainer>::remove( s32 index )
     {
         NIMBLE_BREAK_IF( index < 0 || index >= count(), "index is out of range" );
         m_items[index] = m_items[m_count - 1];
@@ -118,8 +122,8 @@ NIMBLE_BEGIN
     }
 
     // ** FixedArray::push
-    template<typename T>
-    s32 FixedArray<T>::push( const T& value )
+    template<typename T, typename TContainer>
+    s32 FixedArray<T, TContainer>::push( const T& value )
     {
         if( count() < maximumCapacity() ) {
             m_items[m_count] = value;
@@ -132,8 +136,8 @@ NIMBLE_BEGIN
     }
 
     // ** FixedArray::push
-    template<typename T>
-    void FixedArray<T>::emplace( s32 index, const T& value )
+    template<typename T, typename TContainer>
+    void FixedArray<T, TContainer>::emplace( s32 index, const T& value )
     {
         if (index >= count())
         {
@@ -144,8 +148,8 @@ NIMBLE_BEGIN
     }
 
     // ** FixedArray::resize
-    template<typename T>
-    void FixedArray<T>::resize( s32 size )
+    template<typename T, typename TContainer>
+    void FixedArray<T, TContainer>::resize( s32 size )
     {
         if( size ) {
             m_items.resize( size );
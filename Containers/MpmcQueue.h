@@ -0,0 +1,243 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_Containers_MpmcQueue_H__
+#define __Nimble_Containers_MpmcQueue_H__
+
+#include "../Globals.h"
+#include "../Allocators/LinearAllocator.h"
+
+#if NIMBLE_CPP11_ENABLED
+
+#include <atomic>
+
+NIMBLE_BEGIN
+
+    //! A bounded lock-free queue with multiple producer and multiple consumer threads.
+    /*!
+        This is a D. Vyukov's bounded MPMC queue. Each cell stores a sequence number that tells whether
+        the cell is ready for a producer or a consumer at a given position, so producers and consumers
+        only contend on their own index with a single CAS per operation. Batch operations claim a run of
+        ready cells with a single CAS. Cells are stored in a cache line aligned block allocated from a
+        LinearAllocator.
+    */
+    template<typename T>
+    class MpmcQueue {
+    public:
+
+                                //! Constructs a MpmcQueue instance, the capacity is rounded up to a power of two.
+        explicit                MpmcQueue( s32 capacity );
+                                ~MpmcQueue( void );
+
+        //! Pushes an item to a queue, returns false if a queue is full.
+        bool                    push( const T& item );
+
+        //! Pushes up to a specified number of items to a queue and returns the number of pushed items.
+        s32                     push( const T* items, s32 count );
+
+        //! Pops an item from a queue, returns false if a queue is empty.
+        bool                    pop( T& item );
+
+        //! Pops up to a specified number of items from a queue and returns the number of popped items.
+        s32                     pop( T* items, s32 count );
+
+        //! Returns an approximate number of items in a queue.
+        s32                     size( void ) const;
+
+        //! Returns true if a queue looks empty.
+        bool                    isEmpty( void ) const;
+
+        //! Returns the maximum number of items in a queue.
+        s32                     capacity( void ) const;
+
+    private:
+
+                                MpmcQueue( const MpmcQueue& other );
+        MpmcQueue&              operator = ( const MpmcQueue& other );
+
+        //! A queue cell.
+        struct Cell {
+            std::atomic<u64>    sequence;   //!< The position this cell is ready for, equals to position + 1 once an item is written.
+            T                   item;       //!< The stored item.
+        };
+
+        //! Claims a run of up to a specified number of cells whose sequence is a distance ahead of their position, returns the number of claimed cells and the first claimed position.
+        s32                     claim( std::atomic<u64>& index, s32 count, u64 distance, u64& position );
+
+    private:
+
+        LinearAllocator         m_storage;                                              //!< Allocates queue cells.
+        Cell*                   m_cells;                                                //!< Queue cells.
+        u64                     m_mask;                                                 //!< Index mask.
+        u8                      m_padding0[NIMBLE_CACHE_LINE_SIZE];                     //!< Separates read-only data from producer data.
+        std::atomic<u64>        m_tail;                                                 //!< The position of a next pushed item.
+        u8                      m_padding1[NIMBLE_CACHE_LINE_SIZE - sizeof( u64 )];     //!< Keeps the tail index on its own cache line.
+        std::atomic<u64>        m_head;                                                 //!< The position of a next popped item.
+        u8                      m_padding2[NIMBLE_CACHE_LINE_SIZE - sizeof( u64 )];     //!< Keeps the head index on its own cache line.
+    };
+
+    // ** MpmcQueue::MpmcQueue
+    template<typename T>
+    MpmcQueue<T>::MpmcQueue( s32 capacity )
+        : m_storage( nextPowerOf2( capacity ) * sizeof( Cell ) + NIMBLE_CACHE_LINE_SIZE )
+        , m_mask( nextPowerOf2( capacity ) - 1 )
+        , m_tail( 0 )
+        , m_head( 0 )
+    {
+        NIMBLE_ABORT_IF( capacity <= 0, "a queue capacity should be positive" );
+
+        // Align cells to a cache line
+        u8* bytes = m_storage.allocate( m_storage.size() );
+        m_cells = reinterpret_cast<Cell*>( (reinterpret_cast<uintptr_t>( bytes ) + NIMBLE_CACHE_LINE_SIZE - 1) & ~static_cast<uintptr_t>( NIMBLE_CACHE_LINE_SIZE - 1 ) );
+
+        for( u64 i = 0; i <= m_mask; i++ ) {
+            new( m_cells + i ) Cell;
+            m_cells[i].sequence.store( i, std::memory_order_relaxed );
+        }
+    }
+
+    // ** MpmcQueue::~MpmcQueue
+    template<typename T>
+    MpmcQueue<T>::~MpmcQueue( void )
+    {
+        for( u64 i = 0; i <= m_mask; i++ ) {
+            m_cells[i].~Cell();
+        }
+    }
+
+    // ** MpmcQueue::claim
+    template<typename T>
+    s32 MpmcQueue<T>::claim( std::atomic<u64>& index, s32 count, u64 distance, u64& position )
+    {
+        position = index.load( std::memory_order_relaxed );
+
+        for( ;; ) {
+            // Count the run of cells that are ready for this position
+            s32 ready = 0;
+
+            while( ready < count && ready <= static_cast<s32>( m_mask ) ) {
+                u64 sequence = m_cells[(position + ready) & m_mask].sequence.load( std::memory_order_acquire );
+
+                if( sequence != position + ready + distance ) {
+                    break;
+                }
+
+                ready++;
+            }
+
+            if( ready == 0 ) {
+                u64 sequence = m_cells[position & m_mask].sequence.load( std::memory_order_acquire );
+
+                // The first cell was not released yet for this lap, so the queue is either full or empty
+                if( static_cast<s64>( sequence - (position + distance) ) < 0 ) {
+                    return 0;
+                }
+
+                // Another thread has claimed this position
+                position = index.load( std::memory_order_relaxed );
+                continue;
+            }
+
+            if( index.compare_exchange_weak( position, position + ready, std::memory_order_relaxed ) ) {
+                return ready;
+            }
+        }
+    }
+
+    // ** MpmcQueue::push
+    template<typename T>
+    bool MpmcQueue<T>::push( const T& item )
+    {
+        return push( &item, 1 ) == 1;
+    }
+
+    // ** MpmcQueue::push
+    template<typename T>
+    s32 MpmcQueue<T>::push( const T* items, s32 count )
+    {
+        u64 position;
+        s32 pushed = claim( m_tail, count, 0, position );
+
+        for( s32 i = 0; i < pushed; i++ ) {
+            Cell& cell = m_cells[(position + i) & m_mask];
+            cell.item = items[i];
+            cell.sequence.store( position + i + 1, std::memory_order_release );
+        }
+
+        return pushed;
+    }
+
+    // ** MpmcQueue::pop
+    template<typename T>
+    bool MpmcQueue<T>::pop( T& item )
+    {
+        return pop( &item, 1 ) == 1;
+    }
+
+    // ** MpmcQueue::pop
+    template<typename T>
+    s32 MpmcQueue<T>::pop( T* items, s32 count )
+    {
+        u64 position;
+        s32 popped = claim( m_head, count, 1, position );
+
+        for( s32 i = 0; i < popped; i++ ) {
+            Cell& cell = m_cells[(position + i) & m_mask];
+            items[i] = std::move( cell.item );
+            cell.sequence.store( position + i + m_mask + 1, std::memory_order_release );
+        }
+
+        return popped;
+    }
+
+    // ** MpmcQueue::size
+    template<typename T>
+    s32 MpmcQueue<T>::size( void ) const
+    {
+        u64 head = m_head.load( std::memory_order_relaxed );
+        u64 tail = m_tail.load( std::memory_order_relaxed );
+        return tail > head ? static_cast<s32>( min2<u64>( tail - head, m_mask + 1 ) ) : 0;
+    }
+
+    // ** MpmcQueue::isEmpty
+    template<typename T>
+    bool MpmcQueue<T>::isEmpty( void ) const
+    {
+        return size() == 0;
+    }
+
+    // ** MpmcQueue::capacity
+    template<typename T>
+    s32 MpmcQueue<T>::capacity( void ) const
+    {
+        return static_cast<s32>( m_mask + 1 );
+    }
+
+NIMBLE_END
+
+#endif  /*  NIMBLE_CPP11_ENABLED    */
+
+#endif  /*  !__Nimble_Containers_MpmcQueue_H__    */
@@ -0,0 +1,241 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_Containers_PagedArray_H__
+#define __Nimble_Containers_PagedArray_H__
+
+#include "../Globals.h"
+
+NIMBLE_BEGIN
+
+    //! An array that stores items in fixed-size pages, so items are never moved and their addresses stay valid while an array grows.
+    /*!
+        A page holds 2^TPageBits items, an index is translated to a page and an offset with a shift and a mask.
+        Growing an array only appends page pointers to a page table, so push_back is amortized O(1) without
+        copying items. Pages are kept when an array shrinks and released by a destructor. The interface
+        mirrors a subset of Array, so PagedArray can be used as a storage of FixedArray and IndexAllocator.
+    */
+    template<typename T, s32 TPageBits = 10>
+    class PagedArray {
+    public:
+
+        //! The number of items stored in a single page.
+        enum { PageSize = 1 << TPageBits };
+
+                            //! Constructs an empty PagedArray instance.
+                            PagedArray( void );
+
+                            //! Copies items from another PagedArray instance.
+                            PagedArray( const PagedArray& other );
+
+                            ~PagedArray( void );
+
+        //! Replaces items with a copy of another array.
+        PagedArray&         operator = ( const PagedArray& other );
+
+        //! Returns an item at specified index.
+        NIMBLE_INLINE const T&  operator [] ( size_t index ) const;
+        NIMBLE_INLINE T&        operator [] ( size_t index );
+
+        //! Returns the total number of items.
+        size_t              size( void ) const;
+
+        //! Returns the total number of items that fit allocated pages.
+        size_t              capacity( void ) const;
+
+        //! Returns true if an array is empty.
+        bool                empty( void ) const;
+
+        //! Appends an item to the end of an array.
+        void                push_back( const T& value );
+
+        //! Removes the last item of an array.
+        void                pop_back( void );
+
+        //! Resizes an array, new items are copies of a specified value.
+        void                resize( size_t size, const T& value = T() );
+
+        //! Allocates pages to hold a specified number of items.
+        void                reserve( size_t size );
+
+        //! Destroys all items, allocated pages are kept.
+        void                clear( void );
+
+    private:
+
+        //! Returns an item pointer at specified index.
+        NIMBLE_INLINE T*    at( size_t index ) const;
+
+    private:
+
+        Array<T*>           m_pages;    //!< Allocated pages.
+        size_t              m_size;     //!< The total number of items.
+    };
+
+    // ** PagedArray::PagedArray
+    template<typename T, s32 TPageBits>
+    PagedArray<T, TPageBits>::PagedArray( void )
+        : m_size( 0 )
+    {
+    }
+
+    // ** PagedArray::PagedArray
+    template<typename T, s32 TPageBits>
+    PagedArray<T, TPageBits>::PagedArray( const PagedArray& other )
+        : m_size( 0 )
+    {
+        *this = other;
+    }
+
+    // ** PagedArray::~PagedArray
+    template<typename T, s32 TPageBits>
+    PagedArray<T, TPageBits>::~PagedArray( void )
+    {
+        clear();
+
+        for( size_t i = 0, n = m_pages.size(); i < n; i++ ) {
+            free( m_pages[i] );
+        }
+    }
+
+    // ** PagedArray::operator =
+    template<typename T, s32 TPageBits>
+    PagedArray<T, TPageBits>& PagedArray<T, TPageBits>::operator = ( const PagedArray& other )
+    {
+        if( this == &other ) {
+            return *this;
+        }
+
+        clear();
+        reserve( other.size() );
+
+        for( size_t i = 0, n = other.size(); i < n; i++ ) {
+            new( at( i ) ) T( other[i] );
+            m_size++;
+        }
+
+        return *this;
+    }
+
+    // ** PagedArray::at
+    template<typename T, s32 TPageBits>
+    NIMBLE_INLINE T* PagedArray<T, TPageBits>::at( size_t index ) const
+    {
+        return m_pages[index >> TPageBits] + (index & (PageSize - 1));
+    }
+
+    // ** PagedArray::operator []
+    template<typename T, s32 TPageBits>
+    NIMBLE_INLINE const T& PagedArray<T, TPageBits>::operator []( size_t index ) const
+    {
+        NIMBLE_BREAK_IF( index >= m_size, "index is out of range" );
+        return *at( index );
+    }
+
+    // ** PagedArray::operator []
+    template<typename T, s32 TPageBits>
+    NIMBLE_INLINE T& PagedArray<T, TPageBits>::operator []( size_t index )
+    {
+        NIMBLE_BREAK_IF( index >= m_size, "index is out of range" );
+        return *at( index );
+    }
+
+    // ** PagedArray::size
+    template<typename T, s32 TPageBits>
+    size_t PagedArray<T, TPageBits>::size( void ) const
+    {
+        return m_size;
+    }
+
+    // ** PagedArray::capacity
+    template<typename T, s32 TPageBits>
+    size_t PagedArray<T, TPageBits>::capacity( void ) const
+    {
+        return m_pages.size() << TPageBits;
+    }
+
+    // ** PagedArray::empty
+    template<typename T, s32 TPageBits>
+    bool PagedArray<T, TPageBits>::empty( void ) const
+    {
+        return m_size == 0;
+    }
+
+    // ** PagedArray::push_back
+    template<typename T, s32 TPageBits>
+    void PagedArray<T, TPageBits>::push_back( const T& value )
+    {
+        reserve( m_size + 1 );
+        new( at( m_size ) ) T( value );
+        m_size++;
+    }
+
+    // ** PagedArray::pop_back
+    template<typename T, s32 TPageBits>
+    void PagedArray<T, TPageBits>::pop_back( void )
+    {
+        NIMBLE_BREAK_IF( m_size == 0, "array is empty" );
+        at( --m_size )->~T();
+    }
+
+    // ** PagedArray::resize
+    template<typename T, s32 TPageBits>
+    void PagedArray<T, TPageBits>::resize( size_t size, const T& value )
+    {
+        while( m_size > size ) {
+            pop_back();
+        }
+
+        reserve( size );
+
+        for( ; m_size < size; m_size++ ) {
+            new( at( m_size ) ) T( value );
+        }
+    }
+
+    // ** PagedArray::reserve
+    template<typename T, s32 TPageBits>
+    void PagedArray<T, TPageBits>::reserve( size_t size )
+    {
+        while( capacity() < size ) {
+            T* page = reinterpret_cast<T*>( malloc( sizeof( T ) * PageSize ) );
+            NIMBLE_ABORT_IF( page == NULL, "failed to allocate a page" );
+            m_pages.push_back( page );
+        }
+    }
+
+    // ** PagedArray::clear
+    template<typename T, s32 TPageBits>
+    void PagedArray<T, TPageBits>::clear( void )
+    {
+        while( m_size > 0 ) {
+            pop_back();
+        }
+    }
+
+NIMBLE_END
+
+#endif  /*  !__Nimble_Containers_PagedArray_H__    */
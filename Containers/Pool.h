@@ -47,6 +47,9 @@ NIMBLE_BEGIN
                                 OpaqueHandle( const OpaqueHandle& other )
                                     : m_index( other.m_index ), m_generation( other.m_generation ) {}
 
+                                //! Copies an OpaqueHandle instance.
+        OpaqueHandle&           operator = ( const OpaqueHandle& other ) { m_index = other.m_index; m_generation = other.m_generation; return *this; }
+
                                 //! Casts this OpaqueHandle to an integer value.
                                 operator u32( void ) const;
 
@@ -0,0 +1,210 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_Containers_SpscRingBuffer_H__
+#define __Nimble_Containers_SpscRingBuffer_H__
+
+#include "../Globals.h"
+#include "../Allocators/LinearAllocator.h"
+
+#if NIMBLE_CPP11_ENABLED
+
+#include <atomic>
+
+NIMBLE_BEGIN
+
+    //! A bounded lock-free ring buffer with a single producer and a single consumer thread.
+    /*!
+        Producer and consumer indices live on separate cache lines, and each side caches the last
+        seen index of the other side, so the shared lines are only touched when a buffer looks full
+        or empty. Items are stored in a cache line aligned block allocated from a LinearAllocator.
+    */
+    template<typename T>
+    class SpscRingBuffer {
+    public:
+
+                                //! Constructs a SpscRingBuffer instance, the capacity is rounded up to a power of two.
+        explicit                SpscRingBuffer( s32 capacity );
+                                ~SpscRingBuffer( void );
+
+        //! Pushes an item to a buffer, returns false if a buffer is full. Should only be called by a producer thread.
+        bool                    push( const T& item );
+
+        //! Pushes up to a specified number of items to a buffer and returns the number of pushed items. Should only be called by a producer thread.
+        s32                     push( const T* items, s32 count );
+
+        //! Pops an item from a buffer, returns false if a buffer is empty. Should only be called by a consumer thread.
+        bool                    pop( T& item );
+
+        //! Pops up to a specified number of items from a buffer and returns the number of popped items. Should only be called by a consumer thread.
+        s32                     pop( T* items, s32 count );
+
+        //! Returns an approximate number of items in a buffer.
+        s32                     size( void ) const;
+
+        //! Returns true if a buffer looks empty.
+        bool                    isEmpty( void ) const;
+
+        //! Returns the maximum number of items in a buffer.
+        s32                     capacity( void ) const;
+
+    private:
+
+                                SpscRingBuffer( const SpscRingBuffer& other );
+        SpscRingBuffer&         operator = ( const SpscRingBuffer& other );
+
+    private:
+
+        LinearAllocator         m_storage;                                                          //!< Allocates the item storage.
+        T*                      m_items;                                                            //!< Buffer items.
+        u64                     m_mask;                                                             //!< Index mask.
+        u8                      m_padding0[NIMBLE_CACHE_LINE_SIZE];                                 //!< Separates read-only data from producer data.
+        std::atomic<u64>        m_tail;                                                             //!< The index of a next pushed item, modified by a producer.
+        u64                     m_headCache;                                                        //!< The last head index seen by a producer.
+        u8                      m_padding1[NIMBLE_CACHE_LINE_SIZE - 2 * sizeof( u64 )];             //!< Keeps producer data on its own cache line.
+        std::atomic<u64>        m_head;                                                             //!< The index of a next popped item, modified by a consumer.
+        u64                     m_tailCache;                                                        //!< The last tail index seen by a consumer.
+        u8                      m_padding2[NIMBLE_CACHE_LINE_SIZE - 2 * sizeof( u64 )];             //!< Keeps consumer data on its own cache line.
+    };
+
+    // ** SpscRingBuffer::SpscRingBuffer
+    template<typename T>
+    SpscRingBuffer<T>::SpscRingBuffer( s32 capacity )
+        : m_storage( nextPowerOf2( capacity ) * sizeof( T ) + NIMBLE_CACHE_LINE_SIZE )
+        , m_mask( nextPowerOf2( capacity ) - 1 )
+        , m_tail( 0 )
+        , m_headCache( 0 )
+        , m_head( 0 )
+        , m_tailCache( 0 )
+    {
+        NIMBLE_ABORT_IF( capacity <= 0, "a ring buffer capacity should be positive" );
+
+        // Align items to a cache line
+        u8* bytes = m_storage.allocate( m_storage.size() );
+        m_items = reinterpret_cast<T*>( (reinterpret_cast<uintptr_t>( bytes ) + NIMBLE_CACHE_LINE_SIZE - 1) & ~static_cast<uintptr_t>( NIMBLE_CACHE_LINE_SIZE - 1 ) );
+
+        for( u64 i = 0; i <= m_mask; i++ ) {
+            new( m_items + i ) T;
+        }
+    }
+
+    // ** SpscRingBuffer::~SpscRingBuffer
+    template<typename T>
+    SpscRingBuffer<T>::~SpscRingBuffer( void )
+    {
+        for( u64 i = 0; i <= m_mask; i++ ) {
+            m_items[i].~T();
+        }
+    }
+
+    // ** SpscRingBuffer::push
+    template<typename T>
+    bool SpscRingBuffer<T>::push( const T& item )
+    {
+        return push( &item, 1 ) == 1;
+    }
+
+    // ** SpscRingBuffer::push
+    template<typename T>
+    s32 SpscRingBuffer<T>::push( const T* items, s32 count )
+    {
+        u64 tail = m_tail.load( std::memory_order_relaxed );
+        u64 free = m_mask + 1 - (tail - m_headCache);
+
+        // Refresh the cached head index only when the buffer looks full
+        if( free < static_cast<u64>( count ) ) {
+            m_headCache = m_head.load( std::memory_order_acquire );
+            free = m_mask + 1 - (tail - m_headCache);
+        }
+
+        s32 pushed = static_cast<s32>( min2<u64>( free, count ) );
+
+        for( s32 i = 0; i < pushed; i++ ) {
+            m_items[(tail + i) & m_mask] = items[i];
+        }
+
+        m_tail.store( tail + pushed, std::memory_order_release );
+        return pushed;
+    }
+
+    // ** SpscRingBuffer::pop
+    template<typename T>
+    bool SpscRingBuffer<T>::pop( T& item )
+    {
+        return pop( &item, 1 ) == 1;
+    }
+
+    // ** SpscRingBuffer::pop
+    template<typename T>
+    s32 SpscRingBuffer<T>::pop( T* items, s32 count )
+    {
+        u64 head      = m_head.load( std::memory_order_relaxed );
+        u64 available = m_tailCache - head;
+
+        // Refresh the cached tail index only when the buffer looks empty
+        if( available < static_cast<u64>( count ) ) {
+            m_tailCache = m_tail.load( std::memory_order_acquire );
+            available = m_tailCache - head;
+        }
+
+        s32 popped = static_cast<s32>( min2<u64>( available, count ) );
+
+        for( s32 i = 0; i < popped; i++ ) {
+            items[i] = std::move( m_items[(head + i) & m_mask] );
+        }
+
+        m_head.store( head + popped, std::memory_order_release );
+        return popped;
+    }
+
+    // ** SpscRingBuffer::size
+    template<typename T>
+    s32 SpscRingBuffer<T>::size( void ) const
+    {
+        u64 head = m_head.load( std::memory_order_relaxed );
+        u64 tail = m_tail.load( std::memory_order_relaxed );
+        return tail > head ? static_cast<s32>( tail - head ) : 0;
+    }
+
+    // ** SpscRingBuffer::isEmpty
+    template<typename T>
+    bool SpscRingBuffer<T>::isEmpty( void ) const
+    {
+        return size() == 0;
+    }
+
+    // ** SpscRingBuffer::capacity
+    template<typename T>
+    s32 SpscRingBuffer<T>::capacity( void ) const
+    {
+        return static_cast<s32>( m_mask + 1 );
+    }
+
+NIMBLE_END
+
+#endif  /*  NIMBLE_CPP11_ENABLED    */
+
+#endif  /*  !__Nimble_Containers_SpscRingBuffer_H__    */
@@ -31,7 +31,7 @@
 #include "Namespace.h"
 #include "Types.h"
 
-#if defined(NIMBLE_PLATFORM_MACOS) || defined(NIMBLE_PLATFORM_IOS) || defined(NIMBLE_PLATFORM_ANDROID) || defined(NIMBLE_PLATFORM_EMSCRIPTEN)
+#if defined(NIMBLE_PLATFORM_MACOS) || defined(NIMBLE_PLATFORM_IOS) || defined(NIMBLE_PLATFORM_ANDROID) || defined(NIMBLE_PLATFORM_EMSCRIPTEN) || defined(NIMBLE_PLATFORM_LINUX)
     #define _strdup strdup
     #define _snprintf snprintf
 
@@ -44,6 +44,10 @@
     #endif  /*  #ifndef FLT_MIN */
 #endif  /*  #ifdef NIMBLE_PLATFORM_MACOS    */
 
+#if defined( _MSC_VER )
+    #include <intrin.h>
+#endif  /*  _MSC_VER    */
+
 NIMBLE_BEGIN
 
     namespace Internal {
@@ -211,6 +215,66 @@ NIMBLE_BEGIN
         return 1 << count;
     }
 
+    //! Returns the number of trailing zero bits in a non-zero 32-bit value.
+    inline u32 countTrailingZeros( u32 value )
+    {
+    #if defined( _MSC_VER )
+        unsigned long index;
+        _BitScanForward( &index, value );
+        return index;
+    #else
+        return __builtin_ctz( value );
+    #endif  /*  _MSC_VER    */
+    }
+
+    //! Returns the number of trailing zero bits in a non-zero 64-bit value.
+    inline u32 countTrailingZeros( u64 value )
+    {
+    #if defined( _MSC_VER ) && defined( _M_X64 )
+        unsigned long index;
+        _BitScanForward64( &index, value );
+        return index;
+    #elif defined( _MSC_VER )
+        u32 low = static_cast<u32>( value );
+        return low ? countTrailingZeros( low ) : 32 + countTrailingZeros( static_cast<u32>( value >> 32 ) );
+    #else
+        return __builtin_ctzll( value );
+    #endif  /*  _MSC_VER    */
+    }
+
+    //! Returns the number of leading zero bits in a non-zero 64-bit value.
+    inline u32 countLeadingZeros( u64 value )
+    {
+    #if defined( _MSC_VER ) && defined( _M_X64 )
+        unsigned long index;
+        _BitScanReverse64( &index, value );
+        return 63 - index;
+    #elif defined( _MSC_VER )
+        unsigned long index;
+        u32 high = static_cast<u32>( value >> 32 );
+        if( high ) {
+            _BitScanReverse( &index, high );
+            return 31 - index;
+        }
+        _BitScanReverse( &index, static_cast<u32>( value ) );
+        return 63 - index;
+    #else
+        return __builtin_clzll( value );
+    #endif  /*  _MSC_VER    */
+    }
+
+    //! Returns the number of set bits in a 64-bit value.
+    inline u32 countSetBits( u64 value )
+    {
+    #if defined( _MSC_VER ) && defined( _M_X64 )
+        return static_cast<u32>( __popcnt64( value ) );
+    #elif defined( _MSC_VER )
+        return __popcnt( static_cast<u32>( value ) ) + __popcnt( static_cast<u32>( value >> 32 ) );
+    #else
+        return __builtin_popcountll( value );
+    #endif  /*  _MSC_VER    */
+    }
+
     //! Generates a random value in a [0, 1] range.
     inline f32 rand0to1( void ) {
         static f32 invRAND_MAX = 1.0f / RAND_MAX;
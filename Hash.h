@@ -60,8 +60,8 @@ NIMBLE_BEGIN
         }
 
         //! Calculates the 32-bit murmur hash value.
-        template<s32>
-        u32 murmur( const void* input, u32 length, s32 seed = 0 )
+        template<>
+        inline u32 murmur<u32>( const void* input, u32 length, u32 seed )
         {
             // 'm' and 'r' are mixing constants generated offline.
             // They're not really 'magic', they just happen to work well.
@@ -90,8 +90,8 @@ NIMBLE_BEGIN
 
             // Handle the last few bytes of the input array
             switch( length ) {
-            case 3: h ^= data[2] << 16;
-            case 2: h ^= data[1] << 8;
+            case 3: h ^= data[2] << 16; // fall through
+            case 2: h ^= data[1] << 8; // fall through
             case 1: h ^= data[0];
                     h *= m;
             };
@@ -106,8 +106,8 @@ NIMBLE_BEGIN
         }
 
         //! Calculates the 64-bit murmur hash value.
-        template<u64>
-        u64 murmur( const void* input, u32 length, u64 seed = 0 )
+        template<>
+        inline u64 murmur<u64>( const void* input, u32 length, u64 seed )
         {
             const u64 m = 0xc6a4a7935bd1e995ull;
             const s32 r = 47;
@@ -131,12 +131,12 @@ NIMBLE_BEGIN
             const u8* data2 = reinterpret_cast<const u8*>( data );
 
             switch( length & 7 ) {
-            case 7: h ^= u64(data2[6]) << 48;
-            case 6: h ^= u64(data2[5]) << 40;
-            case 5: h ^= u64(data2[4]) << 32;
-            case 4: h ^= u64(data2[3]) << 24;
-            case 3: h ^= u64(data2[2]) << 16;
-            case 2: h ^= u64(data2[1]) << 8;
+            case 7: h ^= u64(data2[6]) << 48; // fall through
+            case 6: h ^= u64(data2[5]) << 40; // fall through
+            case 5: h ^= u64(data2[4]) << 32; // fall through
+            case 4: h ^= u64(data2[3]) << 24; // fall through
+            case 3: h ^= u64(data2[2]) << 16; // fall through
+            case 2: h ^= u64(data2[1]) << 8; // fall through
             case 1: h ^= u64(data2[0]);
                     h *= m;
             };
@@ -28,117 +28,579 @@
 #define    __Nimble_Hashing_Base64_H__
 
 #include "../Globals.h"
+#include "../Preprocessor/Simd.h"
 
 NIMBLE_BEGIN
 
     namespace Private {
         
         //! All valid Base64 encoding characters
-        static const String Base64Chars =
+        static const u8 Base64EncodeTable[] =
         "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
         "abcdefghijklmnopqrstuvwxyz"
         "0123456789+/"
         ;
-        
-        //! Returns true if a specified character is a valid Base64 character.
-        static inline bool isBase64( u8 c )
+
+        //! Maps an ASCII character to a 6-bit Base64 value, invalid characters are mapped to 0xFF.
+        static const u8 Base64DecodeTable[256] = {
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x3e, 0xff, 0xff, 0xff, 0x3f,
+            0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e,
+            0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+            0x29, 0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+            0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+        };
+
+    #if NIMBLE_SIMD_SSSE3
+        //! Translates sixteen 6-bit values to Base64 characters.
+        static inline __m128i base64EncodeLookup( __m128i indices )
         {
-            return isalnum(c) || (c == '+') || (c == '/');
+            const __m128i shift = _mm_setr_epi8( 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0 );
+
+            // Map [0, 25] to 13, [26, 51] to 0, [52, 61] to [1, 10], 62 to 11 and 63 to 12
+            __m128i result = _mm_subs_epu8( indices, _mm_set1_epi8( 51 ) );
+            __m128i less   = _mm_cmpgt_epi8( _mm_set1_epi8( 26 ), indices );
+            result = _mm_or_si128( result, _mm_and_si128( less, _mm_set1_epi8( 13 ) ) );
+
+            return _mm_add_epi8( _mm_shuffle_epi8( shift, result ), indices );
         }
-        
+
+        //! Splits twelve bytes to sixteen 6-bit values.
+        static inline __m128i base64EncodeSplit( __m128i input )
+        {
+            // Each 32-bit lane receives bytes [b1, b0, b2, b1] of a 3-byte group
+            input = _mm_shuffle_epi8( input, _mm_setr_epi8( 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10 ) );
+
+            __m128i ac = _mm_mulhi_epu16( _mm_and_si128( input, _mm_set1_epi32( 0x0fc0fc00 ) ), _mm_set1_epi32( 0x04000040 ) );
+            __m128i bd = _mm_mullo_epi16( _mm_and_si128( input, _mm_set1_epi32( 0x003f03f0 ) ), _mm_set1_epi32( 0x01000010 ) );
+
+            return _mm_or_si128( ac, bd );
+        }
+
+        //! Translates sixteen Base64 characters to 6-bit values, returns false if any of them is not a valid Base64 character.
+        static inline bool base64DecodeLookup( __m128i chars, __m128i& values )
+        {
+            __m128i upper = _mm_and_si128( _mm_cmpgt_epi8( chars, _mm_set1_epi8( 'A' - 1 ) ), _mm_cmpgt_epi8( _mm_set1_epi8( 'Z' + 1 ), chars ) );
+            __m128i lower = _mm_and_si128( _mm_cmpgt_epi8( chars, _mm_set1_epi8( 'a' - 1 ) ), _mm_cmpgt_epi8( _mm_set1_epi8( 'z' + 1 ), chars ) );
+            __m128i digit = _mm_and_si128( _mm_cmpgt_epi8( chars, _mm_set1_epi8( '0' - 1 ) ), _mm_cmpgt_epi8( _mm_set1_epi8( '9' + 1 ), chars ) );
+            __m128i plus  = _mm_cmpeq_epi8( chars, _mm_set1_epi8( '+' ) );
+            __m128i slash = _mm_cmpeq_epi8( chars, _mm_set1_epi8( '/' ) );
+
+            __m128i valid = _mm_or_si128( _mm_or_si128( upper, lower ), _mm_or_si128( _mm_or_si128( digit, plus ), slash ) );
+            if( _mm_movemask_epi8( valid ) != 0xffff ) {
+                return false;
+            }
+
+            __m128i shift = _mm_or_si128( _mm_and_si128( upper, _mm_set1_epi8( -65 ) ), _mm_and_si128( lower, _mm_set1_epi8( -71 ) ) );
+            shift  = _mm_or_si128( shift, _mm_and_si128( digit, _mm_set1_epi8( 4 ) ) );
+            shift  = _mm_or_si128( shift, _mm_and_si128( plus, _mm_set1_epi8( 19 ) ) );
+            shift  = _mm_or_si128( shift, _mm_and_si128( slash, _mm_set1_epi8( 16 ) ) );
+            values = _mm_add_epi8( chars, shift );
+
+            return true;
+        }
+
+        //! Packs sixteen 6-bit values to twelve bytes stored in the lowest part of a register.
+        static inline __m128i base64DecodePack( __m128i values )
+        {
+            __m128i pairs = _mm_maddubs_epi16( values, _mm_set1_epi32( 0x01400140 ) );
+            __m128i quads = _mm_madd_epi16( pairs, _mm_set1_epi32( 0x00011000 ) );
+            return _mm_shuffle_epi8( quads, _mm_setr_epi8( 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1 ) );
+        }
+    #endif  /*  NIMBLE_SIMD_SSSE3   */
+
+    #if NIMBLE_SIMD_AVX2
+        //! Translates thirty two 6-bit values to Base64 characters.
+        static inline __m256i base64EncodeLookup( __m256i indices )
+        {
+            const __m256i shift = _mm256_setr_epi8( 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0
+                                                  , 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0 );
+
+            __m256i result = _mm256_subs_epu8( indices, _mm256_set1_epi8( 51 ) );
+            __m256i less   = _mm256_cmpgt_epi8( _mm256_set1_epi8( 26 ), indices );
+            result = _mm256_or_si256( result, _mm256_and_si256( less, _mm256_set1_epi8( 13 ) ) );
+
+            return _mm256_add_epi8( _mm256_shuffle_epi8( shift, result ), indices );
+        }
+
+        //! Splits two groups of twelve bytes (one per 128-bit lane) to thirty two 6-bit values.
+        static inline __m256i base64EncodeSplit( __m256i input )
+        {
+            input = _mm256_shuffle_epi8( input, _mm256_setr_epi8( 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10
+                                                                , 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10 ) );
+
+            __m256i ac = _mm256_mulhi_epu16( _mm256_and_si256( input, _mm256_set1_epi32( 0x0fc0fc00 ) ), _mm256_set1_epi32( 0x04000040 ) );
+            __m256i bd = _mm256_mullo_epi16( _mm256_and_si256( input, _mm256_set1_epi32( 0x003f03f0 ) ), _mm256_set1_epi32( 0x01000010 ) );
+
+            return _mm256_or_si256( ac, bd );
+        }
+
+        //! Translates thirty two Base64 characters to 6-bit values, returns false if any of them is not a valid Base64 character.
+        static inline bool base64DecodeLookup( __m256i chars, __m256i& values )
+        {
+            __m256i upper = _mm256_and_si256( _mm256_cmpgt_epi8( chars, _mm256_set1_epi8( 'A' - 1 ) ), _mm256_cmpgt_epi8( _mm256_set1_epi8( 'Z' + 1 ), chars ) );
+            __m256i lower = _mm256_and_si256( _mm256_cmpgt_epi8( chars, _mm256_set1_epi8( 'a' - 1 ) ), _mm256_cmpgt_epi8( _mm256_set1_epi8( 'z' + 1 ), chars ) );
+            __m256i digit = _mm256_and_si256( _mm256_cmpgt_epi8( chars, _mm256_set1_epi8( '0' - 1 ) ), _mm256_cmpgt_epi8( _mm256_set1_epi8( '9' + 1 ), chars ) );
+            __m256i plus  = _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '+' ) );
+            __m256i slash = _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '/' ) );
+
+            __m256i valid = _mm256_or_si256( _mm256_or_si256( upper, lower ), _mm256_or_si256( _mm256_or_si256( digit, plus ), slash ) );
+            if( _mm256_movemask_epi8( valid ) != -1 ) {
+                return false;
+            }
+
+            __m256i shift = _mm256_or_si256( _mm256_and_si256( upper, _mm256_set1_epi8( -65 ) ), _mm256_and_si256( lower, _mm256_set1_epi8( -71 ) ) );
+            shift  = _mm256_or_si256( shift, _mm256_and_si256( digit, _mm256_set1_epi8( 4 ) ) );
+            shift  = _mm256_or_si256( shift, _mm256_and_si256( plus, _mm256_set1_epi8( 19 ) ) );
+            shift  = _mm256_or_si256( shift, _mm256_and_si256( slash, _mm256_set1_epi8( 16 ) ) );
+            values = _mm256_add_epi8( chars, shift );
+
+            return true;
+        }
+
+        //! Packs thirty two 6-bit values to twenty four bytes stored in the lowest part of a register.
+        static inline __m256i base64DecodePack( __m256i values )
+        {
+            __m256i pairs = _mm256_maddubs_epi16( values, _mm256_set1_epi32( 0x01400140 ) );
+            __m256i quads = _mm256_madd_epi16( pairs, _mm256_set1_epi32( 0x00011000 ) );
+            __m256i bytes = _mm256_shuffle_epi8( quads, _mm256_setr_epi8( 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1
+                                                                        , 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1 ) );
+            return _mm256_permutevar8x32_epi32( bytes, _mm256_setr_epi32( 0, 1, 2, 4, 5, 6, 3, 7 ) );
+        }
+    #endif  /*  NIMBLE_SIMD_AVX2    */
+
+    #if NIMBLE_SIMD_SSSE3
+        //! Encodes as many complete input blocks as possible with SIMD instructions and returns the number of consumed bytes.
+        static inline u32 base64EncodeSimd( const u8* input, u32 length, u8* output )
+        {
+            u32 consumed = 0;
+
+        #if NIMBLE_SIMD_AVX2
+            // Each iteration reads 28 bytes, but consumes only 24 of them
+            for( ; length - consumed >= 28; consumed += 24, output += 32 ) {
+                __m256i bytes = _mm256_inserti128_si256( _mm256_castsi128_si256( _mm_loadu_si128( reinterpret_cast<const __m128i*>( input + consumed ) ) )
+                                                       , _mm_loadu_si128( reinterpret_cast<const __m128i*>( input + consumed + 12 ) ), 1 );
+                _mm256_storeu_si256( reinterpret_cast<__m256i*>( output ), base64EncodeLookup( base64EncodeSplit( bytes ) ) );
+            }
+        #endif  /*  NIMBLE_SIMD_AVX2    */
+
+        #if NIMBLE_SIMD_SSSE3
+            // Each iteration reads 16 bytes, but consumes only 12 of them
+            for( ; length - consumed >= 16; consumed += 12, output += 16 ) {
+                __m128i bytes = _mm_loadu_si128( reinterpret_cast<const __m128i*>( input + consumed ) );
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( output ), base64EncodeLookup( base64EncodeSplit( bytes ) ) );
+            }
+        #endif  /*  NIMBLE_SIMD_SSSE3   */
+
+            return consumed;
+        }
+
+        //! Decodes as many complete input blocks as possible with SIMD instructions and returns the number of consumed characters.
+        /*!
+            Stops at the first block that contains a character outside of the Base64 alphabet,
+            so that the scalar code path will handle padding and report errors.
+        */
+        static inline u32 base64DecodeSimd( const u8* input, u32 length, u8* output )
+        {
+            u32 consumed = 0;
+
+        #if NIMBLE_SIMD_AVX2
+            // Each iteration writes 32 bytes, but only 24 of them are valid, so leave enough input to overwrite the rest
+            for( ; length - consumed >= 48; consumed += 32, output += 24 ) {
+                __m256i values;
+                if( !base64DecodeLookup( _mm256_loadu_si256( reinterpret_cast<const __m256i*>( input + consumed ) ), values ) ) {
+                    return consumed;
+                }
+                _mm256_storeu_si256( reinterpret_cast<__m256i*>( output ), base64DecodePack( values ) );
+            }
+        #endif  /*  NIMBLE_SIMD_AVX2    */
+
+        #if NIMBLE_SIMD_SSSE3
+            // Each iteration writes 16 bytes, but only 12 of them are valid, so leave enough input to overwrite the rest
+            for( ; length - consumed >= 24; consumed += 16, output += 12 ) {
+                __m128i values;
+                if( !base64DecodeLookup( _mm_loadu_si128( reinterpret_cast<const __m128i*>( input + consumed ) ), values ) ) {
+                    return consumed;
+                }
+                _mm_storeu_si128( reinterpret_cast<__m128i*>( output ), base64DecodePack( values ) );
+            }
+        #endif  /*  NIMBLE_SIMD_SSSE3   */
+
+            return consumed;
+        }
+    #endif  /*  NIMBLE_SIMD_SSSE3   */
+
     } // namespace Private
 
     //! Base64 encoder and decoder.
     class Base64
     {
     public:
-        
+
+        class Encoder;
+        class Decoder;
+
+        //! Returns the exact number of characters produced by encoding a specified number of bytes.
+        static u32      encodedLength( u32 length );
+
+        //! Returns the maximum number of bytes produced by decoding a specified number of characters.
+        static u32      maxDecodedLength( u32 length );
+
+        //! Returns the exact number of bytes produced by decoding a Base64 input, takes the padding into account.
+        static u32      decodedLength( const u8* input, u32 length );
+
+        //! Encodes an input array of bytes to a caller-provided buffer of encodedLength( length ) bytes and returns the number of written characters.
+        static u32      encode( const u8* input, u32 length, u8* output );
+
+        //! Decodes the Base64 input to a caller-provided buffer of decodedLength( input, length ) bytes.
+        /*!
+            The input may be either padded or not. Returns the number of written bytes
+            or -1 if the input contains invalid characters or has an invalid length.
+        */
+        static s32      decode( const u8* input, u32 length, u8* output );
+
         //! Performs the Base64 encoding of an input array of bytes
-        static String encode( const u8* input, s32 length )
-        {
-            std::string ret;
-            int i = 0;
-            int j = 0;
-            unsigned char char_array_3[3];
-            unsigned char char_array_4[4];
-            
-            while (length--) {
-                char_array_3[i++] = *(input++);
-                if (i == 3) {
-                    char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-                    char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-                    char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-                    char_array_4[3] = char_array_3[2] & 0x3f;
-                    
-                    for(i = 0; (i <4) ; i++)
-                        ret += Private::Base64Chars[char_array_4[i]];
-                    i = 0;
-                }
+        static String   encode( const u8* input, s32 length );
+
+        //! Decodes the Base64-encoded data, stops at the first padding or invalid character.
+        static String   decode( const String& input );
+    };
+
+    //! Streaming Base64 encoder that accepts the input in chunks of arbitrary size.
+    class Base64::Encoder {
+    public:
+
+                        //! Constructs an Encoder instance.
+                        Encoder( void );
+
+        //! Encodes the next chunk of data to a buffer of encodedLength( length + 2 ) bytes and returns the number of written characters.
+        u32             update( const u8* input, u32 length, u8* output );
+
+        //! Encodes bytes left from previous updates with padding and returns the number of written characters (at most 4).
+        u32             finish( u8* output );
+
+    private:
+
+        u8              m_pending[3];   //!< Bytes that do not form a complete 3-byte group yet.
+        u32             m_count;        //!< The number of pending bytes.
+    };
+
+    //! Streaming Base64 decoder that accepts the input in chunks of arbitrary size.
+    class Base64::Decoder {
+    public:
+
+                        //! Constructs a Decoder instance.
+                        Decoder( void );
+
+        //! Decodes the next chunk of data to a buffer of maxDecodedLength( length + 3 ) bytes and returns the number of written bytes or -1 on error.
+        s32             update( const u8* input, u32 length, u8* output );
+
+        //! Decodes characters left from previous updates as an unpadded tail and returns the number of written bytes (at most 2) or -1 on error.
+        s32             finish( u8* output );
+
+    private:
+
+        u8              m_pending[4];   //!< Characters that do not form a complete 4-character group yet.
+        u32             m_count;        //!< The number of pending characters.
+        bool            m_finished;     //!< Set to true once the padding was decoded, no more input is accepted after that.
+    };
+
+    // ** Base64::encodedLength
+    NIMBLE_INLINE u32 Base64::encodedLength( u32 length )
+    {
+        return ((length + 2) / 3) * 4;
+    }
+
+    // ** Base64::maxDecodedLength
+    NIMBLE_INLINE u32 Base64::maxDecodedLength( u32 length )
+    {
+        return (length / 4) * 3 + ((length % 4) * 3) / 4;
+    }
+
+    // ** Base64::decodedLength
+    NIMBLE_INLINE u32 Base64::decodedLength( const u8* input, u32 length )
+    {
+        if( length && length % 4 == 0 && input[length - 1] == '=' ) {
+            length -= input[length - 2] == '=' ? 2 : 1;
+        }
+
+        return maxDecodedLength( length );
+    }
+
+    // ** Base64::encode
+    inline u32 Base64::encode( const u8* input, u32 length, u8* output )
+    {
+        const u8* table    = Private::Base64EncodeTable;
+    #if NIMBLE_SIMD_SSSE3
+        u32       consumed = Private::base64EncodeSimd( input, length, output );
+    #else
+        u32       consumed = 0;
+    #endif  /*  NIMBLE_SIMD_SSSE3   */
+        u8*       out      = output + (consumed / 3) * 4;
+
+        // Encode the rest of complete 3-byte groups
+        for( ; length - consumed >= 3; consumed += 3, out += 4 ) {
+            u32 group = (input[consumed] << 16) | (input[consumed + 1] << 8) | input[consumed + 2];
+            out[0] = table[(group >> 18) & 0x3f];
+            out[1] = table[(group >> 12) & 0x3f];
+            out[2] = table[(group >>  6) & 0x3f];
+            out[3] = table[(group >>  0) & 0x3f];
+        }
+
+        // Encode the tail with a padding
+        switch( length - consumed ) {
+        case 1: out[0] = table[input[consumed] >> 2];
+                out[1] = table[(input[consumed] & 0x03) << 4];
+                out[2] = '=';
+                out[3] = '=';
+                out += 4;
+                break;
+        case 2: out[0] = table[input[consumed] >> 2];
+                out[1] = table[((input[consumed] & 0x03) << 4) | (input[consumed + 1] >> 4)];
+                out[2] = table[(input[consumed + 1] & 0x0f) << 2];
+                out[3] = '=';
+                out += 4;
+                break;
+        }
+
+        return static_cast<u32>( out - output );
+    }
+
+    // ** Base64::decode
+    inline s32 Base64::decode( const u8* input, u32 length, u8* output )
+    {
+        const u8* table = Private::Base64DecodeTable;
+
+        // Strip the padding
+        if( length && length % 4 == 0 && input[length - 1] == '=' ) {
+            length -= input[length - 2] == '=' ? 2 : 1;
+        }
+
+        // A single character can't encode a complete byte
+        if( length % 4 == 1 ) {
+            return -1;
+        }
+
+    #if NIMBLE_SIMD_SSSE3
+        u32 consumed = Private::base64DecodeSimd( input, length, output );
+    #else
+        u32 consumed = 0;
+    #endif  /*  NIMBLE_SIMD_SSSE3   */
+        u8* out      = output + (consumed / 4) * 3;
+
+        // Decode the rest of complete 4-character groups
+        for( ; length - consumed >= 4; consumed += 4, out += 3 ) {
+            u32 a = table[input[consumed + 0]];
+            u32 b = table[input[consumed + 1]];
+            u32 c = table[input[consumed + 2]];
+            u32 d = table[input[consumed + 3]];
+
+            if( (a | b | c | d) & 0xc0 ) {
+                return -1;
             }
-            
-            if (i)
-            {
-                for(j = i; j < 3; j++)
-                    char_array_3[j] = '\0';
-                
-                char_array_4[0] = (char_array_3[0] & 0xfc) >> 2;
-                char_array_4[1] = ((char_array_3[0] & 0x03) << 4) + ((char_array_3[1] & 0xf0) >> 4);
-                char_array_4[2] = ((char_array_3[1] & 0x0f) << 2) + ((char_array_3[2] & 0xc0) >> 6);
-                char_array_4[3] = char_array_3[2] & 0x3f;
-                
-                for (j = 0; (j < i + 1); j++)
-                    ret += Private::Base64Chars[char_array_4[j]];
-                
-                while((i++ < 3))
-                    ret += '=';
-            }
-            
-            return ret;
+
+            u32 group = (a << 18) | (b << 12) | (c << 6) | d;
+            out[0] = static_cast<u8>( group >> 16 );
+            out[1] = static_cast<u8>( group >>  8 );
+            out[2] = static_cast<u8>( group >>  0 );
         }
-        
-        //! Decodes the Base64-encoded data
-        static String decode( const String& input )
-        {
-            size_t in_len = input.size();
-            int i = 0;
-            int j = 0;
-            int in_ = 0;
-            unsigned char char_array_4[4], char_array_3[3];
-            std::string ret;
-            
-            while (in_len-- && ( input[in_] != '=') && Private::isBase64(input[in_])) {
-                char_array_4[i++] = input[in_]; in_++;
-                if (i ==4) {
-                    for (i = 0; i <4; i++)
-                        char_array_4[i] = static_cast<u8>(Private::Base64Chars.find(char_array_4[i]));
-                    
-                    char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-                    char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-                    char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-                    
-                    for (i = 0; (i < 3); i++)
-                        ret += char_array_3[i];
-                    i = 0;
-                }
+
+        // Decode the unpadded tail of 2 or 3 characters
+        if( u32 tail = length - consumed ) {
+            u32 a = table[input[consumed + 0]];
+            u32 b = table[input[consumed + 1]];
+            u32 c = tail == 3 ? table[input[consumed + 2]] : 0;
+
+            if( (a | b | c) & 0xc0 ) {
+                return -1;
+            }
+
+            u32 group = (a << 18) | (b << 12) | (c << 6);
+            *out++ = static_cast<u8>( group >> 16 );
+
+            if( tail == 3 ) {
+                *out++ = static_cast<u8>( group >> 8 );
             }
-            
-            if (i) {
-                for (j = i; j <4; j++)
-                    char_array_4[j] = 0;
-                
-                for (j = 0; j <4; j++)
-                    char_array_4[j] = static_cast<u8>(Private::Base64Chars.find(char_array_4[j]));
-                
-                char_array_3[0] = (char_array_4[0] << 2) + ((char_array_4[1] & 0x30) >> 4);
-                char_array_3[1] = ((char_array_4[1] & 0xf) << 4) + ((char_array_4[2] & 0x3c) >> 2);
-                char_array_3[2] = ((char_array_4[2] & 0x3) << 6) + char_array_4[3];
-                
-                for (j = 0; (j < i - 1); j++) ret += char_array_3[j];
-            }
-            
-            return ret;
         }
-    };
+
+        return static_cast<s32>( out - output );
+    }
+
+    // ** Base64::encode
+    inline String Base64::encode( const u8* input, s32 length )
+    {
+        String result;
+        result.resize( encodedLength( length ) );
+
+        if( length > 0 ) {
+            encode( input, static_cast<u32>( length ), reinterpret_cast<u8*>( &result[0] ) );
+        }
+
+        return result;
+    }
+
+    // ** Base64::decode
+    inline String Base64::decode( const String& input )
+    {
+        const u8* chars  = reinterpret_cast<const u8*>( input.c_str() );
+        u32       length = 0;
+
+        // Find the first padding or invalid character
+        while( length < input.size() && Private::Base64DecodeTable[chars[length]] != 0xff ) {
+            length++;
+        }
+
+        // Skip the dangling character that does not encode a complete byte
+        if( length % 4 == 1 ) {
+            length--;
+        }
+
+        String result;
+        result.resize( maxDecodedLength( length ) );
+
+        if( length ) {
+            decode( chars, length, reinterpret_cast<u8*>( &result[0] ) );
+        }
+
+        return result;
+    }
+
+    // ** Base64::Encoder::Encoder
+    NIMBLE_INLINE Base64::Encoder::Encoder( void )
+        : m_count( 0 )
+    {
+    }
+
+    // ** Base64::Encoder::update
+    inline u32 Base64::Encoder::update( const u8* input, u32 length, u8* output )
+    {
+        u32 written = 0;
+
+        // Complete the pending group first
+        if( m_count ) {
+            while( m_count < 3 && length ) {
+                m_pending[m_count++] = *input++;
+                length--;
+            }
+
+            if( m_count < 3 ) {
+                return 0;
+            }
+
+            written += Base64::encode( m_pending, 3, output );
+            m_count  = 0;
+        }
+
+        // Encode all complete groups directly from the input
+        u32 complete = length - length % 3;
+        written += Base64::encode( input, complete, output + written );
+
+        // Save the rest for the next update
+        for( u32 i = complete; i < length; i++ ) {
+            m_pending[m_count++] = input[i];
+        }
+
+        return written;
+    }
+
+    // ** Base64::Encoder::finish
+    inline u32 Base64::Encoder::finish( u8* output )
+    {
+        u32 written = Base64::encode( m_pending, m_count, output );
+        m_count = 0;
+        return written;
+    }
+
+    // ** Base64::Decoder::Decoder
+    NIMBLE_INLINE Base64::Decoder::Decoder( void )
+        : m_count( 0 )
+        , m_finished( false )
+    {
+    }
+
+    // ** Base64::Decoder::update
+    inline s32 Base64::Decoder::update( const u8* input, u32 length, u8* output )
+    {
+        if( length == 0 ) {
+            return 0;
+        }
+
+        // No more data is expected after the padding
+        if( m_finished ) {
+            return -1;
+        }
+
+        s32 written = 0;
+
+        // Complete the pending group first
+        if( m_count ) {
+            while( m_count < 4 && length ) {
+                m_pending[m_count++] = *input++;
+                length--;
+            }
+
+            if( m_count < 4 ) {
+                return 0;
+            }
+
+            written = Base64::decode( m_pending, 4, output );
+            m_count = 0;
+
+            if( written < 0 ) {
+                return -1;
+            }
+
+            m_finished = written < 3;
+        }
+
+        // Decode all complete groups directly from the input
+        u32 complete = length - length % 4;
+
+        if( complete ) {
+            if( m_finished ) {
+                return -1;
+            }
+
+            s32 decoded = Base64::decode( input, complete, output + written );
+
+            if( decoded < 0 ) {
+                return -1;
+            }
+
+            m_finished = static_cast<u32>( decoded ) < (complete / 4) * 3;
+            written   += decoded;
+        }
+
+        // Save the rest for the next update
+        if( complete < length && m_finished ) {
+            return -1;
+        }
+
+        for( u32 i = complete; i < length; i++ ) {
+            m_pending[m_count++] = input[i];
+        }
+
+        return written;
+    }
+
+    // ** Base64::Decoder::finish
+    inline s32 Base64::Decoder::finish( u8* output )
+    {
+        s32 written = m_count ? Base64::decode( m_pending, m_count, output ) : 0;
+        m_count    = 0;
+        m_finished = false;
+        return written;
+    }
 
 NIMBLE_END
 
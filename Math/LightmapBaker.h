@@ -0,0 +1,503 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_LightmapBaker_H__
+#define __Nimble_LightmapBaker_H__
+
+#include "../Globals.h"
+
+NIMBLE_BEGIN
+
+    //! Bakes ambient occlusion and direct lighting of a mesh to texels of a lightmap.
+    /*!
+        Mesh faces are rasterized to a texel grid using a lightmap UV set, produced for example by UvGenerator,
+        and a world space position and a face normal are recorded for each covered texel. A bake then casts rays
+        from each covered texel through a TriangleBvh built over the mesh. A lightmap is split into square tiles,
+        so a parallel bake schedules tiles across cores of a JobSystem. Each texel seeds its own random sequence
+        from a texel index, so a result does not depend on a number of threads or a tile order.
+    */
+    template<typename TMesh>
+    class LightmapBaker {
+    public:
+
+        //! The default size of a square lightmap tile baked by a single job.
+        enum { DefaultTileSize = 16 };
+
+        //! A light source used for a direct lighting bake.
+        struct Light {
+            //! Available light types.
+            enum Type {
+                  Directional   //!< A light with parallel rays, a vector is a light direction.
+                , Point         //!< A light that has a position, a vector is a light position.
+            };
+
+            //! Constructs a directional light.
+            static Light        directional( const Vec3& direction, const Rgb& color );
+
+            //! Constructs a point light, an intensity falls off with a squared distance.
+            static Light        point( const Vec3& position, const Rgb& color );
+
+            Type                type;       //!< A light type.
+            Vec3                vector;     //!< A light direction or position.
+            Rgb                 color;      //!< A light color scaled by an intensity.
+        };
+
+                                //! Constructs a LightmapBaker instance and rasterizes mesh faces to a lightmap of a specified size.
+                                LightmapBaker( const TMesh& mesh, u32 uvLayer, s32 width, s32 height, f32 bias = 0.001f, s32 tileSize = DefaultTileSize );
+
+        //! Returns a lightmap width.
+        s32                     width( void ) const;
+
+        //! Returns a lightmap height.
+        s32                     height( void ) const;
+
+        //! Returns true if a texel is covered by a mesh face.
+        bool                    isCovered( s32 x, s32 y ) const;
+
+        //! Returns the total number of texels covered by mesh faces.
+        s32                     coveredCount( void ) const;
+
+        //! Bakes an ambient occlusion, each covered texel receives a fraction of cosine weighted rays that were not occluded closer than a max distance.
+        void                    bakeAmbientOcclusion( Array<f32>& texels, s32 samples, f32 maxDistance ) const;
+
+        //! Bakes a direct lighting from a set of lights, a light is visible from a texel if a shadow ray is not occluded.
+        void                    bakeDirectLight( Array<Rgb>& texels, const Array<Light>& lights ) const;
+
+    #if NIMBLE_CPP11_ENABLED
+        //! Bakes an ambient occlusion with lightmap tiles scheduled across a job system.
+        void                    bakeAmbientOcclusion( JobSystem& jobs, Array<f32>& texels, s32 samples, f32 maxDistance ) const;
+
+        //! Bakes a direct lighting with lightmap tiles scheduled across a job system.
+        void                    bakeDirectLight( JobSystem& jobs, Array<Rgb>& texels, const Array<Light>& lights ) const;
+    #endif  /*  NIMBLE_CPP11_ENABLED    */
+
+        //! Fills uncovered texels along chart borders with an average of covered neighbours, each iteration grows charts by a single texel.
+        template<typename TValue>
+        void                    dilate( Array<TValue>& texels, s32 iterations ) const;
+
+    private:
+
+        //! A world space sample recorded for a lightmap texel.
+        struct Texel {
+            Vec3                position;   //!< A texel position on a mesh surface.
+            Vec3                normal;     //!< A normal of a face that covers a texel.
+            s32                 face;       //!< A face index, or -1 if a texel is not covered.
+        };
+
+        //! Rasterizes a single mesh face to texels.
+        void                    rasterize( s32 face, const Vec3* positions, const Vec2* uv );
+
+        //! Returns the total number of lightmap tiles.
+        s32                     tileCount( void ) const;
+
+        //! Bakes a range of lightmap tiles with a texel shader.
+        template<typename TValue, typename TShader>
+        void                    bakeTiles( const TShader& shader, TValue* texels, s32 begin, s32 end ) const;
+
+        //! Returns a next random number in [0, 1) and advances a random sequence state.
+        static f32              random( u32& state );
+
+        //! Computes an ambient occlusion of a texel.
+        struct AmbientOcclusion {
+                                //! Constructs an AmbientOcclusion instance.
+                                AmbientOcclusion( const LightmapBaker& baker, s32 samples, f32 maxDistance )
+                                    : baker( baker ), samples( samples ), maxDistance( maxDistance ) {}
+
+            //! Returns a fraction of unoccluded rays cast from a texel.
+            f32                 operator () ( s32 index ) const;
+
+            const LightmapBaker& baker;     //!< A parent lightmap baker.
+            s32                 samples;    //!< The number of rays cast from each texel.
+            f32                 maxDistance;//!< A max distance of an occluder.
+        };
+
+        //! Computes a direct lighting of a texel.
+        struct DirectLight {
+                                //! Constructs a DirectLight instance.
+                                DirectLight( const LightmapBaker& baker, const Array<Light>& lights )
+                                    : baker( baker ), lights( lights ) {}
+
+            //! Returns a sum of visible lights contributions.
+            Rgb                 operator () ( s32 index ) const;
+
+            const LightmapBaker& baker;     //!< A parent lightmap baker.
+            const Array<Light>& lights;     //!< Lights to be baked.
+        };
+
+    private:
+
+        TriangleBvh             m_bvh;          //!< A tree used to cast rays against a mesh.
+        Array<Texel>            m_texels;       //!< Texel samples in a row major order.
+        s32                     m_width;        //!< A lightmap width.
+        s32                     m_height;       //!< A lightmap height.
+        s32                     m_tileSize;     //!< A size of a square tile baked by a single job.
+        f32                     m_bias;         //!< A distance along a normal used to offset ray origins from a surface.
+        s32                     m_coveredCount; //!< The total number of covered texels.
+    };
+
+    // ** LightmapBaker::Light::directional
+    template<typename TMesh>
+    typename LightmapBaker<TMesh>::Light LightmapBaker<TMesh>::Light::directional( const Vec3& direction, const Rgb& color )
+    {
+        Light light;
+        light.type   = Directional;
+        light.vector = Vec3::normalize( direction );
+        light.color  = color;
+        return light;
+    }
+
+    // ** LightmapBaker::Light::point
+    template<typename TMesh>
+    typename LightmapBaker<TMesh>::Light LightmapBaker<TMesh>::Light::point( const Vec3& position, const Rgb& color )
+    {
+        Light light;
+        light.type   = Point;
+        light.vector = position;
+        light.color  = color;
+        return light;
+    }
+
+    // ** LightmapBaker::LightmapBaker
+    template<typename TMesh>
+    LightmapBaker<TMesh>::LightmapBaker( const TMesh& mesh, u32 uvLayer, s32 width, s32 height, f32 bias, s32 tileSize )
+        : m_width( width ), m_height( height ), m_tileSize( max2( tileSize, 1 ) ), m_bias( bias ), m_coveredCount( 0 )
+    {
+        NIMBLE_ABORT_IF( width <= 0 || height <= 0, "invalid lightmap size" );
+
+        m_bvh.build( mesh );
+
+        Texel empty;
+        empty.face = -1;
+        m_texels.resize( width * height, empty );
+
+        const typename TMesh::Vertices& vertices = mesh.vertices();
+        const typename TMesh::Indices&  indices  = mesh.indices();
+
+        for( s32 i = 0, n = mesh.faceCount(); i < n; i++ ) {
+            Vec3 positions[3];
+            Vec2 uv[3];
+
+            for( s32 j = 0; j < 3; j++ ) {
+                const typename TMesh::Vertex& vertex = vertices[indices[i * 3 + j]];
+                positions[j] = vertex.position;
+                uv[j]        = Vec2( vertex.uv[uvLayer].x * width, vertex.uv[uvLayer].y * height );
+            }
+
+            rasterize( i, positions, uv );
+        }
+
+        for( s32 i = 0, n = width * height; i < n; i++ ) {
+            if( m_texels[i].face >= 0 ) {
+                m_coveredCount++;
+            }
+        }
+    }
+
+    // ** LightmapBaker::width
+    template<typename TMesh>
+    s32 LightmapBaker<TMesh>::width( void ) const
+    {
+        return m_width;
+    }
+
+    // ** LightmapBaker::height
+    template<typename TMesh>
+    s32 LightmapBaker<TMesh>::height( void ) const
+    {
+        return m_height;
+    }
+
+    // ** LightmapBaker::isCovered
+    template<typename TMesh>
+    bool LightmapBaker<TMesh>::isCovered( s32 x, s32 y ) const
+    {
+        NIMBLE_BREAK_IF( x < 0 || x >= m_width || y < 0 || y >= m_height );
+        return m_texels[y * m_width + x].face >= 0;
+    }
+
+    // ** LightmapBaker::coveredCount
+    template<typename TMesh>
+    s32 LightmapBaker<TMesh>::coveredCount( void ) const
+    {
+        return m_coveredCount;
+    }
+
+    // ** LightmapBaker::rasterize
+    template<typename TMesh>
+    void LightmapBaker<TMesh>::rasterize( s32 face, const Vec3* positions, const Vec2* uv )
+    {
+        // Twice a signed area of a triangle in texel space
+        f32 area = (uv[1].x - uv[0].x) * (uv[2].y - uv[0].y) - (uv[1].y - uv[0].y) * (uv[2].x - uv[0].x);
+
+        if( fabsf( area ) < 1e-8f ) {
+            return;
+        }
+
+        Vec3 normal = (positions[1] - positions[0]) % (positions[2] - positions[0]);
+        normal.normalize();
+
+        // Texel centers are placed at half integer coordinates
+        s32 x0 = max2( 0,            static_cast<s32>( floorf( min3( uv[0].x, uv[1].x, uv[2].x ) ) ) );
+        s32 y0 = max2( 0,            static_cast<s32>( floorf( min3( uv[0].y, uv[1].y, uv[2].y ) ) ) );
+        s32 x1 = min2( m_width  - 1, static_cast<s32>( floorf( max3( uv[0].x, uv[1].x, uv[2].x ) ) ) );
+        s32 y1 = min2( m_height - 1, static_cast<s32>( floorf( max3( uv[0].y, uv[1].y, uv[2].y ) ) ) );
+
+        f32 inverseArea = 1.0f / area;
+
+        for( s32 y = y0; y <= y1; y++ ) {
+            for( s32 x = x0; x <= x1; x++ ) {
+                f32 px = x + 0.5f;
+                f32 py = y + 0.5f;
+
+                // Barycentric coordinates from edge functions, a small tolerance closes cracks between adjacent faces
+                f32 w0 = ((uv[1].x - px) * (uv[2].y - py) - (uv[1].y - py) * (uv[2].x - px)) * inverseArea;
+                f32 w1 = ((uv[2].x - px) * (uv[0].y - py) - (uv[2].y - py) * (uv[0].x - px)) * inverseArea;
+                f32 w2 = 1.0f - w0 - w1;
+
+                if( w0 < -1e-4f || w1 < -1e-4f || w2 < -1e-4f ) {
+                    continue;
+                }
+
+                Texel& texel   = m_texels[y * m_width + x];
+                texel.position = positions[0] * w0 + positions[1] * w1 + positions[2] * w2;
+                texel.normal   = normal;
+                texel.face     = face;
+            }
+        }
+    }
+
+    // ** LightmapBaker::tileCount
+    template<typename TMesh>
+    s32 LightmapBaker<TMesh>::tileCount( void ) const
+    {
+        s32 columns = (m_width  + m_tileSize - 1) / m_tileSize;
+        s32 rows    = (m_height + m_tileSize - 1) / m_tileSize;
+        return columns * rows;
+    }
+
+    // ** LightmapBaker::bakeTiles
+    template<typename TMesh>
+    template<typename TValue, typename TShader>
+    void LightmapBaker<TMesh>::bakeTiles( const TShader& shader, TValue* texels, s32 begin, s32 end ) const
+    {
+        s32 columns = (m_width + m_tileSize - 1) / m_tileSize;
+
+        for( s32 tile = begin; tile < end; tile++ ) {
+            s32 x0 = (tile % columns) * m_tileSize;
+            s32 y0 = (tile / columns) * m_tileSize;
+            s32 x1 = min2( x0 + m_tileSize, m_width );
+            s32 y1 = min2( y0 + m_tileSize, m_height );
+
+            for( s32 y = y0; y < y1; y++ ) {
+                for( s32 x = x0; x < x1; x++ ) {
+                    s32 index = y * m_width + x;
+                    texels[index] = m_texels[index].face >= 0 ? shader( index ) : TValue();
+                }
+            }
+        }
+    }
+
+    // ** LightmapBaker::bakeAmbientOcclusion
+    template<typename TMesh>
+    void LightmapBaker<TMesh>::bakeAmbientOcclusion( Array<f32>& texels, s32 samples, f32 maxDistance ) const
+    {
+        texels.resize( m_width * m_height );
+        bakeTiles( AmbientOcclusion( *this, samples, maxDistance ), &texels[0], 0, tileCount() );
+    }
+
+    // ** LightmapBaker::bakeDirectLight
+    template<typename TMesh>
+    void LightmapBaker<TMesh>::bakeDirectLight( Array<Rgb>& texels, const Array<Light>& lights ) const
+    {
+        texels.resize( m_width * m_height );
+        bakeTiles( DirectLight( *this, lights ), &texels[0], 0, tileCount() );
+    }
+
+#if NIMBLE_CPP11_ENABLED
+    // ** LightmapBaker::bakeAmbientOcclusion
+    template<typename TMesh>
+    void LightmapBaker<TMesh>::bakeAmbientOcclusion( JobSystem& jobs, Array<f32>& texels, s32 samples, f32 maxDistance ) const
+    {
+        texels.resize( m_width * m_height );
+
+        AmbientOcclusion shader( *this, samples, maxDistance );
+        f32*             output = &texels[0];
+
+        parallelFor( jobs, tileCount(), [&]( s32 begin, s32 end ) {
+            bakeTiles( shader, output, begin, end );
+        }, 1 );
+    }
+
+    // ** LightmapBaker::bakeDirectLight
+    template<typename TMesh>
+    void LightmapBaker<TMesh>::bakeDirectLight( JobSystem& jobs, Array<Rgb>& texels, const Array<Light>& lights ) const
+    {
+        texels.resize( m_width * m_height );
+
+        DirectLight shader( *this, lights );
+        Rgb*        output = &texels[0];
+
+        parallelFor( jobs, tileCount(), [&]( s32 begin, s32 end ) {
+            bakeTiles( shader, output, begin, end );
+        }, 1 );
+    }
+#endif  /*  NIMBLE_CPP11_ENABLED    */
+
+    // ** LightmapBaker::dilate
+    template<typename TMesh>
+    template<typename TValue>
+    void LightmapBaker<TMesh>::dilate( Array<TValue>& texels, s32 iterations ) const
+    {
+        NIMBLE_ABORT_IF( static_cast<s32>( texels.size() ) != m_width * m_height, "texel count does not match a lightmap size" );
+
+        Array<u8> covered;
+        covered.resize( m_width * m_height );
+
+        for( s32 i = 0, n = m_width * m_height; i < n; i++ ) {
+            covered[i] = m_texels[i].face >= 0 ? 1 : 0;
+        }
+
+        // Texels filled by an iteration become sources only for a next one
+        Array<u8> next = covered;
+
+        for( s32 iteration = 0; iteration < iterations; iteration++ ) {
+            bool changed = false;
+
+            for( s32 y = 0; y < m_height; y++ ) {
+                for( s32 x = 0; x < m_width; x++ ) {
+                    s32 index = y * m_width + x;
+
+                    if( covered[index] ) {
+                        continue;
+                    }
+
+                    TValue sum   = TValue();
+                    s32    count = 0;
+
+                    for( s32 dy = max2( y - 1, 0 ); dy <= min2( y + 1, m_height - 1 ); dy++ ) {
+                        for( s32 dx = max2( x - 1, 0 ); dx <= min2( x + 1, m_width - 1 ); dx++ ) {
+                            s32 neighbour = dy * m_width + dx;
+
+                            if( covered[neighbour] ) {
+                                sum = sum + texels[neighbour];
+                                count++;
+                            }
+                        }
+                    }
+
+                    if( count ) {
+                        texels[index] = sum / static_cast<f32>( count );
+                        next[index]   = 1;
+                        changed       = true;
+                    }
+                }
+            }
+
+            if( !changed ) {
+                break;
+            }
+
+            covered = next;
+        }
+    }
+
+    // ** LightmapBaker::random
+    template<typename TMesh>
+    f32 LightmapBaker<TMesh>::random( u32& state )
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return (state >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // ** LightmapBaker::AmbientOcclusion::operator()
+    template<typename TMesh>
+    f32 LightmapBaker<TMesh>::AmbientOcclusion::operator () ( s32 index ) const
+    {
+        const Texel& texel  = baker.m_texels[index];
+        Vec3         origin = texel.position + texel.normal * baker.m_bias;
+
+        StratifiedDirectionSampler sampler( samples );
+        u32                        state = (static_cast<u32>( index ) + 1) * 0x9E3779B1u;
+        s32                        open  = 0;
+
+        for( s32 i = 0; i < samples; i++ ) {
+            f32  r0        = random( state );
+            f32  r1        = random( state );
+            Vec3 direction = sampler.cosineOnHemisphere( texel.normal, r0, r1 );
+
+            if( !baker.m_bvh.occluded( Ray( origin, direction ), maxDistance ) ) {
+                open++;
+            }
+        }
+
+        return samples > 0 ? open / static_cast<f32>( samples ) : 1.0f;
+    }
+
+    // ** LightmapBaker::DirectLight::operator()
+    template<typename TMesh>
+    Rgb LightmapBaker<TMesh>::DirectLight::operator () ( s32 index ) const
+    {
+        const Texel& texel  = baker.m_texels[index];
+        Vec3         origin = texel.position + texel.normal * baker.m_bias;
+        Rgb          result;
+
+        for( s32 i = 0, n = static_cast<s32>( lights.size() ); i < n; i++ ) {
+            const Light& light = lights[i];
+            Vec3         direction;
+            f32          distance;
+            f32          attenuation;
+
+            if( light.type == Light::Directional ) {
+                direction   = -light.vector;
+                distance    = FLT_MAX;
+                attenuation = 1.0f;
+            } else {
+                direction   = light.vector - origin;
+                distance    = direction.length();
+                if( distance <= 0.0f ) {
+                    continue;
+                }
+                direction   = direction / distance;
+                attenuation = 1.0f / (distance * distance);
+            }
+
+            f32 intensity = texel.normal * direction;
+
+            if( intensity <= 0.0f || baker.m_bvh.occluded( Ray( origin, direction ), distance ) ) {
+                continue;
+            }
+
+            result += light.color * (intensity * attenuation);
+        }
+
+        return result;
+    }
+
+NIMBLE_END
+
+#endif  /*  !__Nimble_LightmapBaker_H__  */
@@ -154,7 +154,7 @@ NIMBLE_BEGIN
     template<typename T>
     Vector<T> Matrix<T>::operator * ( const Vector<T>& v ) const
     {
-        NIMBLE_BREAK_IF( m_cols != v.size() );
+        NIMBLE_BREAK_IF( m_cols != ( s32 )v.size() );
         Vector<T> C( v.size() );
 
         for( s32 i = 0; i < m_rows; i++ ) {
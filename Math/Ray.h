@@ -50,6 +50,9 @@ NIMBLE_BEGIN
         //! Returns ray direction.
         const Vec3& direction( void ) const;
 
+        //! Returns a per-component inverse of a ray direction.
+        const Vec3& inverseDirection( void ) const;
+
         //! Returns true if the ray intersects bounding box.
         bool        intersects( const Bounds& bounds ) const;
 
@@ -57,8 +60,23 @@ NIMBLE_BEGIN
         bool        intersects( const Bounds& bounds, Vec3* point, f32* time = NULL ) const;
 
         //! Returns true if the ray intersects bounding box & calculates intersection point.
+        /*!
+            A time is measured in ray direction lengths, a ray that starts inside a box hits it at zero time.
+        */
         bool        intersects( const Bounds& bounds, f32* point, f32* time = NULL ) const;
 
+        //! Returns true if the ray intersects a triangle & calculates intersection time and barycentric coordinates of a hit point.
+        /*!
+            Both triangle sides are hit, a hit point equals v0 + (v1 - v0) * u + (v2 - v0) * v.
+        */
+        bool        intersects( const Vec3& v0, const Vec3& v1, const Vec3& v2, f32* time = NULL, f32* u = NULL, f32* v = NULL ) const;
+
+        //! Returns true if the ray hits a triangle given by a vertex and two edges from it no later than a maximum time.
+        /*!
+            Acceleration structures store triangle edges to skip two subtractions per test, a hit point equals v0 + e1 * u + e2 * v.
+        */
+        bool        intersectsTriangle( const Vec3& v0, const Vec3& e1, const Vec3& e2, f32 maxTime, f32* time = NULL, f32* u = NULL, f32* v = NULL ) const;
+
         //! Returns true if the ray intersects plane & calculates intersection point.
         bool        intersects( const Plane& plane, Vec3* point = NULL, f32* time = NULL ) const;
 
@@ -69,6 +87,7 @@ NIMBLE_BEGIN
 
         Vec3        m_origin;        //!< Ray origin.
         Vec3        m_direction;    //!< Ray direction.
+        Vec3        m_inverseDirection; //!< Inverse ray direction used by slab tests.
     };
 
     // ** Ray::Ray
@@ -80,7 +99,7 @@ NIMBLE_BEGIN
     // ** Ray::Ray
     inline Ray::Ray( const Vec3& origin, const Vec3& direction ) : m_origin( origin ), m_direction( direction )
     {
-    
+        m_inverseDirection = Vec3( 1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z );
     }
 
     // ** Ray::operator *
@@ -103,6 +122,12 @@ NIMBLE_BEGIN
         return m_direction;
     }
 
+    // ** Ray::inverseDirection
+    inline const Vec3& Ray::inverseDirection( void ) const
+    {
+        return m_inverseDirection;
+    }
+
     // ** Ray::intersects
     inline bool Ray::intersects( const Plane& plane, Vec3* point, f32* time ) const
     {
@@ -129,148 +154,78 @@ NIMBLE_BEGIN
     // ** Ray::intersects
     inline bool Ray::intersects( const Bounds& bounds, f32* point, f32* time ) const
     {
-        Vec3 rayDelta = m_direction * 999999.0f;
         const Vec3& min = bounds.min();
         const Vec3& max = bounds.max();
 
-        bool inside = true;
-        f32 xt, yt, zt;
-
-        if( m_origin.x < min.x) {
-            xt = min.x - m_origin.x;
+        const Vec3& inv = m_inverseDirection;
 
-            if( xt > rayDelta.x ) {
-                return false;
-            }
+        // Intersect a ray with three pairs of parallel planes, a ray hits a box if all slab intervals overlap.
+        // Planes a ray enters and exits each slab through are selected by a direction sign, so a distance is NaN
+        // only when a ray is parallel to a slab and starts on its plane, max2 and min2 skip such a NaN passed first,
+        // so each fold ends with a finite value.
+        f32 x1 = ((inv.x < 0.0f ? max.x : min.x) - m_origin.x) * inv.x, x2 = ((inv.x < 0.0f ? min.x : max.x) - m_origin.x) * inv.x;
+        f32 y1 = ((inv.y < 0.0f ? max.y : min.y) - m_origin.y) * inv.y, y2 = ((inv.y < 0.0f ? min.y : max.y) - m_origin.y) * inv.y;
+        f32 z1 = ((inv.z < 0.0f ? max.z : min.z) - m_origin.z) * inv.z, z2 = ((inv.z < 0.0f ? min.z : max.z) - m_origin.z) * inv.z;
 
-            xt /= rayDelta.x; 
-            inside = false;
-        } 
-        else if( m_origin.x > max.x ) {
-            xt = max.x - m_origin.x;
+        f32 enter = max2( x1, max2( y1, max2( z1, 0.0f ) ) );
+        f32 exit  = min2( x2, min2( y2, min2( z2, FLT_MAX ) ) );
 
-            if( xt < rayDelta.x ) {
-                return false;
-            }
-
-            xt /= rayDelta.x;
-            inside = false;
-        } 
-        else {
-            xt = -1.0f; 
+        if( enter > exit ) {
+            return false;
         }
 
-        if( m_origin.y < min.y ) {
-            yt = min.y - m_origin.y;
-
-            if( yt > rayDelta.y ) {
-                return false;
-            }
-
-            yt /= rayDelta.y;
-            inside = false;
-        } 
-        else if( m_origin.y > max.y ) {
-            yt = max.y - m_origin.y;
-
-            if( yt < rayDelta.y ) {
-                return false;
-            }
-
-            yt /= rayDelta.y;
-            inside = false;
-        } 
-        else {
-            yt = -1.0f;
+        if( point ) {
+            point[0] = m_origin.x + m_direction.x * enter;
+            point[1] = m_origin.y + m_direction.y * enter;
+            point[2] = m_origin.z + m_direction.z * enter;
         }
+        if( time ) *time = enter;
 
-        if( m_origin.z < min.z ) {
-            zt = min.z - m_origin.z;
-
-            if( zt > rayDelta.z ) {
-                return false;
-            }
+        return true;
+    }
 
-            zt /= rayDelta.z;
-            inside = false;
-        } 
-        else if( m_origin.z > max.z ) {
-            zt = max.z - m_origin.z;
+    // ** Ray::intersects
+    inline bool Ray::intersects( const Vec3& v0, const Vec3& v1, const Vec3& v2, f32* time, f32* u, f32* v ) const
+    {
+        return intersectsTriangle( v0, v1 - v0, v2 - v0, FLT_MAX, time, u, v );
+    }
 
-            if( zt < rayDelta.z ) {
-                return false;
-            }
+    // ** Ray::intersectsTriangle
+    inline bool Ray::intersectsTriangle( const Vec3& v0, const Vec3& e1, const Vec3& e2, f32 maxTime, f32* time, f32* u, f32* v ) const
+    {
+        // Moller-Trumbore intersection, barycentric coordinates are found with Cramer's rule
+        Vec3 p   = m_direction % e2;
+        f32  det = e1 * p;
 
-            zt /= rayDelta.z;
-            inside = false;
-        } 
-        else {
-            zt = -1.0f;
+        // A ray is parallel to a triangle plane
+        if( fabsf( det ) < 1e-12f ) {
+            return false;
         }
 
-        f32 t = xt;
-
-        if( yt > t ) {
-            t = yt;
-        }
+        f32  inv = 1.0f / det;
+        Vec3 s   = m_origin - v0;
+        f32  a   = (s * p) * inv;
 
-        if( zt > t ) {
-            t = zt;
+        if( a < 0.0f || a > 1.0f ) {
+            return false;
         }
 
-        if( inside ) {
-            if( point ) {
-                point[0] = m_origin.x + rayDelta.x * t;
-                point[1] = m_origin.y + rayDelta.y * t;
-                point[2] = m_origin.z + rayDelta.z * t;
-            }
-            if( time )  *time = t;
+        Vec3 q = s % e1;
+        f32  b = (m_direction * q) * inv;
 
-            return true;
+        if( b < 0.0f || a + b > 1.0f ) {
+            return false;
         }
 
-        if( t == xt ) {
-            f32 y = m_origin.y + rayDelta.y * t;
-            f32 z = m_origin.z + rayDelta.z * t;
+        f32 t = (e2 * q) * inv;
 
-            if( y < min.y || y > max.y ) {
-                return false;
-            }
-            else if( z < min.z || z > max.z ) {
-                return false;
-            }
-        }
-        else if( t == yt ) {
-            f32 x = m_origin.x + rayDelta.x * t;
-            f32 z = m_origin.z + rayDelta.z * t;
-
-            if( x < min.x || x > max.x ) {
-                return false;
-            }
-            else if( z < min.z || z > max.z ) {
-                return false;
-            }
-        }
-        else {
-            //    _ASSERTE( t == zt );
-
-            f32 x = m_origin.x + rayDelta.x * t;
-            f32 y = m_origin.y + rayDelta.y * t;
-
-            if( x < min.x || x > max.x ) {
-                return false;
-            }
-            else if( y < min.y || y > max.y ) {
-                return false;
-            }
+        if( t <= 0.0f || t > maxTime ) {
+            return false;
         }
 
-        if( point ) {
-            point[0] = m_origin.x + rayDelta.x * t;
-            point[1] = m_origin.y + rayDelta.y * t;
-            point[2] = m_origin.z + rayDelta.z * t;
-        }
         if( time ) *time = t;
+        if( u )    *u    = a;
+        if( v )    *v    = b;
 
         return true;
     }
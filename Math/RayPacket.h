@@ -0,0 +1,369 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_RayPacket_H__
+#define __Nimble_RayPacket_H__
+
+#include "../Globals.h"
+
+NIMBLE_BEGIN
+
+    //! A packet of up to eight rays stored as a structure of arrays and tested against a single primitive at once.
+    /*!
+        Rays are tested with a single AVX2 instruction stream, two SSE2 ones or scalar code depending on
+        enabled instruction sets. Each test returns a bit mask of rays that hit a primitive closer than
+        their maximum times, so closest hits are found by lowering maximum times of hit rays. Arrays that
+        receive per-ray results should have room for MaxRays values.
+    */
+    class RayPacket {
+    public:
+
+        //! The maximum number of rays in a packet.
+        enum { MaxRays = 8 };
+
+                    //! Constructs an empty RayPacket instance.
+                    RayPacket( void );
+
+                    //! Constructs RayPacket instance from an array of rays.
+                    RayPacket( const Ray* rays, s32 count, f32 maxTime = FLT_MAX );
+
+        //! Appends a ray to a packet and returns its index.
+        s32         add( const Ray& ray, f32 maxTime = FLT_MAX );
+
+        //! Removes all rays from a packet.
+        void        clear( void );
+
+        //! Returns the number of rays in a packet.
+        s32         count( void ) const;
+
+        //! Returns the maximum hit time of a ray.
+        f32         maxTime( s32 index ) const;
+
+        //! Sets the maximum hit time of a ray.
+        void        setMaxTime( s32 index, f32 value );
+
+        //! Tests all rays against a bounding box and returns a mask of hit rays, entry times are written to an optional array.
+        u32         intersects( const Bounds& bounds, f32* times = NULL ) const;
+
+        //! Tests all rays against a triangle and returns a mask of hit rays, hit times and barycentric coordinates are written to optional arrays.
+        u32         intersects( const Vec3& v0, const Vec3& v1, const Vec3& v2, f32* times = NULL, f32* u = NULL, f32* v = NULL ) const;
+
+    private:
+
+        //! Returns a mask of rays inside a packet.
+        u32         activeMask( void ) const;
+
+    private:
+
+        f32         m_originX[MaxRays];     //!< Ray origin X coordinates.
+        f32         m_originY[MaxRays];     //!< Ray origin Y coordinates.
+        f32         m_originZ[MaxRays];     //!< Ray origin Z coordinates.
+        f32         m_directionX[MaxRays];  //!< Ray direction X coordinates.
+        f32         m_directionY[MaxRays];  //!< Ray direction Y coordinates.
+        f32         m_directionZ[MaxRays];  //!< Ray direction Z coordinates.
+        f32         m_inverseX[MaxRays];    //!< Inverse ray direction X coordinates.
+        f32         m_inverseY[MaxRays];    //!< Inverse ray direction Y coordinates.
+        f32         m_inverseZ[MaxRays];    //!< Inverse ray direction Z coordinates.
+        f32         m_maxTime[MaxRays];     //!< The maximum hit time of each ray.
+        s32         m_count;                //!< The number of rays inside a packet.
+    };
+
+    // ** RayPacket::RayPacket
+    inline RayPacket::RayPacket( void )
+    {
+        clear();
+    }
+
+    // ** RayPacket::RayPacket
+    inline RayPacket::RayPacket( const Ray* rays, s32 count, f32 maxTime )
+    {
+        clear();
+
+        for( s32 i = 0; i < count; i++ ) {
+            add( rays[i], maxTime );
+        }
+    }
+
+    // ** RayPacket::clear
+    inline void RayPacket::clear( void )
+    {
+        // Unused lanes are still processed by SIMD code, so they are kept initialized
+        for( s32 i = 0; i < MaxRays; i++ ) {
+            m_originX[i]    = m_originY[i]    = m_originZ[i]    = 0.0f;
+            m_directionX[i] = m_directionY[i] = m_directionZ[i] = 0.0f;
+            m_inverseX[i]   = m_inverseY[i]   = m_inverseZ[i]   = 0.0f;
+            m_maxTime[i]    = 0.0f;
+        }
+
+        m_count = 0;
+    }
+
+    // ** RayPacket::add
+    inline s32 RayPacket::add( const Ray& ray, f32 maxTime )
+    {
+        NIMBLE_ABORT_IF( m_count >= MaxRays, "ray packet is full" );
+
+        s32 index = m_count++;
+
+        m_originX[index]    = ray.origin().x;
+        m_originY[index]    = ray.origin().y;
+        m_originZ[index]    = ray.origin().z;
+        m_directionX[index] = ray.direction().x;
+        m_directionY[index] = ray.direction().y;
+        m_directionZ[index] = ray.direction().z;
+        m_inverseX[index]   = ray.inverseDirection().x;
+        m_inverseY[index]   = ray.inverseDirection().y;
+        m_inverseZ[index]   = ray.inverseDirection().z;
+        m_maxTime[index]    = maxTime;
+
+        return index;
+    }
+
+    // ** RayPacket::count
+    inline s32 RayPacket::count( void ) const
+    {
+        return m_count;
+    }
+
+    // ** RayPacket::maxTime
+    inline f32 RayPacket::maxTime( s32 index ) const
+    {
+        NIMBLE_ABORT_IF( index < 0 || index >= m_count, "index is out of range" );
+        return m_maxTime[index];
+    }
+
+    // ** RayPacket::setMaxTime
+    inline void RayPacket::setMaxTime( s32 index, f32 value )
+    {
+        NIMBLE_ABORT_IF( index < 0 || index >= m_count, "index is out of range" );
+        m_maxTime[index] = value;
+    }
+
+    // ** RayPacket::activeMask
+    inline u32 RayPacket::activeMask( void ) const
+    {
+        return (1u << m_count) - 1;
+    }
+
+    // ** RayPacket::intersects
+    inline u32 RayPacket::intersects( const Bounds& bounds, f32* times ) const
+    {
+        const Vec3& min  = bounds.min();
+        const Vec3& max  = bounds.max();
+        u32         mask = 0;
+        s32         i    = 0;
+
+        // Entry and exit planes of each slab are selected by a direction sign, so a distance is NaN only when a ray
+        // is parallel to a slab and starts on its plane. Such NaN is always passed as a first argument to min and max,
+        // which return a second one in this case, so the slab is skipped instead of poisoning an interval.
+    #if defined( NIMBLE_SIMD_AVX2 )
+        {
+            __m256 ix    = _mm256_loadu_ps( m_inverseX );
+            __m256 iy    = _mm256_loadu_ps( m_inverseY );
+            __m256 iz    = _mm256_loadu_ps( m_inverseZ );
+            __m256 minX  = _mm256_set1_ps( min.x ), maxX = _mm256_set1_ps( max.x );
+            __m256 minY  = _mm256_set1_ps( min.y ), maxY = _mm256_set1_ps( max.y );
+            __m256 minZ  = _mm256_set1_ps( min.z ), maxZ = _mm256_set1_ps( max.z );
+            __m256 x1    = _mm256_mul_ps( _mm256_sub_ps( _mm256_blendv_ps( minX, maxX, ix ), _mm256_loadu_ps( m_originX ) ), ix );
+            __m256 x2    = _mm256_mul_ps( _mm256_sub_ps( _mm256_blendv_ps( maxX, minX, ix ), _mm256_loadu_ps( m_originX ) ), ix );
+            __m256 y1    = _mm256_mul_ps( _mm256_sub_ps( _mm256_blendv_ps( minY, maxY, iy ), _mm256_loadu_ps( m_originY ) ), iy );
+            __m256 y2    = _mm256_mul_ps( _mm256_sub_ps( _mm256_blendv_ps( maxY, minY, iy ), _mm256_loadu_ps( m_originY ) ), iy );
+            __m256 z1    = _mm256_mul_ps( _mm256_sub_ps( _mm256_blendv_ps( minZ, maxZ, iz ), _mm256_loadu_ps( m_originZ ) ), iz );
+            __m256 z2    = _mm256_mul_ps( _mm256_sub_ps( _mm256_blendv_ps( maxZ, minZ, iz ), _mm256_loadu_ps( m_originZ ) ), iz );
+            __m256 enter = _mm256_max_ps( x1, _mm256_max_ps( y1, _mm256_max_ps( z1, _mm256_setzero_ps() ) ) );
+            __m256 exit  = _mm256_min_ps( x2, _mm256_min_ps( y2, _mm256_min_ps( z2, _mm256_loadu_ps( m_maxTime ) ) ) );
+
+            if( times ) {
+                _mm256_storeu_ps( times, enter );
+            }
+
+            mask = static_cast<u32>( _mm256_movemask_ps( _mm256_cmp_ps( enter, exit, _CMP_LE_OQ ) ) );
+            i    = MaxRays;
+        }
+    #endif  /*  NIMBLE_SIMD_AVX2    */
+
+    #if defined( NIMBLE_SIMD_SSE2 )
+        for( ; i < MaxRays; i += 4 ) {
+            __m128 ix    = _mm_loadu_ps( m_inverseX + i );
+            __m128 iy    = _mm_loadu_ps( m_inverseY + i );
+            __m128 iz    = _mm_loadu_ps( m_inverseZ + i );
+            __m128 sx    = _mm_cmplt_ps( ix, _mm_setzero_ps() );
+            __m128 sy    = _mm_cmplt_ps( iy, _mm_setzero_ps() );
+            __m128 sz    = _mm_cmplt_ps( iz, _mm_setzero_ps() );
+            __m128 minX  = _mm_set1_ps( min.x ), maxX = _mm_set1_ps( max.x );
+            __m128 minY  = _mm_set1_ps( min.y ), maxY = _mm_set1_ps( max.y );
+            __m128 minZ  = _mm_set1_ps( min.z ), maxZ = _mm_set1_ps( max.z );
+            __m128 x1    = _mm_mul_ps( _mm_sub_ps( _mm_or_ps( _mm_and_ps( sx, maxX ), _mm_andnot_ps( sx, minX ) ), _mm_loadu_ps( m_originX + i ) ), ix );
+            __m128 x2    = _mm_mul_ps( _mm_sub_ps( _mm_or_ps( _mm_and_ps( sx, minX ), _mm_andnot_ps( sx, maxX ) ), _mm_loadu_ps( m_originX + i ) ), ix );
+            __m128 y1    = _mm_mul_ps( _mm_sub_ps( _mm_or_ps( _mm_and_ps( sy, maxY ), _mm_andnot_ps( sy, minY ) ), _mm_loadu_ps( m_originY + i ) ), iy );
+            __m128 y2    = _mm_mul_ps( _mm_sub_ps( _mm_or_ps( _mm_and_ps( sy, minY ), _mm_andnot_ps( sy, maxY ) ), _mm_loadu_ps( m_originY + i ) ), iy );
+            __m128 z1    = _mm_mul_ps( _mm_sub_ps( _mm_or_ps( _mm_and_ps( sz, maxZ ), _mm_andnot_ps( sz, minZ ) ), _mm_loadu_ps( m_originZ + i ) ), iz );
+            __m128 z2    = _mm_mul_ps( _mm_sub_ps( _mm_or_ps( _mm_and_ps( sz, minZ ), _mm_andnot_ps( sz, maxZ ) ), _mm_loadu_ps( m_originZ + i ) ), iz );
+            __m128 enter = _mm_max_ps( x1, _mm_max_ps( y1, _mm_max_ps( z1, _mm_setzero_ps() ) ) );
+            __m128 exit  = _mm_min_ps( x2, _mm_min_ps( y2, _mm_min_ps( z2, _mm_loadu_ps( m_maxTime + i ) ) ) );
+
+            if( times ) {
+                _mm_storeu_ps( times + i, enter );
+            }
+
+            mask |= static_cast<u32>( _mm_movemask_ps( _mm_cmple_ps( enter, exit ) ) ) << i;
+        }
+    #endif  /*  NIMBLE_SIMD_SSE2    */
+
+        for( ; i < MaxRays; i++ ) {
+            f32 ix = m_inverseX[i], iy = m_inverseY[i], iz = m_inverseZ[i];
+
+            f32 x1 = ((ix < 0.0f ? max.x : min.x) - m_originX[i]) * ix, x2 = ((ix < 0.0f ? min.x : max.x) - m_originX[i]) * ix;
+            f32 y1 = ((iy < 0.0f ? max.y : min.y) - m_originY[i]) * iy, y2 = ((iy < 0.0f ? min.y : max.y) - m_originY[i]) * iy;
+            f32 z1 = ((iz < 0.0f ? max.z : min.z) - m_originZ[i]) * iz, z2 = ((iz < 0.0f ? min.z : max.z) - m_originZ[i]) * iz;
+
+            f32 enter = max2( x1, max2( y1, max2( z1, 0.0f ) ) );
+            f32 exit  = min2( x2, min2( y2, min2( z2, m_maxTime[i] ) ) );
+
+            if( times ) {
+                times[i] = enter;
+            }
+
+            mask |= static_cast<u32>( enter <= exit ) << i;
+        }
+
+        return mask & activeMask();
+    }
+
+    // ** RayPacket::intersects
+    inline u32 RayPacket::intersects( const Vec3& v0, const Vec3& v1, const Vec3& v2, f32* times, f32* u, f32* v ) const
+    {
+        // Triangle edges are shared by all rays, Moller-Trumbore is evaluated for each ray in parallel
+        Vec3 e1   = v1 - v0;
+        Vec3 e2   = v2 - v0;
+        u32  mask = 0;
+        s32  i    = 0;
+
+    #if defined( NIMBLE_SIMD_AVX2 )
+        {
+            __m256 dx = _mm256_loadu_ps( m_directionX ), dy = _mm256_loadu_ps( m_directionY ), dz = _mm256_loadu_ps( m_directionZ );
+            __m256 sx = _mm256_sub_ps( _mm256_loadu_ps( m_originX ), _mm256_set1_ps( v0.x ) );
+            __m256 sy = _mm256_sub_ps( _mm256_loadu_ps( m_originY ), _mm256_set1_ps( v0.y ) );
+            __m256 sz = _mm256_sub_ps( _mm256_loadu_ps( m_originZ ), _mm256_set1_ps( v0.z ) );
+            __m256 e1x = _mm256_set1_ps( e1.x ), e1y = _mm256_set1_ps( e1.y ), e1z = _mm256_set1_ps( e1.z );
+            __m256 e2x = _mm256_set1_ps( e2.x ), e2y = _mm256_set1_ps( e2.y ), e2z = _mm256_set1_ps( e2.z );
+
+            // p = d x e2, q = s x e1
+            __m256 px  = _mm256_sub_ps( _mm256_mul_ps( dy, e2z ), _mm256_mul_ps( dz, e2y ) );
+            __m256 py  = _mm256_sub_ps( _mm256_mul_ps( dz, e2x ), _mm256_mul_ps( dx, e2z ) );
+            __m256 pz  = _mm256_sub_ps( _mm256_mul_ps( dx, e2y ), _mm256_mul_ps( dy, e2x ) );
+            __m256 qx  = _mm256_sub_ps( _mm256_mul_ps( sy, e1z ), _mm256_mul_ps( sz, e1y ) );
+            __m256 qy  = _mm256_sub_ps( _mm256_mul_ps( sz, e1x ), _mm256_mul_ps( sx, e1z ) );
+            __m256 qz  = _mm256_sub_ps( _mm256_mul_ps( sx, e1y ), _mm256_mul_ps( sy, e1x ) );
+
+            __m256 det = _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( e1x, px ), _mm256_mul_ps( e1y, py ) ), _mm256_mul_ps( e1z, pz ) );
+            __m256 inv = _mm256_div_ps( _mm256_set1_ps( 1.0f ), det );
+            __m256 a   = _mm256_mul_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( sx, px ), _mm256_mul_ps( sy, py ) ), _mm256_mul_ps( sz, pz ) ), inv );
+            __m256 b   = _mm256_mul_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( dx, qx ), _mm256_mul_ps( dy, qy ) ), _mm256_mul_ps( dz, qz ) ), inv );
+            __m256 t   = _mm256_mul_ps( _mm256_add_ps( _mm256_add_ps( _mm256_mul_ps( e2x, qx ), _mm256_mul_ps( e2y, qy ) ), _mm256_mul_ps( e2z, qz ) ), inv );
+
+            __m256 absDet = _mm256_andnot_ps( _mm256_set1_ps( -0.0f ), det );
+            __m256 hit    = _mm256_cmp_ps( absDet, _mm256_set1_ps( 1e-12f ), _CMP_GE_OQ );
+            hit = _mm256_and_ps( hit, _mm256_cmp_ps( a, _mm256_setzero_ps(), _CMP_GE_OQ ) );
+            hit = _mm256_and_ps( hit, _mm256_cmp_ps( b, _mm256_setzero_ps(), _CMP_GE_OQ ) );
+            hit = _mm256_and_ps( hit, _mm256_cmp_ps( _mm256_add_ps( a, b ), _mm256_set1_ps( 1.0f ), _CMP_LE_OQ ) );
+            hit = _mm256_and_ps( hit, _mm256_cmp_ps( t, _mm256_setzero_ps(), _CMP_GT_OQ ) );
+            hit = _mm256_and_ps( hit, _mm256_cmp_ps( t, _mm256_loadu_ps( m_maxTime ), _CMP_LE_OQ ) );
+
+            if( times ) _mm256_storeu_ps( times, t );
+            if( u )     _mm256_storeu_ps( u, a );
+            if( v )     _mm256_storeu_ps( v, b );
+
+            mask = static_cast<u32>( _mm256_movemask_ps( hit ) );
+            i    = MaxRays;
+        }
+    #endif  /*  NIMBLE_SIMD_AVX2    */
+
+    #if defined( NIMBLE_SIMD_SSE2 )
+        for( ; i < MaxRays; i += 4 ) {
+            __m128 dx = _mm_loadu_ps( m_directionX + i ), dy = _mm_loadu_ps( m_directionY + i ), dz = _mm_loadu_ps( m_directionZ + i );
+            __m128 sx = _mm_sub_ps( _mm_loadu_ps( m_originX + i ), _mm_set1_ps( v0.x ) );
+            __m128 sy = _mm_sub_ps( _mm_loadu_ps( m_originY + i ), _mm_set1_ps( v0.y ) );
+            __m128 sz = _mm_sub_ps( _mm_loadu_ps( m_originZ + i ), _mm_set1_ps( v0.z ) );
+            __m128 e1x = _mm_set1_ps( e1.x ), e1y = _mm_set1_ps( e1.y ), e1z = _mm_set1_ps( e1.z );
+            __m128 e2x = _mm_set1_ps( e2.x ), e2y = _mm_set1_ps( e2.y ), e2z = _mm_set1_ps( e2.z );
+
+            // p = d x e2, q = s x e1
+            __m128 px  = _mm_sub_ps( _mm_mul_ps( dy, e2z ), _mm_mul_ps( dz, e2y ) );
+            __m128 py  = _mm_sub_ps( _mm_mul_ps( dz, e2x ), _mm_mul_ps( dx, e2z ) );
+            __m128 pz  = _mm_sub_ps( _mm_mul_ps( dx, e2y ), _mm_mul_ps( dy, e2x ) );
+            __m128 qx  = _mm_sub_ps( _mm_mul_ps( sy, e1z ), _mm_mul_ps( sz, e1y ) );
+            __m128 qy  = _mm_sub_ps( _mm_mul_ps( sz, e1x ), _mm_mul_ps( sx, e1z ) );
+            __m128 qz  = _mm_sub_ps( _mm_mul_ps( sx, e1y ), _mm_mul_ps( sy, e1x ) );
+
+            __m128 det = _mm_add_ps( _mm_add_ps( _mm_mul_ps( e1x, px ), _mm_mul_ps( e1y, py ) ), _mm_mul_ps( e1z, pz ) );
+            __m128 inv = _mm_div_ps( _mm_set1_ps( 1.0f ), det );
+            __m128 a   = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( sx, px ), _mm_mul_ps( sy, py ) ), _mm_mul_ps( sz, pz ) ), inv );
+            __m128 b   = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( dx, qx ), _mm_mul_ps( dy, qy ) ), _mm_mul_ps( dz, qz ) ), inv );
+            __m128 t   = _mm_mul_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( e2x, qx ), _mm_mul_ps( e2y, qy ) ), _mm_mul_ps( e2z, qz ) ), inv );
+
+            __m128 absDet = _mm_andnot_ps( _mm_set1_ps( -0.0f ), det );
+            __m128 hit    = _mm_cmpge_ps( absDet, _mm_set1_ps( 1e-12f ) );
+            hit = _mm_and_ps( hit, _mm_cmpge_ps( a, _mm_setzero_ps() ) );
+            hit = _mm_and_ps( hit, _mm_cmpge_ps( b, _mm_setzero_ps() ) );
+            hit = _mm_and_ps( hit, _mm_cmple_ps( _mm_add_ps( a, b ), _mm_set1_ps( 1.0f ) ) );
+            hit = _mm_and_ps( hit, _mm_cmpgt_ps( t, _mm_setzero_ps() ) );
+            hit = _mm_and_ps( hit, _mm_cmple_ps( t, _mm_loadu_ps( m_maxTime + i ) ) );
+
+            if( times ) _mm_storeu_ps( times + i, t );
+            if( u )     _mm_storeu_ps( u + i, a );
+            if( v )     _mm_storeu_ps( v + i, b );
+
+            mask |= static_cast<u32>( _mm_movemask_ps( hit ) ) << i;
+        }
+    #endif  /*  NIMBLE_SIMD_SSE2    */
+
+        for( ; i < MaxRays; i++ ) {
+            Vec3 direction( m_directionX[i], m_directionY[i], m_directionZ[i] );
+            Vec3 s = Vec3( m_originX[i], m_originY[i], m_originZ[i] ) - v0;
+            Vec3 p = direction % e2;
+            Vec3 q = s % e1;
+
+            f32 det = e1 * p;
+            f32 inv = 1.0f / det;
+            f32 a   = (s * p) * inv;
+            f32 b   = (direction * q) * inv;
+            f32 t   = (e2 * q) * inv;
+
+            if( times ) times[i] = t;
+            if( u )     u[i]     = a;
+            if( v )     v[i]     = b;
+
+            bool hit = fabsf( det ) >= 1e-12f && a >= 0.0f && b >= 0.0f && a + b <= 1.0f && t > 0.0f && t <= m_maxTime[i];
+            mask |= static_cast<u32>( hit ) << i;
+        }
+
+        return mask & activeMask();
+    }
+
+NIMBLE_END
+
+#endif  /*  !__Nimble_RayPacket_H__  */
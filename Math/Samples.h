@@ -29,6 +29,10 @@
 
 #include "../Globals.h"
 
+#if NIMBLE_CPP11_ENABLED
+    #include "../Threading/ParallelAlgorithms.h"
+#endif  /*  NIMBLE_CPP11_ENABLED    */
+
 NIMBLE_BEGIN
 
     //! The sample set.
@@ -60,6 +64,14 @@ NIMBLE_BEGIN
         //! Returns the variance of a sample set.
         T                variance( void ) const;
 
+    #if NIMBLE_CPP11_ENABLED
+        //! Returns the mean value of a sample set, computing it in parallel if needed.
+        T                mean( JobSystem& jobs ) const;
+
+        //! Returns the variance of a sample set, computing it in parallel if needed.
+        T                variance( JobSystem& jobs ) const;
+    #endif  /*  NIMBLE_CPP11_ENABLED    */
+
         //! Creates a new sample set by a subtracting the mean value from each sample.
         Samples<T>        centered( void ) const;
 
@@ -83,7 +95,7 @@ NIMBLE_BEGIN
 
                         //! Constructs State instance.
                         State( void )
-                            : flags( 0 ), mean( 0.0f ), variance( 0.0f ), sdev( 0.0f ) {}
+                            : flags( 0 ), mean( T() ), variance( T() ), sdev( T() ) {}
 
             //! Sets the state flag.
             void        set( u8 mask ) { flags |= mask; }
@@ -172,7 +184,7 @@ NIMBLE_BEGIN
         }
 
         // ** Recompute the mean
-        T sum = 0.0f;
+        T sum = T();
 
         for( u32 i = 0, n = ( u32 )m_samples.size(); i < n; i++ ) {
             sum += at( i );
@@ -206,6 +218,45 @@ NIMBLE_BEGIN
         return m_state.variance;
     }
 
+#if NIMBLE_CPP11_ENABLED
+    // ** Samples::mean
+    template<typename T>
+    T Samples<T>::mean( JobSystem& jobs ) const
+    {
+        if( !m_state.is( State::RecomputeMean ) ) {
+            return m_state.mean;
+        }
+
+        // ** Recompute the mean
+        T sum = parallelSum( jobs, m_samples, T() );
+
+        m_state.mean = sum / size();
+        m_state.reset( State::RecomputeMean );
+
+        return m_state.mean;
+    }
+
+    // ** Samples::variance
+    template<typename T>
+    T Samples<T>::variance( JobSystem& jobs ) const
+    {
+        if( !m_state.is( State::RecomputeVariance ) ) {
+            return m_state.variance;
+        }
+
+        // ** Recompute the variance.
+        T u   = mean( jobs );
+        T sum = parallelReduce( jobs, size(), T()
+                              , [this, u]( s32 begin, s32 end ) { T sum = T(); for( s32 i = begin; i < end; i++ ) { T d = at( i ) - u; sum += d * d; } return sum; }
+                              , []( const T& a, const T& b ) { return a + b; } );
+
+        m_state.variance = sum / size();
+        m_state.reset( State::RecomputeVariance );
+
+        return m_state.variance;
+    }
+#endif  /*  NIMBLE_CPP11_ENABLED    */
+
     // ** Samples::sdev
     template<typename T>
     T Samples<T>::sdev( void ) const
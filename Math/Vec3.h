@@ -403,6 +403,7 @@ NIMBLE_BEGIN
                 {
                     m_count     = ( s32 )sqrtf( ( f32 )samples );
                     m_strata = 1.0f / m_count;
+                    m_columns   = max2( ( s32 )ceilf( sqrtf( ( f32 )samples ) ), 1 );
                 }
 
         //! Generates next sample on sphere.
@@ -431,10 +432,37 @@ NIMBLE_BEGIN
             return ( dir * normal < 0 ) ?  -dir : dir;
         }
 
+        //! Generates next cosine weighted sample on hemisphere, two random numbers in [0, 1) place a sample inside a stratum.
+        /*!
+            Each sample gets its own stratum of an equal area even if the number of samples is not a perfect square:
+            strata are laid out in rows of ceil(sqrt(samples)) cells, and a height of a last incomplete row grows to
+            compensate for the smaller number of cells in it.
+        */
+        Vec3    cosineOnHemisphere( const Vec3& normal, f32 r0, f32 r1 )
+        {
+            s32 cell    = m_index++ % m_samples;
+            s32 row     = cell / m_columns;
+            s32 column  = cell % m_columns;
+            s32 columns = min2( m_columns, m_samples - row * m_columns );
+            f32 u       = (row * m_columns + r0 * columns) / m_samples;
+            f32 v       = (column + r1) / columns;
+
+            f32 radius = sqrtf( u );
+            f32 phi    = 2 * Pi * v;
+
+            // Build a tangent frame around the normal
+            Vec3 tangent = (fabsf( normal.x ) > 0.9f ? Vec3( 0, 1, 0 ) : Vec3( 1, 0, 0 )) % normal;
+            tangent.normalize();
+            Vec3 bitangent = normal % tangent;
+
+            return tangent * (radius * cosf( phi )) + bitangent * (radius * sinf( phi )) + normal * sqrtf( max2( 0.0f, 1.0f - u ) );
+        }
+
         s32        m_samples;    //!< The total number of samples.
         s32        m_index;    //!< Current index.
         s32        m_count;    //!< The square root of samples.
         f32        m_strata;    //!< The strata size.
+        s32        m_columns;   //!< The number of strata in a row of cosine weighted samples.
     };
 
     //! Returns the random 3D vector in specified range.
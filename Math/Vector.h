@@ -76,7 +76,7 @@ NIMBLE_BEGIN
     template<typename T>
     const T& Vector<T>::operator [] ( s32 index ) const
     {
-        NIMBLE_BREAK_IF( index < 0 || index >= size() );
+        NIMBLE_BREAK_IF( index < 0 || index >= ( s32 )size() );
         return m_data[index];
     }
 
@@ -36,6 +36,7 @@
 #include "Pointers/Ptr.h"
 #include "Pointers/WeakPtr.h"
 #include "Pointers/UniquePtr.h"
+#include "Pointers/EpochReclaimer.h"
 
 #include "Templates.h"
 #include "Hash.h"
@@ -49,14 +50,20 @@
 
 #include "Allocators/LinearAllocator.h"
 #include "Allocators/IndexAllocator.h"
+#include "Allocators/SlabAllocator.h"
 
 #include "Containers/Pool.h"
+#include "Containers/ConcurrentPool.h"
 #include "Containers/StringList.h"
+#include "Containers/PagedArray.h"
 #include "Containers/FixedArray.h"
 #include "Containers/IndexCache.h"
 #include "Containers/IndexManager.h"
+#include "Containers/BitmapIndexManager.h"
 #include "Containers/BidHashMap.h"
 #include "Containers/BidMap.h"
+#include "Containers/SpscRingBuffer.h"
+#include "Containers/MpmcQueue.h"
 
 #include "Color/Rgb.h"
 #include "Color/Rgba.h"
@@ -81,9 +88,19 @@
 #include "RectanglePacker.h"
 
 #include "Math/Plane.h"
+#include "Bv/CullingFrustum.h"
 #include "Math/Ray.h"
+#include "Math/RayPacket.h"
+#include "Bv/Bvh.h"
+#include "Bv/LooseOctree.h"
+#include "Bv/HashedGrid.h"
+#include "Bv/SweepAndPrune.h"
+#include "Bv/ConvexHull.h"
+#include "Bv/KdTree.h"
 
 #include "Math/Mesh.h"
+#include "Bv/TriangleBvh.h"
+#include "Math/LightmapBaker.h"
 
 #include "TypeTraits/NumericTraits.h"
 #include "TypeTraits/TypeIndex.h"
@@ -101,7 +118,14 @@
 
 #include "Strings/FixedString.h"
 #include "Strings/StringView.h"
+#include "Strings/NumberConversion.h"
 #include "Strings/FixedStringBuffer.h"
+#include "Strings/StringPool.h"
+#include "Strings/StringSplitter.h"
+
+#include "Threading/WorkStealingDeque.h"
+#include "Threading/JobSystem.h"
+#include "Threading/ParallelAlgorithms.h"
 
 #include "Parser/ExpressionTokenizer.h"
 #include "Parser/ExpressionParser.h"
@@ -123,6 +147,14 @@ namespace std {
         }
     };
 
+    //! Used by std::unordered_map to hash an interned string.
+    template<>
+    struct hash< NIMBLE_NS InternedString > {
+        size_t operator () ( const NIMBLE_NS InternedString& value ) const {
+            return hash<const void*>()( value.entry() );
+        }
+    };
+
     //! Used by std::unordered_map to hash a string.
     template<>
     struct hash< NIMBLE_NS String32 > {
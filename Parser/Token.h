@@ -70,6 +70,12 @@ NIMBLE_BEGIN
         //! Returns token column number.
         s32                     column() const;
         
+        //! Parses the token text as an integer, returns false if the whole text is not an integer.
+        bool                    toInteger(s64& value) const;
+
+        //! Parses the token text as a floating point number, an optional 'f' suffix is ignored.
+        bool                    toDouble(f64& value) const;
+
         //! Returns token type.
         u8                      type() const;
         
@@ -167,6 +173,27 @@ NIMBLE_BEGIN
         return m_column;
     }
 
+    // ** Token::toInteger
+    NIMBLE_INLINE bool Token::toInteger(s64& value) const
+    {
+        s32 consumed = Number::parse(m_text, value);
+        return consumed > 0 && consumed == length();
+    }
+
+    // ** Token::toDouble
+    NIMBLE_INLINE bool Token::toDouble(f64& value) const
+    {
+        s32 consumed = Number::parse(m_text, value);
+
+        if (consumed > 0 && consumed + 1 == length())
+        {
+            s8 suffix = m_text.value()[consumed];
+            return suffix == 'f' || suffix == 'F';
+        }
+
+        return consumed > 0 && consumed == length();
+    }
+
     // ** Token::type
     NIMBLE_INLINE u8 Token::type() const
     {
@@ -0,0 +1,503 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_EpochReclaimer_H__
+#define __Nimble_EpochReclaimer_H__
+
+#include "Ptr.h"
+#include "../Patterns/Singleton.h"
+
+#if NIMBLE_CPP11_ENABLED
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+NIMBLE_BEGIN
+
+    // --------------------------------- EpochReclaimer --------------------------------- //
+
+    //! Epoch-based memory reclamation that lets readers access shared objects without locks.
+    /*!
+        Readers wrap each access to shared data in an EpochGuard, which only publishes the
+        current global epoch to a thread record. Writers replace shared data atomically and
+        retire the old version, which is destroyed once the global epoch has advanced twice
+        since the retirement, so no reader can still see it.
+
+        The epoch advances when every thread inside a critical section has observed the current
+        one. A thread that stays inside a critical section forever blocks the reclamation, so
+        guards should be short lived.
+    */
+    class EpochReclaimer : public Singleton<EpochReclaimer> {
+    public:
+
+        //! A function that destroys a retired object.
+        typedef void            (*Deleter)( void* pointer );
+
+        //! Retired objects are collected once a thread retires this number of objects.
+        enum { CollectThreshold = 64 };
+
+                                //! Constructs an EpochReclaimer instance.
+                                EpochReclaimer( void );
+                                ~EpochReclaimer( void );
+
+        //! Enters a critical section on a calling thread, sections may be nested.
+        void                    enter( void );
+
+        //! Leaves a critical section on a calling thread.
+        void                    leave( void );
+
+        //! Returns true if a calling thread is inside a critical section.
+        bool                    isInside( void );
+
+        //! Retires an object that will be destroyed with a deleter once no reader can access it.
+        void                    retire( void* pointer, Deleter deleter );
+
+        //! Retires an object that will be deleted once no reader can access it.
+        template<typename TValue>
+        void                    retire( TValue* pointer );
+
+        //! Tries to advance the global epoch and destroys retired objects that are safe to destroy.
+        void                    collect( void );
+
+        //! Blocks until all objects retired by a calling thread are destroyed, should not be called inside a critical section.
+        void                    synchronize( void );
+
+        //! Returns the current global epoch.
+        u64                     epoch( void ) const;
+
+    private:
+
+        //! A retired object waiting for destruction.
+        struct Retired {
+            void*               pointer;    //!< Retired object.
+            Deleter             deleter;    //!< A function that destroys an object.
+            u64                 epoch;      //!< The global epoch at the moment of retirement.
+        };
+
+        //! A per-thread record, records are never freed and are reused by new threads.
+        struct Record {
+                                //! Constructs a Record instance.
+                                Record( void )
+                                    : epoch( 0 ), isUsed( true ), depth( 0 ), next( NULL ) {}
+
+            std::atomic<u64>    epoch;      //!< The epoch observed when entering a critical section, zero outside of it.
+            std::atomic<bool>   isUsed;     //!< Set while a record is owned by a thread.
+            s32                 depth;      //!< Critical section nesting depth.
+            Array<Retired>      retired;    //!< Objects retired by an owner thread.
+            Record*             next;       //!< Next record in a list.
+        };
+
+        //! Releases a thread record when a thread exits.
+        struct ThreadRecord {
+                                //! Constructs a ThreadRecord instance.
+                                ThreadRecord( void )
+                                    : record( NULL ) {}
+                                ~ThreadRecord( void );
+
+            Record*             record;     //!< A record owned by a thread.
+        };
+
+        //! Returns a record owned by a calling thread.
+        Record*                 acquireRecord( void );
+
+        //! Moves objects that are still retired to an orphan list and releases a record.
+        void                    releaseRecord( Record* record );
+
+        //! Advances the global epoch if all threads inside a critical section observed the current one and returns the current epoch.
+        u64                     tryAdvance( void );
+
+        //! Destroys retired objects that are safe to destroy at a specified epoch.
+        static void             reclaim( Array<Retired>& retired, u64 epoch );
+
+        //! Moves retired objects that are safe to destroy at a specified epoch to an output array.
+        static void             extract( Array<Retired>& retired, u64 epoch, Array<Retired>& expired );
+
+        //! Destroys expired objects.
+        static void             destroy( const Array<Retired>& expired );
+
+        //! Deletes an object of a specified type.
+        template<typename TValue>
+        static void             deleteObject( void* pointer );
+
+    private:
+
+        std::atomic<u64>        m_epoch;    //!< The global epoch.
+        std::atomic<Record*>    m_records;  //!< A list of thread records.
+        std::mutex              m_mutex;    //!< Guards orphaned objects.
+        Array<Retired>          m_orphans;  //!< Objects retired by threads that have already exited.
+    };
+
+    // ** EpochReclaimer::EpochReclaimer
+    inline EpochReclaimer::EpochReclaimer( void )
+        : m_epoch( 1 )
+        , m_records( NULL )
+    {
+    }
+
+    // ** EpochReclaimer::~EpochReclaimer
+    inline EpochReclaimer::~EpochReclaimer( void )
+    {
+        // No reader can exist at this point, so everything retired is destroyed
+        reclaim( m_orphans, ~0ull );
+
+        for( Record* record = m_records.load(); record; ) {
+            Record* next = record->next;
+            reclaim( record->retired, ~0ull );
+            delete record;
+            record = next;
+        }
+    }
+
+    // ** EpochReclaimer::ThreadRecord::~ThreadRecord
+    inline EpochReclaimer::ThreadRecord::~ThreadRecord( void )
+    {
+        if( record ) {
+            EpochReclaimer::instance().releaseRecord( record );
+        }
+    }
+
+    // ** EpochReclaimer::acquireRecord
+    inline EpochReclaimer::Record* EpochReclaimer::acquireRecord( void )
+    {
+        static thread_local ThreadRecord local;
+
+        if( local.record ) {
+            return local.record;
+        }
+
+        // Reuse a record released by an exited thread
+        for( Record* record = m_records.load( std::memory_order_acquire ); record; record = record->next ) {
+            bool expected = false;
+
+            if( !record->isUsed.load( std::memory_order_relaxed ) && record->isUsed.compare_exchange_strong( expected, true, std::memory_order_acquire ) ) {
+                local.record = record;
+                return record;
+            }
+        }
+
+        // Push a new record to the list
+        Record* record = new Record;
+        Record* head   = m_records.load( std::memory_order_relaxed );
+
+        do {
+            record->next = head;
+        } while( !m_records.compare_exchange_weak( head, record, std::memory_order_release, std::memory_order_relaxed ) );
+
+        local.record = record;
+        return record;
+    }
+
+    // ** EpochReclaimer::releaseRecord
+    inline void EpochReclaimer::releaseRecord( Record* record )
+    {
+        NIMBLE_BREAK_IF( record->depth != 0, "a thread exits inside a critical section" );
+
+        if( !record->retired.empty() ) {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_orphans.insert( m_orphans.end(), record->retired.begin(), record->retired.end() );
+            record->retired.clear();
+        }
+
+        record->depth = 0;
+        record->epoch.store( 0, std::memory_order_release );
+        record->isUsed.store( false, std::memory_order_release );
+    }
+
+    // ** EpochReclaimer::enter
+    NIMBLE_INLINE void EpochReclaimer::enter( void )
+    {
+        Record* record = acquireRecord();
+
+        if( record->depth++ == 0 ) {
+            // A sequentially consistent exchange orders the epoch publication before any read of shared data
+            record->epoch.exchange( m_epoch.load( std::memory_order_relaxed ), std::memory_order_seq_cst );
+        }
+    }
+
+    // ** EpochReclaimer::leave
+    NIMBLE_INLINE void EpochReclaimer::leave( void )
+    {
+        Record* record = acquireRecord();
+        NIMBLE_ABORT_IF( record->depth == 0, "leaving a critical section that was not entered" );
+
+        if( --record->depth == 0 ) {
+            record->epoch.store( 0, std::memory_order_release );
+        }
+    }
+
+    // ** EpochReclaimer::isInside
+    inline bool EpochReclaimer::isInside( void )
+    {
+        return acquireRecord()->depth > 0;
+    }
+
+    // ** EpochReclaimer::epoch
+    inline u64 EpochReclaimer::epoch( void ) const
+    {
+        return m_epoch.load( std::memory_order_acquire );
+    }
+
+    // ** EpochReclaimer::retire
+    inline void EpochReclaimer::retire( void* pointer, Deleter deleter )
+    {
+        if( pointer == NULL ) {
+            return;
+        }
+
+        Record* record = acquireRecord();
+
+        // Objects are unlinked before retirement, so the fence makes that visible before the epoch is sampled
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+
+        Retired retired;
+        retired.pointer = pointer;
+        retired.deleter = deleter;
+        retired.epoch   = m_epoch.load( std::memory_order_seq_cst );
+        record->retired.push_back( retired );
+
+        if( record->retired.size() >= CollectThreshold ) {
+            collect();
+        }
+    }
+
+    // ** EpochReclaimer::retire
+    template<typename TValue>
+    void EpochReclaimer::retire( TValue* pointer )
+    {
+        retire( pointer, &EpochReclaimer::deleteObject<TValue> );
+    }
+
+    // ** EpochReclaimer::deleteObject
+    template<typename TValue>
+    void EpochReclaimer::deleteObject( void* pointer )
+    {
+        delete static_cast<TValue*>( pointer );
+    }
+
+    // ** EpochReclaimer::tryAdvance
+    inline u64 EpochReclaimer::tryAdvance( void )
+    {
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+
+        u64 current = m_epoch.load( std::memory_order_relaxed );
+
+        for( Record* record = m_records.load( std::memory_order_acquire ); record; record = record->next ) {
+            u64 observed = record->epoch.load( std::memory_order_acquire );
+
+            if( observed != 0 && observed != current ) {
+                return current;
+            }
+        }
+
+        if( m_epoch.compare_exchange_strong( current, current + 1, std::memory_order_acq_rel ) ) {
+            return current + 1;
+        }
+
+        return current;
+    }
+
+    // ** EpochReclaimer::reclaim
+    inline void EpochReclaimer::reclaim( Array<Retired>& retired, u64 epoch )
+    {
+        Array<Retired> expired;
+        extract( retired, epoch, expired );
+        destroy( expired );
+    }
+
+    // ** EpochReclaimer::extract
+    inline void EpochReclaimer::extract( Array<Retired>& retired, u64 epoch, Array<Retired>& expired )
+    {
+        size_t kept = 0;
+
+        for( size_t i = 0, n = retired.size(); i < n; i++ ) {
+            // No reader can observe an object retired two epochs ago
+            if( epoch == ~0ull || retired[i].epoch + 2 <= epoch ) {
+                expired.push_back( retired[i] );
+            } else {
+                retired[kept++] = retired[i];
+            }
+        }
+
+        retired.resize( kept );
+    }
+
+    // ** EpochReclaimer::destroy
+    inline void EpochReclaimer::destroy( const Array<Retired>& expired )
+    {
+        // Deleters may retire more objects, so they run after retired lists are updated
+        for( size_t i = 0, n = expired.size(); i < n; i++ ) {
+            expired[i].deleter( expired[i].pointer );
+        }
+    }
+
+    // ** EpochReclaimer::collect
+    inline void EpochReclaimer::collect( void )
+    {
+        Record*        record = acquireRecord();
+        u64            epoch  = tryAdvance();
+        Array<Retired> expired;
+
+        extract( record->retired, epoch, expired );
+
+        {
+            std::unique_lock<std::mutex> lock( m_mutex, std::try_to_lock );
+
+            if( lock.owns_lock() && !m_orphans.empty() ) {
+                extract( m_orphans, epoch, expired );
+            }
+        }
+
+        destroy( expired );
+    }
+
+    // ** EpochReclaimer::synchronize
+    inline void EpochReclaimer::synchronize( void )
+    {
+        Record* record = acquireRecord();
+        NIMBLE_ABORT_IF( record->depth != 0, "synchronizing inside a critical section would never finish" );
+
+        while( !record->retired.empty() ) {
+            collect();
+            std::this_thread::yield();
+        }
+    }
+
+    // --------------------------------- EpochGuard --------------------------------- //
+
+    //! Keeps a calling thread inside an epoch critical section during the guard lifetime.
+    class EpochGuard {
+    public:
+
+                                //! Enters a critical section.
+                                EpochGuard( void )  { EpochReclaimer::instance().enter(); }
+
+                                //! Leaves a critical section.
+                                ~EpochGuard( void ) { EpochReclaimer::instance().leave(); }
+
+    private:
+
+                                EpochGuard( const EpochGuard& other );
+        EpochGuard&             operator = ( const EpochGuard& other );
+    };
+
+    // --------------------------------- SnapshotPtr --------------------------------- //
+
+    //! Holds the current version of a reference counted object that is read by many threads and is replaced by writers.
+    /*!
+        The snapshot owns a reference to the current version. Publishing a new version
+        swaps a pointer atomically and retires the reference to an old one, so readers that
+        still hold it inside an EpochGuard are safe. The type T should be derived from
+        AtomicRefCounted when readers make Ptr references to a snapshot.
+    */
+    template<typename T>
+    class SnapshotPtr {
+    public:
+
+                                //! Constructs a SnapshotPtr instance.
+                                SnapshotPtr( const Ptr<T>& value = Ptr<T>() );
+                                ~SnapshotPtr( void );
+
+        //! Returns the current version, the pointer stays valid until a calling thread leaves a critical section.
+        T*                      get( void ) const;
+
+        //! Returns a strong reference to the current version that can be used outside a critical section.
+        Ptr<T>                  lock( void ) const;
+
+        //! Publishes a new version and retires the old one.
+        void                    publish( const Ptr<T>& value );
+
+    private:
+
+                                SnapshotPtr( const SnapshotPtr& other );
+        SnapshotPtr&            operator = ( const SnapshotPtr& other );
+
+        //! Drops a reference to a retired version.
+        static void             releaseObject( void* pointer );
+
+    private:
+
+        std::atomic<T*>         m_value;    //!< The current version.
+    };
+
+    // ** SnapshotPtr::SnapshotPtr
+    template<typename T>
+    SnapshotPtr<T>::SnapshotPtr( const Ptr<T>& value )
+        : m_value( value.get() )
+    {
+        if( T* pointer = value.get() ) {
+            pointer->retain();
+        }
+    }
+
+    // ** SnapshotPtr::~SnapshotPtr
+    template<typename T>
+    SnapshotPtr<T>::~SnapshotPtr( void )
+    {
+        EpochReclaimer::instance().retire( m_value.exchange( NULL ), &SnapshotPtr::releaseObject );
+    }
+
+    // ** SnapshotPtr::get
+    template<typename T>
+    T* SnapshotPtr<T>::get( void ) const
+    {
+        NIMBLE_BREAK_IF( !EpochReclaimer::instance().isInside(), "snapshot should be read inside an epoch critical section" );
+        return m_value.load( std::memory_order_acquire );
+    }
+
+    // ** SnapshotPtr::lock
+    template<typename T>
+    Ptr<T> SnapshotPtr<T>::lock( void ) const
+    {
+        EpochGuard guard;
+        return Ptr<T>( m_value.load( std::memory_order_acquire ) );
+    }
+
+    // ** SnapshotPtr::publish
+    template<typename T>
+    void SnapshotPtr<T>::publish( const Ptr<T>& value )
+    {
+        T* pointer = value.get();
+
+        if( pointer ) {
+            pointer->retain();
+        }
+
+        EpochReclaimer::instance().retire( m_value.exchange( pointer, std::memory_order_acq_rel ), &SnapshotPtr::releaseObject );
+    }
+
+    // ** SnapshotPtr::releaseObject
+    template<typename T>
+    void SnapshotPtr<T>::releaseObject( void* pointer )
+    {
+        static_cast<T*>( pointer )->release();
+    }
+
+NIMBLE_END
+
+#endif  /*  NIMBLE_CPP11_ENABLED    */
+
+#endif  /*  !__Nimble_EpochReclaimer_H__    */
@@ -47,7 +47,7 @@ NIMBLE_BEGIN
                         template <class R>
                         Ptr( const Ptr<R>& other ) : m_ptr( other.get() ) {
                             if( m_ptr ) {
-                                static_cast<RefCounted*>( m_ptr )->retain();
+                                m_ptr->retain();
                             }
                         }
 
@@ -93,7 +93,8 @@ NIMBLE_BEGIN
     // ** Ptr::Ptr
     template<typename T>
     Ptr<T>::Ptr( const WeakPtr<T>& pointer ) : m_ptr( NULL ) {
-        setPointer( pointer.get() );
+        ThisType locked = pointer.lock();
+        setPointer( locked.get() );
     }
 
     // ** Ptr::~Ptr
@@ -29,16 +29,236 @@
 
 #include "../Globals.h"
 
+#if NIMBLE_CPP11_ENABLED
+    #include "../Containers/ConcurrentPool.h"
+    #include <atomic>
+    #include <thread>
+#else
+    #include "../Allocators/SlabAllocator.h"
+#endif  /*  NIMBLE_CPP11_ENABLED    */
+
 NIMBLE_BEGIN
 
+    class WeakProxy;
+
+    // --------------------------------- UnsafeCounter --------------------------------- //
+
+    //! A plain reference counter that should not be shared between threads.
+    class UnsafeCounter {
+    public:
+
+        //! A pointer to a weak proxy object stored by a reference counted object.
+        typedef WeakProxy*      ProxyPointer;
+
+                                UnsafeCounter( s32 value = 0 );
+
+        //! Increments the counter and returns the new value.
+        s32                     increment( void );
+
+        //! Increments the counter only if it is not zero, returns false otherwise.
+        bool                    incrementIfNonZero( void );
+
+        //! Decrements the counter and returns the new value.
+        s32                     decrement( void );
+
+        //! Returns the counter value.
+        s32                     value( void ) const;
+
+        //! Sets the counter value.
+        void                    store( s32 value );
+
+        //! Sets the proxy pointer if it was NULL, otherwise outputs the current one and returns false.
+        static bool             publish( ProxyPointer& pointer, WeakProxy*& expected, WeakProxy* desired );
+
+    private:
+
+        s32                     m_value;    //!< Counter value.
+    };
+
+    // ** UnsafeCounter::UnsafeCounter
+    inline UnsafeCounter::UnsafeCounter( s32 value )
+        : m_value( value )
+    {
+    }
+
+    // ** UnsafeCounter::increment
+    inline s32 UnsafeCounter::increment( void ) {
+        return ++m_value;
+    }
+
+    // ** UnsafeCounter::incrementIfNonZero
+    inline bool UnsafeCounter::incrementIfNonZero( void )
+    {
+        if( m_value == 0 ) {
+            return false;
+        }
+
+        ++m_value;
+        return true;
+    }
+
+    // ** UnsafeCounter::decrement
+    inline s32 UnsafeCounter::decrement( void ) {
+        return --m_value;
+    }
+
+    // ** UnsafeCounter::value
+    inline s32 UnsafeCounter::value( void ) const {
+        return m_value;
+    }
+
+    // ** UnsafeCounter::store
+    inline void UnsafeCounter::store( s32 value ) {
+        m_value = value;
+    }
+
+    // ** UnsafeCounter::publish
+    inline bool UnsafeCounter::publish( ProxyPointer& pointer, WeakProxy*& expected, WeakProxy* desired )
+    {
+        if( pointer != expected ) {
+            expected = pointer;
+            return false;
+        }
+
+        pointer = desired;
+        return true;
+    }
+
+#if NIMBLE_CPP11_ENABLED
+
+    // --------------------------------- AtomicCounter --------------------------------- //
+
+    //! A reference counter that can be safely shared between threads.
+    /*!
+        A new reference is always made from an existing one, so increments do not need to
+        synchronize anything and are relaxed. Decrements use a release ordering, and the thread
+        that drops the last reference issues an acquire fence, so all writes made through
+        other references are visible to a destructor.
+    */
+    class AtomicCounter {
+    public:
+
+        //! A pointer to a weak proxy object stored by a reference counted object.
+        typedef std::atomic<WeakProxy*> ProxyPointer;
+
+                                AtomicCounter( s32 value = 0 );
+
+        //! Increments the counter and returns the new value.
+        s32                     increment( void );
+
+        //! Increments the counter only if it is not zero, returns false otherwise.
+        bool                    incrementIfNonZero( void );
+
+        //! Decrements the counter and returns the new value.
+        s32                     decrement( void );
+
+        //! Returns the counter value.
+        s32                     value( void ) const;
+
+        //! Sets the counter value.
+        void                    store( s32 value );
+
+        //! Sets the proxy pointer if it was NULL, otherwise outputs the current one and returns false.
+        static bool             publish( ProxyPointer& pointer, WeakProxy*& expected, WeakProxy* desired );
+
+    private:
+
+        std::atomic<s32>        m_value;    //!< Counter value.
+    };
+
+    // ** AtomicCounter::AtomicCounter
+    inline AtomicCounter::AtomicCounter( s32 value )
+        : m_value( value )
+    {
+    }
+
+    // ** AtomicCounter::increment
+    inline s32 AtomicCounter::increment( void ) {
+        return m_value.fetch_add( 1, std::memory_order_relaxed ) + 1;
+    }
+
+    // ** AtomicCounter::incrementIfNonZero
+    inline bool AtomicCounter::incrementIfNonZero( void )
+    {
+        // A counter that reached zero never grows again, so an object that is being destroyed is not resurrected
+        s32 value = m_value.load( std::memory_order_relaxed );
+
+        while( value != 0 ) {
+            if( m_value.compare_exchange_weak( value, value + 1, std::memory_order_acquire, std::memory_order_relaxed ) ) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // ** AtomicCounter::decrement
+    inline s32 AtomicCounter::decrement( void )
+    {
+        s32 left = m_value.fetch_sub( 1, std::memory_order_release ) - 1;
+
+        if( left == 0 ) {
+            std::atomic_thread_fence( std::memory_order_acquire );
+        }
+
+        return left;
+    }
+
+    // ** AtomicCounter::value
+    inline s32 AtomicCounter::value( void ) const {
+        return m_value.load( std::memory_order_relaxed );
+    }
+
+    // ** AtomicCounter::store
+    inline void AtomicCounter::store( s32 value ) {
+        m_value.store( value, std::memory_order_release );
+    }
+
+    // ** AtomicCounter::publish
+    inline bool AtomicCounter::publish( ProxyPointer& pointer, WeakProxy*& expected, WeakProxy* desired ) {
+        return pointer.compare_exchange_strong( expected, desired, std::memory_order_acq_rel, std::memory_order_acquire );
+    }
+
+    //! Weak proxies are shared between threads when objects are.
+    typedef AtomicCounter WeakCounter;
+
+    //! A flag that tells weak pointers whether an object is alive.
+    typedef std::atomic<bool> WeakFlag;
+
+#else
+
+    //! Weak proxies are shared between threads when objects are.
+    typedef UnsafeCounter WeakCounter;
+
+    //! A flag that tells weak pointers whether an object is alive.
+    typedef bool WeakFlag;
+
+#endif  /*  NIMBLE_CPP11_ENABLED    */
+
     // --------------------------------- WeakProxy --------------------------------- //
 
     //! A reference counted object proxy for WeakPtr object.
+    /*!
+        Weak proxy counters are atomic, so weak pointers to an object can be copied, released
+        and locked on any thread. A locking thread pins a proxy while it retains an object,
+        and a thread that drops the last strong reference expires a proxy and waits for pinned
+        lockers before an object is disposed, so a counter is never touched after it is freed.
+
+        Proxies are allocated from a shared lock-free pool instead of a heap, so scenes
+        with lots of weakly referenced objects do not end up with as many tiny heap blocks,
+        and threads that create and drop weak pointers concurrently do not contend on a lock.
+    */
     class WeakProxy {
     public:
 
                         WeakProxy( void );
 
+        //! Allocates a weak proxy from a shared pool.
+        static void*    operator new( size_t size );
+
+        //! Returns a weak proxy memory to a shared pool.
+        static void     operator delete( void* pointer );
+
         //! Retains this weak proxy.
         int             retain( void );
 
@@ -51,56 +271,177 @@ NIMBLE_BEGIN
         //! Returns true if a target object is still alive.
         bool            isAlive( void ) const;
 
+        //! Pins a target object memory while it is being retained, returns false if an object has expired.
+        bool            pin( void );
+
+        //! Unpins a target object memory.
+        void            unpin( void );
+
+        //! Marks a target object as dead and waits until it is not pinned by any thread.
+        void            expire( void );
+
     private:
 
-                        WeakProxy( const WeakProxy& other ) {}
-        void operator = ( const WeakProxy& other ) {}
+                        WeakProxy( const WeakProxy& ) {}
+        void operator = ( const WeakProxy& ) {}
 
     private:
 
         //! Weak proxy reference counter.
-        int             m_references;
+        WeakCounter     m_references;
         
         //! Dead or alive flag.
-        bool            m_isAlive;
+        WeakFlag        m_isAlive;
+
+        //! The total number of threads that are retaining a target object.
+    #if NIMBLE_CPP11_ENABLED
+        std::atomic<s32> m_pins;
+    #else
+        s32             m_pins;
+    #endif  /*  NIMBLE_CPP11_ENABLED    */
     };
 
     // ** WeakProxy::cWeakProxy
     inline WeakProxy::WeakProxy( void )
+        : m_references( 0 )
+        , m_isAlive( true )
+        , m_pins( 0 )
     {
-        m_references = 0;
-        m_isAlive     = true;
+    }
+
+    namespace Private {
+
+        //! A shared allocator of weak proxy objects.
+        struct WeakProxyAllocator {
+        #if NIMBLE_CPP11_ENABLED
+            //! A handle to a pooled weak proxy.
+            typedef OpaqueHandle<24, 8>         Handle;
+
+            //! A pool slot that stores weak proxy memory followed by a handle used to release it.
+            struct Block {
+                union {
+                    u8                          data[sizeof( WeakProxy )];  //!< Weak proxy memory.
+                    f64                         alignment;                  //!< Aligns weak proxies to 8 bytes.
+                }                               memory;
+                Handle                          handle;                     //!< A pool handle of this block.
+            };
+
+            //! Proxies are released by any thread that drops the last weak reference, so a lock-free pool is used.
+            ConcurrentPool<Block, Handle>       blocks;
+        #else
+            SlabAllocator<sizeof( WeakProxy )>  slabs;  //!< Allocated proxies.
+        #endif  /*  NIMBLE_CPP11_ENABLED    */
+
+            //! Returns the shared allocator instance.
+            static WeakProxyAllocator&          instance( void )
+                                                {
+                                                    // The allocator is never destroyed, so weak pointers stay valid during a static destruction
+                                                    static WeakProxyAllocator* allocator = new WeakProxyAllocator;
+                                                    return *allocator;
+                                                }
+        };
+
+    } // namespace Private
+
+    // ** WeakProxy::operator new
+    inline void* WeakProxy::operator new( size_t size )
+    {
+        NIMBLE_ABORT_IF( size != sizeof( WeakProxy ), "unexpected weak proxy size" );
+
+        Private::WeakProxyAllocator& allocator = Private::WeakProxyAllocator::instance();
+    #if NIMBLE_CPP11_ENABLED
+        Private::WeakProxyAllocator::Handle handle = allocator.blocks.reserve();
+        Private::WeakProxyAllocator::Block& block  = allocator.blocks.get( handle );
+        block.handle = handle;
+        return block.memory.data;
+    #else
+        return allocator.slabs.allocate();
+    #endif  /*  NIMBLE_CPP11_ENABLED    */
+    }
+
+    // ** WeakProxy::operator delete
+    inline void WeakProxy::operator delete( void* pointer )
+    {
+        Private::WeakProxyAllocator& allocator = Private::WeakProxyAllocator::instance();
+    #if NIMBLE_CPP11_ENABLED
+        // Weak proxy memory is the first member of a pool block
+        const Private::WeakProxyAllocator::Block* block = reinterpret_cast<const Private::WeakProxyAllocator::Block*>( pointer );
+        allocator.blocks.remove( block->handle );
+    #else
+        allocator.slabs.deallocate( pointer );
+    #endif  /*  NIMBLE_CPP11_ENABLED    */
     }
 
     // ** WeakProxy::retain
     inline int WeakProxy::retain( void )
     {
-        NIMBLE_ABORT_IF( m_isAlive == false, "dead objects should not be retained" );
-        m_references++;
-        return m_references;
+        // Expired proxies are still retained by copies of weak pointers
+        return m_references.increment();
     }
 
     // ** WeakProxy::release
     inline int WeakProxy::release( void )
     {
-        NIMBLE_ABORT_IF( m_references == 0, "objects should not be released twice" );
+        NIMBLE_ABORT_IF( m_references.value() == 0, "objects should not be released twice" );
+
+        int left = m_references.decrement();
 
-        if( --m_references == 0 ) {
+        if( left == 0 ) {
             delete this;
-            return 0;
         }
 
-        return m_references;
+        return left;
     }
 
     // ** WeakProxy::setAlive
     inline void WeakProxy::setAlive( bool alive ) {
+    #if NIMBLE_CPP11_ENABLED
+        m_isAlive.store( alive );
+    #else
         m_isAlive = alive;
+    #endif  /*  NIMBLE_CPP11_ENABLED    */
     }
 
     // ** WeakProxy::isAlive
     inline bool WeakProxy::isAlive( void ) const {
+    #if NIMBLE_CPP11_ENABLED
+        return m_isAlive.load();
+    #else
         return m_isAlive;
+    #endif  /*  NIMBLE_CPP11_ENABLED    */
+    }
+
+    // ** WeakProxy::pin
+    inline bool WeakProxy::pin( void )
+    {
+        // Sequentially consistent operations make sure that either expire() sees this pin,
+        // or this thread sees an object expired and never touches its memory
+        m_pins++;
+
+        if( !isAlive() ) {
+            m_pins--;
+            return false;
+        }
+
+        return true;
+    }
+
+    // ** WeakProxy::unpin
+    inline void WeakProxy::unpin( void ) {
+        m_pins--;
+    }
+
+    // ** WeakProxy::expire
+    inline void WeakProxy::expire( void )
+    {
+        setAlive( false );
+
+    #if NIMBLE_CPP11_ENABLED
+        // Lockers only hold a pin while trying to increment a counter, so this wait is short
+        while( m_pins.load() != 0 ) {
+            std::this_thread::yield();
+        }
+    #endif  /*  NIMBLE_CPP11_ENABLED    */
     }
 
     // --------------------------------- RefCounted --------------------------------- //
@@ -122,6 +463,9 @@ NIMBLE_BEGIN
         //! Retains this object (adds a reference).
         virtual int            retain( void ) const;
 
+        //! Retains this object only if it still has references, returns false otherwise.
+        bool                    tryRetain( void ) const;
+
         //! Releases this object (drops a reference), disposes an object if there are no more references left.
         virtual int            release( void ) const;
 
@@ -144,7 +488,7 @@ NIMBLE_BEGIN
     }
 
     // ** RefCounted::RefCounted
-    inline RefCounted::RefCounted( const RefCounted& other ) {
+    inline RefCounted::RefCounted( const RefCounted& ) {
         m_references = 0;
         m_weakProxy  = NULL;
     }
@@ -172,6 +516,17 @@ NIMBLE_BEGIN
         return m_references;
     }
 
+    // ** RefCounted::tryRetain
+    inline bool RefCounted::tryRetain( void ) const
+    {
+        if( m_references == 0 ) {
+            return false;
+        }
+
+        retain();
+        return true;
+    }
+
     // ** RefCounted::release
     inline int RefCounted::release( void ) const
     {
@@ -200,6 +555,154 @@ NIMBLE_BEGIN
         return m_weakProxy;
     }
 
+    // --------------------------------- BasicRefCounted --------------------------------- //
+
+    //! An intrusive reference counting object with a customizable counter and non-virtual reference counting.
+    /*!
+        Unlike RefCounted, the retain and release methods are not virtual, so copying a Ptr
+        compiles to an inline counter update. Only the dispose method that is called once the
+        last reference is dropped stays virtual. Use AtomicRefCounted for objects that are
+        shared between threads.
+    */
+    template<typename TCounter>
+    class BasicRefCounted {
+    public:
+
+                                BasicRefCounted( void );
+                                BasicRefCounted( const BasicRefCounted& other );
+        virtual                ~BasicRefCounted( void );
+
+        //! Returns a WeakProxy object.
+        WeakProxy*              weakProxy( void ) const;
+
+        //! Disposes this object.
+        virtual void            dispose( void ) const;
+
+        //! Retains this object (adds a reference).
+        int                     retain( void ) const;
+
+        //! Retains this object only if it still has references, returns false otherwise.
+        bool                    tryRetain( void ) const;
+
+        //! Releases this object (drops a reference), disposes an object if there are no more references left.
+        int                     release( void ) const;
+
+        //! Returns an amount of references pointing to this object.
+        int                     totalReferences( void ) const;
+
+    private:
+
+        //! Reference counter.
+        mutable TCounter        m_references;
+
+        //! Weak proxy object.
+        mutable typename TCounter::ProxyPointer m_weakProxy;
+    };
+
+    // ** BasicRefCounted::BasicRefCounted
+    template<typename TCounter>
+    BasicRefCounted<TCounter>::BasicRefCounted( void )
+        : m_references( 0 )
+        , m_weakProxy( NULL )
+    {
+    }
+
+    // ** BasicRefCounted::BasicRefCounted
+    template<typename TCounter>
+    BasicRefCounted<TCounter>::BasicRefCounted( const BasicRefCounted& )
+        : m_references( 0 )
+        , m_weakProxy( NULL )
+    {
+    }
+
+    // ** BasicRefCounted::~BasicRefCounted
+    template<typename TCounter>
+    BasicRefCounted<TCounter>::~BasicRefCounted( void )
+    {
+        NIMBLE_ABORT_IF( m_references.value() != 0, "reference counter expected to be 0 upon destruction" );
+
+        WeakProxy* proxy = m_weakProxy;
+
+        if( proxy ) {
+            proxy->setAlive( false );
+            proxy->release();
+        }
+    }
+
+    // ** BasicRefCounted::dispose
+    template<typename TCounter>
+    void BasicRefCounted<TCounter>::dispose( void ) const {
+        delete this;
+    }
+
+    // ** BasicRefCounted::retain
+    template<typename TCounter>
+    NIMBLE_INLINE int BasicRefCounted<TCounter>::retain( void ) const {
+        return m_references.increment();
+    }
+
+    // ** BasicRefCounted::tryRetain
+    template<typename TCounter>
+    NIMBLE_INLINE bool BasicRefCounted<TCounter>::tryRetain( void ) const {
+        return m_references.incrementIfNonZero();
+    }
+
+    // ** BasicRefCounted::release
+    template<typename TCounter>
+    NIMBLE_INLINE int BasicRefCounted<TCounter>::release( void ) const
+    {
+        NIMBLE_ABORT_IF( m_references.value() == 0, "objects should not be released twice" );
+
+        int left = m_references.decrement();
+        if( left == 0 ) {
+            // Weak pointers that are being locked by other threads should stop touching this object first
+            WeakProxy* proxy = m_weakProxy;
+
+            if( proxy ) {
+                proxy->expire();
+            }
+
+            dispose();
+        }
+        return left;
+    }
+
+    // ** BasicRefCounted::totalReferences
+    template<typename TCounter>
+    int BasicRefCounted<TCounter>::totalReferences( void ) const {
+        return m_references.value();
+    }
+
+    // ** BasicRefCounted::weakProxy
+    template<typename TCounter>
+    WeakProxy* BasicRefCounted<TCounter>::weakProxy( void ) const
+    {
+        WeakProxy* proxy = m_weakProxy;
+
+        if( !proxy ) {
+            // Another thread may create a proxy at the same time, so only one of them is published
+            WeakProxy* created = new WeakProxy;
+            created->retain();
+
+            if( TCounter::publish( m_weakProxy, proxy, created ) ) {
+                proxy = created;
+            } else {
+                created->release();
+            }
+        }
+
+        proxy->retain();
+        return proxy;
+    }
+
+    //! A reference counted object that should not be shared between threads, but has no virtual calls on retain and release.
+    typedef BasicRefCounted<UnsafeCounter> UnsafeRefCounted;
+
+#if NIMBLE_CPP11_ENABLED
+    //! A reference counted object that can be retained and released from multiple threads.
+    typedef BasicRefCounted<AtomicCounter> AtomicRefCounted;
+#endif  /*  NIMBLE_CPP11_ENABLED    */
+
 NIMBLE_END
 
 #endif  /*  !__Nimble_RefCounted_H__    */
@@ -34,15 +34,18 @@ NIMBLE_BEGIN
     // ** class WeakPtr
     template<typename T>
     class WeakPtr {
+    template<typename R> friend class WeakPtr;
     private:
 
-        mutable T*          m_ptr;
-        mutable WeakProxy*  m_weakProxy;
+        T*                  m_ptr;
+        WeakProxy*          m_weakProxy;
 
     private:
 
         void                setPointer( T *pointer );
-        void                manageProxy( void ) const;
+        template<typename R>
+        void                setProxy( R* pointer, WeakProxy* proxy );
+        T*                  target( void ) const;
 
     public:
 
@@ -52,7 +55,7 @@ NIMBLE_BEGIN
 
                             template <class R>
                             WeakPtr( const WeakPtr<R>& other ) : m_ptr( NULL ), m_weakProxy( NULL ) {
-                                setPointer( other.get() );
+                                setProxy( other.m_ptr, other.m_weakProxy );
                             }
                             template <class R>
                             WeakPtr( const Ptr<R>& other ) : m_ptr( NULL ), m_weakProxy( NULL ) {
@@ -88,7 +91,7 @@ NIMBLE_BEGIN
     // ** WeakPtr::WeakPtr
     template<typename T>
     WeakPtr<T>::WeakPtr( const WeakPtr<T>& other ) : m_ptr( NULL ), m_weakProxy( NULL ) {
-        setPointer( other.get() );
+        setProxy( other.m_ptr, other.m_weakProxy );
     }
 
     // ** WeakPtr::WeakPtr
@@ -106,30 +109,28 @@ NIMBLE_BEGIN
     // ** WeakPtr::operator ->
     template<typename T>
     T* WeakPtr<T>::operator -> ( void ) {
-        manageProxy();
-        return m_ptr;
+        return target();
     }
 
     template<typename T>
     const T* WeakPtr<T>::operator -> ( void ) const {
-        manageProxy();
-        return m_ptr;
+        return target();
     }
 
     // ** WeakPtr::operator *
     template<typename T>
     T& WeakPtr<T>::operator * ( void ) {
-        manageProxy();
-        NIMBLE_ABORT_IF( m_ptr == NULL, "dereferencing NULL pointer" );
-        return *m_ptr;
+        T* pointer = target();
+        NIMBLE_ABORT_IF( pointer == NULL, "dereferencing NULL pointer" );
+        return *pointer;
     }
 
     // ** WeakPtr::operator *
     template<typename T>
     const T& WeakPtr<T>::operator * ( void ) const {
-        manageProxy();
-        NIMBLE_ABORT_IF( m_ptr == NULL, "dereferencing NULL pointer" );
-        return *m_ptr;
+        T* pointer = target();
+        NIMBLE_ABORT_IF( pointer == NULL, "dereferencing NULL pointer" );
+        return *pointer;
     }
 
     // ** WeakPtr::operator =
@@ -142,49 +143,45 @@ NIMBLE_BEGIN
     // ** WeakPtr::operator =
     template<typename T>
     WeakPtr<T>& WeakPtr<T>::operator = ( const WeakPtr<T>& other ) {
-        setPointer( other.get() );
+        setProxy( other.m_ptr, other.m_weakProxy );
         return *this;
     }
 
     // ** WeakPtr::operator ==
     template<typename T>
     bool WeakPtr<T>::operator == ( T *pointer ) const {
-        manageProxy();
-        return ( m_ptr == pointer );
+        return ( target() == pointer );
     }
 
     // ** WeakPtr::operator ==
     template<typename T>
     bool WeakPtr<T>::operator == ( const WeakPtr<T>& other ) const {
-        manageProxy();
-        return ( m_ptr == other.get() );
+        return ( target() == other.get() );
     }
 
     // ** WeakPtr::operator !=
     template<typename T>
     bool WeakPtr<T>::operator != ( T *pointer ) const {
-        manageProxy();
-        return ( m_ptr != pointer );
+        return ( target() != pointer );
     }
 
     // ** WeakPtr::operator !=
     template<typename T>
     bool WeakPtr<T>::operator != ( const WeakPtr<T>& other ) const {
-        manageProxy();
-        return ( m_ptr != other.get() );
+        return ( target() != other.get() );
     }
 
     // ** WeakPtr::operator <
     template<typename T>
     bool WeakPtr<T>::operator < ( const WeakPtr<T>& other ) const {
-        manageProxy();
-        return ( m_ptr < other.get() );
+        return ( target() < other.get() );
     }
 
     // ** WeakPtr::setPointer
     template<typename T>
     void WeakPtr<T>::setPointer( T *pointer ) {
-        if( m_ptr == pointer ) {
+        // A stale pointer to an expired object may equal a new object allocated at the same address
+        if( m_ptr == pointer && target() == pointer ) {
             return;
         }
 
@@ -198,45 +195,71 @@ NIMBLE_BEGIN
         }
     }
 
+    // ** WeakPtr::setProxy
+    template<typename T>
+    template<typename R>
+    void WeakPtr<T>::setProxy( R* pointer, WeakProxy* proxy ) {
+        // Weak pointers are copied through a proxy, so an object that may be destroyed by
+        // another thread is never touched, an expired copy keeps a proxy until it is reassigned
+        if( m_weakProxy == proxy ) {
+            return;
+        }
+
+        if( proxy ) {
+            proxy->retain();
+        }
+
+        if( m_weakProxy ) {
+            m_weakProxy->release();
+        }
+
+        m_ptr       = pointer;
+        m_weakProxy = proxy;
+    }
+
     // ** WeakPtr::get
     template<typename T>
     T* WeakPtr<T>::get( void ) const  {
-        manageProxy();
-        return m_ptr; 
+        return target();
     }
 
     // ** WeakPtr::lock
     template<typename T>
     Ptr<T> WeakPtr<T>::lock( void ) const  {
-        manageProxy();
-        return Ptr<T>( m_ptr );
+        // Members are only read, so threads may lock a shared weak pointer concurrently
+        if( !m_weakProxy || !m_weakProxy->pin() ) {
+            return Ptr<T>();
+        }
+
+        // An object that has already dropped its last strong reference is not resurrected
+        bool retained = m_ptr->tryRetain();
+        m_weakProxy->unpin();
+
+        if( !retained ) {
+            return Ptr<T>();
+        }
+
+        Ptr<T> result( m_ptr );
+        m_ptr->release();
+
+        return result;
     }
 
     // ** WeakPtr::valid
     template<typename T>
     NIMBLE_INLINE bool WeakPtr<T>::valid( void ) const {
-        manageProxy();
-        return m_ptr != NULL;
+        return target() != NULL;
     }
 
-    // ** WeakPtr::manageProxy
+    // ** WeakPtr::target
     template<typename T>
-    void WeakPtr<T>::manageProxy( void ) const {
-        if( !m_ptr ) {
-            return;
-        }
-
-        NIMBLE_BREAK_IF( m_weakProxy == NULL, "weak proxy expected to be valid" );
-        
-        if( !m_weakProxy ) {
-            m_ptr = NULL;
+    T* WeakPtr<T>::target( void ) const {
+        // An expired proxy is kept until a weak pointer is reassigned or destroyed, so const accessors never write
+        if( !m_weakProxy || !m_weakProxy->isAlive() ) {
+            return NULL;
         }
 
-        if( m_weakProxy && !m_weakProxy->isAlive() ) {
-            m_weakProxy->release();
-            m_weakProxy = NULL;
-            m_ptr       = NULL;
-        }
+        return m_ptr;
     }
 
 NIMBLE_END
@@ -77,4 +77,7 @@
 
 #define NIMBLE_NO_DEFAULT       NIMBLE_HINT( 0 )
 
+//! The assumed CPU cache line size, data modified by different threads is padded to it to avoid false sharing
+#define NIMBLE_CACHE_LINE_SIZE  64
+
 #endif  /*  !__Nimble_Preprocessor_CplusplusFeatures_H__    */
@@ -58,6 +58,11 @@
     #define NIMBLE_PLATFORM_ANDROID
 #endif  /*  __ANDROID__ */
 
+#if defined( __linux__ ) && !defined( __ANDROID__ )
+    #define NIMBLE_PLATFORM NIMBLE_LINUX
+    #define NIMBLE_PLATFORM_LINUX
+#endif  /*  __linux__   */
+
 #if defined(__EMSCRIPTEN__)
     #define NIMBLE_PLATFORM NIMBLE_EMSCRIPTEN
     #define NIMBLE_PLATFORM_EMSCRIPTEN
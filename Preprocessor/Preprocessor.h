@@ -31,6 +31,7 @@
 #include "CplusplusFeatures.h"
 #include "Debug.h"
 #include "EnumClass.h"
+#include "Simd.h"
 
 //! Macro definition to simplify bitmasks declarations
 #define BIT( bit ) ( 1 << (bit) )
@@ -0,0 +1,64 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_Preprocessor_Simd_H__
+#define __Nimble_Preprocessor_Simd_H__
+
+/*!
+    SIMD instruction sets are selected at compile time from the compiler target
+    flags (for example -mssse3, -mavx2 or /arch:AVX2). Define NIMBLE_NO_SIMD to
+    force scalar code paths.
+*/
+
+#if !defined( NIMBLE_NO_SIMD )
+    #if defined( __AVX2__ )
+        #define NIMBLE_SIMD_AVX2    (1)
+    #endif  /*  __AVX2__    */
+
+    #if defined( __SSE4_1__ ) || defined( NIMBLE_SIMD_AVX2 )
+        #define NIMBLE_SIMD_SSE41   (1)
+    #endif  /*  __SSE4_1__  */
+
+    #if defined( __SSSE3__ ) || defined( NIMBLE_SIMD_SSE41 )
+        #define NIMBLE_SIMD_SSSE3   (1)
+    #endif  /*  __SSSE3__   */
+
+    #if defined( __SSE2__ ) || defined( _M_X64 ) || (defined( _M_IX86_FP ) && _M_IX86_FP >= 2) || defined( NIMBLE_SIMD_SSSE3 )
+        #define NIMBLE_SIMD_SSE2    (1)
+    #endif  /*  __SSE2__    */
+#endif  /*  !NIMBLE_NO_SIMD */
+
+#if defined( NIMBLE_SIMD_AVX2 )
+    #include <immintrin.h>
+#elif defined( NIMBLE_SIMD_SSE41 )
+    #include <smmintrin.h>
+#elif defined( NIMBLE_SIMD_SSSE3 )
+    #include <tmmintrin.h>
+#elif defined( NIMBLE_SIMD_SSE2 )
+    #include <emmintrin.h>
+#endif  /*  NIMBLE_SIMD_AVX2    */
+
+#endif  /*  !__Nimble_Preprocessor_Simd_H__    */
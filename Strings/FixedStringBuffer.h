@@ -28,6 +28,7 @@ SOFTWARE.
 #define __Nimble_FixedStringBuffer_H__
 
 #include "../Globals.h"
+#include "NumberConversion.h"
 
 NIMBLE_BEGIN
 
@@ -48,6 +49,24 @@ NIMBLE_BEGIN
         //! Stream write operator that copies a fixed string buffer.
         FixedStringBuffer&  operator << (const FixedStringBuffer& other);
 
+        //! Writes a decimal representation of a signed 32-bit integer.
+        FixedStringBuffer&  operator << (s32 value);
+
+        //! Writes a decimal representation of a unsigned 32-bit integer.
+        FixedStringBuffer&  operator << (u32 value);
+
+        //! Writes a decimal representation of a signed 64-bit integer.
+        FixedStringBuffer&  operator << (s64 value);
+
+        //! Writes a decimal representation of a unsigned 64-bit integer.
+        FixedStringBuffer&  operator << (u64 value);
+
+        //! Writes a decimal representation of a 32-bit floating point value.
+        FixedStringBuffer&  operator << (f32 value);
+
+        //! Writes a decimal representation of a 64-bit floating point value.
+        FixedStringBuffer&  operator << (f64 value);
+
         //! Returns a string buffer pointer.
         const s8*           cstr() const;
 
@@ -112,6 +131,54 @@ NIMBLE_BEGIN
         return *this;
     }
 
+    // ** FixedStringBuffer::operator <<
+    NIMBLE_INLINE FixedStringBuffer& FixedStringBuffer::operator << (s32 value)
+    {
+        s8 buffer[Number::MaxLength];
+        write(buffer, Number::format(value, buffer));
+        return *this;
+    }
+
+    // ** FixedStringBuffer::operator <<
+    NIMBLE_INLINE FixedStringBuffer& FixedStringBuffer::operator << (u32 value)
+    {
+        s8 buffer[Number::MaxLength];
+        write(buffer, Number::format(value, buffer));
+        return *this;
+    }
+
+    // ** FixedStringBuffer::operator <<
+    NIMBLE_INLINE FixedStringBuffer& FixedStringBuffer::operator << (s64 value)
+    {
+        s8 buffer[Number::MaxLength];
+        write(buffer, Number::format(value, buffer));
+        return *this;
+    }
+
+    // ** FixedStringBuffer::operator <<
+    NIMBLE_INLINE FixedStringBuffer& FixedStringBuffer::operator << (u64 value)
+    {
+        s8 buffer[Number::MaxLength];
+        write(buffer, Number::format(value, buffer));
+        return *this;
+    }
+
+    // ** FixedStringBuffer::operator <<
+    NIMBLE_INLINE FixedStringBuffer& FixedStringBuffer::operator << (f32 value)
+    {
+        s8 buffer[Number::MaxLength];
+        write(buffer, Number::format(value, buffer));
+        return *this;
+    }
+
+    // ** FixedStringBuffer::operator <<
+    NIMBLE_INLINE FixedStringBuffer& FixedStringBuffer::operator << (f64 value)
+    {
+        s8 buffer[Number::MaxLength];
+        write(buffer, Number::format(value, buffer));
+        return *this;
+    }
+
     // ** FixedStringBuffer::cstr
     NIMBLE_INLINE const s8* FixedStringBuffer::cstr() const
     {
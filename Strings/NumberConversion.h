@@ -0,0 +1,829 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_NumberConversion_H__
+#define __Nimble_NumberConversion_H__
+
+#include "../Globals.h"
+#include "NumberTables.h"
+#include "StringView.h"
+
+#include <float.h>
+#include <limits>
+#include <stdlib.h>
+#include <string.h>
+
+NIMBLE_BEGIN
+
+    namespace Private {
+
+        //! Floating point type properties used by number conversion routines.
+        template<typename TFloat>
+        struct FloatTraits;
+
+        //! Properties of a 64-bit floating point type.
+        template<>
+        struct FloatTraits<f64> {
+            typedef u64 Bits;
+            enum {
+                  MantissaBits          = 52    //!< The number of explicitly stored mantissa bits.
+                , ExponentBias          = 1023  //!< The exponent bias.
+                , InfinitePower         = 0x7ff //!< The biased exponent of infinity and NaN values.
+                , MinRoundToEven        = -4    //!< The smallest decimal exponent that may produce a halfway case.
+                , MaxRoundToEven        = 23    //!< The largest decimal exponent that may produce a halfway case.
+                , SmallestPowerOfTen    = -342  //!< Any smaller decimal exponent produces a zero.
+                , LargestPowerOfTen     = 308   //!< Any larger decimal exponent produces an infinity.
+            };
+        };
+
+        //! Properties of a 32-bit floating point type.
+        template<>
+        struct FloatTraits<f32> {
+            typedef u32 Bits;
+            enum {
+                  MantissaBits          = 23
+                , ExponentBias          = 127
+                , InfinitePower         = 0xff
+                , MinRoundToEven        = -17
+                , MaxRoundToEven        = 10
+                , SmallestPowerOfTen    = -65
+                , LargestPowerOfTen     = 38
+            };
+        };
+
+        //! A decimal floating point value equal to mantissa * 10^exponent.
+        struct DecimalFloat {
+            u64                 mantissa;   //!< Decimal mantissa.
+            s32                 exponent;   //!< Decimal exponent.
+        };
+
+        //! Pairs of decimal digits for all numbers in [0, 99] range.
+        static const s8 NumberDigitPairs[] =
+            "0001020304050607080910111213141516171819"
+            "2021222324252627282930313233343536373839"
+            "4041424344454647484950515253545556575859"
+            "6061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+
+        //! Multiplies two 64-bit values, returns the low part of a 128-bit product and outputs the high part.
+        inline u64 multiply128( u64 a, u64 b, u64& high )
+        {
+        #if defined( __SIZEOF_INT128__ )
+            unsigned __int128 product = static_cast<unsigned __int128>( a ) * b;
+            high = static_cast<u64>( product >> 64 );
+            return static_cast<u64>( product );
+        #elif defined( _MSC_VER ) && defined( _M_X64 )
+            return _umul128( a, b, &high );
+        #else
+            u64 aLow = a & 0xffffffff, aHigh = a >> 32;
+            u64 bLow = b & 0xffffffff, bHigh = b >> 32;
+            u64 ll = aLow * bLow, lh = aLow * bHigh, hl = aHigh * bLow, hh = aHigh * bHigh;
+            u64 middle = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+            high = hh + (lh >> 32) + (hl >> 32) + (middle >> 32);
+            return (middle << 32) | (ll & 0xffffffff);
+        #endif  /*  __SIZEOF_INT128__   */
+        }
+
+        //! Writes decimal digits of a value to a buffer and returns the number of written characters.
+        inline s32 formatDecimal( u32 value, s8* output )
+        {
+            s8  buffer[10];
+            s8* end    = buffer + sizeof( buffer );
+            s8* cursor = end;
+
+            // Write two digits at a time starting from the least significant ones
+            while( value >= 100 ) {
+                u32 pair = value % 100;
+                value /= 100;
+                cursor -= 2;
+                memcpy( cursor, NumberDigitPairs + pair * 2, 2 );
+            }
+
+            if( value >= 10 ) {
+                cursor -= 2;
+                memcpy( cursor, NumberDigitPairs + value * 2, 2 );
+            } else {
+                *--cursor = static_cast<s8>( '0' + value );
+            }
+
+            s32 length = static_cast<s32>( end - cursor );
+            memcpy( output, cursor, length );
+            return length;
+        }
+
+        //! Writes decimal digits of a value to a buffer and returns the number of written characters.
+        inline s32 formatDecimal( u64 value, s8* output )
+        {
+            if( value <= 0xffffffff ) {
+                return formatDecimal( static_cast<u32>( value ), output );
+            }
+
+            // Split the value to the 32-bit head and 8-digit chunks
+            s8  buffer[20];
+            s8* end    = buffer + sizeof( buffer );
+            s8* cursor = end;
+
+            while( value > 0xffffffff ) {
+                u32 chunk = static_cast<u32>( value % 100000000 );
+                value /= 100000000;
+
+                for( s32 i = 0; i < 4; i++ ) {
+                    cursor -= 2;
+                    memcpy( cursor, NumberDigitPairs + (chunk % 100) * 2, 2 );
+                    chunk /= 100;
+                }
+            }
+
+            s32 head = formatDecimal( static_cast<u32>( value ), output );
+            s32 tail = static_cast<s32>( end - cursor );
+            memcpy( output + head, cursor, tail );
+            return head + tail;
+        }
+
+        //! Returns ceil(log2(5^e)) for e in [1, 3528], and 1 for e = 0.
+        NIMBLE_INLINE s32 pow5Bits( s32 e )
+        {
+            return static_cast<s32>( ((static_cast<u32>( e ) * 1217359) >> 19) + 1 );
+        }
+
+        //! Returns floor(log10(2^e)) for e in [0, 1650].
+        NIMBLE_INLINE u32 log10Pow2( s32 e )
+        {
+            return (static_cast<u32>( e ) * 78913) >> 18;
+        }
+
+        //! Returns floor(log10(5^e)) for e in [0, 2620].
+        NIMBLE_INLINE u32 log10Pow5( s32 e )
+        {
+            return (static_cast<u32>( e ) * 732923) >> 20;
+        }
+
+        //! Returns true if a non-zero value is divisible by 5^p.
+        NIMBLE_INLINE bool multipleOfPowerOf5( u64 value, u32 p )
+        {
+            u32 count = 0;
+
+            for( ; value % 5 == 0 && count < p; value /= 5 ) {
+                count++;
+            }
+
+            return count >= p;
+        }
+
+        //! Returns true if a value is divisible by 2^p.
+        NIMBLE_INLINE bool multipleOfPowerOf2( u64 value, u32 p )
+        {
+            return (value & ((1ull << p) - 1)) == 0;
+        }
+
+        //! Multiplies a value by a 125-bit table constant and shifts the product right by j bits.
+        NIMBLE_INLINE u64 mulShift64( u64 m, const u64* mul, s32 j )
+        {
+            u64 high0, high1;
+            multiply128( m, mul[0], high0 );
+            u64 low1  = multiply128( m, mul[1], high1 );
+            u64 sum   = high0 + low1;
+            high1    += sum < high0;
+
+            s32 shift = j - 64;
+            return (high1 << (64 - shift)) | (sum >> shift);
+        }
+
+        //! Converts a binary floating point number to the shortest decimal that rounds back to the same value.
+        /*!
+            This is the Ryu algorithm by Ulf Adams, "Ryu: fast float-to-string conversion", PLDI 2018.
+            The same 125-bit tables are used for both 32-bit and 64-bit inputs.
+        */
+        inline DecimalFloat shortestDecimal( u64 ieeeMantissa, u32 ieeeExponent, s32 mantissaBits, s32 exponentBias )
+        {
+            s32 e2;
+            u64 m2;
+
+            if( ieeeExponent == 0 ) {
+                e2 = 1 - exponentBias - mantissaBits - 2;
+                m2 = ieeeMantissa;
+            } else {
+                e2 = static_cast<s32>( ieeeExponent ) - exponentBias - mantissaBits - 2;
+                m2 = (1ull << mantissaBits) | ieeeMantissa;
+            }
+
+            bool acceptBounds = (m2 & 1) == 0;
+
+            // Determine the interval of valid decimal representations
+            u64 mv      = 4 * m2;
+            u32 mmShift = ieeeMantissa != 0 || ieeeExponent <= 1;
+
+            // Convert to a decimal power base
+            u64  vr, vp, vm;
+            s32  e10;
+            bool vmIsTrailingZeros = false;
+            bool vrIsTrailingZeros = false;
+
+            if( e2 >= 0 ) {
+                u32 q = log10Pow2( e2 ) - (e2 > 3);
+                s32 k = 125 + pow5Bits( q ) - 1;
+                s32 i = -e2 + static_cast<s32>( q ) + k;
+
+                e10 = static_cast<s32>( q );
+                vr  = mulShift64( 4 * m2, NumberPow5InvSplit[q], i );
+                vp  = mulShift64( 4 * m2 + 2, NumberPow5InvSplit[q], i );
+                vm  = mulShift64( 4 * m2 - 1 - mmShift, NumberPow5InvSplit[q], i );
+
+                if( q <= 21 ) {
+                    if( mv % 5 == 0 ) {
+                        vrIsTrailingZeros = multipleOfPowerOf5( mv, q );
+                    } else if( acceptBounds ) {
+                        vmIsTrailingZeros = multipleOfPowerOf5( mv - 1 - mmShift, q );
+                    } else {
+                        vp -= multipleOfPowerOf5( mv + 2, q );
+                    }
+                }
+            } else {
+                u32 q = log10Pow5( -e2 ) - (-e2 > 1);
+                s32 i = -e2 - static_cast<s32>( q );
+                s32 k = pow5Bits( i ) - 125;
+                s32 j = static_cast<s32>( q ) - k;
+
+                e10 = static_cast<s32>( q ) + e2;
+                vr  = mulShift64( 4 * m2, NumberPow5Split[i], j );
+                vp  = mulShift64( 4 * m2 + 2, NumberPow5Split[i], j );
+                vm  = mulShift64( 4 * m2 - 1 - mmShift, NumberPow5Split[i], j );
+
+                if( q <= 1 ) {
+                    vrIsTrailingZeros = true;
+
+                    if( acceptBounds ) {
+                        vmIsTrailingZeros = mmShift == 1;
+                    } else {
+                        --vp;
+                    }
+                } else if( q < 63 ) {
+                    vrIsTrailingZeros = multipleOfPowerOf2( mv, q );
+                }
+            }
+
+            // Find the shortest decimal representation in the interval of valid representations
+            s32 removed          = 0;
+            u32 lastRemovedDigit = 0;
+            u64 output;
+
+            if( vmIsTrailingZeros || vrIsTrailingZeros ) {
+                // The general case, which happens rarely
+                for( ; vp / 10 > vm / 10; removed++ ) {
+                    vmIsTrailingZeros &= vm % 10 == 0;
+                    vrIsTrailingZeros &= lastRemovedDigit == 0;
+                    lastRemovedDigit = static_cast<u32>( vr % 10 );
+                    vr /= 10;
+                    vp /= 10;
+                    vm /= 10;
+                }
+
+                if( vmIsTrailingZeros ) {
+                    for( ; vm % 10 == 0; removed++ ) {
+                        vrIsTrailingZeros &= lastRemovedDigit == 0;
+                        lastRemovedDigit = static_cast<u32>( vr % 10 );
+                        vr /= 10;
+                        vp /= 10;
+                        vm /= 10;
+                    }
+                }
+
+                // Round to even if the exact number is .....50..0
+                if( vrIsTrailingZeros && lastRemovedDigit == 5 && vr % 2 == 0 ) {
+                    lastRemovedDigit = 4;
+                }
+
+                // Take vr + 1 if vr is outside bounds or we need to round up
+                output = vr + ((vr == vm && (!acceptBounds || !vmIsTrailingZeros)) || lastRemovedDigit >= 5);
+            } else {
+                // The common case, remove two digits at a time first
+                bool roundUp = false;
+
+                if( vp / 100 > vm / 100 ) {
+                    roundUp  = vr % 100 >= 50;
+                    vr      /= 100;
+                    vp      /= 100;
+                    vm      /= 100;
+                    removed += 2;
+                }
+
+                for( ; vp / 10 > vm / 10; removed++ ) {
+                    roundUp = vr % 10 >= 5;
+                    vr /= 10;
+                    vp /= 10;
+                    vm /= 10;
+                }
+
+                output = vr + (vr == vm || roundUp);
+            }
+
+            DecimalFloat result;
+            result.mantissa = output;
+            result.exponent = e10 + removed;
+            return result;
+        }
+
+        //! Writes a decimal floating point number to a buffer and returns the number of written characters.
+        /*!
+            Numbers with a decimal point position in (-6, 21] range are written in a fixed
+            notation, others in a scientific notation, like the JavaScript does.
+        */
+        inline s32 formatDecimalFloat( bool negative, const DecimalFloat& value, s8* output )
+        {
+            s8  digits[20];
+            s32 count = formatDecimal( value.mantissa, digits );
+            s32 point = count + value.exponent;
+            s8* out   = output;
+
+            if( negative ) {
+                *out++ = '-';
+            }
+
+            if( value.exponent >= 0 && point <= 21 ) {
+                // An integer value
+                memcpy( out, digits, count );
+                memset( out + count, '0', value.exponent );
+                out += point;
+            } else if( point > 0 && point <= 21 ) {
+                // A decimal point is inside the digits
+                memcpy( out, digits, point );
+                out[point] = '.';
+                memcpy( out + point + 1, digits + point, count - point );
+                out += count + 1;
+            } else if( point > -6 && point <= 0 ) {
+                // A small number with leading zeros
+                *out++ = '0';
+                *out++ = '.';
+                memset( out, '0', -point );
+                memcpy( out - point, digits, count );
+                out += count - point;
+            } else {
+                // A scientific notation
+                *out++ = digits[0];
+
+                if( count > 1 ) {
+                    *out++ = '.';
+                    memcpy( out, digits + 1, count - 1 );
+                    out += count - 1;
+                }
+
+                s32 exponent = point - 1;
+                *out++ = 'e';
+                *out++ = exponent < 0 ? '-' : '+';
+                out   += formatDecimal( static_cast<u32>( exponent < 0 ? -exponent : exponent ), out );
+            }
+
+            return static_cast<s32>( out - output );
+        }
+
+        //! Writes a floating point value with the shortest decimal representation that rounds back to the same value.
+        template<typename TFloat>
+        s32 formatFloat( TFloat value, s8* output )
+        {
+            typedef FloatTraits<TFloat>         Traits;
+            typedef typename Traits::Bits       Bits;
+
+            Bits bits;
+            memcpy( &bits, &value, sizeof( bits ) );
+
+            bool negative = (bits >> (sizeof( Bits ) * 8 - 1)) != 0;
+            u64  mantissa = bits & ((static_cast<Bits>( 1 ) << Traits::MantissaBits) - 1);
+            u32  exponent = static_cast<u32>( (bits >> Traits::MantissaBits) & Traits::InfinitePower );
+            s8*  out      = output;
+
+            if( exponent == Traits::InfinitePower ) {
+                if( mantissa ) {
+                    memcpy( out, "nan", 3 );
+                    return 3;
+                }
+
+                if( negative ) {
+                    *out++ = '-';
+                }
+
+                memcpy( out, "inf", 3 );
+                return static_cast<s32>( out - output ) + 3;
+            }
+
+            if( exponent == 0 && mantissa == 0 ) {
+                if( negative ) {
+                    *out++ = '-';
+                }
+
+                *out++ = '0';
+                return static_cast<s32>( out - output );
+            }
+
+            return formatDecimalFloat( negative, shortestDecimal( mantissa, exponent, Traits::MantissaBits, Traits::ExponentBias ), output );
+        }
+
+        //! Parses decimal digits to an unsigned integer that can not exceed a specified value, returns the number of consumed characters.
+        template<typename TValue>
+        s32 parseDecimal( const s8* begin, const s8* end, TValue limit, TValue& value )
+        {
+            const s8* cursor = begin;
+            TValue    result = 0;
+
+            for( ; cursor != end; cursor++ ) {
+                u32 digit = static_cast<u32>( *cursor - '0' );
+
+                if( digit > 9 ) {
+                    break;
+                }
+
+                if( result > (limit - digit) / 10 ) {
+                    return 0;
+                }
+
+                result = result * 10 + digit;
+            }
+
+            if( cursor != begin ) {
+                value = result;
+            }
+
+            return static_cast<s32>( cursor - begin );
+        }
+
+        //! Parses an unsigned integer value.
+        template<typename TValue>
+        s32 parseUnsigned( const StringView& input, TValue& value )
+        {
+            const s8* begin = input.value();
+            return begin ? parseDecimal<TValue>( begin, begin + input.length(), ~static_cast<TValue>( 0 ), value ) : 0;
+        }
+
+        //! Parses a signed integer value with an optional minus sign.
+        template<typename TSigned, typename TUnsigned>
+        s32 parseSigned( const StringView& input, TSigned& value )
+        {
+            const s8* begin = input.value();
+            const s8* end   = begin + input.length();
+
+            if( begin == NULL || begin == end ) {
+                return 0;
+            }
+
+            bool      negative = *begin == '-';
+            TUnsigned limit    = static_cast<TUnsigned>( ~static_cast<TUnsigned>( 0 ) >> 1 ) + negative;
+            TUnsigned result;
+
+            s32 consumed = parseDecimal<TUnsigned>( begin + negative, end, limit, result );
+
+            if( consumed == 0 ) {
+                return 0;
+            }
+
+            value = negative ? static_cast<TSigned>( 0 - result ) : static_cast<TSigned>( result );
+            return consumed + negative;
+        }
+
+        //! Converts a decimal w * 10^q to the nearest binary floating point value.
+        /*!
+            This is the Eisel-Lemire algorithm, see Daniel Lemire, "Number Parsing at a Gigabyte per Second",
+            Software: Practice and Experience 51 (8), 2021. The w value should contain all significant digits.
+        */
+        template<typename TFloat>
+        TFloat decimalToFloat( u64 w, s64 q, bool negative )
+        {
+            typedef FloatTraits<TFloat>         Traits;
+            typedef typename Traits::Bits       Bits;
+
+            u64 mantissa = 0;
+            s32 power2   = 0;
+
+            if( w == 0 || q < Traits::SmallestPowerOfTen ) {
+                // The value is rounded to zero
+            } else if( q > Traits::LargestPowerOfTen ) {
+                power2 = Traits::InfinitePower;
+            } else {
+                s32 lz = countLeadingZeros( w );
+                w <<= lz;
+
+                // Multiply by a truncated power of five, the second product improves the precision when needed
+                const u64* power = NumberPow5Truncated128 + 2 * (q - NumberPow5Truncated128Min);
+                u64        high;
+                u64        low   = multiply128( w, power[0], high );
+                u64        precisionMask = ~0ull >> (Traits::MantissaBits + 3);
+
+                if( (high & precisionMask) == precisionMask ) {
+                    u64 high2;
+                    multiply128( w, power[1], high2 );
+                    low += high2;
+                    high += high2 > low;
+                }
+
+                s32 upperBit = static_cast<s32>( high >> 63 );
+                s32 shift    = upperBit + 64 - Traits::MantissaBits - 3;
+
+                mantissa = high >> shift;
+                power2   = static_cast<s32>( (((152170 + 65536) * q) >> 16) + 63 ) + upperBit - lz + Traits::ExponentBias;
+
+                if( power2 <= 0 ) {
+                    // A subnormal value
+                    if( -power2 + 1 >= 64 ) {
+                        mantissa = 0;
+                        power2   = 0;
+                    } else {
+                        mantissa >>= -power2 + 1;
+                        mantissa  += mantissa & 1;
+                        mantissa >>= 1;
+                        power2     = mantissa < (1ull << Traits::MantissaBits) ? 0 : 1;
+                        mantissa  &= ~(1ull << Traits::MantissaBits);
+                    }
+                } else {
+                    // Round to even when the value falls exactly in between
+                    if( low <= 1 && q >= Traits::MinRoundToEven && q <= Traits::MaxRoundToEven && (mantissa & 3) == 1 && (mantissa << shift) == high ) {
+                        mantissa &= ~1ull;
+                    }
+
+                    mantissa += mantissa & 1;
+                    mantissa >>= 1;
+
+                    if( mantissa >= (2ull << Traits::MantissaBits) ) {
+                        mantissa = 1ull << Traits::MantissaBits;
+                        power2++;
+                    }
+
+                    mantissa &= ~(1ull << Traits::MantissaBits);
+
+                    if( power2 >= Traits::InfinitePower ) {
+                        power2   = Traits::InfinitePower;
+                        mantissa = 0;
+                    }
+                }
+            }
+
+            Bits bits = static_cast<Bits>( mantissa | (static_cast<u64>( power2 ) << Traits::MantissaBits) );
+            bits |= static_cast<Bits>( negative ) << (sizeof( Bits ) * 8 - 1);
+
+            TFloat result;
+            memcpy( &result, &bits, sizeof( result ) );
+            return result;
+        }
+
+        //! Returns true if the input starts with a specified lower case word, ignoring the character case.
+        inline bool startsWithNoCase( const s8* begin, const s8* end, CString word )
+        {
+            for( ; *word; word++, begin++ ) {
+                if( begin == end || (*begin | 0x20) != *word ) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        //! Parses a floating point value in a fixed or a scientific notation.
+        template<typename TFloat>
+        s32 parseFloat( const StringView& input, TFloat& value )
+        {
+            const s8* begin  = input.value();
+            const s8* end    = begin + input.length();
+            const s8* cursor = begin;
+
+            if( begin == NULL ) {
+                return 0;
+            }
+
+            bool negative = cursor != end && *cursor == '-';
+            cursor += negative;
+
+            // Parse special values
+            if( cursor != end && ((*cursor | 0x20) == 'i' || (*cursor | 0x20) == 'n') ) {
+                TFloat special;
+
+                if( startsWithNoCase( cursor, end, "infinity" ) ) {
+                    special = std::numeric_limits<TFloat>::infinity();
+                    cursor += 8;
+                } else if( startsWithNoCase( cursor, end, "inf" ) ) {
+                    special = std::numeric_limits<TFloat>::infinity();
+                    cursor += 3;
+                } else if( startsWithNoCase( cursor, end, "nan" ) ) {
+                    special = std::numeric_limits<TFloat>::quiet_NaN();
+                    cursor += 3;
+                } else {
+                    return 0;
+                }
+
+                value = negative ? -special : special;
+                return static_cast<s32>( cursor - begin );
+            }
+
+            // Accumulate up to 19 significant digits
+            u64  mantissa  = 0;
+            s32  digits    = 0;
+            s64  exponent  = 0;
+            bool truncated = false;
+            bool hasDigits = false;
+
+            for( ; cursor != end && static_cast<u32>( *cursor - '0' ) <= 9; cursor++ ) {
+                u32 digit = *cursor - '0';
+                hasDigits = true;
+
+                if( mantissa == 0 && digit == 0 ) {
+                    continue;
+                }
+
+                if( digits < 19 ) {
+                    mantissa = mantissa * 10 + digit;
+                    digits++;
+                } else {
+                    exponent++;
+                    truncated |= digit != 0;
+                }
+            }
+
+            if( cursor != end && *cursor == '.' ) {
+                for( cursor++; cursor != end && static_cast<u32>( *cursor - '0' ) <= 9; cursor++ ) {
+                    u32 digit = *cursor - '0';
+                    hasDigits = true;
+
+                    if( mantissa == 0 && digit == 0 ) {
+                        exponent--;
+                        continue;
+                    }
+
+                    if( digits < 19 ) {
+                        mantissa = mantissa * 10 + digit;
+                        digits++;
+                        exponent--;
+                    } else {
+                        truncated |= digit != 0;
+                    }
+                }
+            }
+
+            if( !hasDigits ) {
+                return 0;
+            }
+
+            // Parse an optional exponent, it is not consumed if there are no digits after it
+            if( cursor != end && (*cursor | 0x20) == 'e' ) {
+                const s8* next     = cursor + 1;
+                bool      minus    = next != end && *next == '-';
+                s64       explicitExponent = 0;
+
+                next += next != end && (*next == '-' || *next == '+');
+
+                if( next != end && static_cast<u32>( *next - '0' ) <= 9 ) {
+                    for( ; next != end && static_cast<u32>( *next - '0' ) <= 9; next++ ) {
+                        if( explicitExponent < 100000 ) {
+                            explicitExponent = explicitExponent * 10 + (*next - '0');
+                        }
+                    }
+
+                    exponent += minus ? -explicitExponent : explicitExponent;
+                    cursor    = next;
+                }
+            }
+
+            s32 consumed = static_cast<s32>( cursor - begin );
+
+            // Too many significant digits, so fallback to a C library conversion
+            if( truncated ) {
+                String text( begin, consumed );
+                value = static_cast<TFloat>( sizeof( TFloat ) == sizeof( f32 ) ? strtof( text.c_str(), NULL ) : strtod( text.c_str(), NULL ) );
+                return consumed;
+            }
+
+        #if defined( FLT_EVAL_METHOD ) && FLT_EVAL_METHOD == 0
+            // Both the mantissa and a power of ten are exact doubles, so a single operation is correctly rounded
+            if( sizeof( TFloat ) == sizeof( f64 ) && mantissa <= (1ull << 53) && exponent >= -22 && exponent <= 22 ) {
+                static const f64 powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+                f64 result = static_cast<f64>( mantissa );
+                result = exponent < 0 ? result / powers[-exponent] : result * powers[exponent];
+                value  = static_cast<TFloat>( negative ? -result : result );
+                return consumed;
+            }
+        #endif  /*  FLT_EVAL_METHOD */
+
+            value = decimalToFloat<TFloat>( mantissa, exponent, negative );
+            return consumed;
+        }
+
+    } // namespace Private
+
+    //! Fast conversions between numbers and their text representation without streams and locales.
+    /*!
+        Format functions write characters to a buffer that should have space for at least MaxLength
+        characters, the output is not zero-terminated. Floating point values are written with the
+        shortest representation that parses back to the same value.
+
+        Parse functions return the number of consumed characters or 0 if the input does not start
+        with a number or if the number does not fit the value type, in which case the value is not
+        modified.
+    */
+    namespace Number {
+
+        //! The maximum number of characters written by format functions.
+        enum { MaxLength = 32 };
+
+        //! Writes an unsigned 32-bit integer and returns the number of written characters.
+        inline s32 format( u32 value, s8* output ) { return Private::formatDecimal( value, output ); }
+
+        //! Writes an unsigned 64-bit integer and returns the number of written characters.
+        inline s32 format( u64 value, s8* output ) { return Private::formatDecimal( value, output ); }
+
+        //! Writes a signed 32-bit integer and returns the number of written characters.
+        inline s32 format( s32 value, s8* output )
+        {
+            if( value >= 0 ) {
+                return Private::formatDecimal( static_cast<u32>( value ), output );
+            }
+
+            *output = '-';
+            return Private::formatDecimal( 0u - static_cast<u32>( value ), output + 1 ) + 1;
+        }
+
+        //! Writes a signed 64-bit integer and returns the number of written characters.
+        inline s32 format( s64 value, s8* output )
+        {
+            if( value >= 0 ) {
+                return Private::formatDecimal( static_cast<u64>( value ), output );
+            }
+
+            *output = '-';
+            return Private::formatDecimal( 0ull - static_cast<u64>( value ), output + 1 ) + 1;
+        }
+
+        //! Writes the shortest decimal representation of a 32-bit floating point value and returns the number of written characters.
+        inline s32 format( f32 value, s8* output ) { return Private::formatFloat<f32>( value, output ); }
+
+        //! Writes the shortest decimal representation of a 64-bit floating point value and returns the number of written characters.
+        inline s32 format( f64 value, s8* output ) { return Private::formatFloat<f64>( value, output ); }
+
+        //! Parses an unsigned 32-bit integer.
+        inline s32 parse( const StringView& input, u32& value ) { return Private::parseUnsigned<u32>( input, value ); }
+
+        //! Parses an unsigned 64-bit integer.
+        inline s32 parse( const StringView& input, u64& value ) { return Private::parseUnsigned<u64>( input, value ); }
+
+        //! Parses a signed 32-bit integer.
+        inline s32 parse( const StringView& input, s32& value ) { return Private::parseSigned<s32, u32>( input, value ); }
+
+        //! Parses a signed 64-bit integer.
+        inline s32 parse( const StringView& input, s64& value ) { return Private::parseSigned<s64, u64>( input, value ); }
+
+        //! Parses a 32-bit floating point value, the result is correctly rounded.
+        inline s32 parse( const StringView& input, f32& value ) { return Private::parseFloat<f32>( input, value ); }
+
+        //! Parses a 64-bit floating point value, the result is correctly rounded.
+        inline s32 parse( const StringView& input, f64& value ) { return Private::parseFloat<f64>( input, value ); }
+
+    } // namespace Number
+
+    //! Converts a signed 32-bit integer to a string without a string stream.
+    inline String toString( s32 value )
+    {
+        s8 buffer[Number::MaxLength];
+        return String( buffer, Number::format( value, buffer ) );
+    }
+
+    //! Converts an unsigned 32-bit integer to a string without a string stream.
+    inline String toString( u32 value )
+    {
+        s8 buffer[Number::MaxLength];
+        return String( buffer, Number::format( value, buffer ) );
+    }
+
+    //! Converts a signed 64-bit integer to a string without a string stream.
+    inline String toString( s64 value )
+    {
+        s8 buffer[Number::MaxLength];
+        return String( buffer, Number::format( value, buffer ) );
+    }
+
+    //! Converts an unsigned 64-bit integer to a string without a string stream.
+    inline String toString( u64 value )
+    {
+        s8 buffer[Number::MaxLength];
+        return String( buffer, Number::format( value, buffer ) );
+    }
+
+NIMBLE_END
+
+#endif  /*    !__Nimble_NumberConversion_H__    */
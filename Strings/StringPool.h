@@ -0,0 +1,451 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_StringPool_H__
+#define __Nimble_StringPool_H__
+
+#include "../Globals.h"
+#include "../Hash.h"
+#include "../Patterns/Singleton.h"
+#include "FixedString.h"
+#include "StringView.h"
+
+#if NIMBLE_CPP11_ENABLED
+    #include <mutex>
+#endif  /*  NIMBLE_CPP11_ENABLED    */
+
+NIMBLE_BEGIN
+
+    //! A string interning pool that stores each distinct string once.
+    /*!
+        Strings are copied to arena pages that are never moved or released until the
+        pool is destroyed, so returned entries stay valid for the whole pool lifetime.
+        The pool is split to shards selected by a string hash, each shard is guarded
+        by it's own mutex, so strings can be interned from multiple threads.
+    */
+    class StringPool : public Singleton<StringPool> {
+    public:
+
+        //! An interned string header followed by string characters.
+        struct Entry {
+            u32                 hash;       //!< A string hash value.
+            s32                 length;     //!< A string length.
+            s8                  value[1];   //!< Zero-terminated string characters.
+        };
+
+                                //! Constructs a StringPool instance.
+                                StringPool( void );
+                                ~StringPool( void );
+
+        //! Returns a unique entry for a specified string, the string is copied to a pool when seen for the first time.
+        const Entry*            intern( const s8* value, s32 length );
+
+        //! Returns a unique entry for a specified string or NULL if it was not interned yet.
+        const Entry*            find( const s8* value, s32 length ) const;
+
+        //! Returns the total number of distinct strings stored in a pool.
+        u32                     size( void ) const;
+
+        //! Returns the total number of bytes allocated by pool arenas.
+        u32                     allocatedBytes( void ) const;
+
+    private:
+
+        NIMBLE_DISABLE_COPY( StringPool )
+
+        //! Pool configuration constants.
+        enum {
+              ShardBits         = 4                 //!< The number of hash bits used to select a shard.
+            , ShardCount        = 1 << ShardBits    //!< The total number of shards.
+            , PageSize          = 64 * 1024         //!< The arena page size.
+            , InitialCapacity   = 64                //!< The initial hash table capacity of each shard.
+        };
+
+        //! A pool shard owns a hash table and an arena.
+        struct Shard {
+                                //! Constructs a Shard instance.
+                                Shard( void )
+                                    : count( 0 ), offset( PageSize ), bytes( 0 ) {}
+
+            Array<const Entry*> table;      //!< An open addressing hash table of interned strings.
+            u32                 count;      //!< The number of strings stored in a shard.
+            Array<u8*>          pages;      //!< Allocated arena pages.
+            u32                 offset;     //!< The first free byte inside the last arena page.
+            u32                 bytes;      //!< The total number of allocated bytes.
+        #if NIMBLE_CPP11_ENABLED
+            mutable std::mutex  mutex;      //!< Guards shard data.
+        #endif  /*  NIMBLE_CPP11_ENABLED    */
+        };
+
+        //! Calculates the string hash value.
+        static u32              hash( const s8* value, s32 length );
+
+        //! Returns a table slot for a string, it is either the slot with a matching entry or an empty one.
+        static const Entry**    lookup( const Shard& shard, u32 hash, const s8* value, s32 length );
+
+        //! Allocates and initializes a new entry from a shard arena.
+        static Entry*           allocate( Shard& shard, u32 hash, const s8* value, s32 length );
+
+        //! Doubles the shard hash table capacity.
+        static void             grow( Shard& shard );
+
+    private:
+
+        Shard                   m_shards[ShardCount];   //!< Pool shards.
+    };
+
+    // ** StringPool::StringPool
+    inline StringPool::StringPool( void )
+    {
+        for( s32 i = 0; i < ShardCount; i++ ) {
+            m_shards[i].table.resize( InitialCapacity, NULL );
+        }
+    }
+
+    // ** StringPool::~StringPool
+    inline StringPool::~StringPool( void )
+    {
+        for( s32 i = 0; i < ShardCount; i++ ) {
+            for( size_t j = 0, n = m_shards[i].pages.size(); j < n; j++ ) {
+                free( m_shards[i].pages[j] );
+            }
+        }
+    }
+
+    // ** StringPool::hash
+    NIMBLE_INLINE u32 StringPool::hash( const s8* value, s32 length )
+    {
+        return HashFunction::murmur<u32>( value, length );
+    }
+
+    // ** StringPool::lookup
+    inline const StringPool::Entry** StringPool::lookup( const Shard& shard, u32 hash, const s8* value, s32 length )
+    {
+        const Entry** table = const_cast<const Entry**>( &shard.table[0] );
+        u32           mask  = static_cast<u32>( shard.table.size() ) - 1;
+
+        // Linear probing, the table is never more than half full
+        for( u32 i = hash & mask; ; i = (i + 1) & mask ) {
+            const Entry* entry = table[i];
+
+            if( entry == NULL ) {
+                return table + i;
+            }
+
+            if( entry->hash == hash && entry->length == length && memcmp( entry->value, value, length ) == 0 ) {
+                return table + i;
+            }
+        }
+    }
+
+    // ** StringPool::allocate
+    inline StringPool::Entry* StringPool::allocate( Shard& shard, u32 hash, const s8* value, s32 length )
+    {
+        // Keep entries aligned to 8 bytes
+        u32 size = (static_cast<u32>( offsetof( Entry, value ) + length + 1 ) + 7) & ~7u;
+        u8* bytes;
+
+        if( size > PageSize / 4 ) {
+            // Large strings are stored in a dedicated page, so the current page is not wasted
+            bytes = reinterpret_cast<u8*>( malloc( size ) );
+            shard.pages.push_back( bytes );
+        } else {
+            if( shard.offset + size > PageSize ) {
+                shard.pages.push_back( reinterpret_cast<u8*>( malloc( PageSize ) ) );
+                shard.offset = 0;
+            }
+
+            bytes = shard.pages.back() + shard.offset;
+            shard.offset += size;
+        }
+
+        shard.bytes += size;
+
+        Entry* entry  = reinterpret_cast<Entry*>( bytes );
+        entry->hash   = hash;
+        entry->length = length;
+        memcpy( entry->value, value, length );
+        entry->value[length] = 0;
+
+        return entry;
+    }
+
+    // ** StringPool::grow
+    inline void StringPool::grow( Shard& shard )
+    {
+        Array<const Entry*> table;
+        table.resize( shard.table.size() * 2, NULL );
+
+        u32 mask = static_cast<u32>( table.size() ) - 1;
+
+        for( size_t i = 0, n = shard.table.size(); i < n; i++ ) {
+            const Entry* entry = shard.table[i];
+
+            if( entry == NULL ) {
+                continue;
+            }
+
+            u32 slot = entry->hash & mask;
+            while( table[slot] ) {
+                slot = (slot + 1) & mask;
+            }
+            table[slot] = entry;
+        }
+
+        shard.table.swap( table );
+    }
+
+    // ** StringPool::intern
+    inline const StringPool::Entry* StringPool::intern( const s8* value, s32 length )
+    {
+        u32    h     = hash( value, length );
+        Shard& shard = m_shards[h >> (32 - ShardBits)];
+
+    #if NIMBLE_CPP11_ENABLED
+        std::lock_guard<std::mutex> lock( shard.mutex );
+    #endif  /*  NIMBLE_CPP11_ENABLED    */
+
+        const Entry** slot = lookup( shard, h, value, length );
+
+        if( *slot ) {
+            return *slot;
+        }
+
+        Entry* entry = allocate( shard, h, value, length );
+        *slot = entry;
+
+        if( ++shard.count * 2 > shard.table.size() ) {
+            grow( shard );
+        }
+
+        return entry;
+    }
+
+    // ** StringPool::find
+    inline const StringPool::Entry* StringPool::find( const s8* value, s32 length ) const
+    {
+        u32          h     = hash( value, length );
+        const Shard& shard = m_shards[h >> (32 - ShardBits)];
+
+    #if NIMBLE_CPP11_ENABLED
+        std::lock_guard<std::mutex> lock( shard.mutex );
+    #endif  /*  NIMBLE_CPP11_ENABLED    */
+
+        return *lookup( shard, h, value, length );
+    }
+
+    // ** StringPool::size
+    inline u32 StringPool::size( void ) const
+    {
+        u32 result = 0;
+
+        for( s32 i = 0; i < ShardCount; i++ ) {
+        #if NIMBLE_CPP11_ENABLED
+            std::lock_guard<std::mutex> lock( m_shards[i].mutex );
+        #endif  /*  NIMBLE_CPP11_ENABLED    */
+            result += m_shards[i].count;
+        }
+
+        return result;
+    }
+
+    // ** StringPool::allocatedBytes
+    inline u32 StringPool::allocatedBytes( void ) const
+    {
+        u32 result = 0;
+
+        for( s32 i = 0; i < ShardCount; i++ ) {
+        #if NIMBLE_CPP11_ENABLED
+            std::lock_guard<std::mutex> lock( m_shards[i].mutex );
+        #endif  /*  NIMBLE_CPP11_ENABLED    */
+            result += m_shards[i].bytes;
+        }
+
+        return result;
+    }
+
+    //! Interned string is a handle to a unique string stored in a StringPool.
+    /*!
+        Two interned strings from the same pool are equal only if they point to the
+        same pool entry, so equality and hashing are pointer operations. Note that the
+        less operator compares entry addresses and is not a lexicographical order.
+    */
+    class InternedString {
+    public:
+
+                            //! Constructs an empty InternedString instance.
+                            InternedString( void );
+
+                            //! Constructs an InternedString from a pointer and length.
+        explicit            InternedString( CString value, s32 length = 0, StringPool& pool = StringPool::instance() );
+
+                            //! Constructs an InternedString from a string view.
+        explicit            InternedString( const StringView& value, StringPool& pool = StringPool::instance() );
+
+                            //! Constructs an InternedString from a fixed string.
+        explicit            InternedString( const FixedString& value, StringPool& pool = StringPool::instance() );
+
+        //! Tests two interned strings for an equality.
+        bool                operator == ( const InternedString& other ) const;
+
+        //! Tests two interned strings for an inequality.
+        bool                operator != ( const InternedString& other ) const;
+
+        //! Compares two interned strings by their addresses.
+        bool                operator < ( const InternedString& other ) const;
+
+        //! Returns true if this is an empty string.
+        bool                isEmpty( void ) const;
+
+        //! Returns a string length.
+        s32                 length( void ) const;
+
+        //! Returns a zero-terminated string value.
+        CString             value( void ) const;
+
+        //! Returns a string contents hash value.
+        u32                 hash( void ) const;
+
+        //! Returns an interned string pool entry.
+        const StringPool::Entry*  entry( void ) const;
+
+        //! Returns a string view of an interned string.
+        StringView          view( void ) const;
+
+        //! Returns a fixed string that wraps an interned string.
+        FixedString         fixed( void ) const;
+
+    private:
+
+        //! Interns the string in a pool.
+        void                intern( CString value, s32 length, StringPool& pool );
+
+    private:
+
+        const StringPool::Entry*  m_entry;  //!< Interned string pool entry.
+    };
+
+    // ** InternedString::InternedString
+    NIMBLE_INLINE InternedString::InternedString( void )
+        : m_entry( NULL )
+    {
+    }
+
+    // ** InternedString::InternedString
+    NIMBLE_INLINE InternedString::InternedString( CString value, s32 length, StringPool& pool )
+        : m_entry( NULL )
+    {
+        if( value ) {
+            intern( value, static_cast<s32>( length ? length : strlen( value ) ), pool );
+        }
+    }
+
+    // ** InternedString::InternedString
+    NIMBLE_INLINE InternedString::InternedString( const StringView& value, StringPool& pool )
+        : m_entry( NULL )
+    {
+        intern( value.value(), value.length(), pool );
+    }
+
+    // ** InternedString::InternedString
+    NIMBLE_INLINE InternedString::InternedString( const FixedString& value, StringPool& pool )
+        : m_entry( NULL )
+    {
+        intern( value.value(), value.length(), pool );
+    }
+
+    // ** InternedString::intern
+    NIMBLE_INLINE void InternedString::intern( CString value, s32 length, StringPool& pool )
+    {
+        // All empty strings are represented by a NULL entry
+        if( length ) {
+            m_entry = pool.intern( value, length );
+        }
+    }
+
+    // ** InternedString::operator ==
+    NIMBLE_INLINE bool InternedString::operator == ( const InternedString& other ) const
+    {
+        return m_entry == other.m_entry;
+    }
+
+    // ** InternedString::operator !=
+    NIMBLE_INLINE bool InternedString::operator != ( const InternedString& other ) const
+    {
+        return m_entry != other.m_entry;
+    }
+
+    // ** InternedString::operator <
+    NIMBLE_INLINE bool InternedString::operator < ( const InternedString& other ) const
+    {
+        return m_entry < other.m_entry;
+    }
+
+    // ** InternedString::isEmpty
+    NIMBLE_INLINE bool InternedString::isEmpty( void ) const
+    {
+        return m_entry == NULL;
+    }
+
+    // ** InternedString::length
+    NIMBLE_INLINE s32 InternedString::length( void ) const
+    {
+        return m_entry ? m_entry->length : 0;
+    }
+
+    // ** InternedString::value
+    NIMBLE_INLINE CString InternedString::value( void ) const
+    {
+        return m_entry ? m_entry->value : "";
+    }
+
+    // ** InternedString::hash
+    NIMBLE_INLINE u32 InternedString::hash( void ) const
+    {
+        return m_entry ? m_entry->hash : 0;
+    }
+
+    // ** InternedString::entry
+    NIMBLE_INLINE const StringPool::Entry* InternedString::entry( void ) const
+    {
+        return m_entry;
+    }
+
+    // ** InternedString::view
+    NIMBLE_INLINE StringView InternedString::view( void ) const
+    {
+        return StringView( value(), length() );
+    }
+
+    // ** InternedString::fixed
+    NIMBLE_INLINE FixedString InternedString::fixed( void ) const
+    {
+        return FixedString( value(), length() );
+    }
+
+NIMBLE_END
+
+#endif  /*    !__Nimble_StringPool_H__    */
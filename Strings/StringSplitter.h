@@ -0,0 +1,330 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_StringSplitter_H__
+#define __Nimble_StringSplitter_H__
+
+#include "../Globals.h"
+#include "../Preprocessor/Simd.h"
+#include "StringView.h"
+
+NIMBLE_BEGIN
+
+    //! A set of delimiter characters used to split strings.
+    class DelimiterSet {
+    public:
+
+        //! The maximum number of delimiters that are searched with SIMD instructions.
+        enum { MaxVectorized = 8 };
+
+                            //! Constructs an empty DelimiterSet instance.
+                            DelimiterSet( void );
+
+                            //! Constructs a DelimiterSet instance from a zero-terminated string of delimiter characters.
+        explicit            DelimiterSet( CString delimiters );
+
+        //! Returns true if a character is a delimiter.
+        bool                contains( s8 character ) const;
+
+        //! Returns the total number of delimiter characters.
+        s32                 size( void ) const;
+
+        //! Returns a pointer to the first delimiter inside the [begin, end) range or end if there is no delimiters.
+        const s8*           find( const s8* begin, const s8* end ) const;
+
+    private:
+
+        u32                 m_bits[8];                  //!< A bitmap with one bit per character.
+        s8                  m_chars[MaxVectorized];     //!< First delimiter characters used by SIMD search.
+        s32                 m_count;                    //!< The total number of delimiter characters.
+    };
+
+    // ** DelimiterSet::DelimiterSet
+    NIMBLE_INLINE DelimiterSet::DelimiterSet( void )
+        : m_count( 0 )
+    {
+        memset( m_bits, 0, sizeof( m_bits ) );
+    }
+
+    // ** DelimiterSet::DelimiterSet
+    NIMBLE_INLINE DelimiterSet::DelimiterSet( CString delimiters )
+        : m_count( 0 )
+    {
+        memset( m_bits, 0, sizeof( m_bits ) );
+
+        for( ; *delimiters; delimiters++ ) {
+            u8 character = static_cast<u8>( *delimiters );
+
+            if( contains( *delimiters ) ) {
+                continue;
+            }
+
+            if( m_count < MaxVectorized ) {
+                m_chars[m_count] = *delimiters;
+            }
+
+            m_bits[character >> 5] |= 1u << (character & 31);
+            m_count++;
+        }
+    }
+
+    // ** DelimiterSet::contains
+    NIMBLE_INLINE bool DelimiterSet::contains( s8 character ) const
+    {
+        u8 index = static_cast<u8>( character );
+        return (m_bits[index >> 5] >> (index & 31)) & 1;
+    }
+
+    // ** DelimiterSet::size
+    NIMBLE_INLINE s32 DelimiterSet::size( void ) const
+    {
+        return m_count;
+    }
+
+    // ** DelimiterSet::find
+    inline const s8* DelimiterSet::find( const s8* begin, const s8* end ) const
+    {
+    #if NIMBLE_SIMD_SSE2
+        // Compare blocks of input characters with each delimiter, when there are just a few of them
+        if( m_count <= MaxVectorized ) {
+        #if NIMBLE_SIMD_AVX2
+            __m256i wide[MaxVectorized];
+            for( s32 i = 0; i < m_count; i++ ) {
+                wide[i] = _mm256_set1_epi8( m_chars[i] );
+            }
+
+            for( ; end - begin >= 32; begin += 32 ) {
+                __m256i block   = _mm256_loadu_si256( reinterpret_cast<const __m256i*>( begin ) );
+                __m256i matches = _mm256_setzero_si256();
+
+                for( s32 i = 0; i < m_count; i++ ) {
+                    matches = _mm256_or_si256( matches, _mm256_cmpeq_epi8( block, wide[i] ) );
+                }
+
+                if( u32 mask = static_cast<u32>( _mm256_movemask_epi8( matches ) ) ) {
+                    return begin + countTrailingZeros( mask );
+                }
+            }
+        #endif  /*  NIMBLE_SIMD_AVX2    */
+
+            __m128i delimiters[MaxVectorized];
+            for( s32 i = 0; i < m_count; i++ ) {
+                delimiters[i] = _mm_set1_epi8( m_chars[i] );
+            }
+
+            for( ; end - begin >= 16; begin += 16 ) {
+                __m128i block   = _mm_loadu_si128( reinterpret_cast<const __m128i*>( begin ) );
+                __m128i matches = _mm_setzero_si128();
+
+                for( s32 i = 0; i < m_count; i++ ) {
+                    matches = _mm_or_si128( matches, _mm_cmpeq_epi8( block, delimiters[i] ) );
+                }
+
+                if( u32 mask = static_cast<u32>( _mm_movemask_epi8( matches ) ) ) {
+                    return begin + countTrailingZeros( mask );
+                }
+            }
+        }
+    #endif  /*  NIMBLE_SIMD_SSE2    */
+
+        for( ; begin != end; begin++ ) {
+            if( contains( *begin ) ) {
+                return begin;
+            }
+        }
+
+        return end;
+    }
+
+    //! Lazily splits a string view to tokens that point to the original buffer.
+    /*!
+        Tokens are produced on demand without any allocations, so the input buffer
+        should outlive both the splitter and all returned tokens. Empty tokens are
+        represented by an empty StringView with a NULL value.
+    */
+    class StringSplitter {
+    public:
+
+        //! Available splitter flags.
+        enum Flags {
+              SkipEmpty     = BIT( 0 )  //!< Consecutive delimiters are treated as a single one, so no empty tokens are produced.
+            , Lines         = BIT( 1 )  //!< Trailing carriage return characters are stripped and no empty token is produced after a trailing delimiter.
+        };
+
+        //! Forward iterator over string tokens.
+        class Iterator {
+        friend class StringSplitter;
+        public:
+
+            //! Returns the current token.
+            const StringView&   operator * ( void ) const { return m_token; }
+
+            //! Returns the pointer to a current token.
+            const StringView*   operator -> ( void ) const { return &m_token; }
+
+            //! Advances to the next token.
+            Iterator&           operator ++ ( void ) { m_valid = m_splitter->read( m_cursor, m_token ); return *this; }
+
+            //! Returns true if iterators point to different tokens.
+            bool                operator != ( const Iterator& other ) const { return m_valid != other.m_valid || (m_valid && m_cursor != other.m_cursor); }
+
+            //! Returns true if iterators point to the same token.
+            bool                operator == ( const Iterator& other ) const { return !(*this != other); }
+
+        private:
+
+                                //! Constructs an Iterator instance.
+                                Iterator( const StringSplitter* splitter, const s8* cursor, bool valid )
+                                    : m_splitter( splitter ), m_cursor( cursor ), m_valid( valid ) {}
+
+        private:
+
+            const StringSplitter*   m_splitter; //!< Parent string splitter.
+            const s8*           m_cursor;       //!< A position to continue scanning from, NULL when the input is exhausted.
+            StringView          m_token;        //!< A current token.
+            bool                m_valid;        //!< Set to false once the last token was read.
+        };
+
+                            //! Constructs a StringSplitter instance.
+                            StringSplitter( const StringView& input, const DelimiterSet& delimiters, u8 flags = SkipEmpty );
+
+        //! Returns an iterator that points to the first token.
+        Iterator            begin( void ) const;
+
+        //! Returns an iterator that points past the last token.
+        Iterator            end( void ) const;
+
+        //! Reads the next token, returns false if there are no more tokens.
+        bool                next( StringView& token );
+
+        //! Constructs a splitter that splits the input by any of specified delimiter characters.
+        static StringSplitter   delimiters( const StringView& input, CString delimiters, u8 flags = SkipEmpty );
+
+        //! Constructs a splitter that splits the input to lines, both LF and CRLF line endings are supported.
+        static StringSplitter   lines( const StringView& input );
+
+        //! Constructs a splitter that splits the input to words separated by a whitespace.
+        static StringSplitter   whitespace( const StringView& input );
+
+    private:
+
+        //! Reads the token starting from a cursor and advances the cursor, returns false if there are no more tokens.
+        bool                read( const s8*& cursor, StringView& token ) const;
+
+    private:
+
+        const s8*           m_begin;        //!< The first input character.
+        const s8*           m_end;          //!< Points past the last input character.
+        const s8*           m_cursor;       //!< A cursor used by the next function.
+        DelimiterSet        m_delimiters;   //!< Delimiter characters.
+        u8                  m_flags;        //!< Splitter flags.
+    };
+
+    // ** StringSplitter::StringSplitter
+    NIMBLE_INLINE StringSplitter::StringSplitter( const StringView& input, const DelimiterSet& delimiters, u8 flags )
+        : m_begin( input.value() )
+        , m_end( input.value() + input.length() )
+        , m_cursor( input.value() )
+        , m_delimiters( delimiters )
+        , m_flags( flags )
+    {
+    }
+
+    // ** StringSplitter::begin
+    NIMBLE_INLINE StringSplitter::Iterator StringSplitter::begin( void ) const
+    {
+        Iterator i( this, m_begin, true );
+        return ++i;
+    }
+
+    // ** StringSplitter::end
+    NIMBLE_INLINE StringSplitter::Iterator StringSplitter::end( void ) const
+    {
+        return Iterator( this, NULL, false );
+    }
+
+    // ** StringSplitter::next
+    NIMBLE_INLINE bool StringSplitter::next( StringView& token )
+    {
+        return read( m_cursor, token );
+    }
+
+    // ** StringSplitter::read
+    inline bool StringSplitter::read( const s8*& cursor, StringView& token ) const
+    {
+        if( cursor == NULL ) {
+            return false;
+        }
+
+        // Skip leading delimiters
+        if( m_flags & SkipEmpty ) {
+            while( cursor != m_end && m_delimiters.contains( *cursor ) ) {
+                cursor++;
+            }
+        }
+
+        // A trailing delimiter produces an empty token only when empty tokens are not skipped
+        if( cursor == m_end && ((m_flags & (SkipEmpty | Lines)) || cursor == m_begin) ) {
+            cursor = NULL;
+            return false;
+        }
+
+        const s8* start = cursor;
+        const s8* stop  = m_delimiters.find( start, m_end );
+
+        // Continue after the delimiter or mark the input as exhausted
+        cursor = stop == m_end ? NULL : stop + 1;
+
+        if( (m_flags & Lines) && stop != start && stop[-1] == '\r' ) {
+            stop--;
+        }
+
+        token = stop == start ? StringView() : StringView( start, static_cast<s32>( stop - start ) );
+
+        return true;
+    }
+
+    // ** StringSplitter::delimiters
+    NIMBLE_INLINE StringSplitter StringSplitter::delimiters( const StringView& input, CString delimiters, u8 flags )
+    {
+        return StringSplitter( input, DelimiterSet( delimiters ), flags );
+    }
+
+    // ** StringSplitter::lines
+    NIMBLE_INLINE StringSplitter StringSplitter::lines( const StringView& input )
+    {
+        return StringSplitter( input, DelimiterSet( "\n" ), Lines );
+    }
+
+    // ** StringSplitter::whitespace
+    NIMBLE_INLINE StringSplitter StringSplitter::whitespace( const StringView& input )
+    {
+        return StringSplitter( input, DelimiterSet( " \t\r\n\v\f" ), SkipEmpty );
+    }
+
+NIMBLE_END
+
+#endif  /*    !__Nimble_StringSplitter_H__    */
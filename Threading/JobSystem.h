@@ -0,0 +1,513 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_JobSystem_H__
+#define __Nimble_JobSystem_H__
+
+#include "WorkStealingDeque.h"
+#include "../Pointers/Ptr.h"
+
+#if NIMBLE_CPP11_ENABLED
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+NIMBLE_BEGIN
+
+    class JobSystem;
+
+    // --------------------------------- Job --------------------------------- //
+
+    //! A unit of work executed by a JobSystem.
+    /*!
+        A job is finished once it is executed and all of its child jobs are finished.
+        A job is scheduled once it is submitted and all jobs it depends on are finished.
+    */
+    class Job : public AtomicRefCounted {
+    friend class JobSystem;
+    public:
+
+        virtual                 ~Job( void ) {}
+
+        //! Returns true if this job and all of its children are finished.
+        bool                    isFinished( void ) const;
+
+    protected:
+
+                                //! Constructs a Job instance.
+                                Job( void );
+
+        //! Runs the job.
+        virtual void            execute( void ) = 0;
+
+    private:
+
+        Ptr<Job>                m_parent;           //!< A parent job that is not finished until this one is.
+        std::atomic<s32>        m_unfinished;       //!< The job itself plus the number of unfinished children.
+        std::atomic<s32>        m_dependencies;     //!< The number of unfinished dependencies plus one until a job is submitted.
+        std::mutex              m_mutex;            //!< Guards continuations.
+        Array< Ptr<Job> >       m_continuations;    //!< Jobs that depend on this one.
+        bool                    m_isCompleted;      //!< Set once continuations were notified.
+    };
+
+    //! A strong reference to a job.
+    typedef Ptr<Job> JobHandle;
+
+    // ** Job::Job
+    inline Job::Job( void )
+        : m_unfinished( 1 )
+        , m_dependencies( 1 )
+        , m_isCompleted( false )
+    {
+    }
+
+    // ** Job::isFinished
+    inline bool Job::isFinished( void ) const
+    {
+        return m_unfinished.load( std::memory_order_acquire ) == 0;
+    }
+
+    namespace Private {
+
+        //! A job that invokes a callable object.
+        template<typename TCallable>
+        class CallableJob : public Job {
+        public:
+
+                                //! Constructs a CallableJob instance.
+                                CallableJob( const TCallable& callable )
+                                    : m_callable( callable ) {}
+
+        protected:
+
+            //! Invokes a callable object.
+            virtual void        execute( void ) NIMBLE_OVERRIDE { m_callable(); }
+
+        private:
+
+            TCallable           m_callable; //!< A callable object to be invoked.
+        };
+
+    } // namespace Private
+
+    // --------------------------------- JobSystem --------------------------------- //
+
+    //! A work-stealing job scheduler with a fixed number of worker threads.
+    /*!
+        Each worker owns a Chase-Lev deque, jobs spawned by a worker are pushed to its own
+        deque and idle workers steal from others. Jobs submitted by other threads go to a shared
+        queue. Waiting for a job never blocks a thread, it runs other jobs until the awaited
+        one is finished.
+    */
+    class JobSystem {
+    public:
+
+                                //! Constructs a JobSystem instance and starts workers, the hardware concurrency minus one is used if the worker count is zero.
+        explicit                JobSystem( s32 workerCount = 0 );
+                                ~JobSystem( void );
+
+        //! Returns the number of worker threads.
+        s32                     workerCount( void ) const;
+
+        //! Returns the index of a worker that runs a calling thread or -1 for other threads.
+        s32                     workerIndex( void ) const;
+
+        //! Creates a job that is not scheduled until it is submitted, the parent job is not finished until this one is.
+        template<typename TCallable>
+        JobHandle               create( const TCallable& callable, const JobHandle& parent = JobHandle() );
+
+        //! Makes a job wait for a dependency to finish, should be called before a job is submitted.
+        void                    addDependency( const JobHandle& job, const JobHandle& dependency );
+
+        //! Submits a job, it is executed once all of its dependencies are finished.
+        void                    submit( const JobHandle& job );
+
+        //! Creates and submits a job.
+        template<typename TCallable>
+        JobHandle               run( const TCallable& callable, const JobHandle& parent = JobHandle() );
+
+        //! Creates and submits a job that starts after a specified one is finished.
+        template<typename TCallable>
+        JobHandle               continueWith( const JobHandle& job, const TCallable& callable );
+
+        //! Runs other jobs until a specified one is finished.
+        void                    wait( const JobHandle& job );
+
+    private:
+
+                                JobSystem( const JobSystem& other );
+        JobSystem&              operator = ( const JobSystem& other );
+
+        //! Worker thread state.
+        struct Worker {
+            WorkStealingDeque<Job*> deque;      //!< Jobs spawned by this worker.
+            std::thread             thread;     //!< Worker thread.
+            JobSystem*              owner;      //!< A job system that owns this worker.
+            s32                     index;      //!< Worker index.
+            u32                     random;     //!< Random state used to pick a victim.
+        };
+
+        //! Returns a worker of this job system that runs a calling thread or NULL.
+        Worker*                 currentWorker( void ) const;
+
+        //! Pushes a job to a queue.
+        void                    schedule( Job* job );
+
+        //! Finds a job to run, pops it from a worker deque, steals from others or takes from a shared queue.
+        Job*                    findJob( Worker* worker );
+
+        //! Runs a job and releases a reference owned by a queue.
+        void                    execute( Job* job );
+
+        //! Decrements the number of unfinished jobs and notifies continuations and a parent once a job is finished.
+        void                    finish( Job* job );
+
+        //! A worker thread entry point.
+        void                    workerLoop( s32 index );
+
+        //! Returns a thread-local worker pointer.
+        static Worker*&         threadWorker( void );
+
+    private:
+
+        Array<Worker*>          m_workers;      //!< Worker threads.
+        std::mutex              m_mutex;        //!< Guards the shared queue and sleeping workers.
+        std::condition_variable m_wake;         //!< Wakes sleeping workers.
+        Array<Job*>             m_queue;        //!< Jobs submitted by threads that are not workers.
+        size_t                  m_queueHead;    //!< The index of the oldest job in a shared queue.
+        std::atomic<s32>        m_queued;       //!< The number of jobs in a shared queue.
+        std::atomic<s32>        m_sleeping;     //!< The number of sleeping workers.
+        std::atomic<bool>       m_isRunning;    //!< Cleared to stop workers.
+    };
+
+    // ** JobSystem::JobSystem
+    inline JobSystem::JobSystem( s32 workerCount )
+        : m_queueHead( 0 )
+        , m_queued( 0 )
+        , m_sleeping( 0 )
+        , m_isRunning( true )
+    {
+        if( workerCount <= 0 ) {
+            workerCount = max2<s32>( 1, static_cast<s32>( std::thread::hardware_concurrency() ) - 1 );
+        }
+
+        m_workers.resize( workerCount );
+
+        for( s32 i = 0; i < workerCount; i++ ) {
+            m_workers[i] = new Worker;
+            m_workers[i]->owner  = this;
+            m_workers[i]->index  = i;
+            m_workers[i]->random = 2463534242u + i * 7919;
+        }
+
+        // Workers are started after all of them are constructed, because they steal from each other
+        for( s32 i = 0; i < workerCount; i++ ) {
+            m_workers[i]->thread = std::thread( &JobSystem::workerLoop, this, i );
+        }
+    }
+
+    // ** JobSystem::~JobSystem
+    inline JobSystem::~JobSystem( void )
+    {
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_isRunning.store( false );
+        }
+        m_wake.notify_all();
+
+        for( size_t i = 0, n = m_workers.size(); i < n; i++ ) {
+            m_workers[i]->thread.join();
+        }
+
+        // Drop jobs that were never executed
+        Job* job;
+
+        for( size_t i = 0, n = m_workers.size(); i < n; i++ ) {
+            while( m_workers[i]->deque.pop( job ) ) {
+                job->release();
+            }
+            delete m_workers[i];
+        }
+
+        for( size_t i = m_queueHead, n = m_queue.size(); i < n; i++ ) {
+            m_queue[i]->release();
+        }
+    }
+
+    // ** JobSystem::workerCount
+    inline s32 JobSystem::workerCount( void ) const
+    {
+        return static_cast<s32>( m_workers.size() );
+    }
+
+    // ** JobSystem::threadWorker
+    inline JobSystem::Worker*& JobSystem::threadWorker( void )
+    {
+        static thread_local Worker* worker = NULL;
+        return worker;
+    }
+
+    // ** JobSystem::currentWorker
+    inline JobSystem::Worker* JobSystem::currentWorker( void ) const
+    {
+        Worker* worker = threadWorker();
+
+        // A thread may be a worker of another job system
+        return worker && worker->owner == this ? worker : NULL;
+    }
+
+    // ** JobSystem::workerIndex
+    inline s32 JobSystem::workerIndex( void ) const
+    {
+        Worker* worker = currentWorker();
+        return worker ? worker->index : -1;
+    }
+
+    // ** JobSystem::create
+    template<typename TCallable>
+    JobHandle JobSystem::create( const TCallable& callable, const JobHandle& parent )
+    {
+        JobHandle job( new Private::CallableJob<TCallable>( callable ) );
+
+        if( parent.valid() ) {
+            NIMBLE_ABORT_IF( parent->isFinished(), "child jobs should not be added to finished jobs" );
+            parent.get()->m_unfinished.fetch_add( 1, std::memory_order_relaxed );
+            job.get()->m_parent = parent;
+        }
+
+        return job;
+    }
+
+    // ** JobSystem::run
+    template<typename TCallable>
+    JobHandle JobSystem::run( const TCallable& callable, const JobHandle& parent )
+    {
+        JobHandle job = create( callable, parent );
+        submit( job );
+        return job;
+    }
+
+    // ** JobSystem::continueWith
+    template<typename TCallable>
+    JobHandle JobSystem::continueWith( const JobHandle& job, const TCallable& callable )
+    {
+        JobHandle continuation = create( callable );
+        addDependency( continuation, job );
+        submit( continuation );
+        return continuation;
+    }
+
+    // ** JobSystem::addDependency
+    inline void JobSystem::addDependency( const JobHandle& job, const JobHandle& dependency )
+    {
+        NIMBLE_ABORT_IF( !job.valid() || !dependency.valid(), "invalid job handle" );
+
+        job.get()->m_dependencies.fetch_add( 1, std::memory_order_relaxed );
+
+        {
+            std::lock_guard<std::mutex> lock( dependency.get()->m_mutex );
+
+            if( !dependency.get()->m_isCompleted ) {
+                dependency.get()->m_continuations.push_back( job );
+                return;
+            }
+        }
+
+        // A dependency is already finished
+        job.get()->m_dependencies.fetch_sub( 1, std::memory_order_relaxed );
+    }
+
+    // ** JobSystem::submit
+    inline void JobSystem::submit( const JobHandle& job )
+    {
+        NIMBLE_ABORT_IF( !job.valid(), "invalid job handle" );
+
+        if( job.get()->m_dependencies.fetch_sub( 1, std::memory_order_acq_rel ) == 1 ) {
+            schedule( job.get() );
+        }
+    }
+
+    // ** JobSystem::schedule
+    inline void JobSystem::schedule( Job* job )
+    {
+        // A queue owns a reference to a job until it is executed
+        job->retain();
+
+        if( Worker* worker = currentWorker() ) {
+            worker->deque.push( job );
+        } else {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            m_queue.push_back( job );
+            m_queued.fetch_add( 1, std::memory_order_release );
+        }
+
+        if( m_sleeping.load( std::memory_order_acquire ) > 0 ) {
+            m_wake.notify_one();
+        }
+    }
+
+    // ** JobSystem::findJob
+    inline Job* JobSystem::findJob( Worker* worker )
+    {
+        Job* job = NULL;
+
+        if( worker && worker->deque.pop( job ) ) {
+            return job;
+        }
+
+        // Steal from workers starting from a random one
+        s32 count = workerCount();
+        u32 start = 0;
+
+        if( worker ) {
+            worker->random ^= worker->random << 13;
+            worker->random ^= worker->random >> 17;
+            worker->random ^= worker->random << 5;
+            start = worker->random;
+        }
+
+        for( s32 i = 0; i < count; i++ ) {
+            Worker* victim = m_workers[(start + i) % count];
+
+            if( victim != worker && victim->deque.steal( job ) ) {
+                return job;
+            }
+        }
+
+        // Take the oldest job from a shared queue
+        if( m_queued.load( std::memory_order_acquire ) > 0 ) {
+            std::lock_guard<std::mutex> lock( m_mutex );
+
+            if( m_queueHead < m_queue.size() ) {
+                job = m_queue[m_queueHead++];
+                m_queued.fetch_sub( 1, std::memory_order_release );
+
+                if( m_queueHead == m_queue.size() ) {
+                    m_queue.clear();
+                    m_queueHead = 0;
+                }
+
+                return job;
+            }
+        }
+
+        return NULL;
+    }
+
+    // ** JobSystem::execute
+    inline void JobSystem::execute( Job* job )
+    {
+        job->execute();
+        finish( job );
+        job->release();
+    }
+
+    // ** JobSystem::finish
+    inline void JobSystem::finish( Job* job )
+    {
+        if( job->m_unfinished.fetch_sub( 1, std::memory_order_acq_rel ) != 1 ) {
+            return;
+        }
+
+        // Schedule continuations that have no other unfinished dependencies
+        Array<JobHandle> continuations;
+        {
+            std::lock_guard<std::mutex> lock( job->m_mutex );
+            job->m_isCompleted = true;
+            continuations.swap( job->m_continuations );
+        }
+
+        for( size_t i = 0, n = continuations.size(); i < n; i++ ) {
+            if( continuations[i]->m_dependencies.fetch_sub( 1, std::memory_order_acq_rel ) == 1 ) {
+                schedule( continuations[i].get() );
+            }
+        }
+
+        // A parent is finished once all of its children are
+        if( job->m_parent.valid() ) {
+            JobHandle parent = job->m_parent;
+            job->m_parent = JobHandle();
+            finish( parent.get() );
+        }
+    }
+
+    // ** JobSystem::wait
+    inline void JobSystem::wait( const JobHandle& job )
+    {
+        Worker* worker = currentWorker();
+
+        while( !job->isFinished() ) {
+            if( Job* next = findJob( worker ) ) {
+                execute( next );
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    // ** JobSystem::workerLoop
+    inline void JobSystem::workerLoop( s32 index )
+    {
+        Worker* worker = m_workers[index];
+        threadWorker() = worker;
+
+        // The number of unsuccessful attempts to find a job before a worker goes to sleep
+        const s32 SpinCount = 64;
+        s32       idle      = 0;
+
+        while( m_isRunning.load( std::memory_order_acquire ) ) {
+            if( Job* job = findJob( worker ) ) {
+                execute( job );
+                idle = 0;
+                continue;
+            }
+
+            if( ++idle < SpinCount ) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            // A worker may miss a wake up notification, so it sleeps with a timeout
+            std::unique_lock<std::mutex> lock( m_mutex );
+            m_sleeping.fetch_add( 1, std::memory_order_acq_rel );
+
+            if( m_isRunning.load() && m_queued.load() == 0 ) {
+                m_wake.wait_for( lock, std::chrono::milliseconds( 1 ) );
+            }
+
+            m_sleeping.fetch_sub( 1, std::memory_order_acq_rel );
+            idle = 0;
+        }
+
+        threadWorker() = NULL;
+    }
+
+NIMBLE_END
+
+#endif  /*  NIMBLE_CPP11_ENABLED    */
+
+#endif  /*  !__Nimble_JobSystem_H__ */
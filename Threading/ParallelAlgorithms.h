@@ -0,0 +1,286 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_ParallelAlgorithms_H__
+#define __Nimble_ParallelAlgorithms_H__
+
+#include "JobSystem.h"
+
+#if NIMBLE_CPP11_ENABLED
+
+#include <algorithm>
+
+NIMBLE_BEGIN
+
+    //! The default number of items processed by a single job when a grain size is not specified.
+    enum { ParallelMinGrainSize = 1024 };
+
+    namespace Private {
+
+        //! Returns the number of items processed by a single job, a zero grain size splits the range to a few chunks per worker.
+        inline s32 parallelGrainSize( const JobSystem& jobs, s32 count, s32 grainSize )
+        {
+            if( grainSize > 0 ) {
+                return grainSize;
+            }
+
+            return max2<s32>( ParallelMinGrainSize, count / (jobs.workerCount() * 4 + 1) + 1 );
+        }
+
+        //! Returns the number of chunks a range is split to.
+        inline s32 parallelChunkCount( s32 count, s32 grainSize )
+        {
+            return (count + grainSize - 1) / grainSize;
+        }
+
+        //! Runs a chunk callback for each chunk in parallel and waits for all of them to finish.
+        template<typename TChunk>
+        void parallelChunks( JobSystem& jobs, s32 chunkCount, const TChunk& chunk )
+        {
+            JobHandle root = jobs.create( []() {} );
+
+            // The calling thread runs the first chunk itself
+            for( s32 i = 1; i < chunkCount; i++ ) {
+                jobs.run( [&chunk, i]() { chunk( i ); }, root );
+            }
+
+            jobs.submit( root );
+            chunk( 0 );
+            jobs.wait( root );
+        }
+
+    } // namespace Private
+
+    //! Invokes a body for each chunk of a [0, count) range in parallel.
+    /*!
+        The body is called as body( begin, end ). Ranges smaller than a grain size are
+        processed by the calling thread without scheduling any jobs.
+    */
+    template<typename TBody>
+    void parallelFor( JobSystem& jobs, s32 count, const TBody& body, s32 grainSize = 0 )
+    {
+        if( count <= 0 ) {
+            return;
+        }
+
+        s32 grain = Private::parallelGrainSize( jobs, count, grainSize );
+
+        if( count <= grain ) {
+            body( 0, count );
+            return;
+        }
+
+        Private::parallelChunks( jobs, Private::parallelChunkCount( count, grain ), [&]( s32 chunk ) {
+            s32 begin = chunk * grain;
+            body( begin, min2( begin + grain, count ) );
+        } );
+    }
+
+    //! Invokes a function for each array item in parallel.
+    template<typename TValue, typename TFunction>
+    void parallelForEach( JobSystem& jobs, Array<TValue>& items, const TFunction& function, s32 grainSize = 0 )
+    {
+        parallelFor( jobs, static_cast<s32>( items.size() ), [&]( s32 begin, s32 end ) {
+            for( s32 i = begin; i < end; i++ ) {
+                function( items[i] );
+            }
+        }, grainSize );
+    }
+
+    //! Reduces a [0, count) range in parallel.
+    /*!
+        The chunk function reduces a range and is called as chunk( begin, end ), the combine
+        function merges two partial results. Partial results are combined in a range order,
+        so a result is deterministic for a given grain size.
+    */
+    template<typename TValue, typename TChunk, typename TCombine>
+    TValue parallelReduce( JobSystem& jobs, s32 count, const TValue& identity, const TChunk& chunk, const TCombine& combine, s32 grainSize = 0 )
+    {
+        if( count <= 0 ) {
+            return identity;
+        }
+
+        s32 grain = Private::parallelGrainSize( jobs, count, grainSize );
+
+        if( count <= grain ) {
+            return combine( identity, chunk( 0, count ) );
+        }
+
+        s32           chunkCount = Private::parallelChunkCount( count, grain );
+        Array<TValue> partial;
+        partial.resize( chunkCount, identity );
+
+        Private::parallelChunks( jobs, chunkCount, [&]( s32 index ) {
+            s32 begin = index * grain;
+            partial[index] = chunk( begin, min2( begin + grain, count ) );
+        } );
+
+        TValue result = identity;
+
+        for( s32 i = 0; i < chunkCount; i++ ) {
+            result = combine( result, partial[i] );
+        }
+
+        return result;
+    }
+
+    //! Computes a sum of array items in parallel.
+    template<typename TValue>
+    TValue parallelSum( JobSystem& jobs, const Array<TValue>& items, const TValue& identity, s32 grainSize = 0 )
+    {
+        return parallelReduce( jobs, static_cast<s32>( items.size() ), identity
+                             , [&]( s32 begin, s32 end ) { TValue sum = identity; for( s32 i = begin; i < end; i++ ) sum += items[i]; return sum; }
+                             , []( const TValue& a, const TValue& b ) { return a + b; }
+                             , grainSize );
+    }
+
+    //! Sorts an array in parallel with a merge sort.
+    /*!
+        Chunks are sorted by std::sort in parallel and then sorted runs are merged pairwise,
+        each merge pass runs its merges in parallel. The sort is not stable.
+    */
+    template<typename TValue, typename TCompare>
+    void parallelSort( JobSystem& jobs, Array<TValue>& items, const TCompare& compare, s32 grainSize = 0 )
+    {
+        s32 count = static_cast<s32>( items.size() );
+        s32 grain = Private::parallelGrainSize( jobs, count, grainSize );
+
+        if( count <= grain ) {
+            std::sort( items.begin(), items.end(), compare );
+            return;
+        }
+
+        // Sort chunks
+        s32 chunkCount = Private::parallelChunkCount( count, grain );
+
+        Private::parallelChunks( jobs, chunkCount, [&]( s32 chunk ) {
+            s32 begin = chunk * grain;
+            std::sort( items.begin() + begin, items.begin() + min2( begin + grain, count ), compare );
+        } );
+
+        // Merge sorted runs, doubling the run width after each pass
+        Array<TValue>  buffer;
+        buffer.resize( items.size() );
+        Array<TValue>* source = &items;
+        Array<TValue>* target = &buffer;
+
+        for( s32 width = grain; width < count; width *= 2 ) {
+            s32 mergeCount = (count + 2 * width - 1) / (2 * width);
+
+            Private::parallelChunks( jobs, mergeCount, [&]( s32 merge ) {
+                s32 begin  = merge * 2 * width;
+                s32 middle = min2( begin + width, count );
+                s32 end    = min2( begin + 2 * width, count );
+                std::merge( source->begin() + begin, source->begin() + middle, source->begin() + middle, source->begin() + end, target->begin() + begin, compare );
+            } );
+
+            std::swap( source, target );
+        }
+
+        if( source != &items ) {
+            items.swap( buffer );
+        }
+    }
+
+    //! Sorts an array in parallel in an ascending order.
+    template<typename TValue>
+    void parallelSort( JobSystem& jobs, Array<TValue>& items, s32 grainSize = 0 )
+    {
+        parallelSort( jobs, items, []( const TValue& a, const TValue& b ) { return a < b; }, grainSize );
+    }
+
+    //! Computes an exclusive prefix scan of an array in parallel, output[i] is a combination of all input items before i.
+    /*!
+        Chunk totals are computed in parallel first, then scanned serially, and finally
+        each chunk is scanned in parallel starting from its offset. The combine function
+        should be associative.
+    */
+    template<typename TValue, typename TCombine>
+    void parallelScan( JobSystem& jobs, const Array<TValue>& input, Array<TValue>& output, const TValue& identity, const TCombine& combine, s32 grainSize = 0 )
+    {
+        s32 count = static_cast<s32>( input.size() );
+        s32 grain = Private::parallelGrainSize( jobs, count, grainSize );
+
+        output.resize( input.size() );
+
+        if( count <= grain ) {
+            TValue sum = identity;
+
+            for( s32 i = 0; i < count; i++ ) {
+                output[i] = sum;
+                sum = combine( sum, input[i] );
+            }
+
+            return;
+        }
+
+        // Compute chunk totals
+        s32           chunkCount = Private::parallelChunkCount( count, grain );
+        Array<TValue> offsets;
+        offsets.resize( chunkCount, identity );
+
+        Private::parallelChunks( jobs, chunkCount, [&]( s32 chunk ) {
+            TValue sum = identity;
+
+            for( s32 i = chunk * grain, end = min2( (chunk + 1) * grain, count ); i < end; i++ ) {
+                sum = combine( sum, input[i] );
+            }
+
+            offsets[chunk] = sum;
+        } );
+
+        // Turn chunk totals to chunk offsets
+        TValue sum = identity;
+
+        for( s32 i = 0; i < chunkCount; i++ ) {
+            TValue total = offsets[i];
+            offsets[i] = sum;
+            sum = combine( sum, total );
+        }
+
+        // Scan each chunk starting from its offset
+        Private::parallelChunks( jobs, chunkCount, [&]( s32 chunk ) {
+            TValue sum = offsets[chunk];
+
+            for( s32 i = chunk * grain, end = min2( (chunk + 1) * grain, count ); i < end; i++ ) {
+                output[i] = sum;
+                sum = combine( sum, input[i] );
+            }
+        } );
+    }
+
+    //! Computes an exclusive prefix sum of an array in parallel.
+    template<typename TValue>
+    void parallelScan( JobSystem& jobs, const Array<TValue>& input, Array<TValue>& output, const TValue& identity, s32 grainSize = 0 )
+    {
+        parallelScan( jobs, input, output, identity, []( const TValue& a, const TValue& b ) { return a + b; }, grainSize );
+    }
+
+NIMBLE_END
+
+#endif  /*  NIMBLE_CPP11_ENABLED    */
+
+#endif  /*  !__Nimble_ParallelAlgorithms_H__    */
@@ -0,0 +1,227 @@
+/**************************************************************************
+
+ The MIT License (MIT)
+
+ Copyright (c) 2015 Dmitry Sovetov
+
+ https://github.com/dmsovetov
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+
+ **************************************************************************/
+
+#ifndef __Nimble_WorkStealingDeque_H__
+#define __Nimble_WorkStealingDeque_H__
+
+#include "../Globals.h"
+
+#if NIMBLE_CPP11_ENABLED
+
+#include <atomic>
+
+NIMBLE_BEGIN
+
+    //! A Chase-Lev work-stealing deque, the owner thread pushes and pops items at the bottom, other threads steal them from the top.
+    /*!
+        This implementation follows N. M. Le, A. Pop, A. Cohen, F. Zappa Nardelli, "Correct and Efficient
+        Work-Stealing for Weak Memory Models", PPoPP 2013. The item type should be trivially copyable,
+        usually a pointer. Arrays replaced by a growth are kept until the deque is destroyed, because
+        a thief may still be reading from them.
+    */
+    template<typename T>
+    class WorkStealingDeque {
+    public:
+
+                                //! Constructs a WorkStealingDeque instance with a specified initial capacity, that should be a power of two.
+        explicit                WorkStealingDeque( s32 capacity = 1024 );
+                                ~WorkStealingDeque( void );
+
+        //! Pushes an item to the bottom of a deque, should only be called by an owner thread.
+        void                    push( T item );
+
+        //! Pops an item from the bottom of a deque, should only be called by an owner thread.
+        bool                    pop( T& item );
+
+        //! Steals an item from the top of a deque, can be called by any thread.
+        bool                    steal( T& item );
+
+        //! Returns an approximate number of items in a deque.
+        s32                     size( void ) const;
+
+        //! Returns true if a deque looks empty.
+        bool                    isEmpty( void ) const;
+
+    private:
+
+                                WorkStealingDeque( const WorkStealingDeque& other );
+        WorkStealingDeque&      operator = ( const WorkStealingDeque& other );
+
+        //! A circular array of items.
+        struct Buffer {
+                                //! Constructs a Buffer instance.
+                                Buffer( s64 capacity )
+                                    : mask( capacity - 1 ), items( new std::atomic<T>[capacity] ) {}
+                                ~Buffer( void ) { delete[] items; }
+
+            //! Returns an item at specified index.
+            T                   get( s64 index ) const { return items[index & mask].load( std::memory_order_relaxed ); }
+
+            //! Writes an item at specified index.
+            void                put( s64 index, T item ) { items[index & mask].store( item, std::memory_order_relaxed ); }
+
+            //! Returns buffer capacity.
+            s64                 capacity( void ) const { return mask + 1; }
+
+            s64                 mask;   //!< Index mask.
+            std::atomic<T>*     items;  //!< Buffer items.
+        };
+
+        //! Doubles the buffer capacity and returns the new buffer.
+        Buffer*                 grow( Buffer* buffer, s64 top, s64 bottom );
+
+    private:
+
+        std::atomic<s64>        m_top;                                                  //!< The index of a first item, thieves increment it.
+        u8                      m_padding0[NIMBLE_CACHE_LINE_SIZE - sizeof( s64 )];     //!< Keeps the top index on its own cache line.
+        std::atomic<s64>        m_bottom;                                               //!< The index after a last item, modified by an owner.
+        std::atomic<Buffer*>    m_buffer;                                               //!< The current buffer.
+        u8                      m_padding1[NIMBLE_CACHE_LINE_SIZE - sizeof( s64 ) - sizeof( Buffer* )]; //!< Keeps owner data on its own cache line.
+        Array<Buffer*>          m_retired;                                              //!< Buffers replaced by a growth.
+    };
+
+    // ** WorkStealingDeque::WorkStealingDeque
+    template<typename T>
+    WorkStealingDeque<T>::WorkStealingDeque( s32 capacity )
+        : m_top( 0 )
+        , m_bottom( 0 )
+        , m_buffer( new Buffer( nextPowerOf2( capacity ) ) )
+    {
+    }
+
+    // ** WorkStealingDeque::~WorkStealingDeque
+    template<typename T>
+    WorkStealingDeque<T>::~WorkStealingDeque( void )
+    {
+        delete m_buffer.load();
+
+        for( size_t i = 0, n = m_retired.size(); i < n; i++ ) {
+            delete m_retired[i];
+        }
+    }
+
+    // ** WorkStealingDeque::size
+    template<typename T>
+    s32 WorkStealingDeque<T>::size( void ) const
+    {
+        s64 bottom = m_bottom.load( std::memory_order_relaxed );
+        s64 top    = m_top.load( std::memory_order_relaxed );
+        return static_cast<s32>( max2<s64>( bottom - top, 0 ) );
+    }
+
+    // ** WorkStealingDeque::isEmpty
+    template<typename T>
+    bool WorkStealingDeque<T>::isEmpty( void ) const
+    {
+        return size() == 0;
+    }
+
+    // ** WorkStealingDeque::grow
+    template<typename T>
+    typename WorkStealingDeque<T>::Buffer* WorkStealingDeque<T>::grow( Buffer* buffer, s64 top, s64 bottom )
+    {
+        Buffer* grown = new Buffer( buffer->capacity() * 2 );
+
+        for( s64 i = top; i < bottom; i++ ) {
+            grown->put( i, buffer->get( i ) );
+        }
+
+        m_retired.push_back( buffer );
+        m_buffer.store( grown, std::memory_order_release );
+        return grown;
+    }
+
+    // ** WorkStealingDeque::push
+    template<typename T>
+    void WorkStealingDeque<T>::push( T item )
+    {
+        s64     bottom = m_bottom.load( std::memory_order_relaxed );
+        s64     top    = m_top.load( std::memory_order_acquire );
+        Buffer* buffer = m_buffer.load( std::memory_order_relaxed );
+
+        if( bottom - top > buffer->capacity() - 1 ) {
+            buffer = grow( buffer, top, bottom );
+        }
+
+        buffer->put( bottom, item );
+        std::atomic_thread_fence( std::memory_order_release );
+        m_bottom.store( bottom + 1, std::memory_order_relaxed );
+    }
+
+    // ** WorkStealingDeque::pop
+    template<typename T>
+    bool WorkStealingDeque<T>::pop( T& item )
+    {
+        s64     bottom = m_bottom.load( std::memory_order_relaxed ) - 1;
+        Buffer* buffer = m_buffer.load( std::memory_order_relaxed );
+
+        m_bottom.store( bottom, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+
+        s64 top = m_top.load( std::memory_order_relaxed );
+
+        // The deque is empty
+        if( top > bottom ) {
+            m_bottom.store( bottom + 1, std::memory_order_relaxed );
+            return false;
+        }
+
+        item = buffer->get( bottom );
+
+        if( top != bottom ) {
+            return true;
+        }
+
+        // This is the last item, so race with thieves for it
+        bool won = m_top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed );
+        m_bottom.store( bottom + 1, std::memory_order_relaxed );
+        return won;
+    }
+
+    // ** WorkStealingDeque::steal
+    template<typename T>
+    bool WorkStealingDeque<T>::steal( T& item )
+    {
+        s64 top = m_top.load( std::memory_order_acquire );
+        std::atomic_thread_fence( std::memory_order_seq_cst );
+        s64 bottom = m_bottom.load( std::memory_order_acquire );
+
+        if( top >= bottom ) {
+            return false;
+        }
+
+        // Consume ordering is promoted to acquire by all major compilers anyway
+        Buffer* buffer = m_buffer.load( std::memory_order_acquire );
+        item = buffer->get( top );
+
+        return m_top.compare_exchange_strong( top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed );
+    }
+
+NIMBLE_END
+
+#endif  /*  NIMBLE_CPP11_ENABLED    */
+
+#endif  /*  !__Nimble_WorkStealingDeque_H__ */